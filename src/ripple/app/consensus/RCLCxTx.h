@@ -31,22 +31,28 @@ class RCLCxTx
 {
 public:
 
-    RCLCxTx (SHAMapItem const& txn) : txn_ (txn)
+    RCLCxTx (boost::intrusive_ptr<SHAMapItem const> txn)
+        : txn_ (std::move (txn))
     { }
 
     uint256 const& getID() const
     {
-        return txn_.key ();
+        return txn_->key ();
     }
 
     SHAMapItem const& txn() const
+    {
+        return *txn_;
+    }
+
+    boost::intrusive_ptr<SHAMapItem const> const& item() const
     {
         return txn_;
     }
 
 protected:
 
-    SHAMapItem const txn_;
+    boost::intrusive_ptr<SHAMapItem const> txn_;
 };
 
 class RCLTxSet;
@@ -60,9 +66,7 @@ public:
     bool
     addEntry (RCLCxTx const& p)
     {
-        return map_->addItem (
-            SHAMapItem {p.getID(), p.txn().peekData()},
-            true, false);
+        return map_->addGiveItem (p.item(), true, false);
     }
 
     bool
@@ -109,7 +113,7 @@ public:
     {
         auto item = map_->peekItem (entry);
         if (item)
-            return RCLCxTx(*item);
+            return RCLCxTx(item);
         return boost::none;
     }
 
@@ -0,0 +1,298 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/app/ledger/BookIndex.h>
+#include <ripple/app/ledger/IncrementalIndex.h>
+#include <ripple/basics/Log.h>
+#include <ripple/ledger/BookDirs.h>
+#include <ripple/ledger/View.h>
+#include <ripple/protocol/Indexes.h>
+#include <ripple/protocol/LedgerFormats.h>
+#include <ripple/protocol/SField.h>
+#include <ripple/protocol/STArray.h>
+#include <algorithm>
+
+namespace ripple {
+
+STAmount const*
+BookIndex::Offers::funds (AccountID const& owner) const
+{
+    auto const it = funds_.find (owner);
+    return it == funds_.end () ? nullptr : &it->second;
+}
+
+//------------------------------------------------------------------------------
+
+// Cache what an offer owner holds in the currency a book pays out
+static
+void
+cacheFunds (ReadView const& ledger, Book const& book,
+    hash_map <AccountID, STAmount>& funds, AccountID const& owner,
+        beast::Journal j)
+{
+    // An issuer's offers of its own IOUs are always fully funded
+    if (owner == book.out.account)
+        return;
+
+    funds[owner] = accountHolds (ledger, owner, book.out.currency,
+        book.out.account, fhZERO_IF_FROZEN, j);
+}
+
+BookIndex::BookIndex (LedgerInfo const& info)
+    : seq_ (info.seq)
+    , hash_ (info.hash)
+{
+}
+
+std::shared_ptr<BookIndex::Offers const>
+BookIndex::find (Book const& book) const
+{
+    auto const it = books_.find (book);
+    if (it == books_.end ())
+        return nullptr;
+    return it->second;
+}
+
+std::shared_ptr<BookIndex::Offers const>
+BookIndex::build (ReadView const& ledger, Book const& book, beast::Journal j)
+{
+    auto offers = std::make_shared<Offers> ();
+
+    for (auto const& sle : BookDirs (ledger, book))
+    {
+        if (! sle)
+        {
+            JLOG (j.warn()) << "BookIndex: missing offer in " << book;
+            continue;
+        }
+
+        offers->dirs_[sle->getFieldH256 (sfBookDirectory)].push_back (sle);
+        ++offers->count_;
+
+        auto const owner = sle->getAccountID (sfAccount);
+        if (offers->funds_.count (owner) == 0)
+            cacheFunds (ledger, book, offers->funds_, owner, j);
+    }
+
+    return offers;
+}
+
+std::shared_ptr<BookIndex const>
+BookIndex::insert (Book const& book, std::shared_ptr<Offers const> offers) const
+{
+    auto next = std::make_shared<BookIndex> (*this);
+    next->books_[book] = std::move (offers);
+    return next;
+}
+
+std::shared_ptr<BookIndex const>
+BookIndex::erase (Book const& book) const
+{
+    auto next = std::make_shared<BookIndex> (*this);
+    next->books_.erase (book);
+    return next;
+}
+
+std::shared_ptr<BookIndex const>
+BookIndex::advance (ReadView const& ledger, beast::Journal j) const
+{
+    auto next = std::make_shared<BookIndex> (ledger.info());
+
+    if (books_.empty () ||
+        ledger.info().seq != seq_ + 1 ||
+        ledger.info().parentHash != hash_)
+    {
+        return next;
+    }
+
+    // Offers join the end of their directory, so the metadata must be
+    // applied in the order the transactions were executed.
+    auto const metas = orderedMetadata (ledger);
+    if (! metas)
+        return next;
+
+    CopyOnWrite <Book, Offers> books (books_);
+
+    // Offers created and consumed within this ledger
+    hash_set <uint256> transient;
+
+    // Accounts whose holdings may have changed
+    hash_set <AccountID> accounts;
+
+    // Accounts whose roots changed, which can freeze a whole book
+    hash_set <AccountID> roots;
+
+    for (auto const& meta : *metas)
+    {
+        for (auto const& node : meta->getFieldArray (sfAffectedNodes))
+        {
+            bool const created = node.getFName () == sfCreatedNode;
+            bool const deleted = node.getFName () == sfDeletedNode;
+            auto const fields = dynamic_cast <STObject const*> (
+                node.peekAtPField (created ? sfNewFields : sfFinalFields));
+            auto const type = node.getFieldU16 (sfLedgerEntryType);
+
+            if (type == ltFEE_SETTINGS)
+            {
+                // Reserves changed, so every XRP balance may differ
+                return next;
+            }
+
+            if (type == ltACCOUNT_ROOT)
+            {
+                if (fields && fields->isFieldPresent (sfAccount))
+                {
+                    auto const id = fields->getAccountID (sfAccount);
+                    accounts.insert (id);
+                    roots.insert (id);
+                }
+                continue;
+            }
+
+            if (type == ltRIPPLE_STATE)
+            {
+                if (fields && fields->isFieldPresent (sfLowLimit))
+                    accounts.insert (
+                        fields->getFieldAmount (sfLowLimit).getIssuer ());
+                if (fields && fields->isFieldPresent (sfHighLimit))
+                    accounts.insert (
+                        fields->getFieldAmount (sfHighLimit).getIssuer ());
+                continue;
+            }
+
+            if (type != ltOFFER)
+                continue;
+
+            if (! fields ||
+                ! fields->isFieldPresent (sfTakerPays) ||
+                ! fields->isFieldPresent (sfTakerGets) ||
+                ! fields->isFieldPresent (sfBookDirectory) ||
+                ! fields->isFieldPresent (sfAccount))
+            {
+                // We can't tell which book this offer is in
+                JLOG (j.warn()) << "BookIndex: incomplete offer metadata";
+                return next;
+            }
+
+            Book const book {
+                fields->getFieldAmount (sfTakerPays).issue (),
+                fields->getFieldAmount (sfTakerGets).issue ()};
+
+            auto offers = books.modify (book);
+            if (! offers)
+                continue;
+
+            auto const key = node.getFieldH256 (sfLedgerIndex);
+            auto const dirKey = fields->getFieldH256 (sfBookDirectory);
+            auto const owner = fields->getAccountID (sfAccount);
+
+            accounts.insert (owner);
+
+            if (created)
+            {
+                // Reads see the ledger's final state
+                if (auto sle = ledger.read (keylet::offer (key)))
+                {
+                    offers->dirs_[dirKey].push_back (std::move (sle));
+                    ++offers->count_;
+
+                    if (offers->funds_.count (owner) == 0)
+                        cacheFunds (ledger, book, offers->funds_, owner, j);
+                }
+                else
+                {
+                    transient.insert (key);
+                }
+                continue;
+            }
+
+            if (transient.count (key) != 0)
+                continue;
+
+            auto const dir = offers->dirs_.find (dirKey);
+            auto it = Offers::Directory::iterator ();
+            if (dir != offers->dirs_.end ())
+            {
+                it = std::find_if (dir->second.begin (), dir->second.end (),
+                    [&key](auto const& sle)
+                    {
+                        return sle->key () == key;
+                    });
+            }
+
+            if (dir == offers->dirs_.end () || it == dir->second.end ())
+            {
+                JLOG (j.debug()) <<
+                    "BookIndex: dropping " << book <<
+                    ", offer " << key << " not indexed";
+                books.drop (book);
+                continue;
+            }
+
+            if (deleted)
+            {
+                dir->second.erase (it);
+                --offers->count_;
+
+                if (dir->second.empty ())
+                    offers->dirs_.erase (dir);
+            }
+            else if (auto sle = ledger.read (keylet::offer (key)))
+            {
+                *it = std::move (sle);
+            }
+        }
+    }
+
+    for (auto const& entry : books_)
+    {
+        auto const& book = entry.first;
+
+        auto const offers = books.find (book);
+        if (! offers)
+            continue;
+
+        // Find the owners whose holdings we need to read again
+        std::vector <AccountID> stale;
+        if (roots.count (book.out.account) != 0)
+        {
+            for (auto const& f : offers->funds_)
+                stale.push_back (f.first);
+        }
+        else
+        {
+            for (auto const& f : offers->funds_)
+                if (accounts.count (f.first) != 0)
+                    stale.push_back (f.first);
+        }
+
+        if (stale.empty ())
+            continue;
+
+        auto& funds = books.modify (book)->funds_;
+        for (auto const& owner : stale)
+            cacheFunds (ledger, book, funds, owner, j);
+    }
+
+    next->books_ = books.apply ();
+    return next;
+}
+
+} // ripple
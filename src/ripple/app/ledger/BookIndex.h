@@ -0,0 +1,148 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_APP_LEDGER_BOOKINDEX_H_INCLUDED
+#define RIPPLE_APP_LEDGER_BOOKINDEX_H_INCLUDED
+
+#include <ripple/basics/UnorderedContainers.h>
+#include <ripple/beast/utility/Journal.h>
+#include <ripple/ledger/ReadView.h>
+#include <ripple/protocol/Book.h>
+#include <ripple/protocol/STAmount.h>
+#include <ripple/protocol/STLedgerEntry.h>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace ripple {
+
+/** A materialized index of order books for one closed ledger.
+
+    Each indexed book holds its offers sorted by quality, as they appear
+    in the book's directories, along with the funds each offer owner
+    holds in the currency the book pays out. Reading a book from the
+    index needs no directory walks or state map lookups.
+
+    An index is immutable once published, so readers may share it
+    without locking. The index for the next ledger is derived from the
+    previous one by applying that ledger's transaction metadata.
+*/
+class BookIndex
+{
+public:
+    /** The offers in a single book. */
+    class Offers
+    {
+    public:
+        using Directory = std::vector <std::shared_ptr<SLE const>>;
+
+        /** The offers in each quality directory, best quality first.
+            The key is the directory's root page, which encodes the
+            quality.
+        */
+        std::map <uint256, Directory> const&
+        directories() const
+        {
+            return dirs_;
+        }
+
+        /** The funds an offer owner holds in the book's output.
+            @return `nullptr` if the owner's funds are not cached. The
+                    issuer of the output is never cached.
+        */
+        STAmount const*
+        funds (AccountID const& owner) const;
+
+        std::size_t
+        size() const
+        {
+            return count_;
+        }
+
+    private:
+        friend class BookIndex;
+
+        std::map <uint256, Directory> dirs_;
+        hash_map <AccountID, STAmount> funds_;
+        std::size_t count_ = 0;
+    };
+
+    /** Create an empty index for a closed ledger. */
+    explicit
+    BookIndex (LedgerInfo const& info);
+
+    std::uint32_t
+    seq() const
+    {
+        return seq_;
+    }
+
+    uint256 const&
+    hash() const
+    {
+        return hash_;
+    }
+
+    /** Returns the number of indexed books. */
+    std::size_t
+    size() const
+    {
+        return books_.size();
+    }
+
+    hash_map <Book, std::shared_ptr<Offers const>> const&
+    entries() const
+    {
+        return books_;
+    }
+
+    /** Returns the indexed offers for a book, or `nullptr`. */
+    std::shared_ptr<Offers const>
+    find (Book const& book) const;
+
+    /** Read every offer in a book from a ledger. */
+    static
+    std::shared_ptr<Offers const>
+    build (ReadView const& ledger, Book const& book, beast::Journal j);
+
+    /** Returns a copy of this index that also holds a book. */
+    std::shared_ptr<BookIndex const>
+    insert (Book const& book, std::shared_ptr<Offers const> offers) const;
+
+    /** Returns a copy of this index without a book. */
+    std::shared_ptr<BookIndex const>
+    erase (Book const& book) const;
+
+    /** Returns the index for a newly closed ledger.
+        If the ledger is this index's successor, the books are carried
+        over and updated from the ledger's metadata. Otherwise the
+        returned index is empty.
+    */
+    std::shared_ptr<BookIndex const>
+    advance (ReadView const& ledger, beast::Journal j) const;
+
+private:
+    std::uint32_t seq_;
+    uint256 hash_;
+    hash_map <Book, std::shared_ptr<Offers const>> books_;
+};
+
+} // ripple
+
+#endif
@@ -0,0 +1,48 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/app/ledger/IncrementalIndex.h>
+#include <ripple/protocol/SField.h>
+#include <algorithm>
+
+namespace ripple {
+
+boost::optional<std::vector<std::shared_ptr<STObject const>>>
+orderedMetadata (ReadView const& ledger)
+{
+    std::vector <std::shared_ptr<STObject const>> metas;
+    for (auto const& item : ledger.txs)
+    {
+        if (! item.second)
+            return boost::none;
+        metas.push_back (item.second);
+    }
+
+    std::sort (metas.begin (), metas.end (),
+        [](auto const& a, auto const& b)
+        {
+            return a->getFieldU32 (sfTransactionIndex) <
+                b->getFieldU32 (sfTransactionIndex);
+        });
+
+    return metas;
+}
+
+} // ripple
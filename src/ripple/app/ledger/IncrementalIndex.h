@@ -0,0 +1,331 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_APP_LEDGER_INCREMENTALINDEX_H_INCLUDED
+#define RIPPLE_APP_LEDGER_INCREMENTALINDEX_H_INCLUDED
+
+#include <ripple/basics/UnorderedContainers.h>
+#include <ripple/ledger/ReadView.h>
+#include <ripple/protocol/STObject.h>
+#include <boost/optional.hpp>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ripple {
+
+/** Returns the metadata of a closed ledger's transactions.
+    The metadata is in the order the transactions were executed, which
+    is the order an index must apply it in.
+    @return `boost::none` if a transaction has no metadata.
+*/
+boost::optional<std::vector<std::shared_ptr<STObject const>>>
+orderedMetadata (ReadView const& ledger);
+
+/** The entries of an index, as changed by one ledger.
+
+    An entry is copied the first time it is modified, so the previous
+    index, which readers may still hold, is left untouched.
+*/
+template <class Key, class Value>
+class CopyOnWrite
+{
+public:
+    using Map = hash_map <Key, std::shared_ptr<Value const>>;
+
+    explicit
+    CopyOnWrite (Map const& base)
+        : base_ (base)
+    {
+    }
+
+    CopyOnWrite (CopyOnWrite const&) = delete;
+    CopyOnWrite& operator= (CopyOnWrite const&) = delete;
+
+    /** Returns an entry as changed so far.
+        @return `nullptr` if the entry is not indexed or was dropped.
+    */
+    Value const*
+    find (Key const& key) const
+    {
+        if (dropped_.count (key) != 0)
+            return nullptr;
+
+        auto const it = changed_.find (key);
+        if (it != changed_.end ())
+            return it->second.get ();
+
+        auto const found = base_.find (key);
+        if (found == base_.end ())
+            return nullptr;
+        return found->second.get ();
+    }
+
+    /** Returns an entry that may be changed.
+        @return `nullptr` if the entry is not indexed or was dropped.
+    */
+    Value*
+    modify (Key const& key)
+    {
+        if (dropped_.count (key) != 0)
+            return nullptr;
+
+        auto const it = changed_.find (key);
+        if (it != changed_.end ())
+            return it->second.get ();
+
+        auto const found = base_.find (key);
+        if (found == base_.end ())
+            return nullptr;
+
+        auto& copy = changed_[key];
+        copy = std::make_shared<Value> (*found->second);
+        return copy.get ();
+    }
+
+    /** Remove an entry that can't be brought up to date. */
+    void
+    drop (Key const& key)
+    {
+        changed_.erase (key);
+        dropped_.insert (key);
+    }
+
+    /** Returns the entries with every change applied. */
+    Map
+    apply () const
+    {
+        Map result;
+        result.reserve (base_.size ());
+
+        for (auto const& entry : base_)
+        {
+            if (dropped_.count (entry.first) != 0)
+                continue;
+
+            auto const it = changed_.find (entry.first);
+            if (it != changed_.end ())
+                result.emplace (entry.first, it->second);
+            else
+                result.emplace (entry.first, entry.second);
+        }
+
+        return result;
+    }
+
+private:
+    Map const& base_;
+    hash_map <Key, std::shared_ptr<Value>> changed_;
+    hash_set <Key> dropped_;
+};
+
+/** The current index of a service, shared with lock-free readers.
+
+    Readers load the index atomically. Changes are serialized, and each
+    one publishes a new immutable index. Entries are read into the index
+    the first time they are asked for. When the index is full, the entry
+    asked for least recently makes room, and entries that nobody asks
+    for are dropped after a while so they stop costing updates.
+
+    `Index` must provide `seq`, `hash`, `size`, `entries`, `find`,
+    `insert` and `erase` like @ref BookIndex does.
+*/
+template <class Key, class Index>
+class PublishedIndex
+{
+public:
+    /** @param limit The most entries the index will hold.
+        @param maxIdle The number of ledgers an entry may go unused
+                       before it is dropped.
+    */
+    PublishedIndex (std::size_t limit, std::uint32_t maxIdle)
+        : limit_ (limit)
+        , maxIdle_ (maxIdle)
+    {
+    }
+
+    PublishedIndex (PublishedIndex const&) = delete;
+    PublishedIndex& operator= (PublishedIndex const&) = delete;
+
+    std::shared_ptr<Index const>
+    current () const
+    {
+        return std::atomic_load (&index_);
+    }
+
+    /** Returns an entry of the index for a closed ledger.
+        An entry that is not indexed yet is read by calling `build`,
+        and added to the index.
+        @return `nullptr` if the index does not cover this ledger.
+    */
+    template <class Build>
+    auto
+    find (ReadView const& ledger, Key const& key, Build&& build)
+        -> decltype (build ())
+    {
+        if (ledger.open ())
+            return nullptr;
+
+        auto const index = current ();
+        if (! index || index->hash () != ledger.info().hash)
+            return nullptr;
+
+        if (auto entry = index->find (key))
+        {
+            touch (key, ledger.info().seq);
+            return entry;
+        }
+
+        auto entry = build ();
+        store (ledger, key, entry);
+        return entry;
+    }
+
+    /** Add or replace an entry that was read from a closed ledger.
+        Nothing is stored if the index is no longer at that ledger.
+        Replacing an entry does not count as a use of it.
+    */
+    template <class Value>
+    void
+    store (ReadView const& ledger, Key const& key,
+        std::shared_ptr<Value const> entry)
+    {
+        std::lock_guard <std::mutex> sl (lock_);
+
+        // The index may have moved on while we were reading
+        auto index = current ();
+        if (! index || index->hash () != ledger.info().hash)
+            return;
+
+        if (! index->find (key))
+        {
+            if (index->size () >= limit_)
+            {
+                auto const victim = evict ();
+                if (! victim)
+                    return;
+                index = index->erase (*victim);
+            }
+
+            touch (key, ledger.info().seq);
+        }
+
+        std::atomic_store (&index_, index->insert (key, std::move (entry)));
+    }
+
+    /** Publish the index that follows the current one.
+        @param next Called with the current index, which may be
+                    `nullptr`. It returns the index to publish, or
+                    `nullptr` to keep the current one.
+        @return The published index.
+    */
+    template <class Next>
+    std::shared_ptr<Index const>
+    update (Next&& next)
+    {
+        std::lock_guard <std::mutex> sl (lock_);
+
+        auto const index = current ();
+        auto published = next (index);
+        if (! published)
+            return index;
+
+        published = expire (std::move (published));
+        std::atomic_store (&index_, published);
+        return published;
+    }
+
+private:
+    void
+    touch (Key const& key, std::uint32_t seq)
+    {
+        std::lock_guard <std::mutex> sl (usedLock_);
+        auto& used = used_[key];
+        used = std::max (used, seq);
+    }
+
+    // Forget the entry asked for least recently, and return it
+    boost::optional<Key>
+    evict ()
+    {
+        std::lock_guard <std::mutex> sl (usedLock_);
+
+        auto const it = std::min_element (used_.begin (), used_.end (),
+            [](auto const& a, auto const& b)
+            {
+                return a.second < b.second;
+            });
+        if (it == used_.end ())
+            return boost::none;
+
+        auto key = it->first;
+        used_.erase (it);
+        return key;
+    }
+
+    // Drop the entries that have not been used for too long
+    std::shared_ptr<Index const>
+    expire (std::shared_ptr<Index const> index)
+    {
+        std::lock_guard <std::mutex> sl (usedLock_);
+
+        std::vector <Key> idle;
+        for (auto const& entry : index->entries ())
+        {
+            // An entry carried in from elsewhere starts out as used
+            auto const it = used_.emplace (entry.first, index->seq ()).first;
+            if (it->second + maxIdle_ < index->seq ())
+                idle.push_back (entry.first);
+        }
+
+        for (auto it = used_.begin (); it != used_.end ();)
+        {
+            if (index->find (it->first))
+                ++it;
+            else
+                it = used_.erase (it);
+        }
+
+        for (auto const& key : idle)
+        {
+            index = index->erase (key);
+            used_.erase (key);
+        }
+
+        return index;
+    }
+
+    std::size_t const limit_;
+    std::uint32_t const maxIdle_;
+
+    // Readers load this atomically, without taking a lock
+    std::shared_ptr<Index const> index_;
+
+    // Serializes changes to the index
+    std::mutex lock_;
+
+    // The last ledger each entry was asked for in
+    hash_map <Key, std::uint32_t> used_;
+    std::mutex usedLock_;
+};
+
+} // ripple
+
+#endif
@@ -0,0 +1,354 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/app/ledger/IncrementalIndex.h>
+#include <ripple/app/ledger/IssuerBalances.h>
+#include <ripple/basics/Log.h>
+#include <ripple/ledger/View.h>
+#include <ripple/protocol/LedgerFormats.h>
+#include <ripple/protocol/SField.h>
+#include <ripple/protocol/STArray.h>
+#include <boost/optional.hpp>
+
+namespace ripple {
+
+namespace {
+
+// The fields of a trust line that the totals depend on
+struct LineFields
+{
+    AccountID low;
+    AccountID high;
+    STAmount balance;
+    std::uint32_t flags = 0;
+};
+
+// Read a trust line from ledger entry fields. Fields missing from
+// `fields` are taken from `fallback`, if one is given.
+boost::optional<LineFields>
+readLineFields (STObject const* fields, STObject const* fallback)
+{
+    auto source = [&](SField const& field) -> STObject const*
+    {
+        if (fields && fields->isFieldPresent (field))
+            return fields;
+        if (fallback && fallback->isFieldPresent (field))
+            return fallback;
+        return nullptr;
+    };
+
+    auto const low = source (sfLowLimit);
+    auto const high = source (sfHighLimit);
+    if (! low || ! high)
+        return boost::none;
+
+    LineFields line;
+    line.low = low->getFieldAmount (sfLowLimit).getIssuer ();
+    line.high = high->getFieldAmount (sfHighLimit).getIssuer ();
+
+    // A new line with default flags and no balance omits them
+    if (auto const balance = source (sfBalance))
+        line.balance = balance->getFieldAmount (sfBalance);
+    if (auto const flags = source (sfFlags))
+        line.flags = flags->getFieldU32 (sfFlags);
+
+    return line;
+}
+
+} // namespace
+
+//------------------------------------------------------------------------------
+
+void
+IssuerBalances::Totals::apply (AccountID const& peer,
+    STAmount const& balance, bool frozen, bool add)
+{
+    if (balance == zero)
+        return;
+
+    auto const& currency = balance.getCurrency ();
+
+    auto update = [&](Balances& balances, STAmount const& amount)
+    {
+        if (add)
+        {
+            balances[peer][currency] = amount;
+            return;
+        }
+
+        auto const it = balances.find (peer);
+        if (it == balances.end ())
+            return;
+        it->second.erase (currency);
+        if (it->second.empty ())
+            balances.erase (it);
+    };
+
+    if (balance > zero)
+    {
+        update (assets_, balance);
+    }
+    else if (frozen)
+    {
+        update (frozen_, -balance);
+    }
+    else if (add)
+    {
+        auto& o = obligations_[currency];
+        if (o.lines++ == 0)
+            o.amount = -balance;
+        else
+            o.amount -= balance;
+    }
+    else
+    {
+        auto const it = obligations_.find (currency);
+        if (it == obligations_.end ())
+            return;
+
+        // Dropping the sum with the last line keeps rounding
+        // errors from outliving the lines that caused them.
+        if (it->second.lines <= 1)
+        {
+            obligations_.erase (it);
+        }
+        else
+        {
+            --it->second.lines;
+            it->second.amount += balance;
+        }
+    }
+}
+
+void
+IssuerBalances::Totals::serialize (Serializer& s) const
+{
+    s.add32 (obligations_.size ());
+    for (auto const& o : obligations_)
+    {
+        o.second.amount.add (s);
+        s.add32 (o.second.lines);
+    }
+
+    for (auto const balances : { &frozen_, &assets_ })
+    {
+        s.add32 (balances->size ());
+        for (auto const& peer : *balances)
+        {
+            s.add160 (peer.first);
+            s.add32 (peer.second.size ());
+            for (auto const& amount : peer.second)
+                amount.second.add (s);
+        }
+    }
+}
+
+std::shared_ptr<IssuerBalances::Totals const>
+IssuerBalances::Totals::deserialize (Slice const& data)
+{
+    auto totals = std::make_shared<Totals> ();
+    SerialIter sit (data);
+
+    for (auto n = sit.get32 (); n != 0; --n)
+    {
+        STAmount amount (sit, sfGeneric);
+        auto& o = totals->obligations_[amount.getCurrency ()];
+        o.amount = std::move (amount);
+        o.lines = sit.get32 ();
+    }
+
+    for (auto const balances : { &totals->frozen_, &totals->assets_ })
+    {
+        for (auto n = sit.get32 (); n != 0; --n)
+        {
+            AccountID id;
+            id.copyFrom (sit.get160 ());
+
+            auto& peer = (*balances)[id];
+            for (auto m = sit.get32 (); m != 0; --m)
+            {
+                STAmount amount (sit, sfGeneric);
+                peer[amount.getCurrency ()] = std::move (amount);
+            }
+        }
+    }
+
+    if (! sit.empty ())
+        return nullptr;
+
+    return totals;
+}
+
+//------------------------------------------------------------------------------
+
+// Add or remove a trust line's balance, as seen from the issuer
+static
+void
+applyLine (IssuerBalances::Totals& totals, AccountID const& issuer,
+    LineFields const& line, bool add)
+{
+    bool const low = line.low == issuer;
+
+    auto balance = line.balance;
+    if (! low)
+        balance.negate ();
+
+    bool const frozen = line.flags & (low ? lsfLowFreeze : lsfHighFreeze);
+
+    totals.apply (low ? line.high : line.low, balance, frozen, add);
+}
+
+IssuerBalances::IssuerBalances (LedgerInfo const& info)
+    : IssuerBalances (info.seq, info.hash)
+{
+}
+
+IssuerBalances::IssuerBalances (std::uint32_t seq, uint256 const& hash)
+    : seq_ (seq)
+    , hash_ (hash)
+{
+}
+
+std::shared_ptr<IssuerBalances::Totals const>
+IssuerBalances::find (AccountID const& issuer) const
+{
+    auto const it = issuers_.find (issuer);
+    if (it == issuers_.end ())
+        return nullptr;
+    return it->second;
+}
+
+std::shared_ptr<IssuerBalances::Totals const>
+IssuerBalances::build (ReadView const& ledger, AccountID const& issuer)
+{
+    auto totals = std::make_shared<Totals> ();
+
+    forEachItem (ledger, issuer,
+        [&](std::shared_ptr<SLE const> const& sle)
+        {
+            if (! sle || sle->getType () != ltRIPPLE_STATE)
+                return;
+
+            if (auto const line = readLineFields (sle.get (), nullptr))
+                applyLine (*totals, issuer, *line, true);
+        });
+
+    return totals;
+}
+
+std::shared_ptr<IssuerBalances const>
+IssuerBalances::insert (AccountID const& issuer,
+    std::shared_ptr<Totals const> totals) const
+{
+    auto next = std::make_shared<IssuerBalances> (*this);
+    next->issuers_[issuer] = std::move (totals);
+    return next;
+}
+
+std::shared_ptr<IssuerBalances const>
+IssuerBalances::erase (AccountID const& issuer) const
+{
+    auto next = std::make_shared<IssuerBalances> (*this);
+    next->issuers_.erase (issuer);
+    return next;
+}
+
+std::shared_ptr<IssuerBalances const>
+IssuerBalances::advance (ReadView const& ledger, beast::Journal j) const
+{
+    auto next = std::make_shared<IssuerBalances> (ledger.info());
+
+    if (issuers_.empty () ||
+        ledger.info().seq != seq_ + 1 ||
+        ledger.info().parentHash != hash_)
+    {
+        return next;
+    }
+
+    // A line changed by several transactions must see them in the
+    // order they were executed, or a frozen or positive balance could
+    // be restored after it was removed.
+    auto const metas = orderedMetadata (ledger);
+    if (! metas)
+        return next;
+
+    CopyOnWrite <AccountID, Totals> issuers (issuers_);
+
+    for (auto const& meta : *metas)
+    {
+        for (auto const& node : meta->getFieldArray (sfAffectedNodes))
+        {
+            if (node.getFieldU16 (sfLedgerEntryType) != ltRIPPLE_STATE)
+                continue;
+
+            bool const created = node.getFName () == sfCreatedNode;
+            bool const deleted = node.getFName () == sfDeletedNode;
+
+            auto const fields = dynamic_cast <STObject const*> (
+                node.peekAtPField (created ? sfNewFields : sfFinalFields));
+            auto const prevs = dynamic_cast <STObject const*> (
+                node.peekAtPField (sfPreviousFields));
+
+            boost::optional<LineFields> before;
+            boost::optional<LineFields> after;
+
+            if (! created)
+            {
+                before = readLineFields (prevs, fields);
+                if (! before)
+                {
+                    JLOG (j.warn()) <<
+                        "IssuerBalances: incomplete trust line metadata";
+                    return next;
+                }
+            }
+
+            if (! deleted)
+            {
+                after = readLineFields (fields, nullptr);
+                if (! after)
+                {
+                    JLOG (j.warn()) <<
+                        "IssuerBalances: incomplete trust line metadata";
+                    return next;
+                }
+            }
+
+            auto const& line = before ? *before : *after;
+
+            for (auto const& issuer : { line.low, line.high })
+            {
+                auto totals = issuers.modify (issuer);
+                if (! totals)
+                    continue;
+
+                if (before)
+                    applyLine (*totals, issuer, *before, false);
+                if (after)
+                    applyLine (*totals, issuer, *after, true);
+            }
+        }
+    }
+
+    next->issuers_ = issuers.apply ();
+    return next;
+}
+
+} // ripple
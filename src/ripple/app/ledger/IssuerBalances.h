@@ -0,0 +1,174 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_APP_LEDGER_ISSUERBALANCES_H_INCLUDED
+#define RIPPLE_APP_LEDGER_ISSUERBALANCES_H_INCLUDED
+
+#include <ripple/basics/Slice.h>
+#include <ripple/basics/UnorderedContainers.h>
+#include <ripple/beast/utility/Journal.h>
+#include <ripple/ledger/ReadView.h>
+#include <ripple/protocol/Serializer.h>
+#include <ripple/protocol/STAmount.h>
+#include <map>
+#include <memory>
+
+namespace ripple {
+
+/** Aggregated trust line balances of issuers for one closed ledger.
+
+    For each indexed issuer this holds what `gateway_balances` reports:
+    the total owed in each currency, and the frozen lines and assets
+    of each counterparty. Balances are seen from the issuer, so a
+    negative balance is an obligation.
+
+    An index is immutable once published, so readers may share it
+    without locking. The index for the next ledger is derived from the
+    previous one by applying that ledger's transaction metadata.
+*/
+class IssuerBalances
+{
+public:
+    /** The aggregated trust lines of a single issuer. */
+    class Totals
+    {
+    public:
+        /** The unfrozen obligations in a currency. */
+        struct Obligation
+        {
+            STAmount amount;
+            std::size_t lines = 0;
+        };
+
+        using Balances =
+            std::map <AccountID, std::map <Currency, STAmount>>;
+
+        /** The sum of unfrozen obligations, by currency.
+            Lines to hot wallets are included, since those are only
+            known when the index is queried. The sums are updated as
+            lines change, so they may differ from a fresh read by
+            rounding.
+        */
+        std::map <Currency, Obligation> const&
+        obligations() const
+        {
+            return obligations_;
+        }
+
+        /** Obligations on lines the issuer has frozen. */
+        Balances const&
+        frozen() const
+        {
+            return frozen_;
+        }
+
+        /** Positive balances, held by the issuer. */
+        Balances const&
+        assets() const
+        {
+            return assets_;
+        }
+
+        /** Add or remove the balance of one trust line.
+            @param balance The balance as seen from the issuer.
+            @param frozen `true` if the issuer froze the line.
+        */
+        void
+        apply (AccountID const& peer, STAmount const& balance,
+            bool frozen, bool add);
+
+        void
+        serialize (Serializer& s) const;
+
+        static
+        std::shared_ptr<Totals const>
+        deserialize (Slice const& data);
+
+    private:
+        std::map <Currency, Obligation> obligations_;
+        Balances frozen_;
+        Balances assets_;
+    };
+
+    /** Create an empty index for a closed ledger. */
+    explicit
+    IssuerBalances (LedgerInfo const& info);
+
+    IssuerBalances (std::uint32_t seq, uint256 const& hash);
+
+    std::uint32_t
+    seq() const
+    {
+        return seq_;
+    }
+
+    uint256 const&
+    hash() const
+    {
+        return hash_;
+    }
+
+    /** Returns the number of indexed issuers. */
+    std::size_t
+    size() const
+    {
+        return issuers_.size();
+    }
+
+    hash_map <AccountID, std::shared_ptr<Totals const>> const&
+    entries() const
+    {
+        return issuers_;
+    }
+
+    /** Returns the totals for an issuer, or `nullptr`. */
+    std::shared_ptr<Totals const>
+    find (AccountID const& issuer) const;
+
+    /** Read every trust line of an issuer from a ledger. */
+    static
+    std::shared_ptr<Totals const>
+    build (ReadView const& ledger, AccountID const& issuer);
+
+    /** Returns a copy of this index that also holds an issuer. */
+    std::shared_ptr<IssuerBalances const>
+    insert (AccountID const& issuer,
+        std::shared_ptr<Totals const> totals) const;
+
+    /** Returns a copy of this index without an issuer. */
+    std::shared_ptr<IssuerBalances const>
+    erase (AccountID const& issuer) const;
+
+    /** Returns the index for a newly closed ledger.
+        If the ledger is this index's successor, the issuers are
+        carried over and updated from the ledger's metadata. Otherwise
+        the returned index is empty.
+    */
+    std::shared_ptr<IssuerBalances const>
+    advance (ReadView const& ledger, beast::Journal j) const;
+
+private:
+    std::uint32_t seq_;
+    uint256 hash_;
+    hash_map <AccountID, std::shared_ptr<Totals const>> issuers_;
+};
+
+} // ripple
+
+#endif
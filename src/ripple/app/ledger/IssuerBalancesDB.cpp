@@ -0,0 +1,304 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/app/ledger/IssuerBalancesDB.h>
+#include <ripple/app/ledger/LedgerMaster.h>
+#include <ripple/basics/Log.h>
+#include <ripple/basics/StringUtilities.h>
+#include <ripple/core/DatabaseCon.h>
+#include <ripple/protocol/AccountID.h>
+#include <boost/optional.hpp>
+
+namespace ripple {
+
+// The most issuers the index will hold
+static std::size_t const maxIndexedIssuers = 256;
+
+// Issuers not asked for in this many ledgers are dropped from the index.
+// An issuer can have far more lines than a book has offers, so issuers
+// are kept longer than books.
+static std::uint32_t const maxIdleIssuers = 4096;
+
+// How often, in ledgers, the index is saved
+static std::uint32_t const saveInterval = 256;
+
+// The most ledgers a saved index will be caught up over
+static std::uint32_t const maxCatchUp = 256;
+
+IssuerBalancesDB::IssuerBalancesDB (Application& app)
+    : app_ (app)
+    , index_ (maxIndexedIssuers, maxIdleIssuers)
+    , j_ (app.journal ("IssuerBalances"))
+{
+}
+
+std::shared_ptr<IssuerBalances::Totals const>
+IssuerBalancesDB::getTotals (ReadView const& ledger, AccountID const& issuer)
+{
+    return index_.find (ledger, issuer,
+        [&]()
+        {
+            return IssuerBalances::build (ledger, issuer);
+        });
+}
+
+std::shared_ptr<IssuerBalances const>
+IssuerBalancesDB::catchUp (IssuerBalances const& saved, ReadView const& ledger)
+{
+    auto const seq = ledger.info().seq;
+
+    if (saved.hash () == ledger.info().hash)
+        return std::make_shared<IssuerBalances const> (saved);
+
+    if (saved.seq () >= seq || seq - saved.seq () > maxCatchUp)
+        return nullptr;
+
+    auto index = std::make_shared<IssuerBalances const> (saved);
+    for (auto s = saved.seq () + 1; s < seq; ++s)
+    {
+        auto const between = app_.getLedgerMaster ().getLedgerBySeq (s);
+        if (! between)
+            return nullptr;
+
+        index = index->advance (*between, j_);
+        if (index->size () == 0)
+            return nullptr;
+    }
+
+    index = index->advance (ledger, j_);
+    if (index->size () == 0)
+        return nullptr;
+
+    return index;
+}
+
+void
+IssuerBalancesDB::rebuild (IssuerBalances const& index, ReadView const& ledger)
+{
+    // Take the issuers in order, starting after the last one read
+    boost::optional<AccountID> first;
+    boost::optional<AccountID> next;
+    for (auto const& entry : index.entries ())
+    {
+        auto const& issuer = entry.first;
+        if (! first || issuer < *first)
+            first = issuer;
+        if (issuer > rebuilt_ && (! next || issuer < *next))
+            next = issuer;
+    }
+
+    if (! next)
+        next = first;
+    if (! next)
+        return;
+
+    rebuilt_ = *next;
+
+    try
+    {
+        index_.store (ledger, rebuilt_,
+            IssuerBalances::build (ledger, rebuilt_));
+    }
+    catch (std::exception const& e)
+    {
+        JLOG (j_.warn()) << "IssuerBalancesDB::rebuild: " << e.what ();
+    }
+}
+
+void
+IssuerBalancesDB::update (std::shared_ptr<ReadView const> const& ledger)
+{
+    std::shared_ptr<IssuerBalances const> saved;
+    {
+        std::lock_guard <std::mutex> sl (lock_);
+        saved = std::move (saved_);
+    }
+
+    bool advanced = false;
+
+    auto const index = index_.update (
+        [&](std::shared_ptr<IssuerBalances const> const& current)
+        {
+            std::shared_ptr<IssuerBalances const> next;
+
+            try
+            {
+                if (saved)
+                {
+                    next = catchUp (*saved, *ledger);
+
+                    JLOG (j_.info()) <<
+                        "Saved index at " << saved->seq () <<
+                        (next ? " restored" : " discarded");
+                }
+                else if (current)
+                {
+                    if (current->hash () == ledger->info().hash)
+                        return next;
+
+                    next = current->advance (*ledger, j_);
+                }
+            }
+            catch (std::exception const& e)
+            {
+                JLOG (j_.warn())
+                    << "IssuerBalancesDB::update: " << e.what ();
+            }
+
+            if (! next)
+                next = std::make_shared<IssuerBalances const> (ledger->info());
+
+            JLOG (j_.trace())
+                << "Issuer balance index at " << next->seq () << ", "
+                << next->size () << " issuers";
+
+            advanced = true;
+            return next;
+        });
+
+    if (! advanced || index->size () == 0)
+        return;
+
+    rebuild (*index, *ledger);
+
+    if (index->seq () % saveInterval == 0)
+        save ();
+}
+
+void
+IssuerBalancesDB::load ()
+{
+    static char const* const sql =
+        "SELECT Issuer, LedgerSeq, LedgerHash, RawData "
+        "FROM IssuerBalances;";
+
+    std::shared_ptr<IssuerBalances const> saved;
+
+    try
+    {
+        auto db = app_.getWalletDB ().checkoutDb ();
+
+        std::string issuer;
+        std::uint64_t seq;
+        std::string hash;
+        soci::blob sociRawData (*db);
+
+        soci::statement st = (db->prepare << sql,
+            soci::into (issuer),
+            soci::into (seq),
+            soci::into (hash),
+            soci::into (sociRawData));
+
+        st.execute ();
+        while (st.fetch ())
+        {
+            uint256 ledgerHash;
+            auto const id = parseBase58<AccountID> (issuer);
+            if (! id || ! ledgerHash.SetHex (hash))
+                continue;
+
+            if (! saved)
+            {
+                saved = std::make_shared<IssuerBalances const> (
+                    static_cast<std::uint32_t> (seq), ledgerHash);
+            }
+            else if (saved->hash () != ledgerHash)
+            {
+                // Rows are always written together
+                JLOG (j_.warn()) << "Inconsistent saved issuer balances";
+                return;
+            }
+
+            Blob data;
+            convert (sociRawData, data);
+
+            if (auto totals = IssuerBalances::Totals::deserialize (
+                    makeSlice (data)))
+            {
+                saved = saved->insert (*id, std::move (totals));
+            }
+        }
+    }
+    catch (std::exception const& e)
+    {
+        JLOG (j_.warn()) << "IssuerBalancesDB::load: " << e.what ();
+        return;
+    }
+
+    if (! saved || saved->size () == 0)
+        return;
+
+    JLOG (j_.info()) <<
+        "Loaded " << saved->size () << " issuers at " << saved->seq ();
+
+    std::lock_guard <std::mutex> sl (lock_);
+    saved_ = std::move (saved);
+}
+
+void
+IssuerBalancesDB::save ()
+{
+    auto const index = index_.current ();
+    if (! index)
+        return;
+
+    static char const* const sql =
+        "INSERT INTO IssuerBalances "
+        "(Issuer, LedgerSeq, LedgerHash, RawData) "
+        "VALUES (:issuer, :seq, :hash, :rawData);";
+
+    try
+    {
+        auto db = app_.getWalletDB ().checkoutDb ();
+
+        soci::transaction tr (*db);
+        *db << "DELETE FROM IssuerBalances;";
+
+        std::uint64_t const seq = index->seq ();
+        std::string const hash = to_string (index->hash ());
+
+        for (auto const& entry : index->entries ())
+        {
+            Serializer s;
+            entry.second->serialize (s);
+
+            std::string const issuer = toBase58 (entry.first);
+
+            // Blob write length is expected to be >= the last write,
+            // so don't reuse the blob between rows
+            soci::blob rawData (*db);
+            convert (s.peekData (), rawData);
+
+            *db << sql,
+                soci::use (issuer),
+                soci::use (seq),
+                soci::use (hash),
+                soci::use (rawData);
+        }
+
+        tr.commit ();
+    }
+    catch (std::exception const& e)
+    {
+        JLOG (j_.warn()) << "IssuerBalancesDB::save: " << e.what ();
+    }
+}
+
+} // ripple
@@ -0,0 +1,90 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_APP_LEDGER_ISSUERBALANCESDB_H_INCLUDED
+#define RIPPLE_APP_LEDGER_ISSUERBALANCESDB_H_INCLUDED
+
+#include <ripple/app/ledger/IncrementalIndex.h>
+#include <ripple/app/ledger/IssuerBalances.h>
+#include <ripple/app/main/Application.h>
+#include <mutex>
+
+namespace ripple {
+
+/** Keeps the issuer balance index in step with published ledgers.
+
+    Issuers are added to the index the first time their balances are
+    asked for, and dropped once they go unused for long enough. The
+    index is saved to the wallet database, so that it can be caught up
+    and reused after a restart instead of reading every trust line
+    again.
+
+    Obligations are running sums, and each change to a line can round
+    them. To keep that error from building up, every ledger also reads
+    one indexed issuer's trust lines again, taking the issuers in turn.
+*/
+class IssuerBalancesDB
+{
+public:
+    explicit
+    IssuerBalancesDB (Application& app);
+
+    /** Returns the totals for an issuer from the index.
+        An issuer is read into the index the first time it is asked for.
+        @return `nullptr` if the index does not cover this ledger.
+    */
+    std::shared_ptr<IssuerBalances::Totals const>
+    getTotals (ReadView const& ledger, AccountID const& issuer);
+
+    /** Advance the index to a newly published ledger. */
+    void
+    update (std::shared_ptr<ReadView const> const& ledger);
+
+    /** Restore the index saved by a previous run. */
+    void
+    load ();
+
+    /** Save the index to the wallet database. */
+    void
+    save ();
+
+private:
+    std::shared_ptr<IssuerBalances const>
+    catchUp (IssuerBalances const& saved, ReadView const& ledger);
+
+    void
+    rebuild (IssuerBalances const& index, ReadView const& ledger);
+
+    Application& app_;
+
+    PublishedIndex <AccountID, IssuerBalances> index_;
+
+    // The index read by load(), until the first update
+    std::shared_ptr<IssuerBalances const> saved_;
+    std::mutex lock_;
+
+    // The issuer last read again by rebuild()
+    AccountID rebuilt_;
+
+    beast::Journal j_;
+};
+
+} // ripple
+
+#endif
@@ -120,7 +120,7 @@ public:
     sles_type::value_type
     dereference() const override
     {
-        auto const item = *iter_;
+        auto const& item = *iter_;
         SerialIter sit(item.slice());
         return std::make_shared<SLE const>(
             sit, item.key());
@@ -176,7 +176,7 @@ public:
     txs_type::value_type
     dereference() const override
     {
-        auto const item = *iter_;
+        auto const& item = *iter_;
         if (metadata_)
             return deserializeTxPlusMeta(item);
         return { deserializeTx(item), nullptr };
@@ -316,6 +316,20 @@ Ledger::Ledger (
     info_.hash = calculateLedgerHash (info_);
 }
 
+Ledger::Ledger (
+        LedgerInfo const& info,
+        Config const& config,
+        Family& family)
+    : mImmutable (false)
+    , txMap_ (std::make_shared <SHAMap> (
+          SHAMapType::TRANSACTION, family, SHAMap::version{1}))
+    , stateMap_ (std::make_shared <SHAMap> (
+          SHAMapType::STATE, family, SHAMap::version{1}))
+    , info_ (info)
+{
+    setup(config);
+}
+
 Ledger::Ledger (std::uint32_t ledgerSeq,
         NetClock::time_point closeTime, Config const& config,
             Family& family)
@@ -365,8 +379,8 @@ Ledger::setAccepted(NetClock::time_point closeTime,
 
 bool Ledger::addSLE (SLE const& sle)
 {
-    SHAMapItem item (sle.key(), sle.getSerializer());
-    return stateMap_->addItem(std::move(item), false, false);
+    return stateMap_->addGiveItem(make_shamapitem(
+        sle.key(), sle.getSerializer().slice()), false, false);
 }
 
 //------------------------------------------------------------------------------
@@ -541,9 +555,8 @@ Ledger::rawInsert(std::shared_ptr<SLE> const& sle)
 {
     Serializer ss;
     sle->add(ss);
-    auto item = std::make_shared<
-        SHAMapItem const>(sle->key(),
-            std::move(ss));
+    auto item = make_shamapitem(
+        sle->key(), ss.slice());
     // VFALCO NOTE addGiveItem should take ownership
     if (! stateMap_->addGiveItem(
             std::move(item), false, false))
@@ -555,9 +568,8 @@ Ledger::rawReplace(std::shared_ptr<SLE> const& sle)
 {
     Serializer ss;
     sle->add(ss);
-    auto item = std::make_shared<
-        SHAMapItem const>(sle->key(),
-            std::move(ss));
+    auto item = make_shamapitem(
+        sle->key(), ss.slice());
     // VFALCO NOTE updateGiveItem should take ownership
     if (! stateMap_->updateGiveItem(
             std::move(item), false, false))
@@ -577,8 +589,7 @@ Ledger::rawTxInsert (uint256 const& key,
         metaData->getDataLength () + 16);
     s.addVL (txn->peekData ());
     s.addVL (metaData->peekData ());
-    auto item = std::make_shared<
-        SHAMapItem const> (key, std::move(s));
+    auto item = make_shamapitem (key, s.slice());
     if (! txMap().addGiveItem
             (std::move(item), true, true))
         LogicError("duplicate_tx: " + to_string(key));
@@ -1104,7 +1115,7 @@ loadLedgerHelper(std::string const& sqlSuffix, Application& app)
     uint256 ledgerHash{};
     std::uint32_t ledgerSeq{0};
 
-    auto db = app.getLedgerDB ().checkoutDb ();
+    auto db = app.getLedgerDB ().checkoutReadDb ();
 
     boost::optional<std::string> sLedgerHash, sPrevHash, sAccountHash,
         sTransHash;
@@ -1247,7 +1258,7 @@ getHashByIndex (std::uint32_t ledgerIndex, Application& app)
 
     std::string hash;
     {
-        auto db = app.getLedgerDB ().checkoutDb ();
+        auto db = app.getLedgerDB ().checkoutReadDb ();
 
         boost::optional<std::string> lh;
         *db << sql,
@@ -1270,7 +1281,7 @@ getHashesByIndex(std::uint32_t ledgerIndex,
     uint256& ledgerHash, uint256& parentHash,
         Application& app)
 {
-    auto db = app.getLedgerDB ().checkoutDb ();
+    auto db = app.getLedgerDB ().checkoutReadDb ();
 
     boost::optional <std::string> lhO, phO;
 
@@ -1307,7 +1318,7 @@ getHashesByIndex (std::uint32_t minSeq, std::uint32_t maxSeq,
     sql.append (beast::lexicalCastThrow <std::string> (maxSeq));
     sql.append (";");
 
-    auto db = app.getLedgerDB ().checkoutDb ();
+    auto db = app.getLedgerDB ().checkoutReadDb ();
 
     std::uint64_t ls;
     std::string lh;
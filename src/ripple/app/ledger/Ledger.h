@@ -115,6 +115,12 @@ public:
         Family& family,
         beast::Journal j);
 
+    // Used for ledgers loaded from snapshots
+    Ledger (
+        LedgerInfo const& info,
+        Config const& config,
+        Family& family);
+
     /** Create a new ledger following a previous ledger
 
         The ledger will have the sequence number that
@@ -26,6 +26,7 @@
 #include <ripple/app/ledger/LedgerCleaner.h>
 #include <ripple/app/ledger/LedgerHistory.h>
 #include <ripple/app/ledger/LedgerHolder.h>
+#include <ripple/app/ledger/LedgerSnapshot.h>
 #include <ripple/app/misc/CanonicalTXSet.h>
 #include <ripple/basics/chrono.h>
 #include <ripple/basics/RangeSet.h>
@@ -349,6 +350,37 @@ private:
 
     std::uint32_t fetch_seq_;
 
+    // The nodes a peer holding one ledger needs to build its parent,
+    // serialized as the objects of a TMGetObjectByHash.
+    struct FetchPackSegment
+    {
+        std::string data;
+        int objects = 0;
+    };
+
+    // Fetch pack segments we have built, shared by every peer that
+    // asks. Keyed by the hash of the ledger the peer has; the ledger
+    // it wants is always the parent of that ledger.
+    TaggedCache<uint256, FetchPackSegment> fetch_pack_segments_;
+
+    // Uptime when a peer last asked us for a fetch pack, or zero
+    std::atomic <int> lastFetchPackRequest_;
+    std::atomic <bool> fetchPackPending_;
+
+    // Returns the cached segment, building it if `build` is set
+    std::shared_ptr<FetchPackSegment>
+    getFetchPackSegment (
+        std::shared_ptr<Ledger const> const& haveLedger,
+        std::shared_ptr<Ledger const> const& wantLedger,
+        bool build = true);
+
+    void prebuildFetchPack (std::shared_ptr<Ledger const> const& ledger);
+
+    // Periodic snapshots of the validated ledger
+    LedgerSnapshotSetup const snapshot_;
+    std::atomic <bool> snapshotPending_;
+
+    void snapshotLedger (std::shared_ptr<Ledger const> const& ledger);
 };
 
 } // ripple
@@ -0,0 +1,506 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/app/ledger/LedgerSnapshot.h>
+#include <ripple/basics/contract.h>
+#include <ripple/basics/Log.h>
+#include <ripple/beast/hash/xxhasher.h>
+#include <ripple/ledger/ReadView.h>
+#include <ripple/protocol/Serializer.h>
+#include <boost/filesystem.hpp>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace ripple {
+
+namespace {
+
+// "XRPLSNAP"
+std::array<char, 8> const snapshotMagic =
+    {{ 'X', 'R', 'P', 'L', 'S', 'N', 'A', 'P' }};
+
+std::uint32_t const snapshotVersion = 1;
+
+// magic, version, ledger header, ledger hash
+std::size_t const snapshotHeaderSize = 8 + 4 + 118 + 32;
+
+// state items, tx items, inner nodes,
+// tx offset, inner offset, checksum
+std::size_t const snapshotTrailerSize = 6 * 8;
+
+// key, data size
+std::size_t const snapshotLeafSize = 32 + 4;
+
+// Bytes buffered before each write
+std::size_t const snapshotWriteSize = 1024 * 1024;
+
+class SnapshotWriter
+{
+private:
+    std::ofstream out_;
+    Serializer buffer_;
+    beast::xxhasher hasher_;
+    std::uint64_t offset_ = 0;
+
+public:
+    explicit
+    SnapshotWriter (std::string const& path)
+        : out_ (path, std::ios::out | std::ios::binary | std::ios::trunc)
+        , buffer_ (snapshotWriteSize + 64 * 1024)
+    {
+        if (! out_)
+            Throw<std::runtime_error> ("unable to create " + path);
+    }
+
+    Serializer&
+    buffer ()
+    {
+        return buffer_;
+    }
+
+    // Offset of the next byte written
+    std::uint64_t
+    offset () const
+    {
+        return offset_ + buffer_.size ();
+    }
+
+    void
+    next ()
+    {
+        if (buffer_.size () >= snapshotWriteSize)
+            flush ();
+    }
+
+    void
+    flush ()
+    {
+        hasher_ (buffer_.data (), buffer_.size ());
+        write (buffer_);
+        offset_ += buffer_.size ();
+        buffer_.erase ();
+    }
+
+    // The trailer is not part of the checksum
+    void
+    finish (Serializer const& trailer)
+    {
+        flush ();
+        write (trailer);
+        out_.close ();
+        if (! out_)
+            Throw<std::runtime_error> ("unable to write snapshot");
+    }
+
+    std::uint64_t
+    checksum ()
+    {
+        return static_cast<std::size_t> (hasher_);
+    }
+
+private:
+    void
+    write (Serializer const& s)
+    {
+        out_.write (static_cast<char const*> (s.data ()), s.size ());
+        if (! out_)
+            Throw<std::runtime_error> ("unable to write snapshot");
+    }
+};
+
+class SnapshotReader
+{
+private:
+    std::ifstream in_;
+    beast::xxhasher hasher_;
+    std::uint64_t offset_ = 0;
+    std::uint64_t size_ = 0;
+
+public:
+    explicit
+    SnapshotReader (std::string const& path)
+        : in_ (path, std::ios::in | std::ios::binary)
+    {
+        if (! in_)
+            Throw<std::runtime_error> ("unable to open " + path);
+        in_.seekg (0, std::ios::end);
+        size_ = in_.tellg ();
+        in_.seekg (0, std::ios::beg);
+        if (! in_)
+            Throw<std::runtime_error> ("unable to read " + path);
+    }
+
+    std::uint64_t
+    size () const
+    {
+        return size_;
+    }
+
+    std::uint64_t
+    offset () const
+    {
+        return offset_;
+    }
+
+    void
+    read (void* data, std::size_t size)
+    {
+        in_.read (static_cast<char*> (data), size);
+        if (! in_)
+            Throw<std::runtime_error> ("snapshot is truncated");
+        hasher_ (data, size);
+        offset_ += size;
+    }
+
+    // Read the trailer without disturbing the position
+    Serializer
+    trailer ()
+    {
+        Serializer s (snapshotTrailerSize);
+        s.modData ().resize (snapshotTrailerSize);
+        auto const pos = in_.tellg ();
+        in_.seekg (size_ - snapshotTrailerSize, std::ios::beg);
+        in_.read (static_cast<char*> (s.getDataPtr ()), snapshotTrailerSize);
+        in_.seekg (pos);
+        if (! in_)
+            Throw<std::runtime_error> ("unable to read snapshot trailer");
+        return s;
+    }
+
+    std::uint64_t
+    checksum ()
+    {
+        return static_cast<std::size_t> (hasher_);
+    }
+};
+
+struct SnapshotTrailer
+{
+    std::uint64_t stateCount;
+    std::uint64_t txCount;
+    std::uint64_t innerCount;
+    std::uint64_t txOffset;
+    std::uint64_t innerOffset;
+    std::uint64_t checksum;
+};
+
+LedgerInfo
+readHeader (SnapshotReader& in)
+{
+    std::array<std::uint8_t, snapshotHeaderSize> header;
+    in.read (header.data (), header.size ());
+
+    if (std::memcmp (header.data (),
+            snapshotMagic.data (), snapshotMagic.size ()) != 0)
+        Throw<std::runtime_error> ("not a ledger snapshot");
+
+    SerialIter sit (header.data () + snapshotMagic.size (),
+        header.size () - snapshotMagic.size ());
+
+    if (sit.get32 () != snapshotVersion)
+        Throw<std::runtime_error> ("unsupported snapshot version");
+
+    LedgerInfo info;
+    info.seq = sit.get32 ();
+    info.drops = sit.get64 ();
+    info.parentHash = sit.get256 ();
+    info.txHash = sit.get256 ();
+    info.accountHash = sit.get256 ();
+    info.parentCloseTime = NetClock::time_point{NetClock::duration{sit.get32()}};
+    info.closeTime = NetClock::time_point{NetClock::duration{sit.get32()}};
+    info.closeTimeResolution = NetClock::duration{sit.get8()};
+    info.closeFlags = sit.get8 ();
+    info.hash = sit.get256 ();
+    return info;
+}
+
+SnapshotTrailer
+readTrailer (SnapshotReader& in)
+{
+    if (in.size () < snapshotHeaderSize + snapshotTrailerSize)
+        Throw<std::runtime_error> ("snapshot is truncated");
+
+    auto const s = in.trailer ();
+    SerialIter sit (s.slice ());
+
+    SnapshotTrailer t;
+    t.stateCount = sit.get64 ();
+    t.txCount = sit.get64 ();
+    t.innerCount = sit.get64 ();
+    t.txOffset = sit.get64 ();
+    t.innerOffset = sit.get64 ();
+    t.checksum = sit.get64 ();
+
+    // The sections must be in order and fill the file exactly
+    auto const end = in.size () - snapshotTrailerSize;
+    if (t.txOffset < snapshotHeaderSize ||
+        t.innerOffset < t.txOffset ||
+        t.innerOffset > end ||
+        (end - t.innerOffset) != t.innerCount * 32 ||
+        (t.txOffset - snapshotHeaderSize) / snapshotLeafSize < t.stateCount ||
+        (t.innerOffset - t.txOffset) / snapshotLeafSize < t.txCount)
+        Throw<std::runtime_error> ("snapshot layout is invalid");
+
+    return t;
+}
+
+void
+writeItems (SnapshotWriter& out, SHAMap const& map, std::uint64_t& count)
+{
+    for (auto const& item : map)
+    {
+        auto& s = out.buffer ();
+        s.add256 (item.key ());
+        s.add32 (static_cast<std::uint32_t> (item.size ()));
+        s.addRaw (item.data (), static_cast<int> (item.size ()));
+        ++count;
+        out.next ();
+    }
+}
+
+SHAMap::SortedItems
+readItems (SnapshotReader& in, std::uint64_t count, std::uint64_t end)
+{
+    SHAMap::SortedItems items;
+    items.reserve (count);
+
+    Blob data;
+    for (std::uint64_t i = 0; i < count; ++i)
+    {
+        std::array<std::uint8_t, snapshotLeafSize> leaf;
+        in.read (leaf.data (), leaf.size ());
+
+        SerialIter sit (leaf.data (), leaf.size ());
+        auto const key = sit.get256 ();
+        auto const size = sit.get32 ();
+        if (size > end - in.offset ())
+            Throw<std::runtime_error> ("snapshot item is too large");
+
+        data.resize (size);
+        in.read (data.data (), size);
+
+        items.push_back (make_shamapitem (key, makeSlice (data)));
+    }
+
+    if (in.offset () != end)
+        Throw<std::runtime_error> ("snapshot section size mismatch");
+
+    return items;
+}
+
+} // (anon)
+
+LedgerSnapshotSetup
+setup_LedgerSnapshot (Section const& section)
+{
+    LedgerSnapshotSetup setup;
+    set (setup.path, "path", section);
+    set (setup.interval, "interval", section);
+
+    if (setup.interval != 0 && setup.path.empty ())
+        Throw<std::runtime_error> (
+            "[ledger_snapshot] interval requires a path");
+
+    return setup;
+}
+
+bool
+writeLedgerSnapshot (Ledger const& ledger, std::string const& path,
+    beast::Journal j)
+{
+    auto const& info = ledger.info ();
+    auto const temp = path + ".tmp";
+
+    if (ledger.stateMap ().is_v2 () || ledger.txMap ().is_v2 ())
+    {
+        JLOG (j.warn()) << "Ledger " << info.seq <<
+            " can't be snapshot: version 2 maps are not supported";
+        return false;
+    }
+
+    try
+    {
+        SnapshotWriter out (temp);
+        SnapshotTrailer t {};
+
+        {
+            auto& s = out.buffer ();
+            s.addRaw (snapshotMagic.data (), snapshotMagic.size ());
+            s.add32 (snapshotVersion);
+            addRaw (info, s);
+            s.add256 (info.hash);
+        }
+
+        writeItems (out, ledger.stateMap (), t.stateCount);
+
+        t.txOffset = out.offset ();
+        writeItems (out, ledger.txMap (), t.txCount);
+
+        t.innerOffset = out.offset ();
+        ledger.stateMap ().visitNodes (
+            [&out, &t](SHAMapAbstractNode& node)
+            {
+                if (node.isInner ())
+                {
+                    out.buffer ().add256 (node.getNodeHash ().as_uint256 ());
+                    ++t.innerCount;
+                    out.next ();
+                }
+                return false;
+            });
+
+        out.flush ();
+        t.checksum = out.checksum ();
+
+        Serializer trailer (snapshotTrailerSize);
+        trailer.add64 (t.stateCount);
+        trailer.add64 (t.txCount);
+        trailer.add64 (t.innerCount);
+        trailer.add64 (t.txOffset);
+        trailer.add64 (t.innerOffset);
+        trailer.add64 (t.checksum);
+        out.finish (trailer);
+
+        boost::filesystem::rename (temp, path);
+
+        JLOG (j.info()) << "Wrote snapshot of ledger " << info.seq <<
+            " to " << path << ": " << t.stateCount << " state items, " <<
+            t.txCount << " transactions";
+        return true;
+    }
+    catch (std::exception const& e)
+    {
+        JLOG (j.warn()) << "Unable to snapshot ledger " << info.seq <<
+            ": " << e.what ();
+    }
+
+    boost::system::error_code ec;
+    boost::filesystem::remove (temp, ec);
+    return false;
+}
+
+bool
+isLedgerSnapshot (std::string const& path)
+{
+    std::ifstream in (path, std::ios::in | std::ios::binary);
+    std::array<char, 8> magic;
+    if (! in.read (magic.data (), magic.size ()))
+        return false;
+    return magic == snapshotMagic;
+}
+
+boost::optional<LedgerInfo>
+readLedgerSnapshotInfo (std::string const& path)
+{
+    try
+    {
+        SnapshotReader in (path);
+        return readHeader (in);
+    }
+    catch (std::exception const&)
+    {
+    }
+    return boost::none;
+}
+
+std::shared_ptr<Ledger>
+loadLedgerSnapshot (std::string const& path, Config const& config,
+    Family& family, beast::Journal j)
+{
+    try
+    {
+        SnapshotReader in (path);
+        auto const t = readTrailer (in);
+        auto const info = readHeader (in);
+
+        if (getSHAMapV2 (info))
+            Throw<std::runtime_error> ("version 2 maps are not supported");
+
+        auto ledger = std::make_shared<Ledger> (info, config, family);
+
+        if (! ledger->stateMap ().addSortedItems (
+                readItems (in, t.stateCount, t.txOffset), false, false))
+            Throw<std::runtime_error> ("state items are not sorted");
+
+        if (! ledger->txMap ().addSortedItems (
+                readItems (in, t.txCount, t.innerOffset), true, true))
+            Throw<std::runtime_error> ("transactions are not sorted");
+
+        // Compare the rebuilt tree against the hashes it was written
+        // from, which finds where a damaged snapshot went wrong.
+        std::uint64_t inner = 0;
+        bool match = true;
+        ledger->stateMap ().visitNodes (
+            [&](SHAMapAbstractNode& node)
+            {
+                if (! node.isInner ())
+                    return false;
+                if (inner++ == t.innerCount)
+                {
+                    match = false;
+                    return true;
+                }
+                uint256 hash;
+                in.read (hash.data (), hash.size ());
+                if (hash != node.getNodeHash ().as_uint256 ())
+                {
+                    JLOG (j.warn()) << "Snapshot inner node " << inner <<
+                        " is " << node.getNodeHash () << ", expected " << hash;
+                    match = false;
+                    return true;
+                }
+                return false;
+            });
+
+        if (! match || inner != t.innerCount)
+            Throw<std::runtime_error> ("state map doesn't match");
+
+        if (in.checksum () != t.checksum)
+            Throw<std::runtime_error> ("checksum mismatch");
+
+        if (ledger->stateMap ().getHash ().as_uint256 () != info.accountHash)
+            Throw<std::runtime_error> ("state map hash mismatch");
+
+        if (ledger->txMap ().getHash ().as_uint256 () != info.txHash)
+            Throw<std::runtime_error> ("transaction map hash mismatch");
+
+        ledger->stateMap ().flushDirty (hotACCOUNT_NODE, info.seq);
+        ledger->txMap ().flushDirty (hotTRANSACTION_NODE, info.seq);
+        ledger->setImmutable (config);
+
+        if (ledger->info ().hash != info.hash)
+            Throw<std::runtime_error> ("ledger hash mismatch");
+
+        JLOG (j.info()) << "Loaded ledger " << info.seq <<
+            " from snapshot " << path << ": " << t.stateCount <<
+            " state items, " << t.txCount << " transactions";
+        return ledger;
+    }
+    catch (std::exception const& e)
+    {
+        JLOG (j.warn()) << "Unable to load snapshot " << path <<
+            ": " << e.what ();
+    }
+    return nullptr;
+}
+
+} // ripple
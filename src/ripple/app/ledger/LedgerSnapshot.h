@@ -0,0 +1,92 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_APP_LEDGER_LEDGERSNAPSHOT_H_INCLUDED
+#define RIPPLE_APP_LEDGER_LEDGERSNAPSHOT_H_INCLUDED
+
+#include <ripple/app/ledger/Ledger.h>
+#include <ripple/basics/BasicConfig.h>
+#include <ripple/beast/utility/Journal.h>
+#include <boost/optional.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace ripple {
+
+/*
+    A ledger snapshot is a binary file holding a closed ledger.
+
+    It holds the ledger header, the leaves of the state map and of the
+    transaction map in key order, and the hashes of the state map's
+    inner nodes in pre-order. Every section has a fixed layout, and a
+    trailer at the end of the file gives the item counts, the offset of
+    each section, and a checksum of everything before it. A reader can
+    map the file and locate each section without parsing the others.
+
+    Loading a snapshot builds both maps in bulk, instead of adding each
+    item or paging each node in from the NodeStore.
+*/
+
+struct LedgerSnapshotSetup
+{
+    // Where the periodic snapshot is written. Empty to disable.
+    std::string path;
+
+    // Write a snapshot of every validated ledger whose sequence
+    // is a multiple of this. Zero to disable.
+    std::uint32_t interval = 0;
+};
+
+LedgerSnapshotSetup
+setup_LedgerSnapshot (Section const& section);
+
+/** Write a closed ledger to a snapshot file.
+    The file is written under a temporary name and then renamed, so an
+    existing snapshot at `path` is only replaced by a complete one.
+    Version 2 maps are not supported.
+*/
+bool
+writeLedgerSnapshot (Ledger const& ledger, std::string const& path,
+    beast::Journal j);
+
+/** Returns `true` if the file starts like a ledger snapshot. */
+bool
+isLedgerSnapshot (std::string const& path);
+
+/** Returns the header of the ledger in a snapshot file. */
+boost::optional<LedgerInfo>
+readLedgerSnapshotInfo (std::string const& path);
+
+/** Load a ledger from a snapshot file.
+
+    The maps are built from the sorted leaves, with the subtrees
+    hashed in parallel, and checked against the stored inner node
+    hashes and the ledger header. The nodes are then stored in the
+    NodeStore.
+
+    @return `nullptr` if the snapshot can't be read or doesn't check.
+*/
+std::shared_ptr<Ledger>
+loadLedgerSnapshot (std::string const& path, Config const& config,
+    Family& family, beast::Journal j);
+
+} // ripple
+
+#endif
@@ -28,10 +28,17 @@
 
 namespace ripple {
 
+// The most books the index will hold
+static std::size_t const maxIndexedBooks = 256;
+
+// Books not asked for in this many ledgers are dropped from the index
+static std::uint32_t const maxIdleBooks = 256;
+
 OrderBookDB::OrderBookDB (Application& app, Stoppable& parent)
     : Stoppable ("OrderBookDB", parent)
     , app_ (app)
     , mSeq (0)
+    , mBookIndex (maxIndexedBooks, maxIdleBooks)
     , j_ (app.journal ("OrderBookDB"))
 {
 }
@@ -232,6 +239,51 @@ BookListeners::pointer OrderBookDB::getBookListeners (Book const& book)
     return ret;
 }
 
+std::shared_ptr<BookIndex::Offers const>
+OrderBookDB::getBookOffers (ReadView const& ledger, Book const& book)
+{
+    return mBookIndex.find (ledger, book,
+        [&]()
+        {
+            return BookIndex::build (ledger, book, j_);
+        });
+}
+
+void OrderBookDB::updateBookIndex (
+    std::shared_ptr<ReadView const> const& ledger)
+{
+    mBookIndex.update (
+        [&](std::shared_ptr<BookIndex const> const& current)
+        {
+            std::shared_ptr<BookIndex const> next;
+
+            if (current)
+            {
+                if (current->hash () == ledger->info().hash)
+                    return next;
+
+                try
+                {
+                    next = current->advance (*ledger, j_);
+                }
+                catch (std::exception const& e)
+                {
+                    JLOG (j_.warn())
+                        << "OrderBookDB::updateBookIndex: " << e.what ();
+                }
+            }
+
+            if (! next)
+                next = std::make_shared<BookIndex const> (ledger->info());
+
+            JLOG (j_.trace())
+                << "Book index at " << next->seq () << ", "
+                << next->size () << " books";
+
+            return next;
+        });
+}
+
 // Based on the meta, send the meta to the streams that are listening.
 // We need to determine which streams a given meta effects.
 void OrderBookDB::processTxn (
@@ -21,7 +21,9 @@
 #define RIPPLE_APP_LEDGER_ORDERBOOKDB_H_INCLUDED
 
 #include <ripple/app/ledger/AcceptedLedgerTx.h>
+#include <ripple/app/ledger/BookIndex.h>
 #include <ripple/app/ledger/BookListeners.h>
+#include <ripple/app/ledger/IncrementalIndex.h>
 #include <ripple/app/main/Application.h>
 #include <ripple/app/misc/OrderBook.h>
 #include <mutex>
@@ -53,6 +55,16 @@ public:
     BookListeners::pointer getBookListeners (Book const&);
     BookListeners::pointer makeBookListeners (Book const&);
 
+    /** Returns the offers in a book from the book index.
+        A book is read into the index the first time it is asked for.
+        @return `nullptr` if the index does not cover this ledger.
+    */
+    std::shared_ptr<BookIndex::Offers const>
+    getBookOffers (ReadView const& ledger, Book const& book);
+
+    /** Advance the book index to a newly published ledger. */
+    void updateBookIndex (std::shared_ptr<ReadView const> const& ledger);
+
     // see if this txn effects any orderbook
     void processTxn (
         std::shared_ptr<ReadView const> const& ledger,
@@ -82,6 +94,8 @@ private:
 
     std::uint32_t mSeq;
 
+    PublishedIndex <Book, BookIndex> mBookIndex;
+
     beast::Journal j_;
 };
 
@@ -611,10 +611,26 @@ void InboundLedger::trigger (std::shared_ptr<Peer> const& peer, TriggerReason re
             AccountStateSF filter(mLedger->stateMap().family(),
                 app_.getLedgerMaster());
 
-            // Release the lock while we process the large state map
+            std::size_t const limit = (reason == TriggerReason::reply)
+                ? reqNodesReply
+                : reqNodes;
+
+            // Release the lock while we process the large state map. Stop
+            // as soon as we have enough nodes we haven't recently asked
+            // for, so the request goes out while reads are still pending.
+            std::vector<std::pair<SHAMapNodeID, uint256>> nodes;
+            std::size_t fresh = 0;
             sl.unlock();
-            auto nodes = mLedger->stateMap().getMissingNodes (
-                missingNodesFind, &filter);
+            mLedger->stateMap().getMissingNodes (missingNodesFind, &filter,
+                [&](SHAMapNodeID const& nodeID, uint256 const& hash)
+                {
+                    nodes.emplace_back (nodeID, hash);
+
+                    ScopedLockType rl (mLock);
+                    if (mRecentNodes.count (hash) == 0)
+                        ++fresh;
+                    return fresh < limit;
+                });
             sl.lock();
 
             // Make sure nothing happened while we released the lock
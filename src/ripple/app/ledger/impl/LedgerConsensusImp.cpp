@@ -1255,8 +1255,8 @@ LedgerConsensusImp<Traits>::makeInitialPosition () ->
     {
         Serializer s (2048);
         tx.first->add(s);
-        initialSet->addItem (
-            SHAMapItem (tx.first->getTransactionID(), std::move (s)), true, false);
+        initialSet->addGiveItem (
+            make_shamapitem (tx.first->getTransactionID(), s.slice()), true, false);
     }
 
     // Add pseudo-transactions to the set
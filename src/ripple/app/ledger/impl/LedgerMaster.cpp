@@ -38,6 +38,7 @@
 #include <ripple/basics/Log.h>
 #include <ripple/basics/TaggedCache.h>
 #include <ripple/basics/UptimeTimer.h>
+#include <ripple/core/ConfigSections.h>
 #include <ripple/core/TimeKeeper.h>
 #include <ripple/overlay/Overlay.h>
 #include <ripple/overlay/Peer.h>
@@ -94,6 +95,13 @@ LedgerMaster::LedgerMaster (Application& app, Stopwatch& stopwatch,
     , fetch_packs_ ("FetchPack", 65536, 45, stopwatch,
         app_.journal("TaggedCache"))
     , fetch_seq_ (0)
+    , fetch_pack_segments_ ("FetchPackSegment", 256, 90, stopwatch,
+        app_.journal("TaggedCache"))
+    , lastFetchPackRequest_ (0)
+    , fetchPackPending_ (false)
+    , snapshot_ (setup_LedgerSnapshot (
+        app_.config().section (SECTION_LEDGER_SNAPSHOT)))
+    , snapshotPending_ (false)
 {
 }
 
@@ -236,10 +244,66 @@ LedgerMaster::setValidLedger(
 
     app_.getOPs().updateLocalTx (*l);
     app_.getSHAMapStore().onLedgerClosed (getValidatedLedger());
+    snapshotLedger (l);
+    prebuildFetchPack (l);
     mLedgerHistory.validatedLedger (l);
     app_.getAmendmentTable().doValidatedLedger (l);
 }
 
+void
+LedgerMaster::snapshotLedger (
+    std::shared_ptr<Ledger const> const& l)
+{
+    if (snapshot_.interval == 0 || (l->info().seq % snapshot_.interval) != 0)
+        return;
+
+    // Skip this one if the last snapshot is still being written
+    if (snapshotPending_.exchange (true))
+        return;
+
+    app_.getJobQueue ().addJob (
+        jtSNAPSHOT, "writeSnapshot",
+        [this, l] (Job&)
+        {
+            writeLedgerSnapshot (*l, snapshot_.path, m_journal);
+            snapshotPending_ = false;
+        });
+}
+
+void
+LedgerMaster::prebuildFetchPack (
+    std::shared_ptr<Ledger const> const& l)
+{
+    // Peers that fall behind ask for packs from the ledgers we just
+    // validated, so while they are asking, build those in advance.
+    auto const last = lastFetchPackRequest_.load ();
+    if (standalone_ || last == 0 ||
+            UptimeTimer::getInstance ().getElapsedSeconds () > last + 60)
+        return;
+
+    if (app_.getFeeTrack ().isLoadedLocal ())
+        return;
+
+    if (fetchPackPending_.exchange (true))
+        return;
+
+    app_.getJobQueue ().addJob (
+        jtPACK, "prebuildFetchPack",
+        [this, l] (Job&)
+        {
+            try
+            {
+                if (auto parent = getLedgerByHash (l->info().parentHash))
+                    getFetchPackSegment (l, parent);
+            }
+            catch (std::exception const&)
+            {
+                JLOG(m_journal.warn()) << "Exception building fetch pack";
+            }
+            fetchPackPending_ = false;
+        });
+}
+
 void
 LedgerMaster::setPubLedger(
     std::shared_ptr<Ledger const> const& l)
@@ -1510,6 +1574,7 @@ LedgerMaster::sweep ()
 {
     mLedgerHistory.sweep ();
     fetch_packs_.sweep ();
+    fetch_pack_segments_.sweep ();
 }
 
 float
@@ -1820,18 +1885,22 @@ LedgerMaster::makeFetchPack (
         return;
     }
 
-    if (app_.getFeeTrack ().isLoadedLocal () ||
-        (getValidatedLedgerAge() > 40s))
+    if (getValidatedLedgerAge() > 40s)
     {
         JLOG(m_journal.info()) << "Too busy to make fetch pack";
         return;
     }
 
+    // When loaded, we only serve segments that are already built
+    bool const loaded = app_.getFeeTrack ().isLoadedLocal ();
+
     auto peer = wPeer.lock ();
 
     if (!peer)
         return;
 
+    lastFetchPackRequest_ = UptimeTimer::getInstance ().getElapsedSeconds ();
+
     auto haveLedger = getLedgerByHash (haveLedgerHash);
 
     if (!haveLedger)
@@ -1872,18 +1941,6 @@ LedgerMaster::makeFetchPack (
     }
 
 
-    auto fpAppender = [](
-        protocol::TMGetObjectByHash* reply,
-        std::uint32_t ledgerSeq,
-        SHAMapHash const& hash,
-        const Blob& blob)
-    {
-        protocol::TMIndexedObject& newObj = * (reply->add_objects ());
-        newObj.set_ledgerseq (ledgerSeq);
-        newObj.set_hash (hash.as_uint256().begin (), 256 / 8);
-        newObj.set_data (&blob[0], blob.size ());
-    };
-
     try
     {
         protocol::TMGetObjectByHash reply;
@@ -1896,39 +1953,27 @@ LedgerMaster::makeFetchPack (
         reply.set_type (protocol::TMGetObjectByHash::otFETCH_PACK);
 
         // Building a fetch pack:
-        //  1. Add the header for the requested ledger.
-        //  2. Add the nodes for the AccountStateMap of that ledger.
-        //  3. If there are transactions, add the nodes for the
-        //     transactions of the ledger.
-        //  4. If the FetchPack now contains greater than or equal to
-        //     256 entries then stop.
-        //  5. If not very much time has elapsed, then loop back and repeat
+        //  1. Add the segment for the requested ledger: its header,
+        //     the nodes for its AccountStateMap and, if there are
+        //     transactions, the nodes for its transactions.
+        //  2. If the FetchPack now contains greater than or equal to
+        //     512 entries then stop.
+        //  3. If not very much time has elapsed, then loop back and repeat
         //     the same process adding the previous ledger to the FetchPack.
+        //
+        // Segments are cached and shared by all the peers that ask.
+        std::vector<std::shared_ptr<FetchPackSegment>> segments;
+        int objects = 0;
         do
         {
-            std::uint32_t lSeq = wantLedger->info().seq;
-
-            protocol::TMIndexedObject& newObj = *reply.add_objects ();
-            newObj.set_hash (
-                wantLedger->info().hash.data(), 256 / 8);
-            Serializer s (256);
-            s.add32 (HashPrefix::ledgerMaster);
-            addRaw(wantLedger->info(), s);
-            newObj.set_data (s.getDataPtr (), s.getLength ());
-            newObj.set_ledgerseq (lSeq);
-
-            wantLedger->stateMap().getFetchPack
-                (&haveLedger->stateMap(), true, 16384,
-                    std::bind (fpAppender, &reply, lSeq, std::placeholders::_1,
-                               std::placeholders::_2));
-
-            if (wantLedger->info().txHash.isNonZero ())
-                wantLedger->txMap().getFetchPack (
-                    nullptr, true, 512,
-                    std::bind (fpAppender, &reply, lSeq, std::placeholders::_1,
-                               std::placeholders::_2));
-
-            if (reply.objects ().size () >= 512)
+            auto segment = getFetchPackSegment (
+                haveLedger, wantLedger, ! loaded);
+            if (! segment)
+                break;
+            objects += segment->objects;
+            segments.push_back (std::move (segment));
+
+            if (objects >= 512)
                 break;
 
             // move may save a ref/unref
@@ -1938,9 +1983,21 @@ LedgerMaster::makeFetchPack (
         while (wantLedger &&
                UptimeTimer::getInstance ().getElapsedSeconds () <= uUptime + 1);
 
+        if (segments.empty ())
+        {
+            JLOG(m_journal.info()) << "Too busy to make fetch pack";
+            return;
+        }
+
+        std::vector<Slice> tail;
+        tail.reserve (segments.size ());
+        for (auto const& segment : segments)
+            tail.emplace_back (segment->data.data (), segment->data.size ());
+
         JLOG(m_journal.info())
-            << "Built fetch pack with " << reply.objects ().size () << " nodes";
-        auto msg = std::make_shared<Message> (reply, protocol::mtGET_OBJECTS);
+            << "Built fetch pack with " << objects << " nodes";
+        auto msg = std::make_shared<Message> (
+            reply, protocol::mtGET_OBJECTS, tail);
         peer->send (msg);
     }
     catch (std::exception const&)
@@ -1949,6 +2006,67 @@ LedgerMaster::makeFetchPack (
     }
 }
 
+auto
+LedgerMaster::getFetchPackSegment (
+    std::shared_ptr<Ledger const> const& haveLedger,
+    std::shared_ptr<Ledger const> const& wantLedger,
+    bool build) -> std::shared_ptr<FetchPackSegment>
+{
+    auto const& key = haveLedger->info().hash;
+    assert (wantLedger->info().hash == haveLedger->info().parentHash);
+
+    if (auto segment = fetch_pack_segments_.fetch (key))
+        return segment;
+
+    if (! build)
+        return {};
+
+    auto fpAppender = [](
+        protocol::TMGetObjectByHash* reply,
+        std::uint32_t ledgerSeq,
+        SHAMapHash const& hash,
+        const Blob& blob)
+    {
+        protocol::TMIndexedObject& newObj = * (reply->add_objects ());
+        newObj.set_ledgerseq (ledgerSeq);
+        newObj.set_hash (hash.as_uint256().begin (), 256 / 8);
+        newObj.set_data (&blob[0], blob.size ());
+    };
+
+    // Only the objects are set, so this serializes as
+    // fields that can be appended to any reply.
+    protocol::TMGetObjectByHash pack;
+
+    std::uint32_t lSeq = wantLedger->info().seq;
+
+    protocol::TMIndexedObject& newObj = *pack.add_objects ();
+    newObj.set_hash (
+        wantLedger->info().hash.data(), 256 / 8);
+    Serializer s (256);
+    s.add32 (HashPrefix::ledgerMaster);
+    addRaw(wantLedger->info(), s);
+    newObj.set_data (s.getDataPtr (), s.getLength ());
+    newObj.set_ledgerseq (lSeq);
+
+    wantLedger->stateMap().getFetchPack
+        (&haveLedger->stateMap(), true, 16384,
+            std::bind (fpAppender, &pack, lSeq, std::placeholders::_1,
+                       std::placeholders::_2));
+
+    if (wantLedger->info().txHash.isNonZero ())
+        wantLedger->txMap().getFetchPack (
+            nullptr, true, 512,
+            std::bind (fpAppender, &pack, lSeq, std::placeholders::_1,
+                       std::placeholders::_2));
+
+    auto segment = std::make_shared<FetchPackSegment> ();
+    segment->objects = pack.objects_size ();
+    pack.SerializePartialToString (&segment->data);
+
+    fetch_pack_segments_.canonicalize (key, segment);
+    return segment;
+}
+
 std::size_t
 LedgerMaster::getFetchPackCacheSize () const
 {
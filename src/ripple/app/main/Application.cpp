@@ -25,7 +25,9 @@
 #include <ripple/app/main/Tuning.h>
 #include <ripple/app/ledger/AcceptedLedger.h>
 #include <ripple/app/ledger/InboundLedgers.h>
+#include <ripple/app/ledger/IssuerBalancesDB.h>
 #include <ripple/app/ledger/LedgerMaster.h>
+#include <ripple/app/ledger/LedgerSnapshot.h>
 #include <ripple/app/ledger/LedgerToJson.h>
 #include <ripple/app/ledger/OpenLedger.h>
 #include <ripple/app/ledger/OrderBookDB.h>
@@ -72,6 +74,7 @@
 #include <ripple/resource/Fees.h>
 #include <ripple/rpc/Context.h>
 #include <ripple/rpc/RPCHandler.h>
+#include <ripple/rpc/impl/ResponseCache.h>
 #include <ripple/shamap/Family.h>
 #include <ripple/crypto/csprng.h>
 #include <ripple/beast/asio/io_latency_probe.h>
@@ -79,6 +82,7 @@
 #include <beast/core/detail/ci_char_traits.hpp>
 #include <boost/asio/signal_set.hpp>
 #include <boost/optional.hpp>
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <fstream>
@@ -332,6 +336,7 @@ public:
     std::unique_ptr <CollectorManager> m_collectorManager;
     detail::AppFamily family_;
     CachedSLEs cachedSLEs_;
+    RPC::ResponseCache responseCache_;
     std::pair<PublicKey, SecretKey> nodeIdentity_;
 
     std::unique_ptr <Resource::Manager> m_resourceManager;
@@ -340,6 +345,7 @@ public:
     std::unique_ptr <JobQueue> m_jobQueue;
     // VFALCO TODO Make OrderBookDB abstract
     OrderBookDB m_orderBookDB;
+    std::unique_ptr <IssuerBalancesDB> issuerBalances_;
     std::unique_ptr <PathRequests> m_pathRequests;
     std::unique_ptr <LedgerMaster> m_ledgerMaster;
     std::unique_ptr <InboundLedgers> m_inboundLedgers;
@@ -423,6 +429,8 @@ public:
 
         , cachedSLEs_ (std::chrono::minutes(1), stopwatch())
 
+        , responseCache_ (RPC::ResponseCache::Setup {}, stopwatch())
+
         , m_resourceManager (Resource::make_Manager (
             m_collectorManager->collector(), logs_->journal("Resource")))
 
@@ -431,7 +439,8 @@ public:
         //
         , m_jobQueue (std::make_unique<JobQueue>(
             m_collectorManager->group ("jobq"), m_nodeStoreScheduler,
-            logs_->journal("JobQueue"), *logs_))
+            logs_->journal("JobQueue"), *logs_,
+            setup_JobQueue (config_->section (SECTION_JOB_QUEUE))))
 
         //
         // Anything which calls addJob must be a descendant of the JobQueue
@@ -439,6 +448,8 @@ public:
 
         , m_orderBookDB (*this, *m_jobQueue)
 
+        , issuerBalances_ (std::make_unique<IssuerBalancesDB> (*this))
+
         , m_pathRequests (std::make_unique<PathRequests> (
             *this, logs_->journal("PathRequest"), m_collectorManager->collector ()))
 
@@ -655,6 +666,11 @@ public:
         return m_orderBookDB;
     }
 
+    IssuerBalancesDB& getIssuerBalancesDB () override
+    {
+        return *issuerBalances_;
+    }
+
     PathRequests& getPathRequests () override
     {
         return *m_pathRequests;
@@ -666,6 +682,12 @@ public:
         return cachedSLEs_;
     }
 
+    RPC::ResponseCache&
+    getResponseCache () override
+    {
+        return responseCache_;
+    }
+
     AmendmentTable& getAmendmentTable() override
     {
         return *m_amendmentTable;
@@ -848,6 +870,8 @@ public:
 
         m_overlay->saveValidatorKeyManifests (getWalletDB ());
 
+        issuerBalances_->save ();
+
         stopped ();
     }
 
@@ -909,6 +933,8 @@ public:
         m_acceptedLedgerCache.sweep();
         family().treecache().sweep();
         cachedSLEs_.expire();
+        responseCache_.sweep();
+        m_jobQueue->sweep();
 
         // VFALCO NOTE does the call to sweep() happen on another thread?
         m_sweepTimer.setExpiration (
@@ -929,6 +955,10 @@ private:
     loadLedgerFromFile (
         std::string const& ledgerID);
 
+    std::shared_ptr<Ledger>
+    loadConfiguredSnapshot (
+        std::shared_ptr<Ledger const> const& latest);
+
     bool loadOldLedger (
         std::string const& ledgerID,
         bool replay,
@@ -970,6 +1000,8 @@ bool ApplicationImp::setup()
     }
 
     logs_->silent (config_->silent());
+    logs_->startAsync (setup_LogsAsync (
+        config_->section (SECTION_LOG_QUEUE)));
 
     if (!config_->standalone())
         timeKeeper_->run(config_->SNTP_SERVERS);
@@ -1054,6 +1086,8 @@ bool ApplicationImp::setup()
 
     m_orderBookDB.setup (getLedgerMaster ().getCurrentLedger ());
 
+    issuerBalances_->load ();
+
     nodeIdentity_ = loadNodeIdentity (*this);
 
     if (!cluster_->load (config().section(SECTION_CLUSTER_NODES)))
@@ -1322,6 +1356,9 @@ std::shared_ptr<Ledger>
 ApplicationImp::loadLedgerFromFile (
     std::string const& name)
 {
+    if (isLedgerSnapshot (name))
+        return loadLedgerSnapshot (name, *config_, family(), m_journal);
+
     try
     {
         std::ifstream ledgerFile (name, std::ios::in);
@@ -1403,6 +1440,9 @@ ApplicationImp::loadLedgerFromFile (
             seq, closeTime, *config_, family());
         loadLedger->setTotalDrops(totalDrops);
 
+        SHAMap::SortedItems items;
+        items.reserve (ledger.get().size());
+
         for (Json::UInt index = 0; index < ledger.get().size(); ++index)
         {
             Json::Value& entry = ledger.get()[index];
@@ -1438,17 +1478,24 @@ ApplicationImp::loadLedgerFromFile (
             //             constructor is used, try to remove it
             STLedgerEntry sle (*stp.object, uIndex);
 
-            if (! loadLedger->addSLE (sle))
-            {
-                JLOG(m_journal.fatal())
-                   << "Couldn't add serialized ledger: "
-                   << uIndex;
-                return nullptr;
-            }
+            items.push_back (make_shamapitem (
+                sle.key(), sle.getSerializer().slice()));
         }
 
-        loadLedger->stateMap().flushDirty (
-            hotACCOUNT_NODE, loadLedger->info().seq);
+        // Build the state map in one pass and store it as it is built
+        std::sort (items.begin(), items.end(),
+            [](auto const& a, auto const& b)
+            {
+                return a->key() < b->key();
+            });
+
+        if (! loadLedger->stateMap().addSortedItems (
+                items, false, false, hotACCOUNT_NODE))
+        {
+            JLOG(m_journal.fatal())
+               << "Couldn't add serialized ledger: duplicate entries";
+            return nullptr;
+        }
 
         loadLedger->setAccepted (closeTime,
             closeTimeResolution, ! closeTimeEstimated,
@@ -1464,6 +1511,33 @@ ApplicationImp::loadLedgerFromFile (
     }
 }
 
+// Load the snapshot from [ledger_snapshot], if it is recent
+// enough to stand in for, or share most nodes with, `latest`
+std::shared_ptr<Ledger>
+ApplicationImp::loadConfiguredSnapshot (
+    std::shared_ptr<Ledger const> const& latest)
+{
+    auto const setup = setup_LedgerSnapshot (
+        config_->section (SECTION_LEDGER_SNAPSHOT));
+
+    if (setup.path.empty () || ! isLedgerSnapshot (setup.path))
+        return nullptr;
+
+    auto const info = readLedgerSnapshotInfo (setup.path);
+    if (! info)
+        return nullptr;
+
+    if (latest && (info->seq > latest->info().seq ||
+            latest->info().seq - info->seq > 16384))
+    {
+        JLOG(m_journal.info()) <<
+            "Not using snapshot of ledger " << info->seq;
+        return nullptr;
+    }
+
+    return loadLedgerSnapshot (setup.path, *config_, family(), m_journal);
+}
+
 bool ApplicationImp::loadOldLedger (
     std::string const& ledgerID, bool replay, bool isFileName)
 {
@@ -1471,6 +1545,10 @@ bool ApplicationImp::loadOldLedger (
     {
         std::shared_ptr<Ledger> loadLedger, replayLedger;
 
+        // Keeps the nodes of a snapshot in the tree cache while
+        // the ledger that shares them is walked
+        std::shared_ptr<Ledger> snapshot;
+
         if (isFileName)
         {
             if (!ledgerID.empty())
@@ -1498,6 +1576,11 @@ bool ApplicationImp::loadOldLedger (
         else if (ledgerID.empty () || beast::detail::ci_equal(ledgerID, "latest"))
         {
             loadLedger = getLastFullLedger ();
+            snapshot = loadConfiguredSnapshot (loadLedger);
+
+            if (snapshot && (! loadLedger ||
+                    snapshot->info().hash == loadLedger->info().hash))
+                loadLedger = snapshot;
         }
         else
         {
@@ -1858,16 +1941,17 @@ bool ApplicationImp::updateTables ()
     {
         auto j = logs_->journal("NodeObject");
         NodeStore::DummyScheduler scheduler;
+        auto const& section =
+            config_->section(ConfigSection::importNodeDatabase ());
         std::unique_ptr <NodeStore::Database> source =
             NodeStore::Manager::instance().make_Database ("NodeStore.import", scheduler,
-                j, 0,
-                config_->section(ConfigSection::importNodeDatabase ()));
+                j, 0, section);
 
         JLOG (j.warn())
             << "Node import from '" << source->getName () << "' to '"
             << getNodeStore ().getName () << "'.";
 
-        getNodeStore().import (*source);
+        getNodeStore().import (*source, NodeStore::setup_Importer (section));
     }
 
     return true;
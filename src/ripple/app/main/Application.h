@@ -35,6 +35,7 @@ namespace ripple {
 namespace unl { class Manager; }
 namespace Resource { class Manager; }
 namespace NodeStore { class Database; }
+namespace RPC { class ResponseCache; }
 
 // VFALCO TODO Fix forward declares required for header dependency loops
 class AmendmentTable;
@@ -47,6 +48,7 @@ class LoadFeeTrack;
 class JobQueue;
 class InboundLedgers;
 class InboundTransactions;
+class IssuerBalancesDB;
 class AcceptedLedger;
 class LedgerMaster;
 class LoadManager;
@@ -130,6 +132,7 @@ public:
     virtual LedgerMaster&           getLedgerMaster () = 0;
     virtual NetworkOPs&             getOPs () = 0;
     virtual OrderBookDB&            getOrderBookDB () = 0;
+    virtual IssuerBalancesDB&       getIssuerBalancesDB () = 0;
     virtual TransactionMaster&      getMasterTransaction () = 0;
 
     virtual
@@ -138,6 +141,7 @@ public:
 
     virtual Resource::Manager&      getResourceManager () = 0;
     virtual PathRequests&           getPathRequests () = 0;
+    virtual RPC::ResponseCache&     getResponseCache () = 0;
     virtual SHAMapStore&            getSHAMapStore () = 0;
     virtual PendingSaves&           pendingSaves() = 0;
     virtual AccountIDCache const&   accountIDCache() const = 0;
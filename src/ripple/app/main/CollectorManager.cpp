@@ -43,7 +43,28 @@ public:
                 get<std::string> (params, "address")));
             std::string const& prefix (get<std::string> (params, "prefix"));
 
-            m_collector = beast::insight::StatsDCollector::New (address, prefix, journal);
+            if (get<bool> (params, "aggregate", false))
+            {
+                m_collector = beast::insight::AggregatingCollector::New (
+                    beast::insight::make_UDPSink (address, journal), prefix,
+                        std::chrono::milliseconds (get<int> (
+                            params, "interval", 1000)), journal);
+            }
+            else
+            {
+                m_collector = beast::insight::StatsDCollector::New (
+                    address, prefix, journal);
+            }
+        }
+        else if (server == "file")
+        {
+            std::string const& prefix (get<std::string> (params, "prefix"));
+
+            m_collector = beast::insight::AggregatingCollector::New (
+                beast::insight::make_FileSink (
+                    get<std::string> (params, "path"), journal), prefix,
+                        std::chrono::milliseconds (get<int> (
+                            params, "interval", 1000)), journal);
         }
         else
         {
@@ -135,6 +135,15 @@ const char* WalletDBInit[] =
         RawData          BLOB NOT NULL               \
     );",
 
+    // Aggregated trust line balances of issuers,
+    // one row per issuer, all for the same ledger.
+    "CREATE TABLE IF NOT EXISTS IssuerBalances (    \
+        Issuer          CHARACTER(35) PRIMARY KEY,  \
+        LedgerSeq       BIGINT UNSIGNED,            \
+        LedgerHash      CHARACTER(64),              \
+        RawData         BLOB NOT NULL               \
+    );",
+
     // Old tables that were present in wallet.db and we
     // no longer need or use.
     "DROP INDEX IF EXISTS SeedNodeNext;",
@@ -235,7 +235,7 @@ FeeVoteImpl::doVoting(
         Serializer s;
         feeTx.add (s);
 
-        auto tItem = std::make_shared<SHAMapItem> (txID, s.peekData ());
+        auto tItem = make_shamapitem (txID, s.slice ());
 
         if (!initialPosition->addGiveItem (tItem, true, false))
         {
@@ -28,6 +28,7 @@
 #include <ripple/app/ledger/AcceptedLedger.h>
 #include <ripple/app/ledger/InboundLedger.h>
 #include <ripple/app/ledger/InboundLedgers.h>
+#include <ripple/app/ledger/IssuerBalancesDB.h>
 #include <ripple/app/ledger/LedgerMaster.h>
 #include <ripple/app/ledger/LedgerTiming.h>
 #include <ripple/app/ledger/LedgerToJson.h>
@@ -1843,7 +1844,7 @@ NetworkOPs::AccountTxs NetworkOPsImp::getAccountTxs (
         bUnlimited);
 
     {
-        auto db = app_.getTxnDB ().checkoutDb ();
+        auto db = app_.getTxnDB ().checkoutReadDb ();
 
         boost::optional<std::uint64_t> ledgerSeq;
         boost::optional<std::string> status;
@@ -1911,7 +1912,7 @@ std::vector<NetworkOPsImp::txnMetaLedgerType> NetworkOPsImp::getAccountTxsB (
         bUnlimited);
 
     {
-        auto db = app_.getTxnDB ().checkoutDb ();
+        auto db = app_.getTxnDB ().checkoutReadDb ();
 
         boost::optional<std::uint64_t> ledgerSeq;
         boost::optional<std::string> status;
@@ -2368,6 +2369,9 @@ void NetworkOPsImp::pubLedger (
         }
     }
 
+    app_.getOrderBookDB ().updateBookIndex (lpAccepted);
+    app_.getIssuerBalancesDB ().update (lpAccepted);
+
     // Don't lock since pubAcceptedTransaction is locking.
     for (auto const& vt : alpAccepted->getMap ())
     {
@@ -2882,6 +2886,141 @@ void NetworkOPsImp::getBookPage (
         isGlobalFrozen(view, book.out.account) ||
             isGlobalFrozen(view, book.in.account);
 
+    auto const rate = transferRate(view, book.out.account);
+    auto viewJ = app_.journal ("View");
+
+    // Offers in closed ledgers come from the book index when possible
+    auto const indexed = app_.getOrderBookDB ().getBookOffers (view, book);
+
+    auto addOffer = [&](std::shared_ptr<SLE const> const& sleOffer,
+        STAmount const& saDirRate)
+    {
+        auto const uOfferOwnerID =
+                sleOffer->getAccountID (sfAccount);
+        auto const& saTakerGets =
+                sleOffer->getFieldAmount (sfTakerGets);
+        auto const& saTakerPays =
+                sleOffer->getFieldAmount (sfTakerPays);
+        STAmount saOwnerFunds;
+        bool firstOwnerOffer (true);
+
+        if (book.out.account == uOfferOwnerID)
+        {
+            // If an offer is selling issuer's own IOUs, it is fully
+            // funded.
+            saOwnerFunds    = saTakerGets;
+        }
+        else if (bGlobalFreeze)
+        {
+            // If either asset is globally frozen, consider all offers
+            // that aren't ours to be totally unfunded
+            saOwnerFunds.clear (book.out);
+        }
+        else
+        {
+            auto umBalanceEntry  = umBalance.find (uOfferOwnerID);
+            if (umBalanceEntry != umBalance.end ())
+            {
+                // Found in running balance table.
+
+                saOwnerFunds    = umBalanceEntry->second;
+                firstOwnerOffer = false;
+            }
+            else
+            {
+                // Did not find balance in table.
+
+                auto const cached = indexed
+                    ? indexed->funds (uOfferOwnerID)
+                    : nullptr;
+
+                if (cached)
+                    saOwnerFunds = *cached;
+                else
+                    saOwnerFunds = accountHolds (view,
+                        uOfferOwnerID, book.out.currency,
+                            book.out.account, fhZERO_IF_FROZEN, viewJ);
+
+                if (saOwnerFunds < zero)
+                {
+                    // Treat negative funds as zero.
+
+                    saOwnerFunds.clear ();
+                }
+            }
+        }
+
+        Json::Value jvOffer = sleOffer->getJson (0);
+
+        STAmount saTakerGetsFunded;
+        STAmount saOwnerFundsLimit = saOwnerFunds;
+        Rate offerRate = parityRate;
+
+        if (rate != parityRate
+            // Have a tranfer fee.
+            && uTakerID != book.out.account
+            // Not taking offers of own IOUs.
+            && book.out.account != uOfferOwnerID)
+            // Offer owner not issuing ownfunds
+        {
+            // Need to charge a transfer fee to offer owner.
+            offerRate = rate;
+            saOwnerFundsLimit = divide (
+                saOwnerFunds, offerRate);
+        }
+
+        if (saOwnerFundsLimit >= saTakerGets)
+        {
+            // Sufficient funds no shenanigans.
+            saTakerGetsFunded   = saTakerGets;
+        }
+        else
+        {
+            // Only provide, if not fully funded.
+
+            saTakerGetsFunded = saOwnerFundsLimit;
+
+            saTakerGetsFunded.setJson (jvOffer[jss::taker_gets_funded]);
+            std::min (
+                saTakerPays, multiply (
+                    saTakerGetsFunded, saDirRate, saTakerPays.issue ())).setJson
+                    (jvOffer[jss::taker_pays_funded]);
+        }
+
+        STAmount saOwnerPays = (parityRate == offerRate)
+            ? saTakerGetsFunded
+            : std::min (
+                saOwnerFunds,
+                multiply (saTakerGetsFunded, offerRate));
+
+        umBalance[uOfferOwnerID]    = saOwnerFunds - saOwnerPays;
+
+        // Include all offers funded and unfunded
+        Json::Value& jvOf = jvOffers.append (jvOffer);
+        jvOf[jss::quality] = saDirRate.getText ();
+
+        if (firstOwnerOffer)
+            jvOf[jss::owner_funds] = saOwnerFunds.getText ();
+    };
+
+    if (indexed)
+    {
+        for (auto const& dir : indexed->directories ())
+        {
+            auto const saDirRate = amountFromQuality (getQuality (dir.first));
+
+            for (auto const& sleOffer : dir.second)
+            {
+                if (iLimit-- == 0)
+                    return;
+
+                addOffer (sleOffer, saDirRate);
+            }
+        }
+
+        return;
+    }
+
     bool            bDone           = false;
     bool            bDirectAdvance  = true;
 
@@ -2890,9 +3029,6 @@ void NetworkOPsImp::getBookPage (
     unsigned int    uBookEntry;
     STAmount        saDirRate;
 
-    auto const rate = transferRate(view, book.out.account);
-    auto viewJ = app_.journal ("View");
-
     while (! bDone && iLimit-- > 0)
     {
         if (bDirectAdvance)
@@ -2933,105 +3069,7 @@ void NetworkOPsImp::getBookPage (
 
             if (sleOffer)
             {
-                auto const uOfferOwnerID =
-                        sleOffer->getAccountID (sfAccount);
-                auto const& saTakerGets =
-                        sleOffer->getFieldAmount (sfTakerGets);
-                auto const& saTakerPays =
-                        sleOffer->getFieldAmount (sfTakerPays);
-                STAmount saOwnerFunds;
-                bool firstOwnerOffer (true);
-
-                if (book.out.account == uOfferOwnerID)
-                {
-                    // If an offer is selling issuer's own IOUs, it is fully
-                    // funded.
-                    saOwnerFunds    = saTakerGets;
-                }
-                else if (bGlobalFreeze)
-                {
-                    // If either asset is globally frozen, consider all offers
-                    // that aren't ours to be totally unfunded
-                    saOwnerFunds.clear (book.out);
-                }
-                else
-                {
-                    auto umBalanceEntry  = umBalance.find (uOfferOwnerID);
-                    if (umBalanceEntry != umBalance.end ())
-                    {
-                        // Found in running balance table.
-
-                        saOwnerFunds    = umBalanceEntry->second;
-                        firstOwnerOffer = false;
-                    }
-                    else
-                    {
-                        // Did not find balance in table.
-
-                        saOwnerFunds = accountHolds (view,
-                            uOfferOwnerID, book.out.currency,
-                                book.out.account, fhZERO_IF_FROZEN, viewJ);
-
-                        if (saOwnerFunds < zero)
-                        {
-                            // Treat negative funds as zero.
-
-                            saOwnerFunds.clear ();
-                        }
-                    }
-                }
-
-                Json::Value jvOffer = sleOffer->getJson (0);
-
-                STAmount saTakerGetsFunded;
-                STAmount saOwnerFundsLimit = saOwnerFunds;
-                Rate offerRate = parityRate;
-
-                if (rate != parityRate
-                    // Have a tranfer fee.
-                    && uTakerID != book.out.account
-                    // Not taking offers of own IOUs.
-                    && book.out.account != uOfferOwnerID)
-                    // Offer owner not issuing ownfunds
-                {
-                    // Need to charge a transfer fee to offer owner.
-                    offerRate = rate;
-                    saOwnerFundsLimit = divide (
-                        saOwnerFunds, offerRate);
-                }
-
-                if (saOwnerFundsLimit >= saTakerGets)
-                {
-                    // Sufficient funds no shenanigans.
-                    saTakerGetsFunded   = saTakerGets;
-                }
-                else
-                {
-                    // Only provide, if not fully funded.
-
-                    saTakerGetsFunded = saOwnerFundsLimit;
-
-                    saTakerGetsFunded.setJson (jvOffer[jss::taker_gets_funded]);
-                    std::min (
-                        saTakerPays, multiply (
-                            saTakerGetsFunded, saDirRate, saTakerPays.issue ())).setJson
-                            (jvOffer[jss::taker_pays_funded]);
-                }
-
-                STAmount saOwnerPays = (parityRate == offerRate)
-                    ? saTakerGetsFunded
-                    : std::min (
-                        saOwnerFunds,
-                        multiply (saTakerGetsFunded, offerRate));
-
-                umBalance[uOfferOwnerID]    = saOwnerFunds - saOwnerPays;
-
-                // Include all offers funded and unfunded
-                Json::Value& jvOf = jvOffers.append (jvOffer);
-                jvOf[jss::quality] = saDirRate.getText ();
-
-                if (firstOwnerOffer)
-                    jvOf[jss::owner_funds] = saOwnerFunds.getText ();
+                addOffer (sleOffer, saDirRate);
             }
             else
             {
@@ -46,6 +46,7 @@ public:
         bool advisoryDelete = false;
         std::uint32_t ledgerHistory = 0;
         Section nodeDatabase;
+        Section shardDatabase;
         std::string databasePath;
         std::uint32_t deleteBatch = 100;
         std::uint32_t backOff = 100;
@@ -78,6 +79,9 @@ public:
 
     /** The number of files that are needed. */
     virtual int fdlimit() const = 0;
+
+    /** The history shards, or nullptr if they are not configured. */
+    virtual NodeStore::ShardStore* getShards() = 0;
 };
 
 //------------------------------------------------------------------------------
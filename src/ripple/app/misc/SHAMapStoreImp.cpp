@@ -26,6 +26,8 @@
 #include <ripple/basics/contract.h>
 #include <ripple/core/ConfigSections.h>
 #include <ripple/core/ThreadEntry.h>
+#include <ripple/nodestore/FetchPriority.h>
+#include <ripple/shamap/SHAMapMissingNode.h>
 #include <boost/format.hpp>
 #include <boost/format.hpp>
 #include <boost/optional.hpp>
@@ -166,6 +168,8 @@ SHAMapStoreImp::SavedStateDB::setLastRotated (LedgerIndex seq)
 
 //------------------------------------------------------------------------------
 
+constexpr std::chrono::minutes SHAMapStoreImp::shardRetryDelay_;
+
 SHAMapStoreImp::SHAMapStoreImp (
         Application& app,
         Setup const& setup,
@@ -206,6 +210,12 @@ SHAMapStoreImp::SHAMapStoreImp (
 
         dbPaths();
     }
+
+    if (! get<std::string>(setup_.shardDatabase, "path").empty())
+    {
+        shards_ = NodeStore::make_ShardStore (setup_.shardDatabase,
+            scheduler_, nodeStoreJournal_);
+    }
 }
 
 std::unique_ptr <NodeStore::Database>
@@ -246,6 +256,12 @@ SHAMapStoreImp::makeDatabase (std::string const& name,
         fdlimit_ = db->fdlimit();
     }
 
+    if (shards_)
+    {
+        db->setShards (shards_);
+        fdlimit_ += shards_->fdlimit();
+    }
+
     return db;
 }
 
@@ -305,7 +321,13 @@ SHAMapStoreImp::run()
 void
 SHAMapStoreImp::runImpl()
 {
-    LedgerIndex lastRotated = state_db_.getState().lastRotated;
+    // Copying and archiving history is the heaviest reading the server
+    // does, and must not hold up consensus
+    NodeStore::ScopedFetchPriority const fetchPriority (
+        NodeStore::FetchPriority::client);
+
+    LedgerIndex lastRotated = setup_.deleteInterval ?
+        state_db_.getState().lastRotated : 0;
     netOPs_ = &app_.getOPs();
     ledgerMaster_ = &app_.getLedgerMaster();
     fullBelowCache_ = &app_.family().fullbelow();
@@ -340,6 +362,25 @@ SHAMapStoreImp::runImpl()
         }
 
         LedgerIndex validatedSeq = validatedLedger->info().seq;
+
+        if (shards_)
+        {
+            switch (archiveShards())
+            {
+                case Health::stopping:
+                    stopped();
+                    return;
+                case Health::unhealthy:
+                    continue;
+                case Health::ok:
+                default:
+                    ;
+            }
+        }
+
+        if (!setup_.deleteInterval)
+            continue;
+
         if (!lastRotated)
         {
             lastRotated = validatedSeq;
@@ -348,7 +389,8 @@ SHAMapStoreImp::runImpl()
 
         // will delete up to (not including) lastRotated)
         if (validatedSeq >= lastRotated + setup_.deleteInterval
-                && canDelete_ >= lastRotated - 1)
+                && canDelete_ >= lastRotated - 1
+                && archived (lastRotated))
         {
             JLOG(journal_.debug()) << "rotating  validatedSeq " << validatedSeq
                     << " lastRotated " << lastRotated << " deleteInterval "
@@ -449,6 +491,158 @@ SHAMapStoreImp::runImpl()
     }
 }
 
+SHAMapStoreImp::Health
+SHAMapStoreImp::archiveShards()
+{
+    // Only ledgers that are fully saved can be archived
+    std::uint32_t minSeq, maxSeq;
+    if (! ledgerMaster_->getValidatedRange (minSeq, maxSeq))
+        return health();
+
+    auto const now = std::chrono::steady_clock::now();
+    auto const perShard = shards_->ledgersPerShard();
+    for (auto index = maxSeq / perShard; index-- > 0;)
+    {
+        if (shards_->firstSeq (index) < minSeq)
+            break;
+
+        if (shards_->hasShard (index))
+            continue;
+
+        auto const retry = shardRetry_.find (index);
+        if (retry != shardRetry_.end() && now < retry->second)
+            continue;
+
+        return buildShard (index);
+    }
+
+    return health();
+}
+
+SHAMapStoreImp::Health
+SHAMapStoreImp::buildShard (std::uint32_t index)
+{
+    auto const firstSeq = shards_->firstSeq (index);
+    auto const lastSeq = shards_->lastSeq (index);
+    JLOG(journal_.info()) << "building shard " << index
+            << " from ledgers " << firstSeq << "-" << lastSeq;
+
+    auto writer = shards_->makeWriter (index);
+    NodeStore::Batch batch;
+    batch.reserve (shardBatchSize_);
+
+    // The first ledger of a shard copies its whole state map, so the
+    // batch is written out as it fills rather than once per ledger
+    auto flush = [&]()
+    {
+        if (batch.size() >= shardBatchSize_)
+        {
+            writer->store (batch);
+            batch.clear();
+        }
+    };
+
+    auto add = [&batch, &flush](NodeObjectType type)
+    {
+        return [&batch, &flush, type](SHAMapHash const& hash, Blob const& data)
+        {
+            batch.push_back (NodeObject::createObject (
+                type, Blob (data), hash.as_uint256()));
+            flush();
+        };
+    };
+
+    try
+    {
+        std::shared_ptr<Ledger const> prev;
+        for (auto seq = firstSeq; seq <= lastSeq; ++seq)
+        {
+            auto ledger = ledgerMaster_->getLedgerBySeq (seq);
+            if (! ledger ||
+                (prev && ledger->info().parentHash != prev->info().hash))
+            {
+                Throw<std::runtime_error> (
+                    "ledger " + std::to_string (seq) + " unavailable");
+            }
+
+            auto header = app_.getNodeStore().fetch (ledger->info().hash);
+            if (! header)
+            {
+                Throw<std::runtime_error> (
+                    "header of ledger " + std::to_string (seq) + " missing");
+            }
+            batch.push_back (std::move (header));
+
+            // Only the state nodes that changed since the previous
+            // ledger, which are in the shard already, need copying
+            ledger->stateMap().getFetchPack (
+                prev ? &prev->stateMap() : nullptr, true,
+                std::numeric_limits<int>::max(), add (hotACCOUNT_NODE));
+            ledger->txMap().getFetchPack (nullptr, true,
+                std::numeric_limits<int>::max(), add (hotTRANSACTION_NODE));
+
+            writer->addLedger (seq, ledger->info().hash);
+            prev = std::move (ledger);
+            flush();
+
+            if (! (seq % checkHealthInterval_))
+            {
+                auto const h = health();
+                if (h != Health::ok)
+                    return h;
+            }
+        }
+
+        writer->store (batch);
+        if (! writer->finalize())
+            Throw<std::runtime_error> ("shard could not be finalized");
+    }
+    catch (std::exception const& e)
+    {
+        // Often a ledger that is not available yet; try again later
+        JLOG(journal_.warn()) << "unable to archive shard " << index
+                << ": " << e.what();
+        shardRetry_[index] =
+            std::chrono::steady_clock::now() + shardRetryDelay_;
+        return health();
+    }
+
+    shardRetry_.erase (index);
+    JLOG(journal_.info()) << "finished shard " << index;
+    return health();
+}
+
+bool
+SHAMapStoreImp::archived (LedgerIndex seq)
+{
+    if (! shards_)
+        return true;
+
+    std::uint32_t minSeq, maxSeq;
+    if (! ledgerMaster_->getValidatedRange (minSeq, maxSeq))
+        return true;
+
+    // Every shard holding a ledger about to be deleted, that can
+    // still be built, must be finalized first. A shard that failed
+    // to build is retried rather than given up on.
+    for (auto index = shards_->shardIndex (std::max (minSeq, 1u));
+        shards_->firstSeq (index) < seq; ++index)
+    {
+        if (shards_->firstSeq (index) < minSeq ||
+                shards_->lastSeq (index) > maxSeq)
+            continue;
+
+        if (! shards_->hasShard (index))
+        {
+            JLOG(journal_.debug()) << "deferring rotation until shard "
+                    << index << " is built";
+            return false;
+        }
+    }
+
+    return true;
+}
+
 void
 SHAMapStoreImp::dbPaths()
 {
@@ -775,7 +969,7 @@ SHAMapStoreImp::health()
 void
 SHAMapStoreImp::onStop()
 {
-    if (setup_.deleteInterval)
+    if (runsThread())
     {
         {
             std::lock_guard <std::mutex> lock (mutex_);
@@ -792,7 +986,7 @@ SHAMapStoreImp::onStop()
 void
 SHAMapStoreImp::onChildrenStopped()
 {
-    if (setup_.deleteInterval)
+    if (runsThread())
     {
         {
             std::lock_guard <std::mutex> lock (mutex_);
@@ -837,6 +1031,8 @@ setup_SHAMapStore (Config const& c)
     get_if_exists (setup.nodeDatabase, "backOff", setup.backOff);
     get_if_exists (setup.nodeDatabase, "age_threshold", setup.ageThreshold);
 
+    setup.shardDatabase = c.section (SECTION_SHARD_DATABASE);
+
     return setup;
 }
 
@@ -27,7 +27,9 @@
 #include <ripple/nodestore/impl/Tuning.h>
 #include <ripple/nodestore/DatabaseRotating.h>
 #include <iostream>
+#include <chrono>
 #include <condition_variable>
+#include <map>
 #include <thread>
 
 
@@ -83,6 +85,10 @@ private:
     static std::uint32_t const minimumDeletionInterval_ = 256;
     // minimum # of ledgers required for standalone mode.
     static std::uint32_t const minimumDeletionIntervalSA_ = 8;
+    // # of objects passed to a shard at once
+    static std::size_t const shardBatchSize_ = 4096;
+    // time to wait before building a shard that failed again
+    static constexpr std::chrono::minutes shardRetryDelay_ {5};
 
     Setup setup_;
     NodeStore::Scheduler& scheduler_;
@@ -109,6 +115,10 @@ private:
     DatabaseCon* transactionDb_ = nullptr;
     DatabaseCon* ledgerDb_ = nullptr;
     int fdlimit_ = 0;
+    std::shared_ptr <NodeStore::ShardStore> shards_;
+    // shards that failed to build, and when to try them again
+    std::map <std::uint32_t,
+        std::chrono::steady_clock::time_point> shardRetry_;
 
 public:
     SHAMapStoreImp (Application& app,
@@ -171,6 +181,12 @@ public:
     void rendezvous() const override;
     int fdlimit() const override;
 
+    NodeStore::ShardStore*
+    getShards() override
+    {
+        return shards_.get();
+    }
+
 private:
     // callback for visitNodes
     bool copyNode (std::uint64_t& nodeCount, SHAMapAbstractNode const &node);
@@ -224,6 +240,14 @@ private:
     void freshenCaches();
     void clearPrior (LedgerIndex lastRotated);
 
+    // Build the newest complete shard that is missing, if any
+    Health archiveShards();
+    // Copy a range of ledgers into a new shard
+    Health buildShard (std::uint32_t index);
+    // Whether the ledgers prior to seq may be deleted without
+    // losing history that could still be archived to a shard
+    bool archived (LedgerIndex seq);
+
     // If rippled is not healthy, defer rotate-delete.
     // If already unhealthy, do not change state on further check.
     // Assume that, once unhealthy, a necessary step has been
@@ -238,10 +262,17 @@ private:
     {
     }
 
+    // Whether the background thread runs
+    bool
+    runsThread() const
+    {
+        return setup_.deleteInterval || shards_;
+    }
+
     void
     onStart() override
     {
-        if (setup_.deleteInterval)
+        if (runsThread())
             thread_ = std::thread (&SHAMapStoreImp::run, this);
     }
 
@@ -255,6 +255,10 @@ private:
         // to put each MaybeTx object into more than one
         // set without copies, pointers, etc.
         boost::intrusive::set_member_hook<> byFeeListHook;
+        // Used by the TxQ::ReadyHook and TxQ::ReadyMultiSet below.
+        // Only linked while this is the first (lowest sequence)
+        // transaction queued for its account.
+        boost::intrusive::set_member_hook<> byReadyListHook;
 
         std::shared_ptr<STTx const> txn;
 
@@ -361,6 +365,14 @@ private:
         < MaybeTx, FeeHook,
         boost::intrusive::compare <GreaterFee> >;
 
+    using ReadyHook = boost::intrusive::member_hook
+        <MaybeTx, boost::intrusive::set_member_hook<>,
+        &MaybeTx::byReadyListHook>;
+
+    using ReadyMultiSet = boost::intrusive::multiset
+        < MaybeTx, ReadyHook,
+        boost::intrusive::compare <GreaterFee> >;
+
     using AccountMap = std::map <AccountID, TxQAccount>;
 
     Setup const setup_;
@@ -368,6 +380,9 @@ private:
 
     FeeMetrics feeMetrics_;
     FeeMultiSet byFee_;
+    // The first queued transaction of every account, by fee level.
+    // These are the only candidates that can apply in accept().
+    ReadyMultiSet byReady_;
     AccountMap byAccount_;
     boost::optional<size_t> maxSize_;
 
@@ -387,13 +402,17 @@ private:
     // Erase and return the next entry in byFee_ (lower fee level)
     FeeMultiSet::iterator_type erase(FeeMultiSet::const_iterator_type);
     // Erase and return the next entry for the account (if fee level
-    // is higher), or next entry in byFee_ (lower fee level).
+    // is higher), or next entry in byReady_ (lower fee level).
     // Used to get the next "applyable" MaybeTx for accept().
-    FeeMultiSet::iterator_type eraseAndAdvance(FeeMultiSet::const_iterator_type);
+    ReadyMultiSet::iterator_type eraseAndAdvance(ReadyMultiSet::const_iterator_type);
     // Erase a range of items, based on TxQAccount::TxMap iterators
     TxQAccount::TxMap::iterator
     erase(TxQAccount& txQAccount, TxQAccount::TxMap::const_iterator begin,
         TxQAccount::TxMap::const_iterator end);
+    // Make sure the first transaction for the account, and
+    // only that one, is indexed in byReady_.
+    void
+    setReady(TxQAccount& txQAccount);
 
     /*
         All-or-nothing attempt to try to apply all the queued txs for `accountIter`
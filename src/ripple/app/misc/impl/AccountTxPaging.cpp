@@ -197,7 +197,7 @@ accountTxPage (
     }
 
     {
-        auto db (connection.checkoutDb());
+        auto db (connection.checkoutReadDb());
 
         Blob rawData;
         Blob rawMeta;
@@ -128,7 +128,7 @@ Transaction::pointer Transaction::load(uint256 const& id, Application& app)
     boost::optional<std::string> status;
     Blob rawTxn;
     {
-        auto db = app.getTxnDB ().checkoutDb ();
+        auto db = app.getTxnDB ().checkoutReadDb ();
         soci::blob sociRawTxnBlob (*db);
         soci::indicator rti;
 
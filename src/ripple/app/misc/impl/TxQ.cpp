@@ -331,6 +331,7 @@ TxQ::TxQ(Setup const& setup,
 
 TxQ::~TxQ()
 {
+    byReady_.clear();
     byFee_.clear();
 }
 
@@ -386,50 +387,55 @@ TxQ::erase(TxQ::FeeMultiSet::const_iterator_type candidateIter)
 {
     auto& txQAccount = byAccount_.at(candidateIter->account);
     auto const sequence = candidateIter->sequence;
+    if (candidateIter->byReadyListHook.is_linked())
+        byReady_.erase(byReady_.iterator_to(*candidateIter));
     auto const newCandidateIter = byFee_.erase(candidateIter);
     // Now that the candidate has been removed from the
-    // intrusive list remove it from the TxQAccount
+    // intrusive lists remove it from the TxQAccount
     // so the memory can be freed.
     auto const found = txQAccount.remove(sequence);
     (void)found;
     assert(found);
+    setReady(txQAccount);
 
     return newCandidateIter;
 }
 
 auto
-TxQ::eraseAndAdvance(TxQ::FeeMultiSet::const_iterator_type candidateIter)
-    -> FeeMultiSet::iterator_type
+TxQ::eraseAndAdvance(TxQ::ReadyMultiSet::const_iterator_type candidateIter)
+    -> ReadyMultiSet::iterator_type
 {
     auto& txQAccount = byAccount_.at(candidateIter->account);
     auto const accountIter = txQAccount.transactions.find(
         candidateIter->sequence);
     assert(accountIter != txQAccount.transactions.end());
     assert(accountIter == txQAccount.transactions.begin());
-    assert(byFee_.iterator_to(accountIter->second) == candidateIter);
+    assert(byReady_.iterator_to(accountIter->second) == candidateIter);
     auto const accountNextIter = std::next(accountIter);
     /* Check if the next transaction for this account has the
-        next sequence number, and a higher fee level, which means
-        we skipped it earlier, and need to try it again.
+        next sequence number, and a higher fee level than the next
+        ready candidate. It becomes ready as soon as the current
+        one is removed, and would otherwise be indexed before our
+        current position, so try it next.
         Edge cases: If the next account tx has a lower fee level,
-            it's going to be later in the fee queue, so we haven't
-            skipped it yet.
-            If the next tx has an equal fee level, it was either
-            submitted later, so it's also going to be later in the
-            fee queue, OR the current was resubmitted to bump up
-            the fee level, and we have skipped that next tx. In
-            the latter case, continue through the fee queue anyway
-            to head off potential ordering manipulation problems.
+            it's going to be indexed later in the ready queue, so
+            we'll get to it.
+            If the next tx has an equal fee level, it is indexed
+            after the other ready candidates of the same level, so
+            continue through the ready queue to head off potential
+            ordering manipulation problems.
     */
-    auto const feeNextIter = std::next(candidateIter);
+    auto const readyNextIter = std::next(candidateIter);
     bool const useAccountNext = accountNextIter != txQAccount.transactions.end() &&
         accountNextIter->first == candidateIter->sequence + 1 &&
-            (feeNextIter == byFee_.end() ||
-                accountNextIter->second.feeLevel > feeNextIter->feeLevel);
-    auto const candidateNextIter = byFee_.erase(candidateIter);
+            (readyNextIter == byReady_.end() ||
+                accountNextIter->second.feeLevel > readyNextIter->feeLevel);
+    auto const candidateNextIter = byReady_.erase(candidateIter);
+    byFee_.erase(byFee_.iterator_to(accountIter->second));
     txQAccount.transactions.erase(accountIter);
+    setReady(txQAccount);
     return useAccountNext ?
-        byFee_.iterator_to(accountNextIter->second) :
+        byReady_.iterator_to(accountNextIter->second) :
             candidateNextIter;
 
 }
@@ -442,9 +448,33 @@ TxQ::erase(TxQ::TxQAccount& txQAccount,
 {
     for (auto it = begin; it != end; ++it)
     {
+        if (it->second.byReadyListHook.is_linked())
+            byReady_.erase(byReady_.iterator_to(it->second));
         byFee_.erase(byFee_.iterator_to(it->second));
     }
-    return txQAccount.transactions.erase(begin, end);
+    auto const result = txQAccount.transactions.erase(begin, end);
+    setReady(txQAccount);
+    return result;
+}
+
+void
+TxQ::setReady(TxQ::TxQAccount& txQAccount)
+{
+    if (txQAccount.empty())
+        return;
+    auto const first = txQAccount.transactions.begin();
+    if (first->second.byReadyListHook.is_linked())
+        return;
+    // Transactions are added to the account one at a time,
+    // so if the first one changed, the previously indexed
+    // transaction can only be the second.
+    auto const second = std::next(first);
+    if (second != txQAccount.transactions.end() &&
+        second->second.byReadyListHook.is_linked())
+    {
+        byReady_.erase(byReady_.iterator_to(second->second));
+    }
+    byReady_.insert(first->second);
 }
 
 std::pair<TER, bool>
@@ -624,10 +654,10 @@ TxQ::apply(Application& app, OpenView& view,
     boost::optional<TxConsequences const> consequences;
     boost::optional<FeeMultiSet::iterator> replacedItemDeleteIter;
 
-    std::lock_guard<std::mutex> lock(mutex_);
-
     // We may need the base fee for multiple transactions
     // or transaction replacement, so just pull it up now.
+    // None of this depends on the queue contents, so do it
+    // before taking the lock.
     // TODO: Do we want to avoid doing it again during
     //   preclaim?
     auto const baseFee = calculateBaseFee(app, view, *tx, j);
@@ -635,6 +665,8 @@ TxQ::apply(Application& app, OpenView& view,
         baseLevel, baseFee, setup_);
     auto const requiredFeeLevel = feeMetrics_.scaleFeeLevel(view);
 
+    std::lock_guard<std::mutex> lock(mutex_);
+
     auto accountIter = byAccount_.find(account);
     bool const accountExists = accountIter != byAccount_.end();
 
@@ -1081,8 +1113,10 @@ TxQ::apply(Application& app, OpenView& view,
     */
     if (consequences)
         candidate.consequences.emplace(*consequences);
-    // Then index it into the byFee lookup.
+    // Then index it into the byFee lookup, and the byReady
+    // lookup if it's now first for the account.
     byFee_.insert(candidate);
+    setReady(accountIter->second);
     JLOG(j_.debug()) << "Added transaction " << candidate.txID <<
         " from " << (accountExists ? "existing" : "new") <<
             " account " << candidate.account << " to queue.";
@@ -1159,12 +1193,11 @@ TxQ::processClosedLedger(Application& app,
     0. Is `featureFeeEscalation` enabled?
         Yes: Continue to next step.
         No: Don't do anything to the open ledger. Stop.
-    1. Iterate over the txs from highest fee level to lowest.
-        For each tx:
-        a) Is this the first tx in the queue for this account?
-            No: Skip this tx. We'll come back to it later.
-            Yes: Continue to the next sub-step.
-        b) Is the tx fee level less than the current required
+    1. Iterate over the first tx queued for each account
+        (see `byReady_`) from highest fee level to lowest.
+        Txs behind the first for their account are never visited
+        until they become first. For each tx:
+        a) Is the tx fee level less than the current required
                 fee level?
             Yes: Stop iterating. Continue to the next step.
             No: Try to apply the transaction. Did it apply?
@@ -1183,7 +1216,7 @@ TxQ::processClosedLedger(Application& app,
     "Appropriate candidate" is defined as the tx that has the
         highest fee level of:
         * the tx for the current account with the next sequence.
-        * the next tx in the queue, simply ordered by fee.
+        * the next ready tx in `byReady_`, ordered by fee.
 */
 bool
 TxQ::accept(Application& app,
@@ -1207,20 +1240,11 @@ TxQ::accept(Application& app,
 
     std::lock_guard<std::mutex> lock(mutex_);
 
-    for (auto candidateIter = byFee_.begin(); candidateIter != byFee_.end();)
+    for (auto candidateIter = byReady_.begin(); candidateIter != byReady_.end();)
     {
         auto& account = byAccount_.at(candidateIter->account);
-        if (candidateIter->sequence >
-            account.transactions.begin()->first)
-        {
-            // This is not the first transaction for this account, so skip it.
-            // It can not succeed yet.
-            JLOG(j_.trace()) << "Skipping queued transaction " <<
-                candidateIter->txID << " from account " <<
-                candidateIter->account << " as it is not the first.";
-            candidateIter++;
-            continue;
-        }
+        assert(candidateIter->sequence ==
+            account.transactions.begin()->first);
         auto const requiredFeeLevel = feeMetrics_.scaleFeeLevel(view);
         auto const feeLevelPaid = candidateIter->feeLevel;
         JLOG(j_.trace()) << "Queued transaction " <<
@@ -1288,9 +1312,8 @@ TxQ::accept(Application& app,
                         transToken(txnResult) <<
                         ". Removing last item of account " <<
                         account.account;
-                    auto endIter = byFee_.iterator_to(dropRIter->second);
-                    assert(endIter != candidateIter);
-                    erase(endIter);
+                    assert(&dropRIter->second != &*candidateIter);
+                    erase(byFee_.iterator_to(dropRIter->second));
 
                 }
                 ++candidateIter;
@@ -24,6 +24,8 @@
 #include <beast/core/detail/ci_char_traits.hpp>
 #include <ripple/beast/utility/Journal.h>
 #include <boost/filesystem.hpp>
+#include <atomic>
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -31,6 +33,8 @@
 
 namespace ripple {
 
+class Section;
+
 // DEPRECATED use beast::severities::Severity instead
 enum LogSeverity
 {
@@ -48,6 +52,27 @@ enum LogSeverity
 /** Manages partitions for logging. */
 class Logs
 {
+public:
+    /** How lines are handed to the background writer. */
+    struct AsyncSetup
+    {
+        // Lines buffered for each logging thread. Zero to write
+        // each line on the thread that logs it.
+        std::size_t size = 0;
+
+        // Wait for room when a thread's buffer is full, instead
+        // of dropping the line.
+        bool block = false;
+    };
+
+    /** Totals for lines passed through the background writer. */
+    struct AsyncCounts
+    {
+        std::uint64_t written = 0;
+        std::uint64_t dropped = 0;
+        std::uint64_t blocked = 0;
+    };
+
 private:
     class Sink : public beast::Journal::Sink
     {
@@ -127,6 +152,9 @@ private:
         */
         void writeln (char const* text);
 
+        /** Flush buffered output to the system file. */
+        void flush ();
+
         /** Write to the log file using std::string. */
         /** @{ */
         void write (std::string const& str)
@@ -153,13 +181,16 @@ private:
     File file_;
     bool silent_ = false;
 
+    class AsyncWriter;
+    std::atomic<AsyncWriter*> async_;
+
 public:
     Logs(beast::severities::Severity level);
 
     Logs (Logs const&) = delete;
     Logs& operator= (Logs const&) = delete;
 
-    virtual ~Logs() = default;
+    virtual ~Logs();
 
     bool
     open (boost::filesystem::path const& pathToLogFile);
@@ -186,6 +217,29 @@ public:
     write (beast::severities::Severity level, std::string const& partition,
         std::string const& text, bool console);
 
+    /** Write lines from a background thread.
+
+        Each logging thread formats its line and places it in a
+        lock-free buffer of its own, so logging never waits on the
+        file or on other threads. A single thread collects the lines,
+        restores the order in which they were logged, and writes them
+        in batches. Fatal lines, and everything logged before them,
+        are written and flushed before `write` returns.
+
+        Call once, before logging starts in earnest. Does nothing
+        if `setup.size` is zero.
+    */
+    void
+    startAsync (AsyncSetup const& setup);
+
+    /** Write out all buffered lines. */
+    void
+    flush ();
+
+    /** Returns the background writer's totals. */
+    AsyncCounts
+    asyncCounts () const;
+
     std::string
     rotate();
 
@@ -246,6 +300,10 @@ private:
 #define JLOG(x) if (!x) { } else x
 #endif
 
+/** Returns the [log_queue] settings for the background log writer. */
+Logs::AsyncSetup
+setup_LogsAsync (Section const& section);
+
 //------------------------------------------------------------------------------
 // Debug logging:
 
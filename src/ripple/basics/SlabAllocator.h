@@ -0,0 +1,202 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_BASICS_SLABALLOCATOR_H_INCLUDED
+#define RIPPLE_BASICS_SLABALLOCATOR_H_INCLUDED
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ripple {
+
+/** Hands out fixed size blocks carved from large slabs.
+
+    Released blocks are kept on a free list and reused. Slabs are only
+    returned to the system when the allocator is destroyed, so memory use
+    tracks the peak number of live blocks, without the per-block headers
+    and fragmentation of the general purpose heap.
+*/
+class SlabAllocator
+{
+private:
+    // Blocks are aligned for any of the types they might hold
+    static std::size_t constexpr align = alignof (std::max_align_t);
+
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    std::size_t const size_;
+    std::size_t const perSlab_;
+
+    std::mutex mutex_;
+    FreeBlock* free_ = nullptr;
+    std::vector<std::unique_ptr<std::uint8_t[]>> slabs_;
+
+public:
+    /** Create an allocator.
+
+        @param size The size of each block. It is rounded up so that
+                    every block is suitably aligned.
+        @param slabSize The number of bytes to request from the heap
+                        each time the free list runs out.
+    */
+    SlabAllocator (std::size_t size, std::size_t slabSize)
+        : size_ (((std::max (size, sizeof (FreeBlock)) + align - 1) / align) * align)
+        , perSlab_ (std::max<std::size_t> (slabSize / size_, 1))
+    {
+    }
+
+    SlabAllocator (SlabAllocator const&) = delete;
+    SlabAllocator& operator= (SlabAllocator const&) = delete;
+
+    /** The size of each block. */
+    std::size_t
+    size () const
+    {
+        return size_;
+    }
+
+    /** Returns an uninitialized block. */
+    void*
+    allocate ()
+    {
+        std::lock_guard<std::mutex> lock (mutex_);
+
+        if (! free_)
+        {
+            // operator new[] returns storage aligned for max_align_t
+            slabs_.emplace_back (new std::uint8_t[size_ * perSlab_]);
+            auto const slab = slabs_.back ().get ();
+            for (std::size_t i = perSlab_; i != 0; --i)
+            {
+                auto const block =
+                    reinterpret_cast<FreeBlock*> (slab + (i - 1) * size_);
+                block->next = free_;
+                free_ = block;
+            }
+        }
+
+        auto const block = free_;
+        free_ = block->next;
+        return block;
+    }
+
+    /** Returns a block obtained from allocate to the free list. */
+    void
+    deallocate (void* p)
+    {
+        assert (p);
+        auto const block = static_cast<FreeBlock*> (p);
+
+        std::lock_guard<std::mutex> lock (mutex_);
+        block->next = free_;
+        free_ = block;
+    }
+
+    /** The number of bytes obtained from the heap. */
+    std::size_t
+    reserved ()
+    {
+        std::lock_guard<std::mutex> lock (mutex_);
+        return slabs_.size () * perSlab_ * size_;
+    }
+};
+
+/** A set of SlabAllocator with increasing block sizes.
+
+    A request is served from the smallest block that will hold it.
+    Requests larger than the largest block go to the heap.
+*/
+class SlabAllocatorSet
+{
+private:
+    std::vector<std::unique_ptr<SlabAllocator>> allocators_;
+
+    SlabAllocator*
+    find (std::size_t size) const
+    {
+        auto const iter = std::lower_bound (
+            allocators_.begin (), allocators_.end (), size,
+            [](std::unique_ptr<SlabAllocator> const& a, std::size_t s)
+            {
+                return a->size () < s;
+            });
+        if (iter == allocators_.end ())
+            return nullptr;
+        return iter->get ();
+    }
+
+public:
+    /** Create a set of allocators.
+
+        @param sizes The block size of each allocator.
+        @param slabSize The slab size used by every allocator.
+    */
+    SlabAllocatorSet (std::vector<std::size_t> sizes, std::size_t slabSize)
+    {
+        std::sort (sizes.begin (), sizes.end ());
+        sizes.erase (std::unique (sizes.begin (), sizes.end ()), sizes.end ());
+        allocators_.reserve (sizes.size ());
+        for (auto const size : sizes)
+            allocators_.push_back (
+                std::make_unique<SlabAllocator> (size, slabSize));
+    }
+
+    /** Returns an uninitialized block of at least `size` bytes. */
+    void*
+    allocate (std::size_t size)
+    {
+        if (auto const a = find (size))
+            return a->allocate ();
+        return ::operator new (size);
+    }
+
+    /** Releases a block.
+        `size` must be the value that was passed to allocate.
+    */
+    void
+    deallocate (void* p, std::size_t size)
+    {
+        if (auto const a = find (size))
+            a->deallocate (p);
+        else
+            ::operator delete (p);
+    }
+
+    /** The number of bytes the allocators obtained from the heap. */
+    std::size_t
+    reserved ()
+    {
+        std::size_t total = 0;
+        for (auto& a : allocators_)
+            total += a->reserved ();
+        return total;
+    }
+};
+
+} // ripple
+
+#endif
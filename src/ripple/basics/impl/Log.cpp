@@ -18,16 +18,24 @@
 //==============================================================================
 
 #include <BeastConfig.h>
+#include <ripple/basics/BasicConfig.h>
 #include <ripple/basics/chrono.h>
 #include <ripple/basics/Log.h>
 #include <ripple/basics/contract.h>
+#include <ripple/beast/core/Thread.h>
 #include <boost/algorithm/string.hpp>
+#include <algorithm>
 #include <cassert>
+#include <condition_variable>
 #include <fstream>
 #include <functional>
 #include <iostream>
+#include <iterator>
+#include <limits>
 #include <memory>
 #include <mutex>
+#include <thread>
+#include <vector>
 
 namespace ripple {
 
@@ -113,13 +121,341 @@ void Logs::File::writeln (char const* text)
     }
 }
 
+void Logs::File::flush ()
+{
+    if (m_stream != nullptr)
+        m_stream->flush ();
+}
+
+//------------------------------------------------------------------------------
+
+class Logs::AsyncWriter
+{
+private:
+    struct Entry
+    {
+        std::uint64_t seq;
+        std::string text;
+    };
+
+    static std::uint64_t constexpr noSeq =
+        std::numeric_limits<std::uint64_t>::max ();
+
+    // Lines from one thread. Only that thread pushes, and
+    // only the holder of drainMutex_ drains.
+    class Ring
+    {
+    private:
+        std::vector<Entry> slots_;
+        std::atomic<std::size_t> head_ {0};
+        std::atomic<std::size_t> tail_ {0};
+
+    public:
+        // Set when the thread that owns the ring exits
+        std::atomic<bool> closed {false};
+
+        // While the owner pushes a line, a bound on its sequence number
+        std::atomic<std::uint64_t> pending {noSeq};
+
+        explicit
+        Ring (std::size_t size)
+            : slots_ (size)
+        {
+        }
+
+        // Leaves `e` alone when the ring is full
+        bool
+        push (Entry& e)
+        {
+            auto const tail = tail_.load (std::memory_order_relaxed);
+            if (tail - head_.load (std::memory_order_acquire) == slots_.size ())
+                return false;
+            slots_[tail % slots_.size ()] = std::move (e);
+            tail_.store (tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool
+        halfFull () const
+        {
+            return tail_.load (std::memory_order_relaxed) -
+                head_.load (std::memory_order_acquire) >= slots_.size () / 2;
+        }
+
+        void
+        drain (std::vector<Entry>& out)
+        {
+            auto head = head_.load (std::memory_order_relaxed);
+            auto const tail = tail_.load (std::memory_order_acquire);
+            for (; head != tail; ++head)
+                out.push_back (std::move (slots_[head % slots_.size ()]));
+            head_.store (head, std::memory_order_release);
+        }
+    };
+
+    // The calling thread's rings, one for each writer it has logged to
+    struct ThreadRings
+    {
+        std::vector<std::pair<
+            std::uint64_t, std::shared_ptr<Ring>>> rings;
+
+        ~ThreadRings ()
+        {
+            for (auto const& r : rings)
+                r.second->closed = true;
+        }
+    };
+
+    static
+    ThreadRings&
+    threadRings ()
+    {
+        thread_local ThreadRings rings;
+        return rings;
+    }
+
+    static
+    std::uint64_t
+    nextId ()
+    {
+        static std::atomic<std::uint64_t> id {0};
+        return ++id;
+    }
+
+    Logs& logs_;
+    std::uint64_t const id_;
+    std::size_t const size_;
+    bool const block_;
+
+    std::atomic<std::uint64_t> seq_ {0};
+    std::atomic<std::uint64_t> written_ {0};
+    std::atomic<std::uint64_t> dropped_ {0};
+    std::atomic<std::uint64_t> blocked_ {0};
+
+    std::mutex ringsMutex_;
+    std::vector<std::shared_ptr<Ring>> rings_;
+
+    std::mutex drainMutex_;
+    std::vector<Entry> batch_;
+    // Lines logged after one that was not yet pushed
+    std::vector<Entry> held_;
+    std::string text_;
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    bool stop_ = false;
+    std::thread thread_;
+
+public:
+    AsyncWriter (Logs& logs, AsyncSetup const& setup)
+        : logs_ (logs)
+        , id_ (nextId ())
+        , size_ (setup.size)
+        , block_ (setup.block)
+    {
+        thread_ = std::thread (&AsyncWriter::run, this);
+    }
+
+    ~AsyncWriter ()
+    {
+        {
+            std::lock_guard<std::mutex> lock (mutex_);
+            stop_ = true;
+        }
+        cond_.notify_one ();
+        thread_.join ();
+        flush ();
+    }
+
+    void
+    write (beast::severities::Severity level, std::string text)
+    {
+        // Don't return until a fatal line, and
+        // everything before it, is in the file.
+        if (level == beast::severities::kFatal)
+        {
+            Entry e {seq_++, std::move (text)};
+            return flush (&e);
+        }
+
+        // Announce the line before numbering it, so that lines
+        // numbered after it are not written ahead of it.
+        auto& r = ring ();
+        r.pending = seq_.load ();
+        Entry e {seq_++, std::move (text)};
+
+        if (! r.push (e))
+        {
+            if (! block_)
+            {
+                r.pending = noSeq;
+                ++dropped_;
+                return;
+            }
+
+            ++blocked_;
+            do
+            {
+                cond_.notify_one ();
+                std::this_thread::yield ();
+            }
+            while (! r.push (e));
+        }
+        r.pending = noSeq;
+
+        if (r.halfFull ())
+            cond_.notify_one ();
+    }
+
+    // Write out everything buffered, followed by `last` if given
+    void
+    flush (Entry* last = nullptr)
+    {
+        writeBatch (true, last);
+    }
+
+    AsyncCounts
+    counts () const
+    {
+        AsyncCounts c;
+        c.written = written_;
+        c.dropped = dropped_;
+        c.blocked = blocked_;
+        return c;
+    }
+
+private:
+    // Write out the buffered lines. Unless `all` is set, lines logged
+    // after one which is still being pushed are held for the next batch.
+    void
+    writeBatch (bool all, Entry* last)
+    {
+        std::lock_guard<std::mutex> drain (drainMutex_);
+        batch_.clear ();
+        batch_.swap (held_);
+
+        auto watermark = noSeq;
+        {
+            std::lock_guard<std::mutex> lock (ringsMutex_);
+            if (! all)
+            {
+                // Every line numbered below this is either drained
+                // below, or was dropped
+                watermark = seq_.load ();
+                for (auto const& r : rings_)
+                    watermark = std::min (watermark, r->pending.load ());
+            }
+
+            for (auto iter = rings_.begin (); iter != rings_.end ();)
+            {
+                // Check before draining, so the last
+                // lines of an exiting thread aren't lost.
+                bool const closed = (*iter)->closed;
+                (*iter)->drain (batch_);
+                if (closed)
+                    iter = rings_.erase (iter);
+                else
+                    ++iter;
+            }
+        }
+
+        if (last)
+            batch_.push_back (std::move (*last));
+
+        if (batch_.empty ())
+            return;
+
+        // Lines from different threads are interleaved
+        // in the order they were logged.
+        std::sort (batch_.begin (), batch_.end (),
+            [](Entry const& a, Entry const& b)
+            {
+                return a.seq < b.seq;
+            });
+
+        auto const split = std::find_if (batch_.begin (), batch_.end (),
+            [watermark](Entry const& e)
+            {
+                return e.seq >= watermark;
+            });
+        held_.assign (std::make_move_iterator (split),
+            std::make_move_iterator (batch_.end ()));
+        batch_.erase (split, batch_.end ());
+
+        if (batch_.empty ())
+            return;
+
+        text_.clear ();
+        for (auto const& e : batch_)
+        {
+            text_ += e.text;
+            text_ += '\n';
+        }
+
+        {
+            std::lock_guard <std::mutex> lock (logs_.mutex_);
+            logs_.file_.write (text_);
+            logs_.file_.flush ();
+            if (! logs_.silent_)
+                std::cerr << text_;
+        }
+
+        written_ += batch_.size ();
+    }
+
+    Ring&
+    ring ()
+    {
+        auto& t = threadRings ();
+        for (auto const& r : t.rings)
+            if (r.first == id_)
+                return *r.second;
+
+        // Forget the rings of writers that are gone
+        t.rings.erase (std::remove_if (t.rings.begin (), t.rings.end (),
+            [](std::pair<std::uint64_t, std::shared_ptr<Ring>> const& r)
+            {
+                return r.second.use_count () == 1;
+            }), t.rings.end ());
+
+        auto r = std::make_shared<Ring> (size_);
+        {
+            std::lock_guard<std::mutex> lock (ringsMutex_);
+            rings_.push_back (r);
+        }
+        t.rings.emplace_back (id_, r);
+        return *r;
+    }
+
+    void
+    run ()
+    {
+        beast::Thread::setCurrentThreadName ("LogWriter");
+
+        std::unique_lock<std::mutex> lock (mutex_);
+        while (! stop_)
+        {
+            cond_.wait_for (lock, std::chrono::milliseconds (50));
+            lock.unlock ();
+            writeBatch (false, nullptr);
+            lock.lock ();
+        }
+    }
+};
+
 //------------------------------------------------------------------------------
 
 Logs::Logs(beast::severities::Severity thresh)
     : thresh_ (thresh) // default severity
+    , async_ (nullptr)
 {
 }
 
+Logs::~Logs()
+{
+    delete async_.exchange (nullptr);
+}
+
 bool
 Logs::open (boost::filesystem::path const& pathToLogFile)
 {
@@ -180,6 +516,10 @@ Logs::write (beast::severities::Severity level, std::string const& partition,
 {
     std::string s;
     format (s, text, level, partition);
+
+    if (auto const async = async_.load ())
+        return async->write (level, std::move (s));
+
     std::lock_guard <std::mutex> lock (mutex_);
     file_.writeln (s);
     if (! silent_)
@@ -189,6 +529,36 @@ Logs::write (beast::severities::Severity level, std::string const& partition,
     //    out_.write_console(s);
 }
 
+void
+Logs::startAsync (AsyncSetup const& setup)
+{
+    if (setup.size == 0)
+        return;
+
+    auto writer = std::make_unique<AsyncWriter> (*this, setup);
+    AsyncWriter* expected = nullptr;
+    if (async_.compare_exchange_strong (expected, writer.get ()))
+        writer.release ();
+}
+
+void
+Logs::flush ()
+{
+    if (auto const async = async_.load ())
+        async->flush ();
+
+    std::lock_guard <std::mutex> lock (mutex_);
+    file_.flush ();
+}
+
+Logs::AsyncCounts
+Logs::asyncCounts () const
+{
+    if (auto const async = async_.load ())
+        return async->counts ();
+    return {};
+}
+
 std::string
 Logs::rotate()
 {
@@ -345,6 +715,27 @@ Logs::format (std::string& output, std::string const& message,
 
 //------------------------------------------------------------------------------
 
+Logs::AsyncSetup
+setup_LogsAsync (Section const& section)
+{
+    Logs::AsyncSetup setup;
+    set (setup.size, "size", section);
+
+    std::string overflow;
+    if (set (overflow, "overflow", section))
+    {
+        if (boost::iequals (overflow, "block"))
+            setup.block = true;
+        else if (! boost::iequals (overflow, "drop"))
+            Throw<std::runtime_error> (
+                "Invalid [log_queue] overflow: " + overflow);
+    }
+
+    return setup;
+}
+
+//------------------------------------------------------------------------------
+
 class DebugSink
 {
 private:
@@ -0,0 +1,86 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of Beast: https://github.com/vinniefalco/Beast
+    Copyright 2013, Vinnie Falco <vinnie.falco@gmail.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef BEAST_INSIGHT_AGGREGATINGCOLLECTOR_H_INCLUDED
+#define BEAST_INSIGHT_AGGREGATINGCOLLECTOR_H_INCLUDED
+
+#include <ripple/beast/insight/Collector.h>
+
+#include <ripple/beast/utility/Journal.h>
+#include <ripple/beast/net/IPEndpoint.h>
+#include <chrono>
+#include <memory>
+#include <string>
+
+namespace beast {
+namespace insight {
+
+/** A Collector that aggregates metrics in place and reports periodically.
+
+    Updates never block and never post work to another thread: counters
+    and meters are spread over padded atomic shards, and events are
+    recorded into sharded log-linear histograms. At each interval the
+    shards are drained, and one line per metric is written to the sink
+    in StatsD format. Events are reported as percentiles and a maximum.
+    Values recorded since the last interval are written when the
+    collector is destroyed.
+*/
+class AggregatingCollector : public Collector
+{
+public:
+    /** Destination for the lines produced by each flush. */
+    class Sink
+    {
+    public:
+        virtual ~Sink() = default;
+
+        /** Write a block of newline terminated metric lines.
+            Called on the collector's thread, one flush at a time.
+        */
+        virtual void write (std::string const& lines) = 0;
+    };
+
+    /** Create an aggregating collector.
+        @param sink Where the aggregated metrics are written.
+        @param prefix A string pre-pended before each metric name.
+        @param interval Time between flushes. One second is used if
+                        this is not positive.
+        @param journal Destination for logging output.
+    */
+    static
+    std::shared_ptr <AggregatingCollector>
+    New (std::unique_ptr <Sink> sink, std::string const& prefix,
+        std::chrono::milliseconds interval, Journal journal);
+
+    /** Aggregate all metrics and write them to the sink now. */
+    virtual void flush () = 0;
+};
+
+/** Returns a Sink that sends metrics to a StatsD server over UDP. */
+std::unique_ptr <AggregatingCollector::Sink>
+make_UDPSink (IP::Endpoint const& address, Journal journal);
+
+/** Returns a Sink that appends metrics to a local file. */
+std::unique_ptr <AggregatingCollector::Sink>
+make_FileSink (std::string const& path, Journal journal);
+
+}
+}
+
+#endif
@@ -0,0 +1,199 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of Beast: https://github.com/vinniefalco/Beast
+    Copyright 2013, Vinnie Falco <vinnie.falco@gmail.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef BEAST_INSIGHT_HISTOGRAM_H_INCLUDED
+#define BEAST_INSIGHT_HISTOGRAM_H_INCLUDED
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+
+namespace beast {
+namespace insight {
+
+namespace detail {
+
+// Number of independent slots that sharded metrics spread
+// their updates over, to keep threads off each other's cache lines.
+static std::size_t constexpr shardCount = 8;
+
+// Each thread is assigned a shard the first time it updates a metric.
+inline
+std::size_t
+shardIndex ()
+{
+    static std::atomic <std::size_t> next (0);
+    thread_local std::size_t const index =
+        next.fetch_add (1, std::memory_order_relaxed) % shardCount;
+    return index;
+}
+
+/*  Log-linear histogram of durations, in the spirit of HdrHistogram.
+    Values below 16 each get their own bucket. Above that, every power
+    of two is split into 8 linear sub-buckets, which bounds the reported
+    error to 12.5%. Values are clamped to 2^32-1.
+
+    Recording is a relaxed atomic increment in the calling thread's
+    shard, so it is cheap enough for hot paths.
+*/
+class Histogram
+{
+public:
+    static std::size_t constexpr linear = 16;
+    static std::size_t constexpr subBits = 3;
+    static std::size_t constexpr subBuckets = 1 << subBits;
+    static std::size_t constexpr bucketCount =
+        linear + (32 - 4) * subBuckets;
+
+    using value_type = std::uint64_t;
+    using Counts = std::array <std::uint64_t, bucketCount>;
+
+    static
+    std::size_t
+    bucket (value_type value)
+    {
+        if (value >= (value_type (1) << 32))
+            value = (value_type (1) << 32) - 1;
+        if (value < linear)
+            return static_cast <std::size_t> (value);
+        int exponent = 63;
+        while (! (value & (value_type (1) << exponent)))
+            --exponent;
+        auto const sub = (value >> (exponent - subBits)) & (subBuckets - 1);
+        return linear + (exponent - 4) * subBuckets + sub;
+    }
+
+    // Returns the highest value that maps to the given bucket
+    static
+    value_type
+    highest (std::size_t index)
+    {
+        if (index < linear)
+            return index;
+        auto const exponent = 4 + (index - linear) / subBuckets;
+        auto const sub = (index - linear) % subBuckets;
+        auto const width = value_type (1) << (exponent - subBits);
+        return ((subBuckets + sub) << (exponent - subBits)) + width - 1;
+    }
+
+    void record (value_type value)
+    {
+        auto& shard = shards_[shardIndex ()];
+        shard.counts[bucket (value)].fetch_add (1, std::memory_order_relaxed);
+        auto max = shard.max.load (std::memory_order_relaxed);
+        while (value > max && ! shard.max.compare_exchange_weak (
+            max, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    // Moves the recorded values into `counts`, returns the maximum.
+    value_type drain (Counts& counts)
+    {
+        counts.fill (0);
+        value_type max (0);
+        for (auto& shard : shards_)
+        {
+            for (std::size_t i = 0; i < bucketCount; ++i)
+                counts[i] += shard.counts[i].exchange (
+                    0, std::memory_order_relaxed);
+            max = std::max (max, shard.max.exchange (
+                0, std::memory_order_relaxed));
+        }
+        return max;
+    }
+
+    // Copies the recorded values into `counts`, returns the maximum.
+    value_type snapshot (Counts& counts) const
+    {
+        counts.fill (0);
+        value_type max (0);
+        for (auto const& shard : shards_)
+        {
+            for (std::size_t i = 0; i < bucketCount; ++i)
+                counts[i] += shard.counts[i].load (
+                    std::memory_order_relaxed);
+            max = std::max (max, shard.max.load (
+                std::memory_order_relaxed));
+        }
+        return max;
+    }
+
+    // Returns the number of recorded values
+    std::uint64_t count () const
+    {
+        std::uint64_t total (0);
+        for (auto const& shard : shards_)
+            for (auto const& count : shard.counts)
+                total += count.load (std::memory_order_relaxed);
+        return total;
+    }
+
+    void clear ()
+    {
+        Counts counts;
+        drain (counts);
+    }
+
+    // Returns the value at or below which `percent` of the samples fall
+    static
+    value_type
+    percentile (Counts const& counts, std::uint64_t total,
+        value_type max, double percent)
+    {
+        assert (total > 0);
+        auto const target = static_cast <std::uint64_t> (
+            std::ceil (total * percent / 100));
+        std::uint64_t seen (0);
+        for (std::size_t i = 0; i < bucketCount; ++i)
+        {
+            seen += counts[i];
+            if (seen >= target && seen > 0)
+                return std::min (highest (i), max);
+        }
+        return max;
+    }
+
+private:
+    struct Shard
+    {
+        std::array <std::atomic <std::uint64_t>, bucketCount> counts;
+        std::atomic <value_type> max;
+        char pad [64];
+
+        Shard ()
+            : max (0)
+        {
+            for (auto& count : counts)
+                count.store (0, std::memory_order_relaxed);
+        }
+    };
+
+    std::array <Shard, shardCount> shards_;
+};
+
+} // detail
+
+} // insight
+} // beast
+
+#endif
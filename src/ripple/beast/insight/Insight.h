@@ -20,6 +20,7 @@
 #ifndef BEAST_INSIGHT_H_INCLUDED
 #define BEAST_INSIGHT_H_INCLUDED
 
+#include <ripple/beast/insight/AggregatingCollector.h>
 #include <ripple/beast/insight/Counter.h>
 #include <ripple/beast/insight/CounterImpl.h>
 #include <ripple/beast/insight/Event.h>
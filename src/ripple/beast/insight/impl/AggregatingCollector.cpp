@@ -0,0 +1,676 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of Beast: https://github.com/vinniefalco/Beast
+    Copyright 2013, Vinnie Falco <vinnie.falco@gmail.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <ripple/beast/insight/AggregatingCollector.h>
+#include <ripple/beast/insight/HookImpl.h>
+#include <ripple/beast/insight/CounterImpl.h>
+#include <ripple/beast/insight/EventImpl.h>
+#include <ripple/beast/insight/GaugeImpl.h>
+#include <ripple/beast/insight/Histogram.h>
+#include <ripple/beast/insight/MeterImpl.h>
+#include <ripple/beast/core/List.h>
+#include <ripple/beast/net/IPAddressConversion.h>
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/ip/udp.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace beast {
+namespace insight {
+
+namespace detail {
+
+// An atomic that occupies its own cache line.
+template <class T>
+struct PaddedAtomic
+{
+    std::atomic <T> value;
+    char pad [64 - sizeof (std::atomic <T>)];
+
+    PaddedAtomic ()
+        : value (0)
+    {
+    }
+};
+
+// A counter spread over several shards. Adding is a relaxed
+// atomic increment of the calling thread's shard, and draining
+// exchanges every shard with zero.
+template <class T>
+class ShardedValue
+{
+public:
+    void add (T amount)
+    {
+        shards_[shardIndex ()].value.fetch_add (
+            amount, std::memory_order_relaxed);
+    }
+
+    T drain ()
+    {
+        T total (0);
+        for (auto& shard : shards_)
+            total += shard.value.exchange (0, std::memory_order_relaxed);
+        return total;
+    }
+
+private:
+    std::array <PaddedAtomic <T>, shardCount> shards_;
+};
+
+//------------------------------------------------------------------------------
+
+class AggregatingCollectorImp;
+
+class AggregatingMetricBase : public List <AggregatingMetricBase>::Node
+{
+public:
+    virtual ~AggregatingMetricBase () = default;
+
+    // Append this metric's lines for the interval to `ss`
+    virtual void do_process (std::ostream& ss) = 0;
+};
+
+//------------------------------------------------------------------------------
+
+class AggregatingHookImpl
+    : public HookImpl
+    , public AggregatingMetricBase
+{
+public:
+    AggregatingHookImpl (HandlerType const& handler,
+        std::shared_ptr <AggregatingCollectorImp> const& impl);
+
+    ~AggregatingHookImpl ();
+
+    void do_process (std::ostream&) override;
+
+private:
+    AggregatingHookImpl& operator= (AggregatingHookImpl const&);
+
+    std::shared_ptr <AggregatingCollectorImp> m_impl;
+    HandlerType m_handler;
+};
+
+//------------------------------------------------------------------------------
+
+class AggregatingCounterImpl
+    : public CounterImpl
+    , public AggregatingMetricBase
+{
+public:
+    AggregatingCounterImpl (std::string const& name,
+        std::shared_ptr <AggregatingCollectorImp> const& impl);
+
+    ~AggregatingCounterImpl ();
+
+    void increment (CounterImpl::value_type amount) override;
+
+    void do_process (std::ostream& ss) override;
+
+private:
+    AggregatingCounterImpl& operator= (AggregatingCounterImpl const&);
+
+    std::shared_ptr <AggregatingCollectorImp> m_impl;
+    std::string m_name;
+    ShardedValue <CounterImpl::value_type> m_value;
+};
+
+//------------------------------------------------------------------------------
+
+class AggregatingEventImpl
+    : public EventImpl
+    , public AggregatingMetricBase
+{
+public:
+    AggregatingEventImpl (std::string const& name,
+        std::shared_ptr <AggregatingCollectorImp> const& impl);
+
+    ~AggregatingEventImpl ();
+
+    void notify (EventImpl::value_type const& value) override;
+
+    void do_process (std::ostream& ss) override;
+
+private:
+    AggregatingEventImpl& operator= (AggregatingEventImpl const&);
+
+    std::shared_ptr <AggregatingCollectorImp> m_impl;
+    std::string m_name;
+    Histogram m_histogram;
+};
+
+//------------------------------------------------------------------------------
+
+class AggregatingGaugeImpl
+    : public GaugeImpl
+    , public AggregatingMetricBase
+{
+public:
+    AggregatingGaugeImpl (std::string const& name,
+        std::shared_ptr <AggregatingCollectorImp> const& impl);
+
+    ~AggregatingGaugeImpl ();
+
+    void set (GaugeImpl::value_type value) override;
+    void increment (GaugeImpl::difference_type amount) override;
+
+    void do_process (std::ostream& ss) override;
+
+private:
+    AggregatingGaugeImpl& operator= (AggregatingGaugeImpl const&);
+
+    std::shared_ptr <AggregatingCollectorImp> m_impl;
+    std::string m_name;
+    std::atomic <GaugeImpl::value_type> m_value;
+    // Only touched by the collector, under its lock
+    GaugeImpl::value_type m_last_value;
+    bool m_reported;
+};
+
+//------------------------------------------------------------------------------
+
+class AggregatingMeterImpl
+    : public MeterImpl
+    , public AggregatingMetricBase
+{
+public:
+    AggregatingMeterImpl (std::string const& name,
+        std::shared_ptr <AggregatingCollectorImp> const& impl);
+
+    ~AggregatingMeterImpl ();
+
+    void increment (MeterImpl::value_type amount) override;
+
+    void do_process (std::ostream& ss) override;
+
+private:
+    AggregatingMeterImpl& operator= (AggregatingMeterImpl const&);
+
+    std::shared_ptr <AggregatingCollectorImp> m_impl;
+    std::string m_name;
+    ShardedValue <MeterImpl::value_type> m_value;
+};
+
+//------------------------------------------------------------------------------
+
+class AggregatingCollectorImp
+    : public AggregatingCollector
+    , public std::enable_shared_from_this <AggregatingCollectorImp>
+{
+private:
+    Journal m_journal;
+    std::unique_ptr <Sink> m_sink;
+    std::string m_prefix;
+    std::chrono::milliseconds m_interval;
+
+    // Only taken to register and unregister metrics, and to flush.
+    // Updates to the metrics themselves never take it.
+    std::recursive_mutex metricsLock_;
+    List <AggregatingMetricBase> hooks_;
+    List <AggregatingMetricBase> metrics_;
+    // Lines from metrics destroyed since the last flush
+    std::ostringstream removed_;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    bool m_stop;
+
+    // Must come last for order of init
+    std::thread m_thread;
+
+public:
+    AggregatingCollectorImp (
+        std::unique_ptr <Sink> sink,
+        std::string const& prefix,
+        std::chrono::milliseconds interval,
+        Journal journal)
+        : m_journal (journal)
+        , m_sink (std::move (sink))
+        , m_prefix (prefix)
+        , m_interval (interval > interval.zero () ?
+            interval : std::chrono::seconds (1))
+        , m_stop (false)
+        , m_thread (&AggregatingCollectorImp::run, this)
+    {
+        if (interval <= interval.zero ())
+        {
+            if (auto stream = m_journal.warn())
+                stream << "interval " << interval.count () <<
+                    "ms is not positive, using " << m_interval.count () <<
+                    "ms";
+        }
+    }
+
+    ~AggregatingCollectorImp ()
+    {
+        {
+            std::lock_guard <std::mutex> lock (m_mutex);
+            m_stop = true;
+        }
+        m_cond.notify_all ();
+        m_thread.join ();
+
+        // Report what was recorded since the last interval
+        flush ();
+    }
+
+    Hook make_hook (HookImpl::HandlerType const& handler) override
+    {
+        return Hook (std::make_shared <detail::AggregatingHookImpl> (
+            handler, shared_from_this ()));
+    }
+
+    Counter make_counter (std::string const& name) override
+    {
+        return Counter (std::make_shared <detail::AggregatingCounterImpl> (
+            name, shared_from_this ()));
+    }
+
+    Event make_event (std::string const& name) override
+    {
+        return Event (std::make_shared <detail::AggregatingEventImpl> (
+            name, shared_from_this ()));
+    }
+
+    Gauge make_gauge (std::string const& name) override
+    {
+        return Gauge (std::make_shared <detail::AggregatingGaugeImpl> (
+            name, shared_from_this ()));
+    }
+
+    Meter make_meter (std::string const& name) override
+    {
+        return Meter (std::make_shared <detail::AggregatingMeterImpl> (
+            name, shared_from_this ()));
+    }
+
+    //--------------------------------------------------------------------------
+
+    void add (AggregatingMetricBase& metric)
+    {
+        std::lock_guard <std::recursive_mutex> _(metricsLock_);
+        metrics_.push_back (metric);
+    }
+
+    void remove (AggregatingMetricBase& metric)
+    {
+        std::lock_guard <std::recursive_mutex> _(metricsLock_);
+        // Keep the values recorded since the last flush
+        metric.do_process (removed_);
+        metrics_.erase (metrics_.iterator_to (metric));
+    }
+
+    void add_hook (AggregatingMetricBase& hook)
+    {
+        std::lock_guard <std::recursive_mutex> _(metricsLock_);
+        hooks_.push_back (hook);
+    }
+
+    void remove_hook (AggregatingMetricBase& hook)
+    {
+        std::lock_guard <std::recursive_mutex> _(metricsLock_);
+        hooks_.erase (hooks_.iterator_to (hook));
+    }
+
+    std::string const& prefix () const
+    {
+        return m_prefix;
+    }
+
+    //--------------------------------------------------------------------------
+
+    void flush () override
+    {
+        std::lock_guard <std::recursive_mutex> _(metricsLock_);
+
+        std::ostringstream ss;
+        // Hooks update other metrics, so run them first
+        for (auto& h : hooks_)
+            h.do_process (ss);
+        for (auto& m : metrics_)
+            m.do_process (ss);
+
+        auto const lines = removed_.str () + ss.str ();
+        removed_.str ("");
+        if (lines.empty ())
+            return;
+
+        try
+        {
+            m_sink->write (lines);
+        }
+        catch (std::exception const& e)
+        {
+            if (auto stream = m_journal.error())
+                stream << "write failed: " << e.what ();
+        }
+    }
+
+    void run ()
+    {
+        std::unique_lock <std::mutex> lock (m_mutex);
+        while (! m_cond.wait_for (lock, m_interval,
+            [this] { return m_stop; }))
+        {
+            lock.unlock ();
+            flush ();
+            lock.lock ();
+        }
+    }
+};
+
+//------------------------------------------------------------------------------
+
+AggregatingHookImpl::AggregatingHookImpl (HandlerType const& handler,
+    std::shared_ptr <AggregatingCollectorImp> const& impl)
+    : m_impl (impl)
+    , m_handler (handler)
+{
+    m_impl->add_hook (*this);
+}
+
+AggregatingHookImpl::~AggregatingHookImpl ()
+{
+    m_impl->remove_hook (*this);
+}
+
+void AggregatingHookImpl::do_process (std::ostream&)
+{
+    m_handler ();
+}
+
+//------------------------------------------------------------------------------
+
+AggregatingCounterImpl::AggregatingCounterImpl (std::string const& name,
+    std::shared_ptr <AggregatingCollectorImp> const& impl)
+    : m_impl (impl)
+    , m_name (name)
+{
+    m_impl->add (*this);
+}
+
+AggregatingCounterImpl::~AggregatingCounterImpl ()
+{
+    m_impl->remove (*this);
+}
+
+void AggregatingCounterImpl::increment (CounterImpl::value_type amount)
+{
+    m_value.add (amount);
+}
+
+void AggregatingCounterImpl::do_process (std::ostream& ss)
+{
+    auto const value = m_value.drain ();
+    if (value != 0)
+        ss << m_impl->prefix () << "." << m_name << ":" <<
+            value << "|c\n";
+}
+
+//------------------------------------------------------------------------------
+
+AggregatingEventImpl::AggregatingEventImpl (std::string const& name,
+    std::shared_ptr <AggregatingCollectorImp> const& impl)
+    : m_impl (impl)
+    , m_name (name)
+{
+    m_impl->add (*this);
+}
+
+AggregatingEventImpl::~AggregatingEventImpl ()
+{
+    m_impl->remove (*this);
+}
+
+void AggregatingEventImpl::notify (EventImpl::value_type const& value)
+{
+    auto const count = value.count ();
+    m_histogram.record (count > 0 ?
+        static_cast <Histogram::value_type> (count) : 0);
+}
+
+void AggregatingEventImpl::do_process (std::ostream& ss)
+{
+    Histogram::Counts counts;
+    auto const max = m_histogram.drain (counts);
+    std::uint64_t total (0);
+    for (auto const count : counts)
+        total += count;
+    if (total == 0)
+        return;
+
+    auto const name = m_impl->prefix () + "." + m_name;
+    ss << name << ".count:" << total << "|c\n";
+    ss << name << ".p50:" <<
+        Histogram::percentile (counts, total, max, 50) << "|g\n";
+    ss << name << ".p90:" <<
+        Histogram::percentile (counts, total, max, 90) << "|g\n";
+    ss << name << ".p99:" <<
+        Histogram::percentile (counts, total, max, 99) << "|g\n";
+    ss << name << ".max:" << max << "|g\n";
+}
+
+//------------------------------------------------------------------------------
+
+AggregatingGaugeImpl::AggregatingGaugeImpl (std::string const& name,
+    std::shared_ptr <AggregatingCollectorImp> const& impl)
+    : m_impl (impl)
+    , m_name (name)
+    , m_value (0)
+    , m_last_value (0)
+    , m_reported (false)
+{
+    m_impl->add (*this);
+}
+
+AggregatingGaugeImpl::~AggregatingGaugeImpl ()
+{
+    m_impl->remove (*this);
+}
+
+void AggregatingGaugeImpl::set (GaugeImpl::value_type value)
+{
+    m_value.store (value, std::memory_order_relaxed);
+}
+
+void AggregatingGaugeImpl::increment (GaugeImpl::difference_type amount)
+{
+    auto value = m_value.load (std::memory_order_relaxed);
+    GaugeImpl::value_type next;
+    do
+    {
+        next = value;
+        if (amount > 0)
+        {
+            GaugeImpl::value_type const d (
+                static_cast <GaugeImpl::value_type> (amount));
+            next +=
+                (d >= std::numeric_limits <GaugeImpl::value_type>::max() - value)
+                ? std::numeric_limits <GaugeImpl::value_type>::max() - value
+                : d;
+        }
+        else if (amount < 0)
+        {
+            GaugeImpl::value_type const d (
+                static_cast <GaugeImpl::value_type> (-amount));
+            next = (d >= value) ? 0 : value - d;
+        }
+    }
+    while (! m_value.compare_exchange_weak (
+        value, next, std::memory_order_relaxed));
+}
+
+void AggregatingGaugeImpl::do_process (std::ostream& ss)
+{
+    auto const value = m_value.load (std::memory_order_relaxed);
+    if (m_reported && value == m_last_value)
+        return;
+    m_reported = true;
+    m_last_value = value;
+    ss << m_impl->prefix () << "." << m_name << ":" <<
+        value << "|g\n";
+}
+
+//------------------------------------------------------------------------------
+
+AggregatingMeterImpl::AggregatingMeterImpl (std::string const& name,
+    std::shared_ptr <AggregatingCollectorImp> const& impl)
+    : m_impl (impl)
+    , m_name (name)
+{
+    m_impl->add (*this);
+}
+
+AggregatingMeterImpl::~AggregatingMeterImpl ()
+{
+    m_impl->remove (*this);
+}
+
+void AggregatingMeterImpl::increment (MeterImpl::value_type amount)
+{
+    m_value.add (amount);
+}
+
+void AggregatingMeterImpl::do_process (std::ostream& ss)
+{
+    auto const value = m_value.drain ();
+    if (value != 0)
+        ss << m_impl->prefix () << "." << m_name << ":" <<
+            value << "|m\n";
+}
+
+//------------------------------------------------------------------------------
+
+class UDPSink : public AggregatingCollector::Sink
+{
+private:
+    enum
+    {
+        max_packet_size = 1472
+    };
+
+    Journal m_journal;
+    boost::asio::io_service m_io_service;
+    boost::asio::ip::udp::socket m_socket;
+    boost::asio::ip::udp::endpoint m_endpoint;
+
+public:
+    UDPSink (IP::Endpoint const& address, Journal journal)
+        : m_journal (journal)
+        , m_socket (m_io_service)
+        , m_endpoint (IP::to_asio_address (address), address.port ())
+    {
+        m_socket.open (m_endpoint.protocol ());
+    }
+
+    void write (std::string const& lines) override
+    {
+        // Break the lines up into blocks that
+        // each fit into one UDP packet.
+        std::size_t begin = 0;
+        while (begin < lines.size ())
+        {
+            std::size_t end = begin;
+            while (end < lines.size ())
+            {
+                auto next = lines.find ('\n', end);
+                next = (next == std::string::npos) ? lines.size () : next + 1;
+                if (end != begin && next - begin > max_packet_size)
+                    break;
+                end = next;
+            }
+
+            boost::system::error_code ec;
+            m_socket.send_to (boost::asio::buffer (
+                &lines[begin], end - begin), m_endpoint, 0, ec);
+            if (ec)
+            {
+                if (auto stream = m_journal.error())
+                    stream << "send_to failed: " << ec.message ();
+                return;
+            }
+            begin = end;
+        }
+    }
+};
+
+//------------------------------------------------------------------------------
+
+class FileSink : public AggregatingCollector::Sink
+{
+private:
+    Journal m_journal;
+    std::ofstream m_stream;
+
+public:
+    FileSink (std::string const& path, Journal journal)
+        : m_journal (journal)
+        , m_stream (path, std::ios::out | std::ios::app)
+    {
+        if (! m_stream)
+        {
+            if (auto stream = m_journal.error())
+                stream << "Unable to open " << path;
+        }
+    }
+
+    void write (std::string const& lines) override
+    {
+        if (m_stream)
+        {
+            m_stream << lines;
+            m_stream.flush ();
+        }
+    }
+};
+
+}
+
+//------------------------------------------------------------------------------
+
+std::shared_ptr <AggregatingCollector> AggregatingCollector::New (
+    std::unique_ptr <Sink> sink, std::string const& prefix,
+        std::chrono::milliseconds interval, Journal journal)
+{
+    return std::make_shared <detail::AggregatingCollectorImp> (
+        std::move (sink), prefix, interval, journal);
+}
+
+std::unique_ptr <AggregatingCollector::Sink>
+make_UDPSink (IP::Endpoint const& address, Journal journal)
+{
+    return std::make_unique <detail::UDPSink> (address, journal);
+}
+
+std::unique_ptr <AggregatingCollector::Sink>
+make_FileSink (std::string const& path, Journal journal)
+{
+    return std::make_unique <detail::FileSink> (path, journal);
+}
+
+}
+}
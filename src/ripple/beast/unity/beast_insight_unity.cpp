@@ -21,6 +21,7 @@
 
 #include <ripple/beast/insight/Insight.h>
 
+#include <ripple/beast/insight/impl/AggregatingCollector.cpp>
 #include <ripple/beast/insight/impl/Collector.cpp>
 #include <ripple/beast/insight/impl/Group.cpp>
 #include <ripple/beast/insight/impl/Groups.cpp>
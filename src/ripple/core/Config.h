@@ -142,6 +142,7 @@ public:
     bool                        LOCK_QUORUM = false;        // Do not raise the quorum
 
     // Peer networking parameters
+    bool                        PEER_COMPRESSION = true;        // True to send LZ4 compressed messages to peers that accept them.
     bool                        PEER_PRIVATE = false;           // True to ask peers not to relay current IP.
     int                         PEERS_MAX = 0;
 
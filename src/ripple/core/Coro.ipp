@@ -40,7 +40,8 @@ Coro(Coro_create_t, JobQueue& jq, JobType type,
 #ifndef NDEBUG
             finished_ = true;
 #endif
-        }, boost::coroutines::attributes (1024 * 1024))
+        }, boost::coroutines::attributes (jq.m_coroStacks->stackSize ()),
+        CoroStackPool::Allocator (jq.m_coroStacks))
 {
 }
 
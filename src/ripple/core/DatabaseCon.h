@@ -23,8 +23,13 @@
 #include <ripple/core/Config.h>
 #include <ripple/core/SociDB.h>
 #include <boost/filesystem/path.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
 
 namespace soci {
@@ -74,6 +79,59 @@ public:
 
 using LockedSociSession = LockedPointer<soci::session, std::recursive_mutex>;
 
+class DatabaseCon;
+
+/** A session checked out for reading.
+
+    The session is either borrowed from the pool of read-only
+    connections, and returned to it on destruction, or it is the
+    writer's session, held under the writer's lock.
+*/
+class ReadSociSession
+{
+private:
+    DatabaseCon* con_;
+    soci::session* it_;
+    std::unique_lock<LockedSociSession::mutex> lock_;
+
+public:
+    ReadSociSession (DatabaseCon& con, soci::session& it)
+        : con_ (&con), it_ (&it)
+    {
+    }
+    ReadSociSession (soci::session& it, LockedSociSession::mutex& m)
+        : con_ (nullptr), it_ (&it), lock_ (m)
+    {
+    }
+    ReadSociSession (ReadSociSession&& rhs) noexcept
+        : con_ (rhs.con_), it_ (rhs.it_), lock_ (std::move (rhs.lock_))
+    {
+        rhs.con_ = nullptr;
+    }
+    ReadSociSession () = delete;
+    ReadSociSession (ReadSociSession const& rhs) = delete;
+    ReadSociSession& operator=(ReadSociSession const& rhs) = delete;
+
+    ~ReadSociSession ();
+
+    soci::session* get ()
+    {
+        return it_;
+    }
+    soci::session& operator*()
+    {
+        return *it_;
+    }
+    soci::session* operator->()
+    {
+        return it_;
+    }
+    explicit operator bool() const
+    {
+        return bool (it_);
+    }
+};
+
 class DatabaseCon
 {
 public:
@@ -82,6 +140,23 @@ public:
         Config::StartUpType startUp = Config::NORMAL;
         bool standAlone = false;
         boost::filesystem::path dataDir;
+        /** Number of read-only connections kept open alongside the
+            writer. Zero sends readers to the writer's session.
+        */
+        std::size_t readConnections = 4;
+    };
+
+    /** Counters for the pool of read-only connections. */
+    struct ReadStats
+    {
+        /** Number of sessions checked out of the pool. */
+        std::uint64_t checkouts = 0;
+
+        /** Number of checkouts that had to wait for a session. */
+        std::uint64_t waits = 0;
+
+        /** Total time spent waiting, in microseconds. */
+        std::uint64_t waitMicroseconds = 0;
     };
 
     DatabaseCon (Setup const& setup,
@@ -99,15 +174,46 @@ public:
         return LockedSociSession (&session_, lock_);
     }
 
+    /** Check out a session for queries that do not write.
+
+        Readers share a pool of read-only connections and do not
+        contend with the writer. If there is no pool, because the
+        database is temporary or the pool is disabled, this returns
+        the writer's session under its lock.
+    */
+    ReadSociSession checkoutReadDb ();
+
+    ReadStats readStats () const;
+
     void setupCheckpointing (JobQueue*, Logs&);
 
 private:
+    friend class ReadSociSession;
+
+    void release (soci::session& session);
+
     LockedSociSession::mutex lock_;
 
     soci::session session_;
     std::unique_ptr<Checkpointer> checkpointer_;
+
+    std::vector<std::unique_ptr<soci::session>> readers_;
+    std::mutex readLock_;
+    std::condition_variable readCond_;
+    std::vector<soci::session*> idle_;
+
+    std::atomic<std::uint64_t> readCheckouts_ {0};
+    std::atomic<std::uint64_t> readWaits_ {0};
+    std::atomic<std::uint64_t> readWaitMicroseconds_ {0};
 };
 
+inline
+ReadSociSession::~ReadSociSession ()
+{
+    if (con_)
+        con_->release (*it_);
+}
+
 DatabaseCon::Setup
 setup_DatabaseCon (Config const& c);
 
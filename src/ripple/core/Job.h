@@ -36,6 +36,7 @@ enum JobType
     // earlier jobs having lower priority than later jobs. If you wish to
     // insert a job at a specific priority, simply add it at the right location.
 
+    jtSNAPSHOT,      // Write a ledger snapshot
     jtPACK,          // Make a fetch pack for a peer
     jtPUBOLDLEDGER,  // An old ledger has been accepted
     jtVALIDATION_ut, // A validation from an untrusted source
@@ -125,8 +126,16 @@ public:
 
     void doJob ();
 
+    /** Returns the type of the job running on the calling thread,
+        or jtINVALID if the thread is not running a job.
+    */
+    static JobType running ();
+
     void rename (std::string const& n);
 
+    /** Returns the name the job was queued or last renamed with. */
+    std::string const& getName () const;
+
     // These comparison operators make the jobs sort in priority order
     // in the job set
     bool operator< (const Job& j) const;
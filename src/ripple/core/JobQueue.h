@@ -20,11 +20,15 @@
 #ifndef RIPPLE_CORE_JOBQUEUE_H_INCLUDED
 #define RIPPLE_CORE_JOBQUEUE_H_INCLUDED
 
+#include <ripple/basics/BasicConfig.h>
 #include <ripple/basics/LocalValue.h>
 #include <ripple/basics/win32_workaround.h>
 #include <ripple/core/Job.h>
 #include <ripple/core/JobTypes.h>
 #include <ripple/core/JobTypeData.h>
+#include <ripple/core/JobTrace.h>
+#include <ripple/core/impl/CoroStackPool.h>
+#include <ripple/core/impl/JobSet.h>
 #include <ripple/core/impl/Workers.h>
 #include <ripple/json/json_value.h>
 #include <ripple/beast/insight/Collector.h>
@@ -32,8 +36,8 @@
 #include <boost/coroutine/all.hpp>
 #include <boost/function.hpp>
 #include <condition_variable>
+#include <memory>
 #include <mutex>
-#include <set>
 #include <thread>
 
 namespace ripple {
@@ -113,8 +117,38 @@ public:
 
     using JobFunction = std::function <void(Job&)>;
 
+    /** How queued jobs are stored until a worker runs them.
+
+        Either way, jobs run in priority order and the per-type limits
+        from JobTypes are honored.
+    */
+    enum class Scheduler
+    {
+        /** A single ordered set shared by all threads. */
+        locked,
+
+        /** Per-thread queues, with idle workers stealing from others.
+            A job that has waited longer than a bound for its type is
+            taken ahead of newer jobs.
+        */
+        stealing
+    };
+
+    /** Settings from the [job_queue] section. */
+    struct Setup
+    {
+        Scheduler scheduler = Scheduler::locked;
+
+        /** The size of each coroutine stack, in bytes. */
+        std::size_t coroStackSize = 1024 * 1024;
+
+        /** How many finished coroutine stacks to keep for reuse. */
+        std::size_t coroStackCache = 32;
+    };
+
     JobQueue (beast::insight::Collector::ptr const& collector,
-        Stoppable& parent, beast::Journal journal, Logs& logs);
+        Stoppable& parent, beast::Journal journal, Logs& logs,
+            Setup const& setup);
     ~JobQueue ();
 
     void addJob (JobType type, std::string const& name, JobFunction const& func);
@@ -168,6 +202,24 @@ public:
     // Cannot be const because LoadMonitor has no const methods.
     Json::Value getJson (int c = 0);
 
+    /** Release coroutine stacks left idle since the last sweep. */
+    void sweep ()
+    {
+        m_coroStacks->sweep ();
+    }
+
+    /** The stacks used by coroutines. */
+    CoroStackPool const& getCoroStacks () const
+    {
+        return *m_coroStacks;
+    }
+
+    /** Latency histograms and recent slow jobs for each job type. */
+    JobTrace& getTrace ()
+    {
+        return m_trace;
+    }
+
     /** Block until no tasks running. */
     void
     rendezvous();
@@ -180,9 +232,13 @@ private:
     beast::Journal m_journal;
     mutable std::mutex m_mutex;
     std::uint64_t m_lastJob;
-    std::set <Job> m_jobSet;
+    std::unique_ptr <JobSet> m_jobSet;
+
+    // The number of jobs which are queued and not yet dispatched
+    int m_jobCount;
     JobDataMap m_jobData;
     JobTypeData m_invalidJobData;
+    JobTrace m_trace;
 
     // The number of jobs currently in processTask()
     int m_processCount;
@@ -190,6 +246,9 @@ private:
     // The number of suspended coroutines
     int nSuspend_ = 0;
 
+    // Shared with each Coro's stack allocator
+    std::shared_ptr <CoroStackPool> m_coroStacks;
+
     Workers m_workers;
     Job::CancelCallback m_cancelCallback;
 
@@ -214,39 +273,39 @@ private:
     // Signals the service stopped if the stopped condition is met.
     void checkStopped (std::lock_guard <std::mutex> const& lock);
 
-    // Signals an added Job for processing.
+    // Accounts for a Job which is about to be added to the JobSet.
     //
     // Pre-conditions:
     //  The JobType must be valid.
-    //  The Job must exist in mJobSet.
     //  The Job must not have previously been queued.
     //
     // Post-conditions:
     //  Count of waiting jobs of that type will be incremented.
-    //  If JobQueue exists, and has at least one thread, Job will eventually run.
+    //  Returns true if a task should be signaled for the Job once it
+    //  is in the JobSet, or false if it was deferred because of limits.
     //
     // Invariants:
     //  The calling thread owns the JobLock
-    void queueJob (Job const& job, std::lock_guard <std::mutex> const& lock);
+    bool queueJob (JobType type, std::lock_guard <std::mutex> const& lock);
 
-    // Returns the next Job we should run now.
+    // Returns the type of the next Job we should run now.
     //
     // RunnableJob:
-    //  A Job in the JobSet whose slots count for its type is greater than zero.
+    //  A waiting Job whose slots count for its type is greater than zero.
     //
     // Pre-conditions:
-    //  mJobSet must not be empty.
-    //  mJobSet holds at least one RunnableJob
+    //  m_jobCount must not be zero.
+    //  At least one RunnableJob is waiting.
     //
     // Post-conditions:
-    //  job is a valid Job object.
-    //  job is removed from mJobQueue.
+    //  One Job of the returned type is reserved for the caller, which
+    //    must remove it from m_jobSet.
     //  Waiting job count of its type is decremented
     //  Running job count of its type is incremented
     //
     // Invariants:
     //  The calling thread owns the JobLock
-    void getNextJob (Job& job);
+    JobType getNextJob ();
 
     // Indicates that a running Job has completed its task.
     //
@@ -290,6 +349,10 @@ private:
     void onChildrenStopped () override;
 };
 
+/** Returns the JobQueue settings from the [job_queue] section. */
+JobQueue::Setup
+setup_JobQueue (Section const& section);
+
 /*
     An RPC command is received and is handled via ServerHandler(HTTP) or
     Handler(websocket), depending on the connection type. The handler then calls
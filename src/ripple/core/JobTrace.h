@@ -0,0 +1,125 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_CORE_JOBTRACE_H_INCLUDED
+#define RIPPLE_CORE_JOBTRACE_H_INCLUDED
+
+#include <ripple/core/Job.h>
+#include <ripple/core/JobTypes.h>
+#include <ripple/json/json_value.h>
+#include <ripple/beast/insight/Histogram.h>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ripple {
+
+/** Always-on latency tracing for the JobQueue.
+
+    For every job type two histograms are kept, one for the time a job
+    spent waiting in the queue and one for the time it took to execute.
+    Recording is a couple of relaxed atomic increments, so it is cheap
+    enough to leave enabled in production. Durations are clamped to
+    about 71 minutes.
+
+    Jobs which waited or ran for longer than the slow threshold are also
+    remembered, with their name, in a fixed size ring buffer. The buffer
+    can be exported as Chrome trace-event JSON and loaded into
+    chrome://tracing or a flame graph viewer.
+*/
+class JobTrace
+{
+public:
+    using clock_type = Job::clock_type;
+
+    /** A histogram of durations, in microseconds. */
+    using Histogram = beast::insight::detail::Histogram;
+
+    /** A job which exceeded the slow threshold. */
+    struct SlowJob
+    {
+        JobType type;
+        std::string name;
+        clock_type::time_point start;
+        std::chrono::microseconds wait;
+        std::chrono::microseconds duration;
+        std::size_t thread;
+    };
+
+    explicit
+    JobTrace (JobTypes const& types,
+        std::chrono::milliseconds slowThreshold =
+            std::chrono::milliseconds (100),
+        std::size_t slowCapacity = 256);
+
+    JobTrace (JobTrace const&) = delete;
+    JobTrace& operator= (JobTrace const&) = delete;
+
+    /** Record a job which has finished executing.
+
+        The name is only copied if the job was slow.
+    */
+    void onJob (JobType type, std::string const& name,
+        clock_type::duration wait, clock_type::time_point start,
+        clock_type::time_point end);
+
+    /** Forget all recorded samples and slow jobs. */
+    void clear ();
+
+    /** Returns the recorded slow jobs, oldest first. */
+    std::vector <SlowJob> getSlowJobs () const;
+
+    /** Returns the wait and run histograms for a job type. */
+    Histogram const& waitHistogram (JobType type) const;
+    Histogram const& runHistogram (JobType type) const;
+
+    /** Percentiles per job type followed by the slow jobs. */
+    Json::Value getJson () const;
+
+    /** The slow jobs in Chrome trace-event format. */
+    Json::Value getChromeTrace () const;
+
+private:
+    struct Entry
+    {
+        Histogram wait;
+        Histogram run;
+    };
+
+    Entry& entry (JobType type);
+    Entry const& entry (JobType type) const;
+
+    JobTypes const& types_;
+    clock_type::duration const slowThreshold_;
+    clock_type::time_point const epoch_;
+
+    // Indexed by JobType + 1, so that jtINVALID has a slot
+    std::vector <Entry> entries_;
+
+    mutable std::mutex mutex_;
+    std::vector <SlowJob> slow_;
+    std::size_t const slowCapacity_;
+    std::size_t slowNext_ = 0;
+};
+
+}
+
+#endif
@@ -38,6 +38,7 @@ public:
     {
         int maxLimit = std::numeric_limits <int>::max ();
 
+add(    jtSNAPSHOT,      "writeSnapshot",           1,        false, 0,     0);
 add(    jtPACK,          "makeFetchPack",           1,        false, 0,     0);
 add(    jtPUBOLDLEDGER,  "publishAcqLedger",        2,        false, 10000, 15000);
 add(    jtVALIDATION_ut, "untrustedValidation",     maxLimit, false, 2000,  5000);
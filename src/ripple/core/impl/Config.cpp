@@ -314,6 +314,9 @@ void Config::loadFromString (std::string const& fileContents)
 
     std::string strTemp;
 
+    if (getSingleSection (secConfig, SECTION_PEER_COMPRESSION, strTemp, j_))
+        PEER_COMPRESSION    = beast::lexicalCastThrow <bool> (strTemp);
+
     if (getSingleSection (secConfig, SECTION_PEER_PRIVATE, strTemp, j_))
         PEER_PRIVATE        = beast::lexicalCastThrow <bool> (strTemp);
 
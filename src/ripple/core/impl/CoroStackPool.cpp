@@ -0,0 +1,117 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/core/impl/CoroStackPool.h>
+#include <boost/coroutine/protected_stack_allocator.hpp>
+#include <boost/coroutine/stack_traits.hpp>
+#include <algorithm>
+
+namespace ripple {
+
+CoroStackPool::CoroStackPool (std::size_t stackSize, std::size_t maxCached)
+    : stackSize_ (std::max (stackSize,
+        boost::coroutines::stack_traits::minimum_size ()))
+    , maxCached_ (maxCached)
+{
+    free_.reserve (maxCached_);
+}
+
+CoroStackPool::~CoroStackPool ()
+{
+    boost::coroutines::protected_stack_allocator alloc;
+    for (auto& sc : free_)
+        alloc.deallocate (sc);
+}
+
+void
+CoroStackPool::allocate (boost::coroutines::stack_context& sc)
+{
+    {
+        std::lock_guard <std::mutex> lock (mutex_);
+        if (! free_.empty ())
+        {
+            sc = free_.back ();
+            free_.pop_back ();
+            lowWater_ = std::min (lowWater_, free_.size ());
+            ++reused_;
+            return;
+        }
+        ++allocated_;
+    }
+
+    boost::coroutines::protected_stack_allocator ().allocate (
+        sc, stackSize_);
+}
+
+void
+CoroStackPool::deallocate (boost::coroutines::stack_context& sc)
+{
+    {
+        std::lock_guard <std::mutex> lock (mutex_);
+        if (free_.size () < maxCached_)
+        {
+            free_.push_back (sc);
+            return;
+        }
+    }
+
+    boost::coroutines::protected_stack_allocator ().deallocate (sc);
+}
+
+void
+CoroStackPool::sweep ()
+{
+    std::vector <boost::coroutines::stack_context> idle;
+    {
+        std::lock_guard <std::mutex> lock (mutex_);
+        // Stacks are reused from the back, so the front ones are idle
+        auto const n = std::min (lowWater_, free_.size ());
+        idle.assign (free_.begin (), free_.begin () + n);
+        free_.erase (free_.begin (), free_.begin () + n);
+        lowWater_ = free_.size ();
+    }
+
+    boost::coroutines::protected_stack_allocator alloc;
+    for (auto& sc : idle)
+        alloc.deallocate (sc);
+}
+
+std::size_t
+CoroStackPool::allocated () const
+{
+    std::lock_guard <std::mutex> lock (mutex_);
+    return allocated_;
+}
+
+std::size_t
+CoroStackPool::reused () const
+{
+    std::lock_guard <std::mutex> lock (mutex_);
+    return reused_;
+}
+
+std::size_t
+CoroStackPool::cached () const
+{
+    std::lock_guard <std::mutex> lock (mutex_);
+    return free_.size ();
+}
+
+}
@@ -0,0 +1,116 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_CORE_COROSTACKPOOL_H_INCLUDED
+#define RIPPLE_CORE_COROSTACKPOOL_H_INCLUDED
+
+#include <boost/coroutine/stack_context.hpp>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ripple {
+
+/** A cache of coroutine stacks.
+
+    Every stack has the same size and a guard page below it. Stacks
+    released by finished coroutines are kept, up to a limit, and handed
+    to the next coroutine instead of being unmapped and mapped again.
+    Stacks which stay in the cache from one sweep to the next are
+    unmapped, so a burst of coroutines does not pin its memory.
+*/
+class CoroStackPool
+{
+public:
+    /** A boost::coroutines StackAllocator which draws from a pool. */
+    class Allocator
+    {
+    private:
+        std::shared_ptr <CoroStackPool> pool_;
+
+    public:
+        explicit
+        Allocator (std::shared_ptr <CoroStackPool> pool)
+            : pool_ (std::move (pool))
+        {
+        }
+
+        void
+        allocate (boost::coroutines::stack_context& sc, std::size_t)
+        {
+            pool_->allocate (sc);
+        }
+
+        void
+        deallocate (boost::coroutines::stack_context& sc)
+        {
+            pool_->deallocate (sc);
+        }
+    };
+
+    /** Create a pool.
+        @param stackSize The usable size of each stack, in bytes.
+        @param maxCached How many idle stacks to keep. Zero disables reuse.
+    */
+    CoroStackPool (std::size_t stackSize, std::size_t maxCached);
+
+    ~CoroStackPool ();
+
+    CoroStackPool (CoroStackPool const&) = delete;
+    CoroStackPool& operator= (CoroStackPool const&) = delete;
+
+    std::size_t
+    stackSize () const
+    {
+        return stackSize_;
+    }
+
+    void allocate (boost::coroutines::stack_context& sc);
+
+    void deallocate (boost::coroutines::stack_context& sc);
+
+    /** Unmap the cached stacks that were not used since the last sweep. */
+    void sweep ();
+
+    /** The number of stacks that had to be newly mapped. */
+    std::size_t allocated () const;
+
+    /** The number of stacks that were reused from the cache. */
+    std::size_t reused () const;
+
+    /** The number of idle stacks held by the cache. */
+    std::size_t cached () const;
+
+private:
+    std::size_t const stackSize_;
+    std::size_t const maxCached_;
+
+    std::mutex mutable mutex_;
+    std::vector <boost::coroutines::stack_context> free_;
+    std::size_t allocated_ = 0;
+    std::size_t reused_ = 0;
+
+    // The fewest cached stacks since the last sweep
+    std::size_t lowWater_ = 0;
+};
+
+}
+
+#endif
@@ -19,9 +19,12 @@
 
 #include <BeastConfig.h>
 #include <ripple/core/DatabaseCon.h>
+#include <ripple/core/ConfigSections.h>
 #include <ripple/core/SociDB.h>
 #include <ripple/basics/contract.h>
 #include <ripple/basics/Log.h>
+#include <boost/algorithm/string/predicate.hpp>
+#include <chrono>
 #include <memory>
 
 namespace ripple {
@@ -55,6 +58,80 @@ DatabaseCon::DatabaseCon (
             // ignore errors
         }
     }
+
+    // A temporary database is private to its connection,
+    // so readers can only share it through the writer.
+    if (useTempFiles)
+        return;
+
+    readers_.reserve (setup.readConnections);
+    idle_.reserve (setup.readConnections);
+    for (std::size_t i = 0; i < setup.readConnections; ++i)
+    {
+        auto reader = std::make_unique<soci::session> ();
+        open (*reader, "sqlite", pPath.string());
+
+        // The connection settings apply per connection, the
+        // schema was created above by the writer.
+        for (int j = 0; j < initCount; ++j)
+        {
+            if (! boost::starts_with (initStrings[j], "PRAGMA"))
+                continue;
+            try
+            {
+                soci::statement st = reader->prepare <<
+                    initStrings[j];
+                st.execute(true);
+            }
+            catch (soci::soci_error&)
+            {
+                // ignore errors
+            }
+        }
+        *reader << "PRAGMA query_only=1;";
+
+        idle_.push_back (reader.get());
+        readers_.push_back (std::move (reader));
+    }
+}
+
+ReadSociSession DatabaseCon::checkoutReadDb ()
+{
+    if (readers_.empty ())
+        return ReadSociSession (session_, lock_);
+
+    std::unique_lock<std::mutex> lock (readLock_);
+    ++readCheckouts_;
+    if (idle_.empty ())
+    {
+        using namespace std::chrono;
+        auto const start = steady_clock::now ();
+        readCond_.wait (lock, [this]{ return ! idle_.empty (); });
+        ++readWaits_;
+        readWaitMicroseconds_ += duration_cast<microseconds> (
+            steady_clock::now () - start).count ();
+    }
+    auto const session = idle_.back ();
+    idle_.pop_back ();
+    return ReadSociSession (*this, *session);
+}
+
+void DatabaseCon::release (soci::session& session)
+{
+    {
+        std::lock_guard<std::mutex> lock (readLock_);
+        idle_.push_back (&session);
+    }
+    readCond_.notify_one ();
+}
+
+DatabaseCon::ReadStats DatabaseCon::readStats () const
+{
+    ReadStats stats;
+    stats.checkouts = readCheckouts_.load ();
+    stats.waits = readWaits_.load ();
+    stats.waitMicroseconds = readWaitMicroseconds_.load ();
+    return stats;
 }
 
 DatabaseCon::Setup setup_DatabaseCon (Config const& c)
@@ -70,6 +147,8 @@ DatabaseCon::Setup setup_DatabaseCon (Config const& c)
             "database_path must be set.");
     }
 
+    set (setup.readConnections, "read_connections", c.section (SECTION_SQLITE));
+
     return setup;
 }
 
@@ -24,6 +24,14 @@
 
 namespace ripple {
 
+static
+JobType&
+runningType ()
+{
+    static thread_local JobType type = jtINVALID;
+    return type;
+}
+
 Job::Job ()
     : mType (jtINVALID)
     , mJobIndex (0)
@@ -85,11 +93,21 @@ void Job::doJob ()
     threadEntry (this, &Job::doJobImpl, ss.str());
 }
 
+JobType Job::running ()
+{
+    return runningType ();
+}
+
 void Job::rename (std::string const& newName)
 {
     mName = newName;
 }
 
+std::string const& Job::getName () const
+{
+    return mName;
+}
+
 bool Job::operator> (const Job& j) const
 {
     if (mType < j.mType)
@@ -139,7 +157,10 @@ void Job::doJobImpl ()
     m_loadEvent->start ();
     m_loadEvent->reName (mName);
 
+    auto const saved = runningType ();
+    runningType () = mType;
     mJob (*this);
+    runningType () = saved;
 
     // Destroy the lambda, otherwise we won't include
     // its duration in the time measurement
@@ -22,22 +22,32 @@
 #include <ripple/core/JobTypes.h>
 #include <ripple/core/JobTypeInfo.h>
 #include <ripple/core/JobTypeData.h>
+#include <ripple/basics/contract.h>
 #include <ripple/beast/clock/chrono_util.h>
 #include <chrono>
 #include <memory>
 #include <mutex>
-#include <set>
+#include <algorithm>
 #include <thread>
 
 namespace ripple {
 
 JobQueue::JobQueue (beast::insight::Collector::ptr const& collector,
-    Stoppable& parent, beast::Journal journal, Logs& logs)
+    Stoppable& parent, beast::Journal journal, Logs& logs,
+        Setup const& setup)
     : Stoppable ("JobQueue", parent)
     , m_journal (journal)
     , m_lastJob (0)
+    , m_jobSet (setup.scheduler == Scheduler::locked
+        ? make_LockedJobSet ()
+        : make_StealingJobSet (getJobTypes (), std::max (1u,
+            std::thread::hardware_concurrency ())))
+    , m_jobCount (0)
     , m_invalidJobData (getJobTypes ().getInvalid (), collector, logs)
+    , m_trace (getJobTypes ())
     , m_processCount (0)
+    , m_coroStacks (std::make_shared <CoroStackPool> (
+        setup.coroStackSize, setup.coroStackCache))
     , m_workers (*this, "JobQueue", 0)
     , m_cancelCallback (std::bind (&Stoppable::isStopping, this))
     , m_collector (collector)
@@ -72,7 +82,7 @@ void
 JobQueue::collect ()
 {
     std::lock_guard <std::mutex> lock (m_mutex);
-    job_count = m_jobSet.size ();
+    job_count = m_jobCount;
 }
 
 void
@@ -92,7 +102,12 @@ JobQueue::addJob (JobType type, std::string const& name,
     // do not add jobs to a queue with no threads
     assert (type == jtCLIENT || m_workers.getNumberOfThreads () > 0);
 
+    std::uint64_t index;
+    bool signal;
+
     {
+        std::lock_guard <std::mutex> lock (m_mutex);
+
         // If this goes off it means that a child didn't follow
         // the Stoppable API rules. A job may only be added if:
         //
@@ -104,21 +119,22 @@ JobQueue::addJob (JobType type, std::string const& name,
         //          OR
         //      * Not all children are stopped
         //
-        std::lock_guard <std::mutex> lock (m_mutex);
         assert (! isStopped() && (
             m_processCount>0 ||
-            ! m_jobSet.empty () ||
+            m_jobCount != 0 ||
             ! areChildrenStopped()));
+
+        index = ++m_lastJob;
+        signal = queueJob (type, lock);
     }
 
-    {
-        std::lock_guard <std::mutex> lock (m_mutex);
+    // The job is counted before it is stored, so that stopping waits
+    // for it. A worker which reserves it first waits in JobSet::pop.
+    m_jobSet->push (Job (type, name, index,
+        data.load (), func, m_cancelCallback));
 
-        std::pair <std::set <Job>::iterator, bool> result (
-            m_jobSet.insert (Job (type, name, ++m_lastJob,
-                data.load (), func, m_cancelCallback)));
-        queueJob (*result.first, lock);
-    }
+    if (signal)
+        m_workers.addTask ();
 }
 
 int
@@ -301,7 +317,7 @@ JobQueue::rendezvous()
     cv_.wait(lock, [&]
     {
         return m_processCount == 0 &&
-            m_jobSet.empty();
+            m_jobCount == 0;
     });
 }
 
@@ -340,67 +356,61 @@ JobQueue::checkStopped (std::lock_guard <std::mutex> const& lock)
     if (isStopping() &&
         areChildrenStopped() &&
         (m_processCount == 0) &&
-        m_jobSet.empty() &&
+        m_jobCount == 0 &&
         nSuspend_ == 0)
     {
         stopped();
     }
 }
 
-void
-JobQueue::queueJob (Job const& job, std::lock_guard <std::mutex> const& lock)
+bool
+JobQueue::queueJob (JobType type, std::lock_guard <std::mutex> const& lock)
 {
-    JobType const type (job.getType ());
     assert (type != jtINVALID);
-    assert (m_jobSet.find (job) != m_jobSet.end ());
 
     JobTypeData& data (getJobTypeData (type));
 
-    if (data.waiting + data.running < getJobLimit (type))
-    {
-        m_workers.addTask ();
-    }
-    else
+    bool signal = true;
+
+    if (data.waiting + data.running >= data.info.limit ())
     {
         // defer the task until we go below the limit
         //
         ++data.deferred;
+        signal = false;
     }
     ++data.waiting;
+    ++m_jobCount;
+
+    return signal;
 }
 
-void
-JobQueue::getNextJob (Job& job)
+JobType
+JobQueue::getNextJob ()
 {
-    assert (! m_jobSet.empty ());
+    assert (m_jobCount != 0);
 
-    std::set <Job>::const_iterator iter;
-    for (iter = m_jobSet.begin (); iter != m_jobSet.end (); ++iter)
+    // Higher job types have higher priority
+    for (auto iter = m_jobData.rbegin (); iter != m_jobData.rend (); ++iter)
     {
-        JobTypeData& data (getJobTypeData (iter->getType ()));
+        JobTypeData& data (iter->second);
 
-        assert (data.running <= getJobLimit (data.type ()));
+        assert (data.running <= data.info.limit ());
 
-        // Run this job if we're running below the limit.
-        if (data.running < getJobLimit (data.type ()))
+        // Run this type if it has a job and we're running below the limit.
+        if (data.waiting > 0 && data.running < data.info.limit ())
         {
-            assert (data.waiting > 0);
-            break;
+            assert (data.type () != jtINVALID);
+
+            --data.waiting;
+            ++data.running;
+            --m_jobCount;
+            return data.type ();
         }
     }
 
-    assert (iter != m_jobSet.end ());
-
-    JobType const type = iter->getType ();
-    JobTypeData& data (getJobTypeData (type));
-
-    assert (type != jtINVALID);
-
-    job = *iter;
-    m_jobSet.erase (iter);
-
-    --data.waiting;
-    ++data.running;
+    assert (false);
+    return jtINVALID;
 }
 
 void
@@ -453,18 +463,20 @@ JobQueue::processTask ()
         Job::clock_type::time_point const start_time (
             Job::clock_type::now());
         {
-            Job job;
             {
                 std::lock_guard <std::mutex> lock (m_mutex);
-                getNextJob (job);
+                type = getNextJob ();
                 ++m_processCount;
             }
-            type = job.getType();
+            Job job (m_jobSet->pop (type));
             JobTypeData& data(getJobTypeData(type));
             beast::Thread::setCurrentThreadName (data.name ());
             JLOG(m_journal.trace()) << "Doing " << data.name () << " job";
             on_dequeue (job.getType (), start_time - job.queue_time ());
             job.doJob ();
+            m_trace.onJob (type, job.getName (),
+                start_time - job.queue_time (), start_time,
+                    Job::clock_type::now ());
         }
         on_execute(type, Job::clock_type::now() - start_time);
     }
@@ -475,7 +487,7 @@ JobQueue::processTask ()
         // otherwise destructors with side effects can access
         // parent objects that are already destroyed.
         finishJob (type);
-        if(--m_processCount == 0 && m_jobSet.empty())
+        if(--m_processCount == 0 && m_jobCount == 0)
             cv_.notify_all();
         checkStopped (lock);
     }
@@ -500,4 +512,34 @@ JobQueue::onChildrenStopped ()
     checkStopped (lock);
 }
 
+//------------------------------------------------------------------------------
+
+JobQueue::Setup
+setup_JobQueue (Section const& section)
+{
+    JobQueue::Setup setup;
+
+    std::string scheduler;
+    set (scheduler, "scheduler", section);
+
+    if (scheduler == "stealing")
+        setup.scheduler = JobQueue::Scheduler::stealing;
+    else if (! scheduler.empty () && scheduler != "locked")
+        Throw<std::runtime_error> (
+            "Invalid [job_queue] scheduler: " + scheduler);
+
+    std::size_t stackKB = 0;
+    if (set (stackKB, "coro_stack_size", section))
+    {
+        if (stackKB < 64)
+            Throw<std::runtime_error> (
+                "[job_queue] coro_stack_size must be at least 64");
+        setup.coroStackSize = stackKB * 1024;
+    }
+
+    set (setup.coroStackCache, "coro_stack_cache", section);
+
+    return setup;
+}
+
 }
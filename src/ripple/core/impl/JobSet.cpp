@@ -0,0 +1,284 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/core/impl/JobSet.h>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <set>
+#include <vector>
+
+namespace ripple {
+
+class LockedJobSet : public JobSet
+{
+private:
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::set <Job> jobs_;
+
+    // Threads waiting in pop for a job to be pushed
+    int waiters_ = 0;
+
+public:
+    void
+    push (Job&& job) override
+    {
+        std::lock_guard <std::mutex> lock (mutex_);
+        jobs_.insert (std::move (job));
+        if (waiters_ != 0)
+            cond_.notify_all ();
+    }
+
+    Job
+    pop (JobType type) override
+    {
+        std::unique_lock <std::mutex> lock (mutex_);
+
+        for (;;)
+        {
+            // Jobs sort by descending type then ascending index, so this
+            // is the oldest job of the requested type, if there is one.
+            auto const iter = jobs_.lower_bound (Job (type, 0));
+            if (iter != jobs_.end () && iter->getType () == type)
+            {
+                Job job = *iter;
+                jobs_.erase (iter);
+                return job;
+            }
+
+            ++waiters_;
+            cond_.wait (lock);
+            --waiters_;
+        }
+    }
+};
+
+//------------------------------------------------------------------------------
+
+class StealingJobSet : public JobSet
+{
+private:
+    using clock_type = Job::clock_type;
+
+    // Marks an empty queue in Slot::fronts
+    static constexpr clock_type::rep noJob =
+        std::numeric_limits <clock_type::rep>::max ();
+
+    struct Slot
+    {
+        std::mutex mutex;
+
+        // Indexed by JobType + 1
+        std::vector <std::deque <Job>> queues;
+
+        // When the job at the front of each queue was queued, so that
+        // other threads can find the oldest job without taking the lock
+        std::vector <std::atomic <clock_type::rep>> fronts;
+
+        explicit
+        Slot (std::size_t types)
+            : queues (types)
+            , fronts (types)
+        {
+            for (auto& front : fronts)
+                front.store (noJob);
+        }
+    };
+
+    std::vector <std::unique_ptr <Slot>> slots_;
+
+    // How long a job of each type may wait before it is taken ahead of
+    // newer jobs in the popping thread's own queue. Indexed by
+    // JobType + 1.
+    std::vector <clock_type::duration> maxAge_;
+
+    // Lets pop sleep until a job is pushed
+    std::mutex waitMutex_;
+    std::condition_variable cond_;
+    std::atomic <int> waiters_ {0};
+    std::uint64_t pushes_ = 0;
+
+    std::size_t
+    home () const
+    {
+        static std::atomic <std::size_t> next (0);
+        thread_local std::size_t const index = next++;
+        return index % slots_.size ();
+    }
+
+    static
+    std::size_t
+    indexOf (JobType type)
+    {
+        assert (type != jtINVALID);
+        return static_cast <std::size_t> (type + 1);
+    }
+
+    static
+    void
+    setFront (Slot& slot, std::size_t index)
+    {
+        auto const& q = slot.queues[index];
+        slot.fronts[index].store (q.empty () ? noJob :
+            q.front ().queue_time ().time_since_epoch ().count ());
+    }
+
+    bool
+    tryPop (Slot& slot, std::size_t index, Job& job)
+    {
+        if (slot.fronts[index].load () == noJob)
+            return false;
+
+        std::lock_guard <std::mutex> lock (slot.mutex);
+        auto& q = slot.queues[index];
+        if (q.empty ())
+            return false;
+
+        job = std::move (q.front ());
+        q.pop_front ();
+        setFront (slot, index);
+        return true;
+    }
+
+    // Returns the slot to pop a job of a type from, or the number of
+    // slots if no queue holds one.
+    std::size_t
+    choose (std::size_t index, std::size_t start) const
+    {
+        std::size_t oldest = slots_.size ();
+        auto oldestTime = noJob;
+        for (std::size_t i = 0; i < slots_.size (); ++i)
+        {
+            auto const slot = (start + i) % slots_.size ();
+            auto const t = slots_[slot]->fronts[index].load ();
+            if (t < oldestTime)
+            {
+                oldest = slot;
+                oldestTime = t;
+            }
+        }
+
+        // Our own queue first, unless another job has waited too long
+        if (slots_[start]->fronts[index].load () != noJob &&
+            clock_type::now ().time_since_epoch ().count () - oldestTime <
+                maxAge_[index].count ())
+        {
+            return start;
+        }
+
+        return oldest;
+    }
+
+public:
+    StealingJobSet (JobTypes const& types, std::size_t slots)
+    {
+        int last = jtINVALID;
+        for (auto const& x : types)
+            last = std::max <int> (last, x.first);
+
+        // A tenth of the type's latency target, if it has one
+        maxAge_.resize (last + 2, std::chrono::milliseconds (10));
+        for (auto const& x : types)
+        {
+            auto const target = x.second.getAverageLatency ();
+            if (target != 0)
+                maxAge_[indexOf (x.first)] =
+                    std::chrono::milliseconds (target) / 10;
+        }
+
+        slots = std::max <std::size_t> (slots, 1);
+        slots_.reserve (slots);
+        for (std::size_t i = 0; i < slots; ++i)
+            slots_.emplace_back (std::make_unique <Slot> (last + 2));
+    }
+
+    void
+    push (Job&& job) override
+    {
+        auto const index = indexOf (job.getType ());
+        Slot& slot = *slots_[home ()];
+
+        {
+            std::lock_guard <std::mutex> lock (slot.mutex);
+            slot.queues[index].push_back (std::move (job));
+            if (slot.queues[index].size () == 1)
+                setFront (slot, index);
+        }
+
+        // Pairs with pop: either the waiter sees our job when it looks
+        // again, or we see the waiter here.
+        if (waiters_.load () != 0)
+        {
+            std::lock_guard <std::mutex> lock (waitMutex_);
+            ++pushes_;
+            cond_.notify_all ();
+        }
+    }
+
+    Job
+    pop (JobType type) override
+    {
+        auto const index = indexOf (type);
+        auto const start = home ();
+        Job job;
+
+        for (;;)
+        {
+            auto const slot = choose (index, start);
+            if (slot != slots_.size ())
+            {
+                if (tryPop (*slots_[slot], index, job))
+                    return job;
+                continue;
+            }
+
+            // The reserved job has not been pushed yet
+            std::unique_lock <std::mutex> lock (waitMutex_);
+            ++waiters_;
+            auto const pushes = pushes_;
+            if (choose (index, start) == slots_.size ())
+                cond_.wait (lock, [&]{ return pushes_ != pushes; });
+            --waiters_;
+        }
+    }
+};
+
+constexpr Job::clock_type::rep StealingJobSet::noJob;
+
+//------------------------------------------------------------------------------
+
+std::unique_ptr <JobSet>
+make_LockedJobSet ()
+{
+    return std::make_unique <LockedJobSet> ();
+}
+
+std::unique_ptr <JobSet>
+make_StealingJobSet (JobTypes const& types, std::size_t slots)
+{
+    return std::make_unique <StealingJobSet> (types, slots);
+}
+
+}
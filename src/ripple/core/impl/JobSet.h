@@ -0,0 +1,81 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_CORE_JOBSET_H_INCLUDED
+#define RIPPLE_CORE_JOBSET_H_INCLUDED
+
+#include <ripple/core/Job.h>
+#include <ripple/core/JobTypes.h>
+#include <cstddef>
+#include <memory>
+
+namespace ripple {
+
+/** Storage for jobs which are queued but not yet running.
+
+    The JobQueue decides under its own lock which job type may run next,
+    using only the per-type counters. It then asks the JobSet for a job
+    of that type. This keeps allocation, copying and searching of Job
+    objects out of the JobQueue's critical section.
+
+    Implementations are thread-safe.
+*/
+class JobSet
+{
+public:
+    virtual ~JobSet () = default;
+
+    /** Add a job. */
+    virtual void push (Job&& job) = 0;
+
+    /** Remove and return a job of the given type.
+
+        The caller must already have reserved a job of this type from the
+        JobQueue's counters. If that job has not been pushed yet, this
+        blocks until it is.
+    */
+    virtual Job pop (JobType type) = 0;
+};
+
+/** Returns a JobSet which keeps every job in one ordered set.
+
+    Jobs of a type are returned strictly in the order they were queued.
+    This is the original JobQueue behavior.
+*/
+std::unique_ptr <JobSet>
+make_LockedJobSet ();
+
+/** Returns a JobSet which spreads jobs over per-thread queues.
+
+    Each thread pushes to, and pops from, its own slot. A thread which
+    finds no job of the requested type in its slot steals the oldest one
+    from another slot. Jobs of one type are only approximately ordered:
+    once a job has waited a tenth of its type's latency target, or 10ms
+    for types without one, it is taken before newer jobs in the popping
+    thread's slot.
+
+    @param types The job types which may be queued.
+    @param slots The number of queues.
+*/
+std::unique_ptr <JobSet>
+make_StealingJobSet (JobTypes const& types, std::size_t slots);
+
+}
+
+#endif
@@ -0,0 +1,254 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/core/JobTrace.h>
+#include <ripple/protocol/JsonFields.h>
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+namespace ripple {
+
+namespace {
+
+// A small, stable number for the calling thread, used as the trace "tid"
+std::size_t
+threadIndex ()
+{
+    static std::atomic <std::size_t> next (0);
+    thread_local std::size_t const index = ++next;
+    return index;
+}
+
+std::uint64_t
+toMicroseconds (JobTrace::clock_type::duration d)
+{
+    using namespace std::chrono;
+    auto const us = duration_cast <microseconds> (d).count ();
+    return us > 0 ? static_cast <std::uint64_t> (us) : 0;
+}
+
+Json::UInt
+clampUInt (std::uint64_t v)
+{
+    return static_cast <Json::UInt> (std::min <std::uint64_t> (
+        v, std::numeric_limits <Json::UInt>::max ()));
+}
+
+Json::Value
+toJson (JobTrace::Histogram const& h)
+{
+    JobTrace::Histogram::Counts counts;
+    auto const max = h.snapshot (counts);
+
+    std::uint64_t total = 0;
+    for (auto const count : counts)
+        total += count;
+
+    auto percentile = [&](double percent) -> Json::UInt
+    {
+        if (total == 0)
+            return 0;
+        return clampUInt (JobTrace::Histogram::percentile (
+            counts, total, max, percent));
+    };
+
+    Json::Value ret (Json::objectValue);
+    ret[jss::count] = clampUInt (total);
+    ret[jss::p50] = percentile (50);
+    ret[jss::p90] = percentile (90);
+    ret[jss::p99] = percentile (99);
+    ret[jss::max] = clampUInt (max);
+    return ret;
+}
+
+}
+
+//------------------------------------------------------------------------------
+
+JobTrace::JobTrace (JobTypes const& types,
+        std::chrono::milliseconds slowThreshold,
+        std::size_t slowCapacity)
+    : types_ (types)
+    , slowThreshold_ (slowThreshold)
+    , epoch_ (clock_type::now ())
+    , slowCapacity_ (slowCapacity)
+{
+    int last = jtINVALID;
+    for (auto const& x : types_)
+        last = std::max <int> (last, x.first);
+    entries_ = std::vector <Entry> (last + 2);
+
+    slow_.reserve (slowCapacity_);
+}
+
+JobTrace::Entry&
+JobTrace::entry (JobType type)
+{
+    auto const i = static_cast <std::size_t> (type + 1);
+    assert (i < entries_.size ());
+    return entries_[std::min (i, entries_.size () - 1)];
+}
+
+JobTrace::Entry const&
+JobTrace::entry (JobType type) const
+{
+    auto const i = static_cast <std::size_t> (type + 1);
+    assert (i < entries_.size ());
+    return entries_[std::min (i, entries_.size () - 1)];
+}
+
+void
+JobTrace::onJob (JobType type, std::string const& name,
+    clock_type::duration wait, clock_type::time_point start,
+    clock_type::time_point end)
+{
+    auto const elapsed = end - start;
+
+    Entry& e = entry (type);
+    e.wait.record (toMicroseconds (wait));
+    e.run.record (toMicroseconds (elapsed));
+
+    if (slowCapacity_ == 0 ||
+        (wait < slowThreshold_ && elapsed < slowThreshold_))
+        return;
+
+    using namespace std::chrono;
+    SlowJob job {type, name, start,
+        duration_cast <microseconds> (wait),
+        duration_cast <microseconds> (elapsed),
+        threadIndex ()};
+
+    std::lock_guard <std::mutex> lock (mutex_);
+    if (slow_.size () < slowCapacity_)
+    {
+        slow_.push_back (std::move (job));
+    }
+    else
+    {
+        slow_[slowNext_] = std::move (job);
+        slowNext_ = (slowNext_ + 1) % slowCapacity_;
+    }
+}
+
+void
+JobTrace::clear ()
+{
+    for (auto& e : entries_)
+    {
+        e.wait.clear ();
+        e.run.clear ();
+    }
+
+    std::lock_guard <std::mutex> lock (mutex_);
+    slow_.clear ();
+    slowNext_ = 0;
+}
+
+std::vector <JobTrace::SlowJob>
+JobTrace::getSlowJobs () const
+{
+    std::lock_guard <std::mutex> lock (mutex_);
+    std::vector <SlowJob> ret;
+    ret.reserve (slow_.size ());
+    ret.insert (ret.end (), slow_.begin () + slowNext_, slow_.end ());
+    ret.insert (ret.end (), slow_.begin (), slow_.begin () + slowNext_);
+    return ret;
+}
+
+JobTrace::Histogram const&
+JobTrace::waitHistogram (JobType type) const
+{
+    return entry (type).wait;
+}
+
+JobTrace::Histogram const&
+JobTrace::runHistogram (JobType type) const
+{
+    return entry (type).run;
+}
+
+Json::Value
+JobTrace::getJson () const
+{
+    Json::Value ret (Json::objectValue);
+
+    Json::Value& jobTypes = (ret[jss::job_types] = Json::arrayValue);
+    for (auto const& x : types_)
+    {
+        Entry const& e = entry (x.first);
+        if (e.wait.count () == 0)
+            continue;
+
+        Json::Value& jt = jobTypes.append (Json::objectValue);
+        jt[jss::job_type] = x.second.name ();
+        jt[jss::wait_us] = toJson (e.wait);
+        jt[jss::run_us] = toJson (e.run);
+    }
+
+    using namespace std::chrono;
+    ret[jss::slow_threshold_ms] = static_cast <Json::UInt> (
+        duration_cast <milliseconds> (slowThreshold_).count ());
+
+    Json::Value& slow = (ret[jss::slow_jobs] = Json::arrayValue);
+    for (auto const& job : getSlowJobs ())
+    {
+        Json::Value& j = slow.append (Json::objectValue);
+        j[jss::job_type] = types_.get (job.type).name ();
+        j[jss::name] = job.name;
+        j[jss::wait_us] = clampUInt (job.wait.count ());
+        j[jss::run_us] = clampUInt (job.duration.count ());
+        j[jss::thread] = static_cast <Json::UInt> (job.thread);
+    }
+
+    return ret;
+}
+
+Json::Value
+JobTrace::getChromeTrace () const
+{
+    using namespace std::chrono;
+
+    Json::Value ret (Json::objectValue);
+    ret[jss::displayTimeUnit] = "ms";
+
+    Json::Value& events = (ret[jss::traceEvents] = Json::arrayValue);
+    for (auto const& job : getSlowJobs ())
+    {
+        // The event fields are named by the trace-event format
+        Json::Value& ev = events.append (Json::objectValue);
+        ev[jss::name] = job.name;
+        ev["cat"] = types_.get (job.type).name ();
+        ev["ph"] = "X";
+        // Timestamps are relative to when tracing started. Doubles
+        // are used because the values overflow a 32 bit integer.
+        ev["ts"] = static_cast <double> (
+            duration_cast <microseconds> (job.start - epoch_).count ());
+        ev["dur"] = static_cast <double> (job.duration.count ());
+        ev["pid"] = 1;
+        ev["tid"] = static_cast <Json::UInt> (job.thread);
+        ev["args"] = Json::objectValue;
+        ev["args"][jss::wait_us] = static_cast <double> (job.wait.count ());
+    }
+
+    return ret;
+}
+
+}
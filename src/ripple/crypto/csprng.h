@@ -20,6 +20,9 @@
 #ifndef RIPPLE_CRYPTO_RANDOM_H_INCLUDED
 #define RIPPLE_CRYPTO_RANDOM_H_INCLUDED
 
+#include <atomic>
+#include <cstdint>
+#include <limits>
 #include <mutex>
 #include <string>
 #include <type_traits>
@@ -28,23 +31,40 @@ namespace ripple {
 
 /** A cryptographically secure random number engine
 
-    The engine is thread-safe (it uses a lock to serialize
-    access) and will, automatically, mix in some randomness
-    from std::random_device.
+    The engine is thread-safe and will, automatically, mix in
+    some randomness from std::random_device.
+
+    Each thread draws from its own ChaCha20 generator, so threads
+    do not contend on a lock. The generators are seeded from
+    OpenSSL's RAND_bytes, and reseeded after a fixed amount of
+    output, whenever entropy is mixed into the engine, and in the
+    child after a fork.
 
     Meets the requirements of UniformRandomNumberEngine
 */
 class csprng_engine
 {
 private:
+    struct state;
+
+    // Serializes access to the OpenSSL generator
     std::mutex mutex_;
 
+    // Changes whenever the per-thread generators must reseed
+    std::atomic<std::uint64_t> generation_;
+
     void
     mix (
         void* buffer,
         std::size_t count,
         double bitsPerByte);
 
+    state&
+    local ();
+
+    void
+    reseed (state& s);
+
 public:
     using result_type = std::uint64_t;
 
@@ -0,0 +1,104 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_CRYPTO_CHACHA20_H_INCLUDED
+#define RIPPLE_CRYPTO_CHACHA20_H_INCLUDED
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ripple {
+namespace detail {
+
+/** The ChaCha20 block function from RFC 7539.
+
+    Produces 64 bytes of key stream for the given 256-bit key,
+    32-bit block counter and 96-bit nonce.
+*/
+inline
+void
+chacha20_block (
+    std::uint8_t const* key,
+    std::uint32_t counter,
+    std::uint8_t const* nonce,
+    std::uint8_t* out)
+{
+    auto load = [](std::uint8_t const* p) -> std::uint32_t
+    {
+        return
+            std::uint32_t{p[0]} |
+            (std::uint32_t{p[1]} <<  8) |
+            (std::uint32_t{p[2]} << 16) |
+            (std::uint32_t{p[3]} << 24);
+    };
+
+    auto rotl = [](std::uint32_t v, int n) -> std::uint32_t
+    {
+        return (v << n) | (v >> (32 - n));
+    };
+
+    std::uint32_t in[16];
+    in[0] = 0x61707865;
+    in[1] = 0x3320646e;
+    in[2] = 0x79622d32;
+    in[3] = 0x6b206574;
+    for (int i = 0; i < 8; ++i)
+        in[4 + i] = load (key + 4 * i);
+    in[12] = counter;
+    for (int i = 0; i < 3; ++i)
+        in[13 + i] = load (nonce + 4 * i);
+
+    std::uint32_t x[16];
+    for (int i = 0; i < 16; ++i)
+        x[i] = in[i];
+
+    auto qr = [&x, &rotl](int a, int b, int c, int d)
+    {
+        x[a] += x[b]; x[d] ^= x[a]; x[d] = rotl (x[d], 16);
+        x[c] += x[d]; x[b] ^= x[c]; x[b] = rotl (x[b], 12);
+        x[a] += x[b]; x[d] ^= x[a]; x[d] = rotl (x[d],  8);
+        x[c] += x[d]; x[b] ^= x[c]; x[b] = rotl (x[b],  7);
+    };
+
+    for (int i = 0; i < 10; ++i)
+    {
+        qr (0, 4,  8, 12);
+        qr (1, 5,  9, 13);
+        qr (2, 6, 10, 14);
+        qr (3, 7, 11, 15);
+        qr (0, 5, 10, 15);
+        qr (1, 6, 11, 12);
+        qr (2, 7,  8, 13);
+        qr (3, 4,  9, 14);
+    }
+
+    for (int i = 0; i < 16; ++i)
+    {
+        auto const v = x[i] + in[i];
+        out[4 * i + 0] = static_cast<std::uint8_t> (v);
+        out[4 * i + 1] = static_cast<std::uint8_t> (v >>  8);
+        out[4 * i + 2] = static_cast<std::uint8_t> (v >> 16);
+        out[4 * i + 3] = static_cast<std::uint8_t> (v >> 24);
+    }
+}
+
+} // detail
+} // ripple
+
+#endif
@@ -20,14 +20,81 @@
 #include <BeastConfig.h>
 #include <ripple/basics/contract.h>
 #include <ripple/crypto/csprng.h>
+#include <ripple/crypto/impl/chacha20.h>
+#include <openssl/crypto.h>
 #include <openssl/rand.h>
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <cstring>
 #include <random>
 #include <stdexcept>
 
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
 namespace ripple {
 
+namespace {
+
+// Incremented in the child after a fork, so that the child does
+// not repeat the output of the parent's generators.
+std::atomic<std::uint64_t> forks {0};
+
+#ifndef _WIN32
+void onFork ()
+{
+    ++forks;
+}
+#endif
+
+}
+
+// The generator of one thread.
+//
+// After every refill the first 32 bytes of key stream become the
+// next key, and output is erased as it is handed out, so the state
+// cannot be used to recover earlier output.
+struct csprng_engine::state
+{
+    // Number of ChaCha20 blocks produced per refill
+    static std::size_t constexpr blocks = 16;
+
+    // Amount of output after which we reseed from OpenSSL
+    static std::size_t constexpr reseedBytes = 1024 * 1024;
+
+    csprng_engine const* engine = nullptr;
+    std::uint64_t generation = 0;
+    std::uint64_t forks = 0;
+    std::size_t sinceReseed = 0;
+
+    std::array<std::uint8_t, 32> key;
+    std::array<std::uint8_t, 64 * blocks> buffer;
+
+    // Unread bytes, at the end of the buffer
+    std::size_t available = 0;
+
+    ~state ()
+    {
+        OPENSSL_cleanse (key.data (), key.size ());
+        OPENSSL_cleanse (buffer.data (), buffer.size ());
+    }
+
+    void
+    refill ()
+    {
+        std::array<std::uint8_t, 12> const nonce {};
+        for (std::size_t i = 0; i < blocks; ++i)
+            detail::chacha20_block (key.data (),
+                static_cast<std::uint32_t> (i), nonce.data (),
+                    buffer.data () + 64 * i);
+        std::memcpy (key.data (), buffer.data (), key.size ());
+        std::memset (buffer.data (), 0, key.size ());
+        available = buffer.size () - key.size ();
+    }
+};
+
 void
 csprng_engine::mix (
     void* data, std::size_t size, double bitsPerByte)
@@ -38,10 +105,20 @@ csprng_engine::mix (
 
     std::lock_guard<std::mutex> lock (mutex_);
     RAND_add (data, size, (size * bitsPerByte) / 8.0);
+    ++generation_;
 }
 
 csprng_engine::csprng_engine ()
+    : generation_ (0)
 {
+#ifndef _WIN32
+    static std::once_flag once;
+    std::call_once (once, []
+        {
+            pthread_atfork (nullptr, nullptr, &onFork);
+        });
+#endif
+
     mix_entropy ();
 }
 
@@ -58,6 +135,7 @@ csprng_engine::load_state (std::string const& file)
         std::lock_guard<std::mutex> lock (mutex_);
         RAND_load_file (file.c_str (), 1024);
         RAND_write_file (file.c_str ());
+        ++generation_;
     }
 }
 
@@ -99,34 +177,78 @@ csprng_engine::mix_entropy (void* buffer, std::size_t count)
         mix (buffer, count, 0.5);
 }
 
-csprng_engine::result_type
-csprng_engine::operator()()
+csprng_engine::state&
+csprng_engine::local ()
 {
-    result_type ret;
+    static thread_local state s;
 
-    std::lock_guard<std::mutex> lock (mutex_);
+    if (s.engine != this ||
+        s.generation != generation_.load () ||
+        s.forks != forks.load () ||
+        s.sinceReseed >= state::reseedBytes)
+    {
+        reseed (s);
+    }
+
+    return s;
+}
+
+void
+csprng_engine::reseed (state& s)
+{
+    // Read these first: a change made while we are
+    // seeding causes another reseed on the next call.
+    auto const generation = generation_.load ();
+    auto const forkCount = forks.load ();
+
+    // Output buffered under the old key is discarded
+    OPENSSL_cleanse (s.buffer.data (), s.buffer.size ());
+    s.available = 0;
 
-    auto const result = RAND_bytes (
-        reinterpret_cast<unsigned char*>(&ret),
-        sizeof(ret));
+    {
+        std::lock_guard<std::mutex> lock (mutex_);
 
-    if (result == 0)
-        Throw<std::runtime_error> ("Insufficient entropy");
+        auto const result = RAND_bytes (s.key.data (), s.key.size ());
 
+        if (result != 1)
+            Throw<std::runtime_error> ("Insufficient entropy");
+    }
+
+    s.engine = this;
+    s.generation = generation;
+    s.forks = forkCount;
+    s.sinceReseed = 0;
+}
+
+csprng_engine::result_type
+csprng_engine::operator()()
+{
+    result_type ret;
+    (*this) (&ret, sizeof(ret));
     return ret;
 }
 
 void
 csprng_engine::operator()(void *ptr, std::size_t count)
 {
-    std::lock_guard<std::mutex> lock (mutex_);
+    auto& s = local ();
+    auto out = reinterpret_cast<std::uint8_t*>(ptr);
 
-    auto const result = RAND_bytes (
-        reinterpret_cast<unsigned char*>(ptr),
-        count);
+    while (count != 0)
+    {
+        if (s.available == 0)
+            s.refill ();
 
-    if (result != 1)
-        Throw<std::runtime_error> ("Insufficient entropy");
+        auto const n = std::min (count, s.available);
+        auto const p = s.buffer.data () + s.buffer.size () - s.available;
+        std::memcpy (out, p, n);
+        std::memset (p, 0, n);
+
+        s.available -= n;
+        s.sinceReseed += n;
+        out += n;
+        count -= n;
+    }
 }
 
 csprng_engine& crypto_prng()
@@ -177,6 +177,26 @@ private:
         return jvRequest;
     }
 
+    // job_trace [chrome] [clear]
+    Json::Value parseJobTrace (Json::Value const& jvParams)
+    {
+        Json::Value     jvRequest (Json::objectValue);
+
+        for (unsigned int i = 0; i < jvParams.size (); ++i)
+        {
+            std::string const strParam = jvParams[i].asString ();
+
+            if (strParam == "chrome")
+                jvRequest[jss::format] = strParam;
+            else if (strParam == "clear")
+                jvRequest[jss::clear] = true;
+            else
+                return rpcError (rpcINVALID_PARAMS);
+        }
+
+        return jvRequest;
+    }
+
     // account_tx accountID [ledger_min [ledger_max [limit [offset]]]] [binary] [count] [descending]
     Json::Value
     parseAccountTransactions (Json::Value const& jvParams)
@@ -1049,6 +1069,7 @@ public:
             {   "fetch_info",           &RPCParser::parseFetchInfo,             0,  1   },
             {   "gateway_balances",     &RPCParser::parseGatewayBalances  ,     1,  -1  },
             {   "get_counts",           &RPCParser::parseGetCounts,             0,  1   },
+            {   "job_trace",            &RPCParser::parseJobTrace,              0,  2   },
             {   "json",                 &RPCParser::parseJson,                  2,  2   },
             {   "json2",                &RPCParser::parseJson2,                 1,  1   },
             {   "ledger",               &RPCParser::parseLedger,                0,  2   },
@@ -22,7 +22,12 @@
 
 #include <ripple/nodestore/NodeObject.h>
 #include <ripple/nodestore/Backend.h>
+#include <ripple/nodestore/FetchPriority.h>
+#include <ripple/nodestore/Importer.h>
+#include <ripple/nodestore/ShardStore.h>
 #include <ripple/basics/TaggedCache.h>
+#include <chrono>
+#include <functional>
 
 namespace ripple {
 namespace NodeStore {
@@ -43,6 +48,10 @@ namespace NodeStore {
 class Database
 {
 public:
+    /** Called when a read scheduled by asyncFetch completes. */
+    using ReadCallback =
+        std::function <void (std::shared_ptr<NodeObject> const&)>;
+
     /** Destroy the node store.
         All pending operations are completed, pending writes flushed,
         and files closed before this returns.
@@ -71,6 +80,24 @@ public:
     */
     virtual std::shared_ptr<NodeObject> fetch (uint256 const& hash) = 0;
 
+    /** Fetch an object, giving up if the disk is too busy.
+        Reads which must go to disk wait their turn behind reads of higher
+        priority. Unlike the other overload, which uses the priority of
+        the calling thread and waits indefinitely, this returns `nullptr`
+        if the read cannot start before `deadline`. An abandoned read
+        does not mark the object as missing.
+
+        @note This can be called concurrently.
+        @param hash The key of the object to retrieve.
+        @param priority The class the read is scheduled in.
+        @param deadline The latest time at which the read may start.
+        @return The object, or nullptr if it couldn't be retrieved.
+        @see FetchPriority
+    */
+    virtual std::shared_ptr<NodeObject> fetch (uint256 const& hash,
+        FetchPriority priority,
+        std::chrono::steady_clock::time_point deadline) = 0;
+
     /** Fetch an object without waiting.
         If I/O is required to determine whether or not the object is present,
         `false` is returned. Otherwise, `true` is returned and `object` is set
@@ -84,6 +111,23 @@ public:
     */
     virtual bool asyncFetch (uint256 const& hash, std::shared_ptr<NodeObject>& object) = 0;
 
+    /** Fetch an object without waiting, with notification on completion.
+        Behaves like the other overload, except that when I/O is scheduled
+        `callback` is invoked once the read finishes, with the object or
+        `nullptr` if it is not present. Scheduled reads are performed in
+        order of the calling thread's fetch priority. Callbacks run on a
+        read thread and must not block. Reads still pending when the
+        database is destroyed complete with `nullptr`.
+
+        @note This can be called concurrently.
+        @param hash The key of the object to retrieve
+        @param object The object retrieved
+        @param callback Invoked when a scheduled read completes
+        @return Whether the operation completed
+    */
+    virtual bool asyncFetch (uint256 const& hash,
+        std::shared_ptr<NodeObject>& object, ReadCallback callback) = 0;
+
     /** Wait for all currently pending async reads to complete.
     */
     virtual void waitReads () = 0;
@@ -109,6 +153,12 @@ public:
                         Blob&& data,
                         uint256 const& hash) = 0;
 
+    /** Store a batch of objects.
+        Each object is added to the cache, and the whole batch is
+        handed to the backend at once. May be called concurrently.
+    */
+    virtual void storeBatch (Batch const& batch) = 0;
+
     /** Visit every object in the database
         This is usually called during import.
 
@@ -118,8 +168,17 @@ public:
     */
     virtual void for_each(std::function <void(std::shared_ptr<NodeObject>)> f) = 0;
 
-    /** Import objects from another database. */
-    virtual void import (Database& source) = 0;
+    /** Import objects from another database.
+        @see Importer
+    */
+    virtual void import (Database& source,
+        Importer::Setup const& setup) = 0;
+
+    /** Look in history shards for objects missing from the backend.
+        Objects found there are cached but never copied to the backend.
+        Must be called before the database is used.
+    */
+    virtual void setShards (std::shared_ptr<ShardStore> shards) = 0;
 
     /** Retrieve the estimated number of pending write operations.
         This is used for diagnostics.
@@ -0,0 +1,130 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_NODESTORE_FETCHPRIORITY_H_INCLUDED
+#define RIPPLE_NODESTORE_FETCHPRIORITY_H_INCLUDED
+
+#include <ripple/core/Job.h>
+#include <boost/optional.hpp>
+
+namespace ripple {
+namespace NodeStore {
+
+/** The urgency of a read from the node store.
+
+    Reads which go to disk are admitted by priority, so that background
+    work cannot starve the reads which keep the server in consensus.
+    Classes are listed from most to least urgent.
+*/
+enum class FetchPriority
+{
+    consensus,  // Tracking and building the current ledger
+    sync,       // Acquiring ledgers and transaction sets from peers
+    client      // Serving clients, peers, and background work
+};
+
+/** The number of distinct fetch priorities. */
+static int constexpr fetchPriorityCount = 3;
+
+/** Returns the fetch priority for work done by a job of the given type.
+    Only the jobs which keep the server in consensus are exempt from
+    throttling; any other job is treated as client work.
+*/
+inline
+FetchPriority
+fetchPriority (JobType type)
+{
+    switch (type)
+    {
+    case jtTRANSACTION_l:
+    case jtTRANSACTION:
+    case jtBATCH:
+    case jtPROPOSAL_t:
+    case jtVALIDATION_t:
+    case jtACCEPT:
+    case jtPUBLEDGER:
+    case jtWAL:
+    case jtWRITE:
+    case jtNETOP_TIMER:
+        return FetchPriority::consensus;
+
+    case jtLEDGER_DATA:
+    case jtTXN_DATA:
+    case jtPUBOLDLEDGER:
+    case jtADVANCE:
+        return FetchPriority::sync;
+
+    default:
+        break;
+    }
+    return FetchPriority::client;
+}
+
+/** Sets the fetch priority of the calling thread for a scope.
+
+    Fetches which are not given an explicit priority use the one
+    in effect on the calling thread. Threads which never set one
+    fetch at the priority of the job they are running, or at client
+    priority outside of a job, so that background work is throttled
+    unless it is known to be urgent.
+*/
+class ScopedFetchPriority
+{
+public:
+    explicit
+    ScopedFetchPriority (FetchPriority priority)
+        : saved_ (get())
+    {
+        get() = priority;
+    }
+
+    ~ScopedFetchPriority ()
+    {
+        get() = saved_;
+    }
+
+    ScopedFetchPriority (ScopedFetchPriority const&) = delete;
+    ScopedFetchPriority& operator= (ScopedFetchPriority const&) = delete;
+
+    /** Returns the fetch priority in effect on the calling thread. */
+    static
+    FetchPriority
+    current ()
+    {
+        if (auto const priority = get())
+            return *priority;
+        return fetchPriority (Job::running ());
+    }
+
+private:
+    static
+    boost::optional <FetchPriority>&
+    get ()
+    {
+        static thread_local boost::optional <FetchPriority> priority;
+        return priority;
+    }
+
+    boost::optional <FetchPriority> saved_;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,121 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_NODESTORE_IMPORTER_H_INCLUDED
+#define RIPPLE_NODESTORE_IMPORTER_H_INCLUDED
+
+#include <ripple/nodestore/Backend.h>
+#include <ripple/basics/BasicConfig.h>
+#include <ripple/beast/utility/Journal.h>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace ripple {
+namespace NodeStore {
+
+class Database;
+
+/** Copies every object in a database into a backend.
+
+    The import is a pipeline. The source is read on the calling thread,
+    and its objects are grouped into batches. A writer thread stores the
+    batches in the order they were read while the next ones are read.
+    Optionally a pool of workers checks each batch before it is written,
+    so that corrupt objects are not copied.
+
+    Progress is logged periodically. When a checkpoint file is set, the
+    number of objects handled is saved in it, and an interrupted import
+    of the same source resumes after them. Those objects are still read
+    from the source, but they are not written again.
+*/
+class Importer
+{
+public:
+    struct Setup
+    {
+        /** The number of objects written at once. */
+        std::size_t batchSize = 4096;
+
+        /** The number of batches read ahead of the writer. */
+        std::size_t queueDepth = 8;
+
+        /** Threads checking objects, besides the writer. */
+        std::size_t threads = 4;
+
+        /** Check that the key of each object is the hash of its data. */
+        bool verify = false;
+
+        /** The file recording progress, or empty for none. */
+        std::string checkpoint;
+
+        /** Time between progress reports. */
+        std::chrono::seconds reportInterval {30};
+    };
+
+    struct Stats
+    {
+        /** Objects read and passed to the writer. */
+        std::uint64_t read = 0;
+
+        /** Objects passed over because an earlier import wrote them. */
+        std::uint64_t skipped = 0;
+
+        /** Objects stored, and the size of their data. */
+        std::uint64_t written = 0;
+        std::uint64_t bytes = 0;
+
+        /** Objects that failed verification and were not stored. */
+        std::uint64_t corrupt = 0;
+    };
+
+    Importer (Setup const& setup, beast::Journal journal);
+
+    /** Copy the objects of a database into a backend.
+        @throws std::exception if reading or writing fails. The
+                checkpoint, if any, is kept so that the import can
+                be resumed.
+    */
+    Stats
+    run (Database& source, Backend& dest);
+
+private:
+    class Pipeline;
+
+    Setup const setup_;
+    beast::Journal journal_;
+};
+
+/** Build import settings from a configuration section.
+
+    Recognized keys are:
+        import_batch        Objects written at once.
+        import_threads      Threads verifying objects.
+        import_verify       1 to check each object against its key.
+        import_checkpoint   File recording progress, so that an
+                            interrupted import can be resumed.
+*/
+Importer::Setup
+setup_Importer (Section const& config);
+
+}
+}
+
+#endif
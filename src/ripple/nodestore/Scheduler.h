@@ -20,6 +20,7 @@
 #ifndef RIPPLE_NODESTORE_SCHEDULER_H_INCLUDED
 #define RIPPLE_NODESTORE_SCHEDULER_H_INCLUDED
 
+#include <ripple/nodestore/FetchPriority.h>
 #include <ripple/nodestore/Task.h>
 #include <chrono>
 
@@ -30,6 +31,8 @@ namespace NodeStore {
 struct FetchReport
 {
     std::chrono::milliseconds elapsed;
+    std::chrono::milliseconds waited;   // part of elapsed spent queued
+    FetchPriority priority;
     bool isAsync;
     bool wentToDisk;
     bool wasFound;
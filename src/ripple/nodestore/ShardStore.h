@@ -0,0 +1,169 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_NODESTORE_SHARDSTORE_H_INCLUDED
+#define RIPPLE_NODESTORE_SHARDSTORE_H_INCLUDED
+
+#include <ripple/nodestore/NodeObject.h>
+#include <ripple/nodestore/Scheduler.h>
+#include <ripple/nodestore/Types.h>
+#include <ripple/basics/BasicConfig.h>
+#include <ripple/beast/utility/Journal.h>
+#include <boost/optional.hpp>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ripple {
+namespace NodeStore {
+
+/** Read-only archives of complete, fixed-size ranges of ledgers.
+
+    History is divided into shards of `ledgersPerShard` consecutive
+    ledgers: shard `i` holds ledgers `i * ledgersPerShard + 1` through
+    `(i + 1) * ledgersPerShard`. Once every ledger in a range is
+    available, its headers and the nodes of its state and transaction
+    maps are written to a new NuDB database of its own, together with
+    an index of the ledger hashes it holds.
+
+    A finalized shard is never written again. It is self-contained, so
+    the directory holding it can be moved to other storage, or exported
+    and imported on another server.
+*/
+class ShardStore
+{
+public:
+    /** Receives the contents of a shard while it is being built.
+        Destroying a writer that was not finalized discards its work.
+    */
+    class Writer
+    {
+    public:
+        virtual ~Writer() = default;
+
+        /** Add objects to the shard. */
+        virtual void store (Batch const& batch) = 0;
+
+        /** Record that a ledger, and all of its nodes, were stored.
+            Ledgers must be added in order.
+        */
+        virtual void addLedger (std::uint32_t seq, uint256 const& hash) = 0;
+
+        /** Make the shard available for reads.
+            @return `false` if the shard is incomplete or already exists.
+        */
+        virtual bool finalize () = 0;
+    };
+
+    /** Returns the hash of the validated ledger with a sequence.
+        Returns none if the hash is not known.
+    */
+    using ValidatedHash =
+        std::function<boost::optional<uint256>(std::uint32_t seq)>;
+
+    virtual ~ShardStore() = default;
+
+    /** The number of ledgers in each shard. */
+    virtual std::uint32_t ledgersPerShard () const = 0;
+
+    /** The index of the shard holding a ledger. */
+    std::uint32_t
+    shardIndex (std::uint32_t seq) const
+    {
+        return (seq - 1) / ledgersPerShard ();
+    }
+
+    /** The first ledger in a shard. */
+    std::uint32_t
+    firstSeq (std::uint32_t index) const
+    {
+        return index * ledgersPerShard () + 1;
+    }
+
+    /** The last ledger in a shard. */
+    std::uint32_t
+    lastSeq (std::uint32_t index) const
+    {
+        return (index + 1) * ledgersPerShard ();
+    }
+
+    /** Whether a shard has been finalized. */
+    virtual bool hasShard (std::uint32_t index) const = 0;
+
+    /** The indexes of the finalized shards, in ascending order. */
+    virtual std::vector<std::uint32_t> getShards () const = 0;
+
+    /** Start building a shard. */
+    virtual std::unique_ptr<Writer> makeWriter (std::uint32_t index) = 0;
+
+    /** Fetch an object from whichever shard holds it.
+        @note This can be called concurrently.
+        @return The object, or nullptr if no shard holds it.
+    */
+    virtual std::shared_ptr<NodeObject> fetch (uint256 const& hash) = 0;
+
+    /** Add a shard exported by another server.
+        The directory is copied and checked before the shard is used:
+        every object must be keyed by the hash of its data, and the
+        ledger headers must link back from a ledger this server knows
+        to be validated.
+        @param path The directory holding the shard.
+        @param validated Looks up the hashes of validated ledgers.
+        @return The index of the imported shard.
+        @throws std::runtime_error if the shard is invalid or present.
+    */
+    virtual std::uint32_t importShard (std::string const& path,
+        ValidatedHash const& validated) = 0;
+
+    /** Copy a finalized shard so that another server can import it.
+        @param index The shard to copy.
+        @param path The directory to create, which must not exist.
+        @throws std::runtime_error if the shard is missing.
+    */
+    virtual void exportShard (std::uint32_t index,
+        std::string const& path) = 0;
+
+    /** The number of fetches, and how many found an object. */
+    virtual std::uint64_t getFetchCount () const = 0;
+    virtual std::uint64_t getFetchHitCount () const = 0;
+
+    /** Return the number of files needed by the open shards. */
+    virtual int fdlimit () const = 0;
+};
+
+/** Open the shards stored under the configured path.
+
+    Recognized keys in the section are:
+        path                The directory holding the shards. Required.
+        ledgers_per_shard   The number of ledgers in each shard, which must
+                            match across servers exchanging shards.
+                            Defaults to 16384.
+
+    Shards left incomplete by a previous run are removed.
+*/
+std::unique_ptr<ShardStore>
+make_ShardStore (Section const& config,
+    Scheduler& scheduler, beast::Journal journal);
+
+}
+}
+
+#endif
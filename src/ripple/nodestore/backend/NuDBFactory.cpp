@@ -25,6 +25,7 @@
 #include <ripple/nodestore/impl/codec.h>
 #include <ripple/nodestore/impl/DecodedBlob.h>
 #include <ripple/nodestore/impl/EncodedBlob.h>
+#include <ripple/nodestore/impl/WorkerPool.h>
 #include <nudb/nudb.hpp>
 #include <boost/filesystem.hpp>
 #include <cassert>
@@ -47,6 +48,9 @@ public:
         // distribution of data sizes.
         arena_alloc_size = 16 * 1024 * 1024,
 
+        // Records decompressed together by for_each
+        visit_batch_size = 4096,
+
         currentType = 1
     };
 
@@ -57,6 +61,10 @@ public:
     std::atomic <bool> deletePath_;
     Scheduler& scheduler_;
 
+    // Overlaps the reads in fetchBatch, the compression in storeBatch
+    // and the decompression in for_each
+    WorkerPool pool_;
+
     NuDBBackend (int keyBytes, Section const& keyValues,
         Scheduler& scheduler, beast::Journal journal)
         : journal_ (journal)
@@ -64,6 +72,7 @@ public:
         , name_ (get<std::string>(keyValues, "path"))
         , deletePath_(false)
         , scheduler_ (scheduler)
+        , pool_ (get<std::size_t>(keyValues, "io_threads", 4), "NuDB")
     {
         if (name_.empty())
             Throw<std::runtime_error> (
@@ -155,30 +164,57 @@ public:
     bool
     canFetchBatch() override
     {
-        return false;
+        return true;
     }
 
     std::vector<std::shared_ptr<NodeObject>>
     fetchBatch (std::size_t n, void const* const* keys) override
     {
-        Throw<std::runtime_error> ("pure virtual called");
-        return {};
+        // Missing and corrupt objects are returned as null
+        std::vector<std::shared_ptr<NodeObject>> results (n);
+        pool_.for_each (n,
+            [&](std::size_t i)
+            {
+                if (fetch (keys[i], &results[i]) != ok)
+                    results[i].reset();
+            });
+        return results;
     }
 
+    // A node object encoded and compressed, ready to insert
+    struct Compressed
+    {
+        EncodedBlob encoded;
+        nudb::detail::buffer bf;
+        std::pair<void const*, std::size_t> result;
+
+        void
+        prepare (std::shared_ptr <NodeObject> const& no)
+        {
+            encoded.prepare (no);
+            result = nodeobject_compress(
+                encoded.getData(), encoded.getSize(), bf);
+        }
+    };
+
     void
-    do_insert (std::shared_ptr <NodeObject> const& no)
+    do_insert (Compressed const& c)
     {
-        EncodedBlob e;
-        e.prepare (no);
         nudb::error_code ec;
-        nudb::detail::buffer bf;
-        auto const result = nodeobject_compress(
-            e.getData(), e.getSize(), bf);
-        db_.insert (e.getKey(), result.first, result.second, ec);
+        db_.insert (c.encoded.getKey(),
+            c.result.first, c.result.second, ec);
         if(ec && ec != nudb::error::key_exists)
             Throw<nudb::system_error>(ec);
     }
 
+    void
+    do_insert (std::shared_ptr <NodeObject> const& no)
+    {
+        Compressed c;
+        c.prepare (no);
+        do_insert (c);
+    }
+
     void
     store (std::shared_ptr <NodeObject> const& no) override
     {
@@ -197,12 +233,19 @@ public:
     storeBatch (Batch const& batch) override
     {
         BatchWriteReport report;
-        EncodedBlob encoded;
         report.writeCount = batch.size();
         auto const start =
             std::chrono::steady_clock::now();
-        for (auto const& e : batch)
-            do_insert (e);
+        // Compress in parallel, then insert in order. The
+        // store only allows one inserting thread at a time.
+        std::vector<Compressed> compressed (batch.size());
+        pool_.for_each (batch.size(),
+            [&](std::size_t i)
+            {
+                compressed[i].prepare (batch[i]);
+            });
+        for (auto const& c : compressed)
+            do_insert (c);
         report.elapsed = std::chrono::duration_cast <
             std::chrono::milliseconds>(
                 std::chrono::steady_clock::now() - start);
@@ -220,28 +263,73 @@ public:
         db_.close(ec);
         if(ec)
             Throw<nudb::system_error>(ec);
-        nudb::visit(dp,
-            [&](
-                void const* key, std::size_t key_bytes,
-                void const* data, std::size_t size,
-                nudb::error_code&)
+        // Records are copied out of the data file in groups, which
+        // are decompressed in parallel and then visited in order.
+        struct Record
+        {
+            Blob key;
+            Blob data;
+            std::shared_ptr<NodeObject> object;
+        };
+        std::vector<Record> records;
+        records.reserve (visit_batch_size);
+        auto const flush =
+            [&]()
             {
-                nudb::detail::buffer bf;
-                auto const result =
-                    nodeobject_decompress(data, size, bf);
-                DecodedBlob decoded (key, result.first, result.second);
-                if (! decoded.wasOk ())
+                pool_.for_each (records.size(),
+                    [&](std::size_t i)
+                    {
+                        auto& r = records[i];
+                        nudb::detail::buffer bf;
+                        auto const result = nodeobject_decompress(
+                            r.data.data(), r.data.size(), bf);
+                        DecodedBlob decoded (r.key.data(),
+                            result.first, result.second);
+                        if (decoded.wasOk ())
+                            r.object = decoded.createObject();
+                    });
+                for (auto& r : records)
                 {
-                    ec = make_error_code(nudb::error::missing_value);
-                    return;
+                    if (! r.object)
+                        return false;
+                    f (std::move (r.object));
                 }
-                f (decoded.createObject());
-            }, nudb::no_progress{}, ec);
-        if(ec)
-            Throw<nudb::system_error>(ec);
-        db_.open(dp, kp, lp, ec);
+                records.clear();
+                return true;
+            };
+        // A corrupt record throws from the decompression; the
+        // database is reopened before the error is passed on.
+        std::exception_ptr error;
+        try
+        {
+            nudb::visit(dp,
+                [&](
+                    void const* key, std::size_t key_bytes,
+                    void const* data, std::size_t size,
+                    nudb::error_code& vec)
+                {
+                    auto const k = static_cast<std::uint8_t const*>(key);
+                    auto const d = static_cast<std::uint8_t const*>(data);
+                    records.push_back ({Blob (k, k + key_bytes),
+                        Blob (d, d + size), nullptr});
+                    if (records.size() >= visit_batch_size && ! flush())
+                        vec = make_error_code(nudb::error::missing_value);
+                }, nudb::no_progress{}, ec);
+            if(! ec && ! flush())
+                ec = make_error_code(nudb::error::missing_value);
+        }
+        catch (std::exception const&)
+        {
+            error = std::current_exception();
+        }
+        nudb::error_code oec;
+        db_.open(dp, kp, lp, oec);
+        if (error)
+            std::rethrow_exception (error);
         if(ec)
             Throw<nudb::system_error>(ec);
+        if(oec)
+            Throw<nudb::system_error>(oec);
     }
 
     int
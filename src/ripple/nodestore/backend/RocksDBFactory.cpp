@@ -279,27 +279,7 @@ public:
     void
     storeBatch (Batch const& batch) override
     {
-        rocksdb::WriteBatch wb;
-
-        EncodedBlob encoded;
-
-        for (auto const& e : batch)
-        {
-            encoded.prepare (e);
-
-            wb.Put (
-                rocksdb::Slice (reinterpret_cast <char const*> (
-                    encoded.getKey ()), m_keyBytes),
-                rocksdb::Slice (reinterpret_cast <char const*> (
-                    encoded.getData ()), encoded.getSize ()));
-        }
-
-        rocksdb::WriteOptions const options;
-
-        auto ret = m_db->Write (options, &wb);
-
-        if (! ret.ok ())
-            Throw<std::runtime_error> ("storeBatch failed: " + ret.ToString());
+        prepareBatch (batch)->commit ();
     }
 
     void
@@ -353,12 +333,59 @@ public:
 
     //--------------------------------------------------------------------------
 
+    // A write batch, encoded and ready to be applied
+    class PreparedWrite : public BatchWriter::Prepared
+    {
+    public:
+        explicit PreparedWrite (rocksdb::DB& db)
+            : db_ (db)
+        {
+        }
+
+        void
+        commit () override
+        {
+            rocksdb::WriteOptions const options;
+
+            auto ret = db_.Write (options, &wb_);
+
+            if (! ret.ok ())
+                Throw<std::runtime_error> ("storeBatch failed: " + ret.ToString());
+        }
+
+        rocksdb::WriteBatch wb_;
+
+    private:
+        rocksdb::DB& db_;
+    };
+
     void
     writeBatch (Batch const& batch) override
     {
         storeBatch (batch);
     }
 
+    std::unique_ptr <BatchWriter::Prepared>
+    prepareBatch (Batch const& batch) override
+    {
+        auto prepared = std::make_unique <PreparedWrite> (*m_db);
+
+        EncodedBlob encoded;
+
+        for (auto const& e : batch)
+        {
+            encoded.prepare (e);
+
+            prepared->wb_.Put (
+                rocksdb::Slice (reinterpret_cast <char const*> (
+                    encoded.getKey ()), m_keyBytes),
+                rocksdb::Slice (reinterpret_cast <char const*> (
+                    encoded.getData ()), encoded.getSize ()));
+        }
+
+        return std::move (prepared);
+    }
+
     void
     verify() override
     {
@@ -19,15 +19,62 @@
 
 #include <BeastConfig.h>
 #include <ripple/nodestore/impl/BatchWriter.h>
+#include <ripple/nodestore/impl/Tuning.h>
+#include <algorithm>
+#include <cassert>
+#include <iterator>
 
 namespace ripple {
 namespace NodeStore {
 
+namespace {
+
+// Leaves all of the work to Callback::writeBatch
+class DeferredBatch : public BatchWriter::Prepared
+{
+public:
+    DeferredBatch (BatchWriter::Callback& callback, Batch const& batch)
+        : m_callback (callback)
+        , m_batch (batch)
+    {
+    }
+
+    void commit () override
+    {
+        m_callback.writeBatch (m_batch);
+    }
+
+private:
+    BatchWriter::Callback& m_callback;
+    Batch m_batch;
+};
+
+}
+
+std::unique_ptr <BatchWriter::Prepared>
+BatchWriter::Callback::prepareBatch (Batch const& batch)
+{
+    return std::make_unique <DeferredBatch> (*this, batch);
+}
+
+void
+BatchWriter::Committer::performScheduledTask ()
+{
+    m_writer.commitBatches ();
+}
+
+//------------------------------------------------------------------------------
+
 BatchWriter::BatchWriter (Callback& callback, Scheduler& scheduler)
     : m_callback (callback)
     , m_scheduler (scheduler)
+    , m_committer (*this)
+    , mPreparedLoad (0)
     , mWriteLoad (0)
-    , mWritePending (false)
+    , mPreparing (false)
+    , mCommitting (false)
+    , mBatchLimit (batchWriteMaximumSize)
+    , mObjectMicros (0)
 {
     mWriteSet.reserve (batchWritePreallocationSize);
 }
@@ -40,16 +87,18 @@ BatchWriter::~BatchWriter ()
 void
 BatchWriter::store (std::shared_ptr<NodeObject> const& object)
 {
-    std::lock_guard<decltype(mWriteMutex)> sl (mWriteMutex);
-
-    mWriteSet.push_back (object);
-
-    if (! mWritePending)
     {
-        mWritePending = true;
+        std::lock_guard<decltype(mWriteMutex)> sl (mWriteMutex);
+
+        mWriteSet.push_back (object);
 
-        m_scheduler.scheduleTask (*this);
+        if (mPreparing)
+            return;
+        mPreparing = true;
     }
+
+    // The scheduler may run the task on this thread
+    m_scheduler.scheduleTask (*this);
 }
 
 int
@@ -57,61 +106,147 @@ BatchWriter::getWriteLoad ()
 {
     std::lock_guard<decltype(mWriteMutex)> sl (mWriteMutex);
 
-    return std::max (mWriteLoad, static_cast<int> (mWriteSet.size ()));
+    return static_cast<int> (mWriteSet.size ()) + mPreparedLoad + mWriteLoad;
 }
 
 void
 BatchWriter::performScheduledTask ()
 {
-    writeBatch ();
+    prepareBatches ();
 }
 
 void
-BatchWriter::writeBatch ()
+BatchWriter::prepareBatches ()
 {
     for (;;)
     {
-        std::vector< std::shared_ptr<NodeObject> > set;
+        Batch set;
 
-        set.reserve (batchWritePreallocationSize);
+        {
+            std::lock_guard<decltype(mWriteMutex)> sl (mWriteMutex);
 
+            // Only one encoded batch waits at a time. The committer
+            // restarts this stage when it takes that batch.
+            if (mPrepared || mWriteSet.empty ())
+            {
+                mPreparing = false;
+                mWriteCondition.notify_all ();
+                return;
+            }
+
+            if (mWriteSet.size () <= mBatchLimit)
+            {
+                set.reserve (batchWritePreallocationSize);
+                mWriteSet.swap (set);
+            }
+            else
+            {
+                auto const last = mWriteSet.begin () + mBatchLimit;
+                set.assign (std::make_move_iterator (mWriteSet.begin ()),
+                    std::make_move_iterator (last));
+                mWriteSet.erase (mWriteSet.begin (), last);
+            }
+        }
+
+        auto prepared = m_callback.prepareBatch (set);
+
+        bool startCommit = false;
         {
             std::lock_guard<decltype(mWriteMutex)> sl (mWriteMutex);
 
-            mWriteSet.swap (set);
-            assert (mWriteSet.empty ());
-            mWriteLoad = set.size ();
+            assert (! mPrepared);
+            mPrepared = std::move (prepared);
+            mPreparedLoad = set.size ();
+
+            if (! mCommitting)
+                startCommit = mCommitting = true;
+        }
+
+        if (startCommit)
+            m_scheduler.scheduleTask (m_committer);
+    }
+}
+
+void
+BatchWriter::commitBatches ()
+{
+    for (;;)
+    {
+        std::unique_ptr <Prepared> prepared;
+        int count;
+        bool startPrepare = false;
+
+        {
+            std::lock_guard<decltype(mWriteMutex)> sl (mWriteMutex);
 
-            if (set.empty ())
+            if (! mPrepared)
             {
-                mWritePending = false;
+                mCommitting = false;
                 mWriteCondition.notify_all ();
-
-                // VFALCO NOTE Fix this function to not return from the middle
                 return;
             }
 
+            prepared = std::move (mPrepared);
+            count = mPreparedLoad;
+            mWriteLoad = mPreparedLoad;
+            mPreparedLoad = 0;
+
+            if (! mPreparing && ! mWriteSet.empty ())
+                startPrepare = mPreparing = true;
         }
 
+        // Encode the next batch while this one is written
+        if (startPrepare)
+            m_scheduler.scheduleTask (*this);
+
         BatchWriteReport report;
-        report.writeCount = set.size();
+        report.writeCount = count;
         auto const before = std::chrono::steady_clock::now();
 
-        m_callback.writeBatch (set);
+        prepared->commit ();
 
+        auto const elapsed = std::chrono::steady_clock::now() - before;
         report.elapsed = std::chrono::duration_cast <std::chrono::milliseconds>
-            (std::chrono::steady_clock::now() - before);
-
+            (elapsed);
         m_scheduler.onBatchWrite (report);
+
+        std::lock_guard<decltype(mWriteMutex)> sl (mWriteMutex);
+        mWriteLoad = 0;
+        adjustBatchLimit (count, elapsed);
     }
 }
 
+void
+BatchWriter::adjustBatchLimit (std::size_t count,
+    std::chrono::steady_clock::duration elapsed)
+{
+    if (count == 0)
+        return;
+
+    // Track the average cost of writing an object, and size batches
+    // so that a commit takes about the target time. Large bursts are
+    // then split into batches whose encoding overlaps the commits.
+    auto const micros = std::chrono::duration <double, std::micro> (
+        elapsed).count () / count;
+    if (mObjectMicros == 0)
+        mObjectMicros = micros;
+    else
+        mObjectMicros = (3 * mObjectMicros + micros) / 4;
+
+    double const target = batchWriteTargetMilliseconds * 1000.0;
+    if (mObjectMicros * batchWriteMaximumSize <= target)
+        mBatchLimit = batchWriteMaximumSize;
+    else
+        mBatchLimit = std::max <std::size_t> (batchWriteMinimumSize,
+            static_cast <std::size_t> (target / mObjectMicros));
+}
+
 void
 BatchWriter::waitForWriting ()
 {
     std::unique_lock <decltype(mWriteMutex)> sl (mWriteMutex);
 
-    while (mWritePending)
+    while (mPreparing || mCommitting)
         mWriteCondition.wait (sl);
 }
 
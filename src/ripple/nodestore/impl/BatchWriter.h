@@ -23,7 +23,9 @@
 #include <ripple/nodestore/Scheduler.h>
 #include <ripple/nodestore/Task.h>
 #include <ripple/nodestore/Types.h>
+#include <chrono>
 #include <condition_variable>
+#include <memory>
 #include <mutex>
 
 namespace ripple {
@@ -35,15 +37,35 @@ namespace NodeStore {
     class it not required. A backend can implement its own write batching,
     or skip write batching if doing so yields a performance benefit.
 
+    Writing is pipelined in two stages, each run as its own scheduled
+    task: a batch is encoded while the previous one is committed to the
+    backend. The number of objects in a batch is adjusted so that each
+    commit takes about the same amount of time.
+
     @see Scheduler
 */
 class BatchWriter : private Task
 {
 public:
+    /** A batch that is encoded and ready to be written. */
+    struct Prepared
+    {
+        virtual ~Prepared () = default;
+
+        /** Write the batch to the backend. */
+        virtual void commit () = 0;
+    };
+
     /** This callback does the actual writing. */
     struct Callback
     {
         virtual void writeBatch (Batch const& batch) = 0;
+
+        /** Encode a batch without writing it.
+            This is called for the next batch while the previous one is
+            committed. The default defers all the work to writeBatch.
+        */
+        virtual std::unique_ptr <Prepared> prepareBatch (Batch const& batch);
     };
 
     /** Create a batch writer. */
@@ -62,25 +84,53 @@ public:
     */
     void store (std::shared_ptr<NodeObject> const& object);
 
-    /** Get an estimate of the amount of writing I/O pending. */
+    /** Get an estimate of the amount of writing I/O pending.
+
+        This is the number of objects waiting to be encoded, encoded
+        and waiting to be written, or being written.
+    */
     int getWriteLoad ();
 
 private:
-    void performScheduledTask ();
-    void writeBatch ();
+    // Commits encoded batches while the next one is encoded
+    class Committer : public Task
+    {
+    public:
+        explicit Committer (BatchWriter& writer)
+            : m_writer (writer)
+        {
+        }
+
+        void performScheduledTask () override;
+
+    private:
+        BatchWriter& m_writer;
+    };
+
+    void performScheduledTask () override;
+    void prepareBatches ();
+    void commitBatches ();
+    void adjustBatchLimit (std::size_t count,
+        std::chrono::steady_clock::duration elapsed);
     void waitForWriting ();
 
 private:
-    using LockType = std::recursive_mutex;
-    using CondvarType = std::condition_variable_any;
+    using LockType = std::mutex;
+    using CondvarType = std::condition_variable;
 
     Callback& m_callback;
     Scheduler& m_scheduler;
+    Committer m_committer;
     LockType mWriteMutex;
     CondvarType mWriteCondition;
-    int mWriteLoad;
-    bool mWritePending;
     Batch mWriteSet;
+    std::unique_ptr <Prepared> mPrepared;
+    int mPreparedLoad;
+    int mWriteLoad;
+    bool mPreparing;
+    bool mCommitting;
+    std::size_t mBatchLimit;
+    double mObjectMicros;
 };
 
 }
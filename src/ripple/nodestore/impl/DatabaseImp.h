@@ -22,6 +22,7 @@
 
 #include <ripple/nodestore/Database.h>
 #include <ripple/nodestore/Scheduler.h>
+#include <ripple/nodestore/impl/ReadScheduler.h>
 #include <ripple/nodestore/impl/Tuning.h>
 #include <ripple/basics/KeyCache.h>
 #include <ripple/basics/Log.h>
@@ -31,10 +32,13 @@
 #include <ripple/basics/Slice.h>
 #include <ripple/basics/TaggedCache.h>
 #include <ripple/beast/core/Thread.h>
+#include <algorithm>
+#include <array>
 #include <chrono>
 #include <condition_variable>
-#include <set>
+#include <map>
 #include <thread>
+#include <vector>
 
 namespace ripple {
 namespace NodeStore {
@@ -57,12 +61,17 @@ private:
     std::mutex                m_readLock;
     std::condition_variable   m_readCondVar;
     std::condition_variable   m_readGenCondVar;
-    std::set <uint256>        m_readSet;        // set of reads to do
-    uint256                   m_readLast;       // last hash read
+    std::array <std::map <uint256, std::vector <ReadCallback>>,
+        fetchPriorityCount>   m_readSet;        // reads to do by priority,
+                                                // and who to tell
+    std::array <uint256, fetchPriorityCount>
+                              m_readLast;       // last hash read by priority
     std::vector <std::thread> m_readThreads;
     bool                      m_readShut;
     uint64_t                  m_readGen;        // current read generation
     int                       fdlimit_;
+    std::shared_ptr <ShardStore> m_shards;   // searched after the backend
+    ReadScheduler             m_reads;          // admits reads that go to disk
 
 public:
     DatabaseImp (std::string const& name,
@@ -80,6 +89,8 @@ public:
         , m_readShut (false)
         , m_readGen (0)
         , fdlimit_ (0)
+        , m_reads (backgroundReadLimit, clientReadLimit,
+            std::chrono::milliseconds (clientReadMaxWaitMilliseconds))
         , m_storeCount (0)
         , m_fetchTotalCount (0)
         , m_fetchHitCount (0)
@@ -104,6 +115,12 @@ public:
 
         for (auto& e : m_readThreads)
             e.join();
+
+        // Nobody will perform the remaining reads
+        for (auto& reads : m_readSet)
+            for (auto& e : reads)
+                for (auto const& callback : e.second)
+                    callback (nullptr);
     }
 
     std::string
@@ -134,13 +151,78 @@ public:
         {
             // No. Post a read
             std::lock_guard <std::mutex> lock (m_readLock);
-            if (m_readSet.insert (hash).second)
-                m_readCondVar.notify_one ();
+            postRead (hash, ScopedFetchPriority::current (), nullptr);
+        }
+
+        return false;
+    }
+
+    bool asyncFetch (uint256 const& hash, std::shared_ptr<NodeObject>& object,
+        ReadCallback callback) override
+    {
+        object = m_cache.fetch (hash);
+        if (object || m_negCache.touch_if_exists (hash))
+            return true;
+
+        {
+            std::lock_guard <std::mutex> lock (m_readLock);
+            if (m_readShut)
+            {
+                object = nullptr;
+                return true;
+            }
+
+            postRead (hash, ScopedFetchPriority::current (),
+                std::move (callback));
         }
 
         return false;
     }
 
+    // Queue a read, or join one already queued. Must hold m_readLock.
+    void postRead (uint256 const& hash, FetchPriority priority,
+        ReadCallback callback)
+    {
+        auto const wanted = static_cast <std::size_t> (priority);
+
+        // A read queued at this priority or higher is shared
+        for (std::size_t i = 0; i <= wanted; ++i)
+        {
+            auto const iter = m_readSet[i].find (hash);
+            if (iter != m_readSet[i].end ())
+            {
+                if (callback)
+                    iter->second.push_back (std::move (callback));
+                return;
+            }
+        }
+
+        auto& callbacks = m_readSet[wanted][hash];
+
+        // A read queued at a lower priority moves up
+        for (auto i = wanted + 1; i < m_readSet.size (); ++i)
+        {
+            auto const iter = m_readSet[i].find (hash);
+            if (iter != m_readSet[i].end ())
+            {
+                callbacks = std::move (iter->second);
+                m_readSet[i].erase (iter);
+                break;
+            }
+        }
+
+        if (callback)
+            callbacks.push_back (std::move (callback));
+        m_readCondVar.notify_one ();
+    }
+
+    // Returns `true` if any read is queued. Must hold m_readLock.
+    bool readsPending () const
+    {
+        return std::any_of (m_readSet.begin (), m_readSet.end (),
+            [](auto const& reads) { return ! reads.empty (); });
+    }
+
     void waitReads() override
     {
         {
@@ -149,7 +231,7 @@ public:
             // Wake in two generations
             std::uint64_t const wakeGeneration = m_readGen + 2;
 
-            while (!m_readShut && !m_readSet.empty () && (m_readGen < wakeGeneration))
+            while (!m_readShut && readsPending () && (m_readGen < wakeGeneration))
                 m_readGenCondVar.wait (lock);
         }
 
@@ -165,18 +247,31 @@ public:
 
     std::shared_ptr<NodeObject> fetch (uint256 const& hash) override
     {
-        return doTimedFetch (hash, false);
+        return doTimedFetch (hash, false, ScopedFetchPriority::current (),
+            ReadScheduler::clock_type::time_point::max ());
+    }
+
+    std::shared_ptr<NodeObject> fetch (uint256 const& hash,
+        FetchPriority priority,
+        std::chrono::steady_clock::time_point deadline) override
+    {
+        return doTimedFetch (hash, false, priority, deadline);
     }
 
     /** Perform a fetch and report the time it took */
-    std::shared_ptr<NodeObject> doTimedFetch (uint256 const& hash, bool isAsync)
+    std::shared_ptr<NodeObject> doTimedFetch (uint256 const& hash,
+        bool isAsync, FetchPriority priority,
+        std::chrono::steady_clock::time_point deadline)
     {
         FetchReport report;
+        report.waited = std::chrono::milliseconds::zero ();
+        report.priority = priority;
         report.isAsync = isAsync;
         report.wentToDisk = false;
 
         auto const before = std::chrono::steady_clock::now();
-        std::shared_ptr<NodeObject> ret = doFetch (hash, report);
+        std::shared_ptr<NodeObject> ret =
+            doFetch (hash, report, priority, deadline);
         report.elapsed = std::chrono::duration_cast <std::chrono::milliseconds>
             (std::chrono::steady_clock::now() - before);
 
@@ -186,7 +281,9 @@ public:
         return ret;
     }
 
-    std::shared_ptr<NodeObject> doFetch (uint256 const& hash, FetchReport &report)
+    std::shared_ptr<NodeObject> doFetch (uint256 const& hash,
+        FetchReport &report, FetchPriority priority,
+        std::chrono::steady_clock::time_point deadline)
     {
         // See if the object already exists in the cache
         //
@@ -202,6 +299,16 @@ public:
 
         report.wentToDisk = true;
 
+        // Wait for our turn at the disk
+        auto const before = std::chrono::steady_clock::now ();
+        auto const permit = m_reads.acquire (priority, deadline);
+        report.waited = std::chrono::duration_cast <std::chrono::milliseconds>
+            (std::chrono::steady_clock::now () - before);
+
+        // Giving up says nothing about whether the object exists
+        if (! permit)
+            return obj;
+
         // Are we still without an object?
         //
         if (obj == nullptr)
@@ -212,6 +319,9 @@ public:
             ++m_fetchTotalCount;
         }
 
+        if (obj == nullptr && m_shards)
+            obj = m_shards->fetch (hash);
+
         if (obj == nullptr)
         {
 
@@ -307,6 +417,30 @@ public:
         m_negCache.erase (hash);
     }
 
+    void storeBatch (Batch const& batch) override
+    {
+        storeBatchInternal (batch, *m_backend.get());
+    }
+
+    void storeBatchInternal (Batch const& batch, Backend& backend)
+    {
+        for (auto const& object : batch)
+        {
+            #if RIPPLE_VERIFY_NODEOBJECT_KEYS
+            assert (object->getHash() ==
+                sha512Hash(makeSlice(object->getData())));
+            #endif
+
+            auto o = object;
+            m_cache.canonicalize (object->getHash(), o, true);
+            m_negCache.erase (object->getHash());
+            m_storeSize += object->getData().size();
+        }
+
+        backend.storeBatch (batch);
+        m_storeCount += batch.size();
+    }
+
     //------------------------------------------------------------------------------
 
     float getCacheHitRate () override
@@ -349,11 +483,13 @@ public:
         while (1)
         {
             uint256 hash;
+            FetchPriority priority;
+            std::vector <ReadCallback> callbacks;
 
             {
                 std::unique_lock <std::mutex> lock (m_readLock);
 
-                while (!m_readShut && m_readSet.empty ())
+                while (!m_readShut && ! readsPending ())
                 {
                     // all work is done
                     m_readGenCondVar.notify_all ();
@@ -363,24 +499,36 @@ public:
                 if (m_readShut)
                     break;
 
+                // Take the most urgent reads first
+                std::size_t p = 0;
+                while (m_readSet[p].empty ())
+                    ++p;
+                auto& reads = m_readSet[p];
+                priority = static_cast <FetchPriority> (p);
+
                 // Read in key order to make the back end more efficient
-                std::set <uint256>::iterator it = m_readSet.lower_bound (m_readLast);
-                if (it == m_readSet.end ())
+                auto it = reads.lower_bound (m_readLast[p]);
+                if (it == reads.end ())
                 {
-                    it = m_readSet.begin ();
+                    it = reads.begin ();
 
                     // A generation has completed
                     ++m_readGen;
                     m_readGenCondVar.notify_all ();
                 }
 
-                hash = *it;
-                m_readSet.erase (it);
-                m_readLast = hash;
+                hash = it->first;
+                callbacks = std::move (it->second);
+                reads.erase (it);
+                m_readLast[p] = hash;
             }
 
             // Perform the read
-            doTimedFetch (hash, true);
+            auto const obj = doTimedFetch (hash, true, priority,
+                ReadScheduler::clock_type::time_point::max ());
+
+            for (auto const& callback : callbacks)
+                callback (obj);
          }
      }
 
@@ -391,33 +539,23 @@ public:
         m_backend->for_each (f);
     }
 
-    void import (Database& source) override
+    void import (Database& source, Importer::Setup const& setup) override
     {
-        importInternal (source, *m_backend.get());
+        importInternal (source, *m_backend.get(), setup);
     }
 
-    void importInternal (Database& source, Backend& dest)
+    void importInternal (Database& source, Backend& dest,
+        Importer::Setup const& setup)
     {
-        Batch b;
-        b.reserve (batchWritePreallocationSize);
+        auto const stats = Importer (setup, m_journal).run (source, dest);
 
-        source.for_each ([&](std::shared_ptr<NodeObject> object)
-        {
-            if (b.size() >= batchWritePreallocationSize)
-            {
-                dest.storeBatch (b);
-                b.clear();
-                b.reserve (batchWritePreallocationSize);
-            }
-
-            b.push_back (object);
-            ++m_storeCount;
-            if (object)
-                m_storeSize += object->getData().size();
-        });
+        m_storeCount += stats.written;
+        m_storeSize += stats.bytes;
+    }
 
-        if (! b.empty())
-            dest.storeBatch (b);
+    void setShards (std::shared_ptr<ShardStore> shards) override
+    {
+        m_shards = std::move (shards);
     }
 
     std::uint32_t getStoreCount () const override
@@ -106,9 +106,9 @@ public:
         b.writableBackend->for_each (f);
     }
 
-    void import (Database& source) override
+    void import (Database& source, Importer::Setup const& setup) override
     {
-        importInternal (source, *getWritableBackend());
+        importInternal (source, *getWritableBackend(), setup);
     }
 
     void store (NodeObjectType type,
@@ -119,6 +119,11 @@ public:
                 *getWritableBackend());
     }
 
+    void storeBatch (Batch const& batch) override
+    {
+        storeBatchInternal (batch, *getWritableBackend());
+    }
+
     std::shared_ptr<NodeObject> fetchNode (uint256 const& hash) override
     {
         return fetchFrom (hash);
@@ -0,0 +1,338 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/nodestore/Importer.h>
+#include <ripple/nodestore/Database.h>
+#include <ripple/nodestore/impl/WorkerPool.h>
+#include <ripple/basics/contract.h>
+#include <ripple/basics/Log.h>
+#include <ripple/basics/Slice.h>
+#include <ripple/protocol/digest.h>
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+namespace ripple {
+namespace NodeStore {
+
+// Moves batches from the reading thread to the writing thread
+class Importer::Pipeline
+{
+public:
+    Pipeline (Importer const& importer, Database& source, Backend& dest)
+        : setup_ (importer.setup_)
+        , journal_ (importer.journal_)
+        , source_ (source)
+        , dest_ (dest)
+        , pool_ (setup_.verify ? setup_.threads : 0, "NodeStore.import")
+    {
+    }
+
+    Stats
+    run ()
+    {
+        position_ = resume_ = loadCheckpoint ();
+        saved_ = position_;
+        start_ = report_ = clock_type::now ();
+
+        std::thread writer ([this] { write (); });
+
+        try
+        {
+            read ();
+        }
+        catch (...)
+        {
+            finish ();
+            writer.join ();
+            throw;
+        }
+
+        finish ();
+        writer.join ();
+
+        if (error_)
+            std::rethrow_exception (error_);
+
+        if (! setup_.checkpoint.empty ())
+            boost::filesystem::remove (setup_.checkpoint);
+
+        report ("Import complete: ");
+        return stats_;
+    }
+
+private:
+    using clock_type = std::chrono::steady_clock;
+
+    void
+    read ()
+    {
+        Batch batch;
+        batch.reserve (setup_.batchSize);
+
+        std::uint64_t seen = 0;
+        source_.for_each ([&](std::shared_ptr<NodeObject> object)
+        {
+            if (seen < resume_)
+            {
+                ++seen;
+                ++stats_.skipped;
+                return;
+            }
+
+            batch.push_back (std::move (object));
+            if (batch.size () >= setup_.batchSize)
+            {
+                push (std::move (batch));
+                batch.clear ();
+                batch.reserve (setup_.batchSize);
+            }
+        });
+
+        if (! batch.empty ())
+            push (std::move (batch));
+    }
+
+    void
+    push (Batch&& batch)
+    {
+        std::unique_lock<std::mutex> lock (mutex_);
+        cv_.wait (lock, [this]
+        {
+            return queue_.size () < setup_.queueDepth || error_;
+        });
+
+        // The writer failed, stop reading
+        if (error_)
+            std::rethrow_exception (error_);
+
+        stats_.read += batch.size ();
+        queue_.push_back (std::move (batch));
+        cv_.notify_all ();
+    }
+
+    void
+    finish ()
+    {
+        std::lock_guard<std::mutex> lock (mutex_);
+        done_ = true;
+        cv_.notify_all ();
+    }
+
+    void
+    write ()
+    {
+        try
+        {
+            for (;;)
+            {
+                Batch batch;
+                {
+                    std::unique_lock<std::mutex> lock (mutex_);
+                    cv_.wait (lock, [this]
+                    {
+                        return ! queue_.empty () || done_;
+                    });
+                    if (queue_.empty ())
+                        return;
+                    batch = std::move (queue_.front ());
+                    queue_.pop_front ();
+                    cv_.notify_all ();
+                }
+
+                auto const count = batch.size ();
+                if (setup_.verify)
+                    check (batch);
+
+                if (! batch.empty ())
+                    dest_.storeBatch (batch);
+
+                stats_.written += batch.size ();
+                for (auto const& object : batch)
+                    stats_.bytes += object->getData ().size ();
+                position_ += count;
+
+                auto const now = clock_type::now ();
+                if (now - report_ >= setup_.reportInterval)
+                {
+                    report ("Importing: ");
+                    saveCheckpoint ();
+                    report_ = now;
+                }
+            }
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock (mutex_);
+            error_ = std::current_exception ();
+            cv_.notify_all ();
+        }
+    }
+
+    // Remove objects whose key is not the hash of their data
+    void
+    check (Batch& batch)
+    {
+        std::vector<char> bad (batch.size ());
+        pool_.for_each (batch.size (), [&](std::size_t i)
+        {
+            bad[i] = ! batch[i] || batch[i]->getHash () !=
+                sha512Half (makeSlice (batch[i]->getData ()));
+        });
+
+        std::size_t n = 0;
+        for (std::size_t i = 0; i < batch.size (); ++i)
+        {
+            if (! bad[i])
+            {
+                batch[n++] = std::move (batch[i]);
+                continue;
+            }
+
+            ++stats_.corrupt;
+            if (batch[i])
+            {
+                JLOG (journal_.error()) <<
+                    "Import: corrupt object " << batch[i]->getHash ();
+            }
+        }
+        batch.resize (n);
+    }
+
+    void
+    report (char const* what)
+    {
+        using namespace std::chrono;
+        auto const elapsed = duration_cast<seconds> (
+            clock_type::now () - start_).count ();
+        JLOG (journal_.warn()) <<
+            what << position_ << " objects read, " <<
+            stats_.written << " written (" <<
+            (stats_.bytes >> 20) << " MB), " <<
+            stats_.written / std::max<std::int64_t> (elapsed, 1) <<
+            "/s, " << stats_.corrupt << " corrupt";
+    }
+
+    std::uint64_t
+    loadCheckpoint ()
+    {
+        if (setup_.checkpoint.empty () ||
+                ! boost::filesystem::exists (setup_.checkpoint))
+            return 0;
+
+        std::ifstream in (setup_.checkpoint);
+        std::string name;
+        std::uint64_t position = 0;
+        if (! std::getline (in, name) || ! (in >> position) ||
+            name != source_.getName ())
+        {
+            JLOG (journal_.warn()) <<
+                "Import: ignoring checkpoint " << setup_.checkpoint;
+            return 0;
+        }
+
+        JLOG (journal_.warn()) <<
+            "Import: resuming after " << position << " objects";
+        return position;
+    }
+
+    // The backend may not have flushed the latest writes yet, so record
+    // the position reached at the previous report instead.
+    void
+    saveCheckpoint ()
+    {
+        if (setup_.checkpoint.empty ())
+            return;
+
+        auto const temp = setup_.checkpoint + ".tmp";
+        {
+            std::ofstream out (temp, std::ios::trunc);
+            out << source_.getName () << '\n' << saved_ << '\n';
+            out.flush ();
+            if (! out)
+                Throw<std::runtime_error> (
+                    "unable to write " + temp);
+        }
+        boost::filesystem::rename (temp, setup_.checkpoint);
+        saved_ = position_;
+    }
+
+    Setup const& setup_;
+    beast::Journal journal_;
+    Database& source_;
+    Backend& dest_;
+    WorkerPool pool_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Batch> queue_;
+    bool done_ = false;
+    std::exception_ptr error_;
+
+    // Only used by the reading thread
+    std::uint64_t resume_ = 0;
+
+    // Only used by the writing thread, until it is joined
+    std::uint64_t position_ = 0;
+    std::uint64_t saved_ = 0;
+    clock_type::time_point start_;
+    clock_type::time_point report_;
+
+    // read and skipped are counted by the reading thread, the rest
+    // by the writing thread
+    Stats stats_;
+};
+
+//------------------------------------------------------------------------------
+
+Importer::Importer (Setup const& setup, beast::Journal journal)
+    : setup_ (setup)
+    , journal_ (journal)
+{
+    if (setup_.batchSize == 0 || setup_.queueDepth == 0)
+        Throw<std::runtime_error> (
+            "nodestore: import batch size must be positive");
+}
+
+Importer::Stats
+Importer::run (Database& source, Backend& dest)
+{
+    Pipeline pipeline (*this, source, dest);
+    return pipeline.run ();
+}
+
+Importer::Setup
+setup_Importer (Section const& config)
+{
+    Importer::Setup setup;
+    get_if_exists (config, "import_batch", setup.batchSize);
+    get_if_exists (config, "import_threads", setup.threads);
+    get_if_exists (config, "import_verify", setup.verify);
+    get_if_exists (config, "import_checkpoint", setup.checkpoint);
+    return setup;
+}
+
+}
+}
@@ -0,0 +1,123 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/nodestore/impl/KeyFilter.h>
+#include <ripple/basics/contract.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace ripple {
+namespace NodeStore {
+
+// About 1% false positives
+static std::size_t const bitsPerKey = 10;
+static int const probes = 7;
+
+// Calls f with the index of each bit a key sets
+template <class Function>
+static
+void
+forEachProbe (uint256 const& key, std::uint64_t bits, Function&& f)
+{
+    std::uint64_t h[2];
+    std::memcpy (h, key.data (), sizeof (h));
+    h[1] |= 1;
+    for (int i = 0; i < probes; ++i)
+        f ((h[0] + i * h[1]) % bits);
+}
+
+KeyFilter::KeyFilter (std::size_t keys)
+    : words_ ((std::max<std::size_t> (keys, 1) * bitsPerKey + 63) / 64)
+{
+}
+
+void
+KeyFilter::insert (uint256 const& key)
+{
+    if (words_.empty ())
+        return;
+
+    forEachProbe (key, words_.size () * 64,
+        [this](std::uint64_t bit)
+        {
+            words_[bit / 64] |= std::uint64_t (1) << (bit % 64);
+        });
+}
+
+bool
+KeyFilter::mayContain (uint256 const& key) const
+{
+    if (words_.empty ())
+        return true;
+
+    bool found = true;
+    forEachProbe (key, words_.size () * 64,
+        [this, &found](std::uint64_t bit)
+        {
+            if (! (words_[bit / 64] & (std::uint64_t (1) << (bit % 64))))
+                found = false;
+        });
+    return found;
+}
+
+void
+KeyFilter::save (std::string const& path) const
+{
+    std::ofstream out (path, std::ios::binary | std::ios::trunc);
+    std::uint64_t const size = words_.size ();
+    out.write (reinterpret_cast<char const*> (&size), sizeof (size));
+    out.write (reinterpret_cast<char const*> (words_.data ()),
+        words_.size () * sizeof (std::uint64_t));
+    out.flush ();
+    if (! out)
+        Throw<std::runtime_error> ("unable to write key filter " + path);
+}
+
+boost::optional<KeyFilter>
+KeyFilter::load (std::string const& path)
+{
+    std::ifstream in (path, std::ios::binary | std::ios::ate);
+    if (! in)
+        return boost::none;
+
+    auto const length = static_cast<std::uint64_t> (in.tellg ());
+    in.seekg (0);
+
+    std::uint64_t size = 0;
+    if (! in.read (reinterpret_cast<char*> (&size), sizeof (size)) ||
+        size == 0 ||
+        length != sizeof (size) + size * sizeof (std::uint64_t))
+    {
+        return boost::none;
+    }
+
+    KeyFilter filter;
+    filter.words_.resize (size);
+    if (! in.read (reinterpret_cast<char*> (filter.words_.data ()),
+            size * sizeof (std::uint64_t)))
+        return boost::none;
+    return filter;
+}
+
+}
+}
@@ -0,0 +1,79 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+//==============================================================================
+
+#ifndef RIPPLE_NODESTORE_KEYFILTER_H_INCLUDED
+#define RIPPLE_NODESTORE_KEYFILTER_H_INCLUDED
+
+#include <ripple/basics/base_uint.h>
+#include <boost/optional.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ripple {
+namespace NodeStore {
+
+/** A Bloom filter over the keys of a read-only store.
+
+    Answers whether a store may hold a key without touching the disk.
+    A `false` answer is always right; a `true` answer is wrong for about
+    one key in a hundred that the store does not hold. Keys are already
+    uniform hashes, so the probe positions are taken from the key itself.
+*/
+class KeyFilter
+{
+public:
+    /** Create a filter which accepts every key. */
+    KeyFilter () = default;
+
+    /** Create an empty filter sized for a number of keys. */
+    explicit
+    KeyFilter (std::size_t keys);
+
+    void
+    insert (uint256 const& key);
+
+    /** Returns `false` if the key was certainly never inserted. */
+    bool
+    mayContain (uint256 const& key) const;
+
+    /** Write the filter to a file.
+        @throws std::runtime_error if the file can not be written.
+    */
+    void
+    save (std::string const& path) const;
+
+    /** Read a filter written by save.
+        @return none if the file is missing or malformed.
+    */
+    static
+    boost::optional<KeyFilter>
+    load (std::string const& path);
+
+private:
+    std::vector<std::uint64_t> words_;
+};
+
+}
+}
+
+#endif
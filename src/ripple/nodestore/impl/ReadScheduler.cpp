@@ -0,0 +1,151 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/nodestore/impl/ReadScheduler.h>
+#include <cassert>
+
+namespace ripple {
+namespace NodeStore {
+
+ReadScheduler::Permit::Permit (Permit&& other)
+    : scheduler_ (other.scheduler_)
+    , priority_ (other.priority_)
+{
+    other.scheduler_ = nullptr;
+}
+
+ReadScheduler::Permit::~Permit ()
+{
+    if (scheduler_)
+        scheduler_->release (priority_);
+}
+
+//------------------------------------------------------------------------------
+
+ReadScheduler::ReadScheduler (int backgroundLimit, int clientLimit,
+        std::chrono::milliseconds maxClientWait)
+    : backgroundLimit_ (backgroundLimit)
+    , clientLimit_ (clientLimit)
+    , maxClientWait_ (maxClientWait)
+{
+    assert (backgroundLimit_ > 0);
+    assert (clientLimit_ > 0);
+}
+
+ReadScheduler::Permit
+ReadScheduler::acquire (FetchPriority priority,
+    clock_type::time_point deadline)
+{
+    auto const i = index (priority);
+    bool promoted = false;
+    auto const ready = [&] { return admissible (priority, promoted); };
+
+    std::unique_lock <std::mutex> lock (mutex_);
+    if (! ready ())
+    {
+        auto const wait = [&] (clock_type::time_point until)
+        {
+            // Waiting until time_point::max() overflows the conversion
+            // to the system clock in some implementations.
+            if (until == clock_type::time_point::max ())
+            {
+                cv_.wait (lock, ready);
+                return true;
+            }
+            return cv_.wait_until (lock, until, ready);
+        };
+
+        ++waiting_[i];
+        bool admitted;
+        auto const promoteAt = clock_type::now () + maxClientWait_;
+        if (priority == FetchPriority::client && deadline > promoteAt)
+        {
+            admitted = wait (promoteAt);
+            if (! admitted)
+            {
+                promoted = true;
+                ++promoted_;
+                admitted = wait (deadline);
+                --promoted_;
+            }
+        }
+        else
+        {
+            admitted = wait (deadline);
+        }
+        --waiting_[i];
+
+        // A read may have been held back for this one
+        if (promoted || (! admitted && priority == FetchPriority::sync))
+            cv_.notify_all ();
+
+        if (! admitted)
+            return {};
+    }
+
+    ++active_[i];
+    return Permit (*this, priority);
+}
+
+int
+ReadScheduler::active (FetchPriority priority) const
+{
+    std::lock_guard <std::mutex> lock (mutex_);
+    return active_[index (priority)];
+}
+
+int
+ReadScheduler::waiting (FetchPriority priority) const
+{
+    std::lock_guard <std::mutex> lock (mutex_);
+    return waiting_[index (priority)];
+}
+
+bool
+ReadScheduler::admissible (FetchPriority priority, bool promoted) const
+{
+    if (priority == FetchPriority::consensus)
+        return true;
+
+    auto const sync = index (FetchPriority::sync);
+    auto const client = index (FetchPriority::client);
+
+    if (active_[sync] + active_[client] >= backgroundLimit_)
+        return false;
+
+    if (priority == FetchPriority::client)
+        return (promoted || waiting_[sync] == 0) &&
+            active_[client] < clientLimit_;
+
+    return promoted_ == 0;
+}
+
+void
+ReadScheduler::release (FetchPriority priority)
+{
+    std::lock_guard <std::mutex> lock (mutex_);
+    --active_[index (priority)];
+    // Nobody waits on consensus reads
+    if (priority != FetchPriority::consensus)
+        cv_.notify_all ();
+}
+
+}
+}
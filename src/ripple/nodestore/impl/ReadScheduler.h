@@ -0,0 +1,131 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_NODESTORE_READSCHEDULER_H_INCLUDED
+#define RIPPLE_NODESTORE_READSCHEDULER_H_INCLUDED
+
+#include <ripple/nodestore/FetchPriority.h>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+namespace ripple {
+namespace NodeStore {
+
+/** Admits reads to the backend by priority.
+
+    Consensus reads are always admitted at once. Sync and client reads
+    share a bounded number of slots, of which client reads may hold only
+    a part; while a sync read is waiting for a slot, no client read is
+    admitted ahead of it. A client read which has waited too long is
+    promoted, and goes ahead of sync reads instead, so that a thread
+    holding a lock others need is not starved by sync traffic. Readers
+    hold a Permit for the duration of the backend access.
+*/
+class ReadScheduler
+{
+public:
+    using clock_type = std::chrono::steady_clock;
+
+    /** Permission to read from the backend, returned when destroyed. */
+    class Permit
+    {
+    public:
+        Permit () = default;
+        Permit (Permit&& other);
+        Permit& operator= (Permit&&) = delete;
+        ~Permit ();
+
+        /** Returns `true` if the read was admitted. */
+        explicit
+        operator bool () const
+        {
+            return scheduler_ != nullptr;
+        }
+
+    private:
+        friend class ReadScheduler;
+
+        Permit (ReadScheduler& scheduler, FetchPriority priority)
+            : scheduler_ (&scheduler)
+            , priority_ (priority)
+        {
+        }
+
+        ReadScheduler* scheduler_ = nullptr;
+        FetchPriority priority_ = FetchPriority::consensus;
+    };
+
+    /** Create the scheduler.
+        @param backgroundLimit Reads allowed at once for sync and client.
+        @param clientLimit Reads allowed at once for client alone.
+        @param maxClientWait How long a client read may be held back
+                             by sync reads before it goes ahead of them.
+    */
+    ReadScheduler (int backgroundLimit, int clientLimit,
+        std::chrono::milliseconds maxClientWait);
+
+    ReadScheduler (ReadScheduler const&) = delete;
+    ReadScheduler& operator= (ReadScheduler const&) = delete;
+
+    /** Wait until a read of the given priority may proceed.
+        @param deadline The time after which the read is abandoned, or
+                        `time_point::max()` to wait indefinitely.
+        @return A permit, which is empty if the deadline passed.
+    */
+    Permit
+    acquire (FetchPriority priority, clock_type::time_point deadline =
+        clock_type::time_point::max ());
+
+    /** Returns the number of reads of a priority holding a permit. */
+    int
+    active (FetchPriority priority) const;
+
+    /** Returns the number of reads of a priority waiting for a permit. */
+    int
+    waiting (FetchPriority priority) const;
+
+private:
+    static
+    std::size_t
+    index (FetchPriority priority)
+    {
+        return static_cast <std::size_t> (priority);
+    }
+
+    bool admissible (FetchPriority priority, bool promoted) const;
+    void release (FetchPriority priority);
+
+    int const backgroundLimit_;
+    int const clientLimit_;
+    std::chrono::milliseconds const maxClientWait_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::array <int, fetchPriorityCount> active_ {};
+    std::array <int, fetchPriorityCount> waiting_ {};
+    // Client reads waiting ahead of sync reads
+    int promoted_ = 0;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,550 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/nodestore/impl/ShardStoreImp.h>
+#include <ripple/nodestore/Manager.h>
+#include <ripple/basics/contract.h>
+#include <ripple/basics/Log.h>
+#include <ripple/basics/Slice.h>
+#include <ripple/protocol/digest.h>
+#include <ripple/protocol/HashPrefix.h>
+#include <ripple/protocol/Serializer.h>
+#include <boost/algorithm/string/predicate.hpp>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace ripple {
+namespace NodeStore {
+
+// The files making up a finalized shard
+static char const* const indexFile = "ledgers";
+static char const* const shardFiles[] = { "ledgers", "nudb.dat", "nudb.key" };
+
+// Derived from the shard's keys, and rebuilt when missing
+static char const* const filterFile = "filter";
+// Suffixes of shards still being written or imported
+static char const* const buildSuffix = ".tmp";
+static char const* const importSuffix = ".import";
+
+// Read the ledger sequences and hashes recorded in a shard
+static
+std::vector<std::pair<std::uint32_t, uint256>>
+readIndex (boost::filesystem::path const& dir)
+{
+    std::ifstream in ((dir / indexFile).string ());
+    if (! in)
+        Throw<std::runtime_error> ("missing shard index in " + dir.string ());
+
+    std::vector<std::pair<std::uint32_t, uint256>> ledgers;
+    std::string line;
+    while (std::getline (in, line))
+    {
+        if (line.empty ())
+            continue;
+
+        std::istringstream fields (line);
+        std::uint32_t seq;
+        std::string hex;
+        uint256 hash;
+        if (! (fields >> seq >> hex) || ! hash.SetHexExact (hex))
+            Throw<std::runtime_error> ("malformed shard index in " +
+                dir.string ());
+        ledgers.emplace_back (seq, hash);
+    }
+    return ledgers;
+}
+
+static
+void
+writeIndex (boost::filesystem::path const& dir,
+    std::vector<std::pair<std::uint32_t, uint256>> const& ledgers)
+{
+    std::ofstream out ((dir / indexFile).string (), std::ios::trunc);
+    for (auto const& ledger : ledgers)
+        out << ledger.first << ' ' << to_string (ledger.second) << '\n';
+    out.flush ();
+    if (! out)
+        Throw<std::runtime_error> ("unable to write shard index in " +
+            dir.string ());
+}
+
+// Read the sequence and parent hash from a stored ledger header
+static
+std::pair<std::uint32_t, uint256>
+readHeader (Blob const& data)
+{
+    SerialIter sit (makeSlice (data));
+    if (sit.get32 () != HashPrefix::ledgerMaster)
+        Throw<std::runtime_error> ("not a ledger header");
+    auto const seq = sit.get32 ();
+    sit.get64 ();
+    return {seq, sit.get256 ()};
+}
+
+// Whether a directory holds every file of a finalized shard
+static
+bool
+isComplete (boost::filesystem::path const& dir)
+{
+    return std::all_of (std::begin (shardFiles), std::end (shardFiles),
+        [&dir](char const* name)
+        {
+            return boost::filesystem::is_regular_file (dir / name);
+        });
+}
+
+//------------------------------------------------------------------------------
+
+class ShardStoreImp::WriterImp
+    : public ShardStore::Writer
+{
+public:
+    WriterImp (ShardStoreImp& store, std::uint32_t index)
+        : store_ (store)
+        , index_ (index)
+        , dir_ (store.root_ / (std::to_string (index) + buildSuffix))
+    {
+        boost::filesystem::remove_all (dir_);
+        backend_ = store_.makeBackend (dir_);
+    }
+
+    ~WriterImp () override
+    {
+        if (! backend_)
+            return;
+
+        // Abandoned, remove what was written
+        try
+        {
+            backend_->setDeletePath ();
+            backend_->close ();
+        }
+        catch (std::exception const& e)
+        {
+            JLOG (store_.journal_.error()) <<
+                "Discarding shard " << index_ << ": " << e.what ();
+        }
+    }
+
+    void
+    store (Batch const& batch) override
+    {
+        backend_->storeBatch (batch);
+    }
+
+    void
+    addLedger (std::uint32_t seq, uint256 const& hash) override
+    {
+        ledgers_.emplace_back (seq, hash);
+    }
+
+    bool
+    finalize () override
+    {
+        if (! backend_ || store_.hasShard (index_))
+            return false;
+
+        try
+        {
+            if (store_.check (ledgers_) != index_)
+                return false;
+        }
+        catch (std::exception const& e)
+        {
+            JLOG (store_.journal_.warn()) <<
+                "Shard " << index_ << " incomplete: " << e.what ();
+            return false;
+        }
+
+        backend_->close ();
+        backend_.reset ();
+        writeIndex (dir_, ledgers_);
+
+        if (! store_.install (index_, dir_))
+        {
+            boost::filesystem::remove_all (dir_);
+            return false;
+        }
+        return true;
+    }
+
+private:
+    ShardStoreImp& store_;
+    std::uint32_t const index_;
+    boost::filesystem::path const dir_;
+    std::unique_ptr<Backend> backend_;
+    Ledgers ledgers_;
+};
+
+//------------------------------------------------------------------------------
+
+ShardStoreImp::ShardStoreImp (Section const& config,
+        Scheduler& scheduler, beast::Journal journal)
+    : scheduler_ (scheduler)
+    , journal_ (journal)
+    , root_ (get<std::string> (config, "path"))
+    , ledgersPerShard_ (get<std::uint32_t> (
+        config, "ledgers_per_shard", 16384))
+    , fetchCount_ (0)
+    , fetchHitCount_ (0)
+{
+    if (root_.empty ())
+        Throw<std::runtime_error> (
+            "nodestore: Missing path in shard database");
+
+    if (ledgersPerShard_ == 0)
+        Throw<std::runtime_error> (
+            "nodestore: ledgers_per_shard must be positive");
+
+    boost::filesystem::create_directories (root_);
+
+    auto shards = std::make_shared<Shards> ();
+    for (boost::filesystem::directory_iterator it (root_);
+        it != boost::filesystem::directory_iterator (); ++it)
+    {
+        auto const& dir = it->path ();
+        if (! boost::filesystem::is_directory (dir))
+            continue;
+
+        auto const name = dir.filename ().string ();
+        if (boost::algorithm::ends_with (name, buildSuffix) ||
+            boost::algorithm::ends_with (name, importSuffix))
+        {
+            JLOG (journal_.info()) << "Removing incomplete shard " << dir;
+            boost::filesystem::remove_all (dir);
+            continue;
+        }
+
+        if (name.empty () ||
+                name.find_first_not_of ("0123456789") != std::string::npos)
+            continue;
+
+        try
+        {
+            if (! isComplete (dir))
+                Throw<std::runtime_error> ("missing files");
+
+            auto const index = check (readIndex (dir));
+            if (std::to_string (index) != name)
+                Throw<std::runtime_error> ("holds shard " +
+                    std::to_string (index));
+
+            shards->push_back (openShard (index, dir));
+        }
+        catch (std::exception const& e)
+        {
+            JLOG (journal_.error()) <<
+                "Ignoring shard " << dir << ": " << e.what ();
+        }
+    }
+
+    std::sort (shards->begin (), shards->end (),
+        [](std::shared_ptr<Shard const> const& lhs,
+            std::shared_ptr<Shard const> const& rhs)
+        {
+            return lhs->index > rhs->index;
+        });
+
+    JLOG (journal_.info()) <<
+        "Opened " << shards->size () << " shards in " << root_;
+
+    shards_ = std::move (shards);
+}
+
+std::shared_ptr<ShardStoreImp::Shards const>
+ShardStoreImp::snapshot () const
+{
+    std::lock_guard<std::mutex> lock (mutex_);
+    return shards_;
+}
+
+std::unique_ptr<Backend>
+ShardStoreImp::makeBackend (boost::filesystem::path const& dir)
+{
+    Section params;
+    params.set ("type", "NuDB");
+    params.set ("path", dir.string ());
+    // Reads are one at a time, so a pool per shard is not needed
+    params.set ("io_threads", "0");
+    return Manager::instance ().make_Backend (params, scheduler_, journal_);
+}
+
+KeyFilter
+ShardStoreImp::loadFilter (std::uint32_t index, Backend& backend,
+    boost::filesystem::path const& dir)
+{
+    auto const path = (dir / filterFile).string ();
+    if (auto filter = KeyFilter::load (path))
+        return std::move (*filter);
+
+    // The shard is never written again, so the keys are read twice:
+    // once to size the filter and once to fill it.
+    JLOG (journal_.info()) << "Building key filter for shard " << index;
+    std::size_t keys = 0;
+    backend.for_each ([&keys](std::shared_ptr<NodeObject>) { ++keys; });
+    KeyFilter filter (keys);
+    backend.for_each ([&filter](std::shared_ptr<NodeObject> object)
+    {
+        filter.insert (object->getHash ());
+    });
+    filter.save (path);
+    return filter;
+}
+
+std::shared_ptr<ShardStoreImp::Shard const>
+ShardStoreImp::openShard (std::uint32_t index,
+    boost::filesystem::path const& dir)
+{
+    auto backend = makeBackend (dir);
+    auto filter = loadFilter (index, *backend, dir);
+    return std::make_shared<Shard const> (
+        Shard {index, std::move (backend), std::move (filter)});
+}
+
+std::uint32_t
+ShardStoreImp::check (Ledgers const& ledgers) const
+{
+    if (ledgers.size () != ledgersPerShard_)
+        Throw<std::runtime_error> ("shard holds " +
+            std::to_string (ledgers.size ()) + " ledgers, expected " +
+            std::to_string (ledgersPerShard_));
+
+    auto const index = shardIndex (ledgers.front ().first);
+    if (ledgers.front ().first != firstSeq (index))
+        Throw<std::runtime_error> ("shard starts at ledger " +
+            std::to_string (ledgers.front ().first));
+
+    for (std::size_t i = 1; i < ledgers.size (); ++i)
+    {
+        if (ledgers[i].first != ledgers[i - 1].first + 1)
+            Throw<std::runtime_error> ("shard skips ledger " +
+                std::to_string (ledgers[i - 1].first + 1));
+    }
+
+    return index;
+}
+
+bool
+ShardStoreImp::install (std::uint32_t index,
+    boost::filesystem::path const& dir)
+{
+    // Reading every key takes a while, so the filter is built before
+    // the lock is taken and moves into place with the shard
+    loadFilter (index, *makeBackend (dir), dir);
+
+    std::lock_guard<std::mutex> lock (mutex_);
+
+    auto const found = std::find_if (shards_->begin (), shards_->end (),
+        [index](std::shared_ptr<Shard const> const& shard)
+        {
+            return shard->index == index;
+        });
+    if (found != shards_->end ())
+        return false;
+
+    auto const dest = root_ / std::to_string (index);
+    boost::filesystem::rename (dir, dest);
+
+    auto shards = std::make_shared<Shards> (*shards_);
+    auto const pos = std::find_if (shards->begin (), shards->end (),
+        [index](std::shared_ptr<Shard const> const& shard)
+        {
+            return shard->index < index;
+        });
+    shards->insert (pos, openShard (index, dest));
+    shards_ = std::move (shards);
+
+    JLOG (journal_.info()) << "Shard " << index << " finalized";
+    return true;
+}
+
+bool
+ShardStoreImp::hasShard (std::uint32_t index) const
+{
+    auto const shards = snapshot ();
+    return std::any_of (shards->begin (), shards->end (),
+        [index](std::shared_ptr<Shard const> const& shard)
+        {
+            return shard->index == index;
+        });
+}
+
+std::vector<std::uint32_t>
+ShardStoreImp::getShards () const
+{
+    auto const shards = snapshot ();
+    std::vector<std::uint32_t> result;
+    result.reserve (shards->size ());
+    for (auto it = shards->rbegin (); it != shards->rend (); ++it)
+        result.push_back ((*it)->index);
+    return result;
+}
+
+std::unique_ptr<ShardStore::Writer>
+ShardStoreImp::makeWriter (std::uint32_t index)
+{
+    return std::make_unique<WriterImp> (*this, index);
+}
+
+std::shared_ptr<NodeObject>
+ShardStoreImp::fetch (uint256 const& hash)
+{
+    ++fetchCount_;
+
+    // Recent history is requested most often
+    auto const shards = snapshot ();
+    for (auto const& shard : *shards)
+    {
+        if (! shard->filter.mayContain (hash))
+            continue;
+
+        std::shared_ptr<NodeObject> object;
+        if (shard->backend->fetch (hash.begin (), &object) == ok && object)
+        {
+            ++fetchHitCount_;
+            return object;
+        }
+    }
+
+    return nullptr;
+}
+
+std::uint32_t
+ShardStoreImp::importShard (std::string const& path,
+    ValidatedHash const& validated)
+{
+    boost::filesystem::path const source (path);
+    if (! isComplete (source))
+        Throw<std::runtime_error> ("no shard in " + path);
+
+    auto const ledgers = readIndex (source);
+    auto const index = check (ledgers);
+    if (hasShard (index))
+        Throw<std::runtime_error> (
+            "shard " + std::to_string (index) + " already present");
+
+    auto const dir = root_ / (std::to_string (index) + importSuffix);
+    boost::filesystem::remove_all (dir);
+    boost::filesystem::create_directories (dir);
+    for (auto const name : shardFiles)
+        boost::filesystem::copy_file (source / name, dir / name);
+
+    // Check the copy, not the source, which could still change
+    try
+    {
+        auto backend = makeBackend (dir);
+        backend->verify ();
+
+        // Maps trust the nodes they are given, so every object must be
+        // keyed by the hash of its data.
+        backend->for_each ([index](std::shared_ptr<NodeObject> object)
+        {
+            if (sha512Half (makeSlice (object->getData ())) !=
+                    object->getHash ())
+                Throw<std::runtime_error> ("shard " +
+                    std::to_string (index) + " holds a corrupt object " +
+                    to_string (object->getHash ()));
+        });
+
+        // The newest ledger must be one this server validated, and each
+        // header must name the one before it as its parent.
+        auto const last = validated (ledgers.back ().first);
+        if (! last || *last != ledgers.back ().second)
+            Throw<std::runtime_error> ("shard " + std::to_string (index) +
+                " does not end with a validated ledger");
+
+        for (auto i = ledgers.size (); i-- > 0;)
+        {
+            auto const& ledger = ledgers[i];
+            std::shared_ptr<NodeObject> object;
+            if (backend->fetch (ledger.second.begin (), &object) != ok ||
+                ! object)
+            {
+                Throw<std::runtime_error> ("shard " +
+                    std::to_string (index) + " lacks ledger " +
+                    std::to_string (ledger.first));
+            }
+
+            auto const header = readHeader (object->getData ());
+            if (header.first != ledger.first ||
+                (i > 0 && header.second != ledgers[i - 1].second))
+            {
+                Throw<std::runtime_error> ("shard " +
+                    std::to_string (index) + " has a broken chain at ledger " +
+                    std::to_string (ledger.first));
+            }
+        }
+    }
+    catch (std::exception const&)
+    {
+        boost::filesystem::remove_all (dir);
+        throw;
+    }
+
+    if (! install (index, dir))
+    {
+        boost::filesystem::remove_all (dir);
+        Throw<std::runtime_error> (
+            "shard " + std::to_string (index) + " already present");
+    }
+
+    return index;
+}
+
+void
+ShardStoreImp::exportShard (std::uint32_t index, std::string const& path)
+{
+    if (! hasShard (index))
+        Throw<std::runtime_error> (
+            "shard " + std::to_string (index) + " not present");
+
+    boost::filesystem::path const dest (path);
+    if (boost::filesystem::exists (dest))
+        Throw<std::runtime_error> (path + " already exists");
+
+    // A finalized shard is never written, so it can be copied while open
+    auto const source = root_ / std::to_string (index);
+    boost::filesystem::create_directories (dest);
+    for (auto const name : shardFiles)
+        boost::filesystem::copy_file (source / name, dest / name);
+}
+
+int
+ShardStoreImp::fdlimit () const
+{
+    auto const shards = snapshot ();
+    int result = 0;
+    for (auto const& shard : *shards)
+        result += shard->backend->fdlimit ();
+    return result;
+}
+
+//------------------------------------------------------------------------------
+
+std::unique_ptr<ShardStore>
+make_ShardStore (Section const& config,
+    Scheduler& scheduler, beast::Journal journal)
+{
+    return std::make_unique<ShardStoreImp> (config, scheduler, journal);
+}
+
+}
+}
@@ -0,0 +1,127 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_NODESTORE_SHARDSTOREIMP_H_INCLUDED
+#define RIPPLE_NODESTORE_SHARDSTOREIMP_H_INCLUDED
+
+#include <ripple/nodestore/ShardStore.h>
+#include <ripple/nodestore/Backend.h>
+#include <ripple/nodestore/impl/KeyFilter.h>
+#include <boost/filesystem.hpp>
+#include <atomic>
+#include <mutex>
+#include <utility>
+
+namespace ripple {
+namespace NodeStore {
+
+class ShardStoreImp
+    : public ShardStore
+{
+public:
+    ShardStoreImp (Section const& config,
+        Scheduler& scheduler, beast::Journal journal);
+
+    std::uint32_t
+    ledgersPerShard () const override
+    {
+        return ledgersPerShard_;
+    }
+
+    bool hasShard (std::uint32_t index) const override;
+
+    std::vector<std::uint32_t> getShards () const override;
+
+    std::unique_ptr<Writer> makeWriter (std::uint32_t index) override;
+
+    std::shared_ptr<NodeObject> fetch (uint256 const& hash) override;
+
+    std::uint32_t importShard (std::string const& path,
+        ValidatedHash const& validated) override;
+
+    void exportShard (std::uint32_t index,
+        std::string const& path) override;
+
+    std::uint64_t
+    getFetchCount () const override
+    {
+        return fetchCount_;
+    }
+
+    std::uint64_t
+    getFetchHitCount () const override
+    {
+        return fetchHitCount_;
+    }
+
+    int fdlimit () const override;
+
+private:
+    class WriterImp;
+
+    using Ledgers = std::vector<std::pair<std::uint32_t, uint256>>;
+
+    struct Shard
+    {
+        std::uint32_t index;
+        std::unique_ptr<Backend> backend;
+        // Lets a fetch skip shards which cannot hold the key
+        KeyFilter filter;
+    };
+
+    // Newest first. A set is replaced as a whole and never modified,
+    // so readers can search it without holding the lock.
+    using Shards = std::vector<std::shared_ptr<Shard const>>;
+
+    Scheduler& scheduler_;
+    beast::Journal journal_;
+    boost::filesystem::path const root_;
+    std::uint32_t const ledgersPerShard_;
+
+    mutable std::mutex mutex_;
+    std::shared_ptr<Shards const> shards_;
+
+    std::atomic<std::uint64_t> fetchCount_;
+    std::atomic<std::uint64_t> fetchHitCount_;
+
+    std::shared_ptr<Shards const> snapshot () const;
+
+    std::unique_ptr<Backend> makeBackend (
+        boost::filesystem::path const& dir);
+
+    // Read a shard's key filter, building it first if needed
+    KeyFilter loadFilter (std::uint32_t index, Backend& backend,
+        boost::filesystem::path const& dir);
+
+    // Open a finalized shard
+    std::shared_ptr<Shard const> openShard (std::uint32_t index,
+        boost::filesystem::path const& dir);
+
+    // Returns the shard described by an index, or throws
+    std::uint32_t check (Ledgers const& ledgers) const;
+
+    // Move a complete shard into place and start serving it.
+    // Returns false if the shard is already present.
+    bool install (std::uint32_t index, boost::filesystem::path const& dir);
+};
+
+}
+}
+
+#endif
@@ -33,6 +33,22 @@ enum
 
     // Fraction of the cache one query source can take
     ,asyncDivider = 8
+
+    // Time the backend should take to commit one batch of writes
+    ,batchWriteTargetMilliseconds = 50
+
+    // Bounds on the number of objects committed in one batch
+    ,batchWriteMinimumSize = 256
+    ,batchWriteMaximumSize = 65536
+
+    // Disk reads allowed at once for sync and client work together
+    ,backgroundReadLimit = 16
+
+    // Disk reads allowed at once for client work alone
+    ,clientReadLimit = 8
+
+    // Time a client read may be held back by sync reads
+    ,clientReadMaxWaitMilliseconds = 100
 };
 
 }
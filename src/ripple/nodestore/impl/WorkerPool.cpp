@@ -0,0 +1,178 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/nodestore/impl/WorkerPool.h>
+#include <ripple/beast/core/Thread.h>
+#include <atomic>
+#include <exception>
+
+namespace ripple {
+namespace NodeStore {
+
+struct WorkerPool::Task
+{
+    std::function <void(std::size_t)> const& f;
+    std::size_t const n;
+    std::atomic <std::size_t> next {0};
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::size_t finished = 0;
+    std::exception_ptr error;
+
+    Task (std::function <void(std::size_t)> const& f_, std::size_t n_)
+        : f (f_)
+        , n (n_)
+    {
+    }
+};
+
+WorkerPool::WorkerPool (std::size_t threads, std::string const& name)
+{
+    threads_.reserve (threads);
+    for (std::size_t i = 0; i < threads; ++i)
+        threads_.emplace_back (&WorkerPool::run, this, name);
+}
+
+WorkerPool::~WorkerPool ()
+{
+    {
+        std::lock_guard <std::mutex> lock (mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all ();
+    for (auto& t : threads_)
+        t.join ();
+}
+
+void
+WorkerPool::work (Task& task)
+{
+    std::size_t done = 0;
+    std::exception_ptr error;
+
+    for (;;)
+    {
+        auto const i = task.next.fetch_add (1);
+        if (i >= task.n)
+            break;
+
+        if (! error)
+        {
+            try
+            {
+                task.f (i);
+            }
+            catch (...)
+            {
+                error = std::current_exception ();
+                // Claim everything left so the others stop early, and
+                // count it as finished so the owner stops waiting.
+                auto const claimed = task.next.exchange (task.n);
+                if (claimed < task.n)
+                    done += task.n - claimed;
+            }
+        }
+        ++done;
+    }
+
+    if (done == 0)
+        return;
+
+    std::lock_guard <std::mutex> lock (task.mutex);
+    if (error && ! task.error)
+        task.error = error;
+    task.finished += done;
+    if (task.finished == task.n)
+        task.cv.notify_all ();
+}
+
+void
+WorkerPool::for_each (std::size_t n,
+    std::function <void(std::size_t)> const& f)
+{
+    if (n == 0)
+        return;
+
+    if (threads_.empty () || n == 1)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+            f (i);
+        return;
+    }
+
+    auto task = std::make_shared <Task> (f, n);
+    {
+        std::lock_guard <std::mutex> lock (mutex_);
+        tasks_.push_back (task);
+    }
+    cv_.notify_all ();
+
+    work (*task);
+
+    {
+        std::unique_lock <std::mutex> lock (task->mutex);
+        task->cv.wait (lock, [&]{ return task->finished == task->n; });
+    }
+
+    {
+        std::lock_guard <std::mutex> lock (mutex_);
+        for (auto iter = tasks_.begin (); iter != tasks_.end (); ++iter)
+        {
+            if (*iter == task)
+            {
+                tasks_.erase (iter);
+                break;
+            }
+        }
+    }
+
+    if (task->error)
+        std::rethrow_exception (task->error);
+}
+
+void
+WorkerPool::run (std::string const& name)
+{
+    beast::Thread::setCurrentThreadName (name);
+
+    std::unique_lock <std::mutex> lock (mutex_);
+    for (;;)
+    {
+        cv_.wait (lock, [&]{ return stop_ || ! tasks_.empty (); });
+        if (stop_)
+            return;
+
+        auto task = tasks_.front ();
+        if (task->next.load () >= task->n)
+        {
+            // Every index is taken; the owner removes it when done
+            tasks_.pop_front ();
+            continue;
+        }
+
+        lock.unlock ();
+        work (*task);
+        lock.lock ();
+    }
+}
+
+}
+}
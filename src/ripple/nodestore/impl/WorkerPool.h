@@ -0,0 +1,91 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_NODESTORE_WORKERPOOL_H_INCLUDED
+#define RIPPLE_NODESTORE_WORKERPOOL_H_INCLUDED
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ripple {
+namespace NodeStore {
+
+/** A fixed set of threads which run the parts of a task in parallel.
+
+    Used by backends to overlap blocking reads and to spread CPU bound
+    work such as compression. The calling thread always takes part, so a
+    pool with no threads runs everything on the caller.
+*/
+class WorkerPool
+{
+public:
+    /** Create the pool.
+        @param threads The number of threads to start.
+        @param name The name given to each thread.
+    */
+    WorkerPool (std::size_t threads, std::string const& name);
+
+    ~WorkerPool ();
+
+    WorkerPool (WorkerPool const&) = delete;
+    WorkerPool& operator= (WorkerPool const&) = delete;
+
+    /** Returns the number of threads in the pool. */
+    std::size_t
+    size () const
+    {
+        return threads_.size ();
+    }
+
+    /** Call `f(i)` for every `i` in `[0, n)` and wait for all of them.
+
+        Calls are made concurrently, in no particular order. This may be
+        called from several threads at once. If any call throws, the
+        remaining indexes are skipped and the first exception is
+        rethrown here.
+    */
+    void
+    for_each (std::size_t n, std::function <void(std::size_t)> const& f);
+
+private:
+    struct Task;
+
+    void run (std::string const& name);
+
+    // Runs indexes of the task until none are left
+    static void work (Task& task);
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque <std::shared_ptr <Task>> tasks_;
+    bool stop_ = false;
+    std::vector <std::thread> threads_;
+};
+
+}
+}
+
+#endif
@@ -21,13 +21,16 @@
 #define RIPPLE_OVERLAY_MESSAGE_H_INCLUDED
 
 #include "ripple.pb.h"
+#include <ripple/basics/Slice.h>
 #include <boost/asio/buffer.hpp>
 #include <boost/asio/buffers_iterator.hpp>
 #include <algorithm>
 #include <cstdint>
 #include <iterator>
 #include <memory>
+#include <mutex>
 #include <type_traits>
+#include <vector>
 
 namespace ripple {
 
@@ -43,6 +46,12 @@ namespace ripple {
 // a string prepended by a header specifying the message length.
 // MessageType should be a Message class generated by the protobuf compiler.
 //
+// A message may also be sent compressed. The high bit of the size field
+// is then set, and the payload holds the uncompressed size as a 4 byte
+// big-endian integer followed by an LZ4 block. The compressed form is
+// computed once per Message, on first use, and shared by every peer the
+// message is sent to.
+//
 
 class Message : public std::enable_shared_from_this <Message>
 {
@@ -54,8 +63,22 @@ public:
     */
     static size_t const kHeaderBytes = 6;
 
+    /** Bit set in the size field when the payload is compressed.
+    */
+    static std::uint32_t const kCompressedFlag = 0x80000000;
+
     Message (::google::protobuf::Message const& message, int type);
 
+    /** Pack a message followed by fields that are already serialized.
+
+        Serialized protocol buffers concatenate: each slice in `tail`
+        is parsed as more fields of `message`. This lets expensive
+        parts of a reply be serialized once and shared between
+        messages.
+    */
+    Message (::google::protobuf::Message const& message, int type,
+        std::vector<Slice> const& tail);
+
     /** Retrieve the packed message data. */
     std::vector <uint8_t> const&
     getBuffer () const
@@ -63,6 +86,17 @@ public:
         return mBuffer;
     }
 
+    /** Retrieve the packed message data, compressed if worthwhile.
+
+        If the message is too small, or does not shrink, the
+        uncompressed buffer is returned.
+
+        @param compressed `true` if the receiving peer accepts
+                          compressed messages.
+    */
+    std::vector <uint8_t> const&
+    getBuffer (bool compressed) const;
+
     /** Get the traffic category */
     int
     getCategory () const
@@ -87,7 +121,7 @@ public:
                 Message::kHeaderBytes)
             return 0;
         std::size_t n;
-        n  = std::size_t{*first++} << 24;
+        n  = (std::size_t{*first++} & 0x7F) << 24;
         n += std::size_t{*first++} << 16;
         n += std::size_t{*first++} <<  8;
         n += std::size_t{*first};
@@ -104,6 +138,30 @@ public:
     }
     /** @} */
 
+    /** Determine whether a packed message has a compressed payload. */
+    /** @{ */
+    template <class FwdIter>
+    static
+    std::enable_if_t<std::is_same<typename
+        FwdIter::value_type, std::uint8_t>::value, bool>
+    compressed (FwdIter first, FwdIter last)
+    {
+        if (std::distance(first, last) <
+                Message::kHeaderBytes)
+            return false;
+        return (*first & 0x80) != 0;
+    }
+
+    template <class BufferSequence>
+    static
+    bool
+    compressed (BufferSequence const& buffers)
+    {
+        return compressed(buffers_begin(buffers),
+            buffers_end(buffers));
+    }
+    /** @} */
+
     /** Determine the type of a packed message. */
     /** @{ */
     static int getType (std::vector <uint8_t> const& buf);
@@ -150,12 +208,20 @@ private:
             BufferSequence, Value>::end (buffers);
     }
 
-        // Encodes the size and type into a header at the beginning of buf
+    // Encodes the size and type into a header at the beginning of buf
     //
-    void encodeHeader (unsigned size, int type);
+    static void encodeHeader (std::vector <uint8_t>& buf,
+        std::uint32_t size, int type);
+
+    // Fills mCompressed if compressing the payload saves space
+    //
+    void compress () const;
 
     std::vector <uint8_t> mBuffer;
 
+    mutable std::once_flag mCompressOnce;
+    mutable std::vector <uint8_t> mCompressed;
+
     int mCategory;
 };
 
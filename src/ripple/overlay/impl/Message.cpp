@@ -20,7 +20,10 @@
 #include <BeastConfig.h>
 #include <ripple/overlay/Message.h>
 #include <ripple/overlay/impl/TrafficCount.h>
+#include <ripple/overlay/impl/Tuning.h>
+#include <lz4/lib/lz4.h>
 #include <cstdint>
+#include <cstring>
 
 namespace ripple {
 
@@ -32,7 +35,7 @@ Message::Message (::google::protobuf::Message const& message, int type)
 
     mBuffer.resize (kHeaderBytes + messageBytes);
 
-    encodeHeader (messageBytes, type);
+    encodeHeader (mBuffer, messageBytes, type);
 
     if (messageBytes != 0)
     {
@@ -43,6 +46,79 @@ Message::Message (::google::protobuf::Message const& message, int type)
         (message, type, false));
 }
 
+std::vector <uint8_t> const&
+Message::getBuffer (bool compressed) const
+{
+    if (! compressed)
+        return mBuffer;
+
+    std::call_once (mCompressOnce, [this]{ compress (); });
+
+    if (mCompressed.empty ())
+        return mBuffer;
+    return mCompressed;
+}
+
+void Message::compress () const
+{
+    auto const messageBytes = mBuffer.size () - kHeaderBytes;
+
+    if (messageBytes < Tuning::compressMinBytes ||
+            messageBytes > Tuning::maxDecompressedBytes)
+        return;
+
+    // The payload is the uncompressed size followed by the LZ4 block
+    auto const bound = LZ4_compressBound (static_cast<int> (messageBytes));
+    std::vector <uint8_t> buf (kHeaderBytes + 4 + bound);
+
+    auto const n = LZ4_compress_default (
+        reinterpret_cast<char const*> (&mBuffer [kHeaderBytes]),
+        reinterpret_cast<char*> (&buf [kHeaderBytes + 4]),
+        static_cast<int> (messageBytes), bound);
+
+    if (n <= 0 || 4 + static_cast<std::size_t> (n) >= messageBytes)
+        return;
+
+    buf.resize (kHeaderBytes + 4 + n);
+    encodeHeader (buf, (4 + n) | kCompressedFlag, getType (mBuffer));
+    buf[kHeaderBytes + 0] = static_cast<std::uint8_t> ((messageBytes >> 24) & 0xFF);
+    buf[kHeaderBytes + 1] = static_cast<std::uint8_t> ((messageBytes >> 16) & 0xFF);
+    buf[kHeaderBytes + 2] = static_cast<std::uint8_t> ((messageBytes >> 8) & 0xFF);
+    buf[kHeaderBytes + 3] = static_cast<std::uint8_t> (messageBytes & 0xFF);
+
+    mCompressed = std::move (buf);
+}
+
+Message::Message (::google::protobuf::Message const& message, int type,
+    std::vector<Slice> const& tail)
+{
+    unsigned const headBytes = message.ByteSize ();
+
+    unsigned messageBytes = headBytes;
+    for (auto const& s : tail)
+        messageBytes += s.size ();
+
+    assert (messageBytes != 0);
+
+    mBuffer.resize (kHeaderBytes + messageBytes);
+
+    encodeHeader (mBuffer, messageBytes, type);
+
+    if (headBytes != 0)
+        message.SerializeToArray (&mBuffer [kHeaderBytes], headBytes);
+
+    auto out = kHeaderBytes + headBytes;
+    for (auto const& s : tail)
+    {
+        if (! s.empty ())
+            std::memcpy (&mBuffer [out], s.data (), s.size ());
+        out += s.size ();
+    }
+
+    mCategory = static_cast<int>(TrafficCount::categorize
+        (message, type, false));
+}
+
 bool Message::operator== (Message const& other) const
 {
     return mBuffer == other.mBuffer;
@@ -54,7 +130,7 @@ unsigned Message::getLength (std::vector <uint8_t> const& buf)
 
     if (buf.size () >= Message::kHeaderBytes)
     {
-        result = buf [0];
+        result = buf [0] & 0x7F;
         result <<= 8;
         result |= buf [1];
         result <<= 8;
@@ -81,15 +157,16 @@ int Message::getType (std::vector<uint8_t> const& buf)
     return ret;
 }
 
-void Message::encodeHeader (unsigned size, int type)
+void Message::encodeHeader (std::vector <uint8_t>& buf,
+    std::uint32_t size, int type)
 {
-    assert (mBuffer.size () >= Message::kHeaderBytes);
-    mBuffer[0] = static_cast<std::uint8_t> ((size >> 24) & 0xFF);
-    mBuffer[1] = static_cast<std::uint8_t> ((size >> 16) & 0xFF);
-    mBuffer[2] = static_cast<std::uint8_t> ((size >> 8) & 0xFF);
-    mBuffer[3] = static_cast<std::uint8_t> (size & 0xFF);
-    mBuffer[4] = static_cast<std::uint8_t> ((type >> 8) & 0xFF);
-    mBuffer[5] = static_cast<std::uint8_t> (type & 0xFF);
+    assert (buf.size () >= Message::kHeaderBytes);
+    buf[0] = static_cast<std::uint8_t> ((size >> 24) & 0xFF);
+    buf[1] = static_cast<std::uint8_t> ((size >> 16) & 0xFF);
+    buf[2] = static_cast<std::uint8_t> ((size >> 8) & 0xFF);
+    buf[3] = static_cast<std::uint8_t> (size & 0xFF);
+    buf[4] = static_cast<std::uint8_t> ((type >> 8) & 0xFF);
+    buf[5] = static_cast<std::uint8_t> (type & 0xFF);
 }
 
 }
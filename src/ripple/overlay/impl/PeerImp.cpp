@@ -87,6 +87,7 @@ PeerImp::PeerImp (Application& app, id_t id, endpoint_type remote_endpoint,
     , publicKey_(publicKey)
     , creationTime_ (clock_type::now())
     , hello_(hello)
+    , compressed_ (app_.config().PEER_COMPRESSION && hello.compression())
     , usage_(consumer)
     , fee_ (Resource::feeLightPeer)
     , slot_ (slot)
@@ -199,7 +200,7 @@ PeerImp::send (Message::pointer const& m)
 
     overlay_.reportTraffic (
         static_cast<TrafficCount::category>(m->getCategory()),
-        false, static_cast<int>(m->getBuffer().size()));
+        false, static_cast<int>(m->getBuffer(compressed_).size()));
 
     auto sendq_size = send_queue_.size();
 
@@ -217,7 +218,7 @@ PeerImp::send (Message::pointer const& m)
         return;
 
     boost::asio::async_write (stream_, boost::asio::buffer(
-        send_queue_.front()->getBuffer()), strand_.wrap(std::bind(
+        send_queue_.front()->getBuffer(compressed_)), strand_.wrap(std::bind(
             &PeerImp::onWriteMessage, shared_from_this(),
                 beast::asio::placeholders::error,
                     beast::asio::placeholders::bytes_transferred)));
@@ -791,7 +792,7 @@ PeerImp::onWriteMessage (error_code ec, std::size_t bytes_transferred)
     {
         // Timeout on writes only
         return boost::asio::async_write (stream_, boost::asio::buffer(
-            send_queue_.front()->getBuffer()), strand_.wrap(std::bind(
+            send_queue_.front()->getBuffer(compressed_)), strand_.wrap(std::bind(
                 &PeerImp::onWriteMessage, shared_from_this(),
                     beast::asio::placeholders::error,
                         beast::asio::placeholders::bytes_transferred)));
@@ -148,6 +148,8 @@ private:
     std::mutex mutable recentLock_;
     protocol::TMStatusChange last_status_;
     protocol::TMHello hello_;
+    // True if we send compressed messages to this peer
+    bool const compressed_;
     Resource::Consumer usage_;
     Resource::Charge fee_;
     PeerFinder::Slot::ptr slot_;
@@ -498,6 +500,7 @@ PeerImp::PeerImp (Application& app, std::unique_ptr<beast::asio::ssl_bundle>&& s
     , publicKey_ (publicKey)
     , creationTime_ (clock_type::now())
     , hello_ (hello)
+    , compressed_ (app_.config().PEER_COMPRESSION && hello.compression())
     , usage_ (usage)
     , fee_ (Resource::feeLightPeer)
     , slot_ (std::move(slot))
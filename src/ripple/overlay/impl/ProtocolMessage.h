@@ -22,10 +22,14 @@
 
 #include "ripple.pb.h"
 #include <ripple/overlay/Message.h>
+#include <ripple/overlay/impl/Tuning.h>
 #include <ripple/overlay/impl/ZeroCopyStream.h>
+#include <lz4/lib/lz4.h>
 #include <boost/asio/buffer.hpp>
 #include <boost/asio/buffers_iterator.hpp>
 #include <boost/system/error_code.hpp>
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <cstdint>
 #include <memory>
@@ -69,17 +73,16 @@ template <class T, class Buffers, class Handler>
 std::enable_if_t<std::is_base_of<
     ::google::protobuf::Message, T>::value,
         boost::system::error_code>
-invoke (int type, Buffers const& buffers,
-    Handler& handler)
+invoke (int type, Buffers const& buffers, std::size_t skip,
+    std::size_t size, Handler& handler)
 {
     ZeroCopyInputStream<Buffers> stream(buffers);
-    stream.Skip(Message::kHeaderBytes);
+    stream.Skip(skip);
     auto const m (std::make_shared<T>());
     if (! m->ParseFromZeroCopyStream(&stream))
         return boost::system::errc::make_error_code(
             boost::system::errc::invalid_argument);
-    auto ec = handler.onMessageBegin (type, m,
-       Message::kHeaderBytes + Message::size (buffers));
+    auto ec = handler.onMessageBegin (type, m, size);
     if (! ec)
     {
         handler.onMessage (m);
@@ -88,6 +91,91 @@ invoke (int type, Buffers const& buffers,
     return ec;
 }
 
+// Parses the payload, which starts skip bytes into buffers, and
+// calls the handler. size is the number of bytes on the wire.
+template <class Buffers, class Handler>
+boost::system::error_code
+dispatch (int type, Buffers const& buffers, std::size_t skip,
+    std::size_t size, Handler& handler)
+{
+    switch (type)
+    {
+    case protocol::mtHELLO:         return invoke<protocol::TMHello> (type, buffers, skip, size, handler);
+    case protocol::mtMANIFESTS:     return invoke<protocol::TMManifests> (type, buffers, skip, size, handler);
+    case protocol::mtPING:          return invoke<protocol::TMPing> (type, buffers, skip, size, handler);
+    case protocol::mtCLUSTER:       return invoke<protocol::TMCluster> (type, buffers, skip, size, handler);
+    case protocol::mtGET_PEERS:     return invoke<protocol::TMGetPeers> (type, buffers, skip, size, handler);
+    case protocol::mtPEERS:         return invoke<protocol::TMPeers> (type, buffers, skip, size, handler);
+    case protocol::mtENDPOINTS:     return invoke<protocol::TMEndpoints> (type, buffers, skip, size, handler);
+    case protocol::mtTRANSACTION:   return invoke<protocol::TMTransaction> (type, buffers, skip, size, handler);
+    case protocol::mtGET_LEDGER:    return invoke<protocol::TMGetLedger> (type, buffers, skip, size, handler);
+    case protocol::mtLEDGER_DATA:   return invoke<protocol::TMLedgerData> (type, buffers, skip, size, handler);
+    case protocol::mtPROPOSE_LEDGER:return invoke<protocol::TMProposeSet> (type, buffers, skip, size, handler);
+    case protocol::mtSTATUS_CHANGE: return invoke<protocol::TMStatusChange> (type, buffers, skip, size, handler);
+    case protocol::mtHAVE_SET:      return invoke<protocol::TMHaveTransactionSet> (type, buffers, skip, size, handler);
+    case protocol::mtVALIDATION:    return invoke<protocol::TMValidation> (type, buffers, skip, size, handler);
+    case protocol::mtGET_OBJECTS:   return invoke<protocol::TMGetObjectByHash> (type, buffers, skip, size, handler);
+    default:
+        break;
+    }
+    return handler.onMessageUnknown (type);
+}
+
+// Expands a compressed message into its uncompressed payload.
+// Returns false if the payload is malformed or too large.
+template <class Buffers>
+bool
+decompress (Buffers const& buffers, std::size_t size,
+    std::vector<std::uint8_t>& payload)
+{
+    std::size_t const offset = Message::kHeaderBytes + 4;
+    if (size < offset)
+        return false;
+    std::size_t const compressed = size - offset;
+
+    std::array<std::uint8_t, offset> header;
+    boost::asio::buffer_copy (boost::asio::buffer(header), buffers);
+
+    auto p = &header[Message::kHeaderBytes];
+    std::size_t n;
+    n  = std::size_t{p[0]} << 24;
+    n += std::size_t{p[1]} << 16;
+    n += std::size_t{p[2]} <<  8;
+    n += std::size_t{p[3]};
+
+    // LZ4 expands its input at most about 255 times, so a larger claim
+    // is malformed and must not cost us the allocation.
+    if (n == 0 || n > std::size_t{Tuning::maxDecompressedBytes} ||
+            n > compressed * 255)
+        return false;
+
+    // Read the block in place when the message is contiguous, which it
+    // usually is. Otherwise copy only the block.
+    std::vector<std::uint8_t> in;
+    char const* block = nullptr;
+    auto const first = buffers.begin();
+    if (first != buffers.end() &&
+        boost::asio::buffer_size(*first) >= size)
+    {
+        block = boost::asio::buffer_cast<char const*>(*first) + offset;
+    }
+    else
+    {
+        in.resize (compressed);
+        auto const begin = boost::asio::buffers_begin(buffers) + offset;
+        std::copy (begin, begin + compressed, in.begin());
+        block = reinterpret_cast<char const*>(in.data());
+    }
+
+    payload.resize (n);
+    auto const result = LZ4_decompress_safe (
+        block,
+        reinterpret_cast<char*>(payload.data()),
+        static_cast<int>(compressed),
+        static_cast<int>(n));
+    return result >= 0 && static_cast<std::size_t>(result) == n;
+}
+
 }
 
 /** Calls the handler for up to one protocol message in the passed buffers.
@@ -111,26 +199,20 @@ invokeProtocolMessage (Buffers const& buffers, Handler& handler)
     if (boost::asio::buffer_size(buffers) < size)
         return result;
 
-    switch (type)
+    if (Message::compressed(buffers))
     {
-    case protocol::mtHELLO:         ec = detail::invoke<protocol::TMHello> (type, buffers, handler); break;
-    case protocol::mtMANIFESTS:     ec = detail::invoke<protocol::TMManifests> (type, buffers, handler); break;
-    case protocol::mtPING:          ec = detail::invoke<protocol::TMPing> (type, buffers, handler); break;
-    case protocol::mtCLUSTER:       ec = detail::invoke<protocol::TMCluster> (type, buffers, handler); break;
-    case protocol::mtGET_PEERS:     ec = detail::invoke<protocol::TMGetPeers> (type, buffers, handler); break;
-    case protocol::mtPEERS:         ec = detail::invoke<protocol::TMPeers> (type, buffers, handler); break;
-    case protocol::mtENDPOINTS:     ec = detail::invoke<protocol::TMEndpoints> (type, buffers, handler); break;
-    case protocol::mtTRANSACTION:   ec = detail::invoke<protocol::TMTransaction> (type, buffers, handler); break;
-    case protocol::mtGET_LEDGER:    ec = detail::invoke<protocol::TMGetLedger> (type, buffers, handler); break;
-    case protocol::mtLEDGER_DATA:   ec = detail::invoke<protocol::TMLedgerData> (type, buffers, handler); break;
-    case protocol::mtPROPOSE_LEDGER:ec = detail::invoke<protocol::TMProposeSet> (type, buffers, handler); break;
-    case protocol::mtSTATUS_CHANGE: ec = detail::invoke<protocol::TMStatusChange> (type, buffers, handler); break;
-    case protocol::mtHAVE_SET:      ec = detail::invoke<protocol::TMHaveTransactionSet> (type, buffers, handler); break;
-    case protocol::mtVALIDATION:    ec = detail::invoke<protocol::TMValidation> (type, buffers, handler); break;
-    case protocol::mtGET_OBJECTS:   ec = detail::invoke<protocol::TMGetObjectByHash> (type, buffers, handler); break;
-    default:
-        ec = handler.onMessageUnknown (type);
-        break;
+        std::vector<std::uint8_t> payload;
+        if (! detail::decompress(buffers, size, payload))
+            ec = boost::system::errc::make_error_code(
+                boost::system::errc::invalid_argument);
+        else
+            ec = detail::dispatch(type, boost::asio::const_buffers_1(
+                payload.data(), payload.size()), 0, size, handler);
+    }
+    else
+    {
+        ec = detail::dispatch(type, buffers,
+            Message::kHeaderBytes, size, handler);
     }
     if (! ec)
         result.first = size;
@@ -138,6 +138,10 @@ buildHello (
     // take over the functionality.
     h.set_nodeprivate (true);
 
+    // We can always decode compressed messages, whether or
+    // not we are configured to send them.
+    h.set_compression (true);
+
     auto const closedLedger = app.getLedgerMaster().getClosedLedger();
 
     assert(! closedLedger->open());
@@ -185,6 +189,9 @@ appendHello (beast::http::fields& h,
     if (hello.has_remote_ip())
         h.insert ("Remote-IP", beast::IP::to_string (
             beast::IP::AddressV4(hello.remote_ip())));
+
+    if (hello.has_compression() && hello.compression())
+        h.insert ("Accept-Compression", "lz4");
 }
 
 std::vector<ProtocolVersion>
@@ -336,6 +343,16 @@ parseHello (bool request, beast::http::fields const& h, beast::Journal journal)
         }
     }
 
+    {
+        auto const iter = h.find ("Accept-Compression");
+        if (iter != h.end())
+        {
+            for (auto const& s : beast::rfc2616::split_commas(iter->second))
+                if (beast::rfc2616::ci_equal(s, "lz4"))
+                    hello.set_compression (true);
+        }
+    }
+
     return hello;
 }
 
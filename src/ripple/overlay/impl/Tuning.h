@@ -71,6 +71,12 @@ enum
 
     /** How many messages we consider reasonable sustained on a send queue */
     targetSendQueue     =   16,
+
+    /** Smallest message payload we attempt to compress for a peer */
+    compressMinBytes    = 1024,
+
+    /** Largest payload we will expand a compressed message into */
+    maxDecompressedBytes = 64 * 1024 * 1024,
 };
 
 } // Tuning
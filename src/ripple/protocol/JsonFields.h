@@ -77,6 +77,7 @@ JSS ( action );
 JSS ( acquiring );                  // out: LedgerRequest
 JSS ( address );                    // out: PeerImp
 JSS ( affected );                   // out: AcceptedLedgerTx
+JSS ( after );                      // out: LedgerDiff
 JSS ( age );                        // out: NetworkOPs, Peers
 JSS ( alternatives );               // out: PathRequest, RipplePathFind
 JSS ( amendment_blocked );          // out: NetworkOPs
@@ -92,6 +93,10 @@ JSS ( balances );                   // out: GatewayBalances
 JSS ( base );                       // out: LogLevel
 JSS ( base_fee );                   // out: NetworkOPs
 JSS ( base_fee_xrp );               // out: NetworkOPs
+JSS ( base_ledger );                // in: LedgerDiff
+JSS ( base_ledger_hash );           // out: LedgerDiff
+JSS ( base_ledger_index );          // out: LedgerDiff
+JSS ( before );                     // out: LedgerDiff
 JSS ( bids );                       // out: Subscribe
 JSS ( binary );                     // in: AccountTX, LedgerEntry,
                                     //     AccountTxOld, Tx LedgerData
@@ -105,6 +110,7 @@ JSS ( can_delete );                 // out: CanDelete
 JSS ( channel_id );                 // out: AccountChannels
 JSS ( channels );                   // out: AccountChannels
 JSS ( check_nodes );                // in: LedgerCleaner
+JSS ( checkouts );                  // out: GetCounts
 JSS ( clear );                      // in/out: FetchInfo
 JSS ( close_flags );                // out: LedgerToJson
 JSS ( close_time );                 // in: Application, out: NetworkOPs,
@@ -136,6 +142,7 @@ JSS ( date );                       // out: tx/Transaction, NetworkOPs
 JSS ( dbKBLedger );                 // out: getCounts
 JSS ( dbKBTotal );                  // out: getCounts
 JSS ( dbKBTransaction );            // out: getCounts
+JSS ( db_read_pool );               // out: GetCounts
 JSS ( debug_signing );              // in: TransactionSign
 JSS ( delivered_amount );           // out: addPaymentDeliveredAmount
 JSS ( deprecated );                 // out: WalletSeed
@@ -146,10 +153,12 @@ JSS ( destination_amount );         // in: PathRequest, RipplePathFind
 JSS ( destination_currencies );     // in: PathRequest, RipplePathFind
 JSS ( destination_tag );            // in: PathRequest
                                     // out: AccountChannels
+JSS ( diff );                       // out: LedgerDiff
 JSS ( dir_entry );                  // out: DirectoryEntryIterator
 JSS ( dir_index );                  // out: DirectoryEntryIterator
 JSS ( dir_root );                   // out: DirectoryEntryIterator
 JSS ( directory );                  // in: LedgerEntry
+JSS ( displayTimeUnit );            // out: JobQueue
 JSS ( drops );                      // out: TxQ
 JSS ( duration_us );                // out: NetworkOPs
 JSS ( enabled );                    // out: AmendmentTable
@@ -164,6 +173,7 @@ JSS ( error_message );              // out: error
 JSS ( expand );                     // in: handler/Ledger
 JSS ( expected_ledger_size );       // out: TxQ
 JSS ( expiration );                 // out: AccountOffers, AccountChannels
+JSS ( export_path );                // in: Shards
 JSS ( fail_hard );                  // in: Sign, Submit
 JSS ( failed );                     // out: InboundLedger
 JSS ( feature );                    // in: Feature
@@ -179,6 +189,7 @@ JSS ( first );                      // out: rpc/Version
 JSS ( fix_txns );                   // in: LedgerCleaner
 JSS ( flags );                      // out: paths/Node, AccountOffers,
                                     //      NetworkOPs
+JSS ( format );                     // in: JobTrace
 JSS ( forward );                    // in: AccountTx
 JSS ( freeze );                     // out: AccountLines
 JSS ( freeze_peer );                // out: AccountLines
@@ -200,6 +211,7 @@ JSS ( hotwallet );                  // in: GatewayBalances
 JSS ( id );                         // websocket.
 JSS ( ident );                      // in: AccountCurrencies, AccountInfo,
                                     //     OwnerInfo
+JSS ( import_path );                // in: Shards
 JSS ( inLedger );                   // out: tx/Transaction
 JSS ( inbound );                    // out: PeerImp
 JSS ( index );                      // in: LedgerEntry; out: PathState,
@@ -213,6 +225,9 @@ JSS ( ip );                         // in: Connect, out: OverlayImpl
 JSS ( issuer );                     // in: RipplePathFind, Subscribe,
                                     //     Unsubscribe, BookOffers
                                     // out: paths/Node, STPathSet, STAmount
+JSS ( item_pool_kb );               // out: GetCounts
+JSS ( job_type );                   // out: JobQueue
+JSS ( job_types );                  // out: JobQueue
 JSS ( jsonrpc );                    // json version
 JSS ( key );                        // out: WalletSeed
 JSS ( key_type );                   // in/out: WalletPropose, TransactionSign
@@ -237,6 +252,7 @@ JSS ( ledger_index_min );           // in, out: AccountTx*
 JSS ( ledger_max );                 // in, out: AccountTx*
 JSS ( ledger_min );                 // in, out: AccountTx*
 JSS ( ledger_time );                // out: NetworkOPs
+JSS ( ledgers_per_shard );          // out: Shards
 JSS ( levels );                     // LogLevels
 JSS ( limit );                      // in/out: AccountTx*, AccountOffers,
                                     //         AccountLines, AccountObjects
@@ -256,6 +272,9 @@ JSS ( load_factor_server );         // out: NetworkOPs
 JSS ( load_fee );                   // out: LoadFeeTrackImp, NetworkOPs
 JSS ( local );                      // out: resource/Logic.h
 JSS ( local_txs );                  // out: GetCounts
+JSS ( log_blocked );                // out: GetCounts
+JSS ( log_dropped );                // out: GetCounts
+JSS ( log_written );                // out: GetCounts
 JSS ( lowest_sequence );            // out: AccountInfo
 JSS ( majority );                   // out: RPC feature
 JSS ( marker );                     // in/out: AccountTx, AccountOffers,
@@ -266,6 +285,7 @@ JSS ( master_key );                 // out: WalletPropose
 JSS ( master_seed );                // out: WalletPropose
 JSS ( master_seed_hex );            // out: WalletPropose
 JSS ( master_signature );           // out: pubManifest
+JSS ( max );                        // out: JobQueue
 JSS ( max_ledger );                 // in/out: LedgerCleaner
 JSS ( max_queue_size );             // out: TxQ
 JSS ( max_spend_drops );            // out: AccountInfo
@@ -307,6 +327,9 @@ JSS ( open_ledger_fee );            // out: TxQ
 JSS ( open_ledger_level );          // out: TxQ
 JSS ( owner );                      // in: LedgerEntry, out: NetworkOPs
 JSS ( owner_funds );                // in/out: Ledger, NetworkOPs, AcceptedLedgerTx
+JSS ( p50 );                        // out: JobQueue
+JSS ( p90 );                        // out: JobQueue
+JSS ( p99 );                        // out: JobQueue
 JSS ( params );                     // RPC
 JSS ( parent_close_time );          // out: LedgerToJson
 JSS ( parent_hash );                // out: LedgerToJson
@@ -353,7 +376,13 @@ JSS ( ripple_lines );               // out: NetworkOPs
 JSS ( ripple_state );               // in: LedgerEntr
 JSS ( ripplerpc );                  // ripple RPC version
 JSS ( role );                       // out: Ping.cpp
+JSS ( rpc_cache_hit_rate );         // out: GetCounts
+JSS ( rpc_cache_hits );             // out: GetCounts
+JSS ( rpc_cache_kb );               // out: GetCounts
+JSS ( rpc_cache_misses );           // out: GetCounts
+JSS ( rpc_cache_size );             // out: GetCounts
 JSS ( rt_accounts );                // in: Subscribe, Unsubscribe
+JSS ( run_us );                     // out: JobQueue
 JSS ( sanity );                     // out: PeerImp
 JSS ( search_depth );               // in: RipplePathFind
 JSS ( secret );                     // in: TransactionSign, WalletSeed,
@@ -370,12 +399,16 @@ JSS ( server_state );               // out: NetworkOPs
 JSS ( server_status );              // out: NetworkOPs
 JSS ( settle_delay );               // out: AccountChannels
 JSS ( severity );                   // in: LogLevel
+JSS ( shard_index );                // in: Shards
+JSS ( shards );                     // out: Shards
 JSS ( signature );                  // out: NetworkOPs, ChannelAuthorize
 JSS ( signature_verified );         // out: ChannelVerify
 JSS ( signing_key );                // out: NetworkOPs
 JSS ( signing_time );               // out: NetworkOPs
 JSS ( signer_list );                // in: AccountObjects
 JSS ( signer_lists );               // in/out: AccountInfo
+JSS ( slow_jobs );                  // out: JobQueue
+JSS ( slow_threshold_ms );          // out: JobQueue
 JSS ( snapshot );                   // in: Subscribe
 JSS ( source_account );             // in: PathRequest, RipplePathFind
 JSS ( source_amount );              // in: PathRequest, RipplePathFind
@@ -401,9 +434,11 @@ JSS ( taker_gets );                 // in: Subscribe, Unsubscribe, BookOffers
 JSS ( taker_gets_funded );          // out: NetworkOPs
 JSS ( taker_pays );                 // in: Subscribe, Unsubscribe, BookOffers
 JSS ( taker_pays_funded );          // out: NetworkOPs
+JSS ( thread );                     // out: JobQueue
 JSS ( threshold );                  // in: Blacklist
 JSS ( ticket );                     // in: AccountObjects
 JSS ( timeouts );                   // out: InboundLedger
+JSS ( traceEvents );                // out: JobQueue
 JSS ( traffic );                    // out: Overlay
 JSS ( totalCoins );                 // out: LedgerToJson
 JSS ( total_coins );                // out: LedgerToJson
@@ -453,6 +488,9 @@ JSS ( value );                      // out: STAmount
 JSS ( version );                    // out: RPCVersion
 JSS ( vetoed );                     // out: AmendmentTableImpl
 JSS ( vote );                       // in: Feature
+JSS ( wait_ms );                    // out: GetCounts
+JSS ( wait_us );                    // out: JobQueue
+JSS ( waits );                      // out: GetCounts
 JSS ( warning );                    // rpc:
 JSS ( write_load );                 // out: GetCounts
 
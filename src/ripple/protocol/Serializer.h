@@ -101,6 +101,7 @@ public:
     }
 
     int addRaw (Blob const& vector);
+    int addRaw (Slice slice);
     int addRaw (const void* ptr, int len);
     int addRaw (const Serializer& s);
     int addZeros (size_t uBytes);
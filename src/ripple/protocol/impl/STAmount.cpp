@@ -29,6 +29,7 @@
 #include <boost/regex.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/multiprecision/cpp_int.hpp>
+#include <algorithm>
 #include <iterator>
 #include <memory>
 #include <iostream>
@@ -48,6 +49,55 @@ static const std::uint64_t tenTo14 = 100000000000000ull;
 static const std::uint64_t tenTo14m1 = tenTo14 - 1;
 static const std::uint64_t tenTo17 = tenTo14 * 1000;
 
+// Every power of ten that fits in 64 bits. Mantissas are rescaled with
+// a single multiply or divide by an entry, rather than a digit at a time.
+static std::uint64_t const powersOfTen[] =
+{
+    1ull,
+    10ull,
+    100ull,
+    1000ull,
+    10000ull,
+    100000ull,
+    1000000ull,
+    10000000ull,
+    100000000ull,
+    1000000000ull,
+    10000000000ull,
+    100000000000ull,
+    1000000000000ull,
+    10000000000000ull,
+    100000000000000ull,
+    1000000000000000ull,
+    10000000000000000ull,
+    100000000000000000ull,
+    1000000000000000000ull,
+    10000000000000000000ull
+};
+
+// Returns the number of decimal digits in a non-zero value
+static
+int
+decimalDigits (std::uint64_t value)
+{
+    return static_cast<int> (std::upper_bound (
+        std::begin (powersOfTen) + 1, std::end (powersOfTen), value) -
+            std::begin (powersOfTen));
+}
+
+// Scale a non-zero native mantissa up to at least cMinValue
+static
+void
+normalizeNative (std::uint64_t& value, int& offset)
+{
+    if (value < STAmount::cMinValue)
+    {
+        int const shift = 16 - decimalDigits (value);
+        value *= powersOfTen[shift];
+        offset -= shift;
+    }
+}
+
 //------------------------------------------------------------------------------
 static
 std::int64_t
@@ -644,16 +694,18 @@ void STAmount::canonicalize ()
             return;
         }
 
-        while (mOffset < 0)
+        if (mOffset < 0)
         {
-            mValue /= 10;
-            ++mOffset;
+            mValue = (mOffset < -19) ? 0 : mValue / powersOfTen[-mOffset];
+            mOffset = 0;
         }
 
+        // Wraps exactly as multiplying by ten one step at a time would
         while (mOffset > 0)
         {
-            mValue *= 10;
-            --mOffset;
+            int const shift = std::min (mOffset, 19);
+            mValue *= powersOfTen[shift];
+            mOffset -= shift;
         }
 
         if (mValue > cMaxNativeN)
@@ -671,19 +723,28 @@ void STAmount::canonicalize ()
         return;
     }
 
-    while ((mValue < cMinValue) && (mOffset > cMinOffset))
+    if (mValue < cMinValue)
     {
-        mValue *= 10;
-        --mOffset;
-    }
+        // Scale up, but not past the smallest offset
+        int const room =
+            (mOffset > cMinOffset + 16) ? 16 : mOffset - cMinOffset;
+        int const shift = std::min (16 - decimalDigits (mValue), room);
 
-    while (mValue > cMaxValue)
+        if (shift > 0)
+        {
+            mValue *= powersOfTen[shift];
+            mOffset -= shift;
+        }
+    }
+    else if (mValue > cMaxValue)
     {
-        if (mOffset >= cMaxOffset)
+        int const shift = decimalDigits (mValue) - 16;
+
+        if (mOffset > cMaxOffset - shift)
             Throw<std::runtime_error> ("value overflow");
 
-        mValue /= 10;
-        ++mOffset;
+        mValue /= powersOfTen[shift];
+        mOffset += shift;
     }
 
     if ((mOffset < cMinOffset) || (mValue < cMinValue))
@@ -972,6 +1033,14 @@ operator- (STAmount const& value)
 //
 //------------------------------------------------------------------------------
 
+// Intermediate type for the products below. Where the compiler offers
+// a native 128-bit integer the multiply and divide need no library call.
+#ifdef __SIZEOF_INT128__
+using product_t = unsigned __int128;
+#else
+using product_t = boost::multiprecision::uint128_t;
+#endif
+
 // Calculate (a * b) / c when all three values are 64-bit
 // without loss of precision:
 static
@@ -981,9 +1050,7 @@ muldiv(
     std::uint64_t multiplicand,
     std::uint64_t divisor)
 {
-    boost::multiprecision::uint128_t ret;
-
-    boost::multiprecision::multiply(ret, multiplier, multiplicand);
+    product_t ret = product_t (multiplier) * multiplicand;
     ret /= divisor;
 
     if (ret > std::numeric_limits<std::uint64_t>::max())
@@ -1005,9 +1072,7 @@ muldiv_round(
     std::uint64_t divisor,
     std::uint64_t rounding)
 {
-    boost::multiprecision::uint128_t ret;
-
-    boost::multiprecision::multiply(ret, multiplier, multiplicand);
+    product_t ret = product_t (multiplier) * multiplicand;
     ret += rounding;
     ret /= divisor;
 
@@ -1038,23 +1103,10 @@ divide (STAmount const& num, STAmount const& den, Issue const& issue)
     int denOffset = den.exponent();
 
     if (num.native())
-    {
-        while (numVal < STAmount::cMinValue)
-        {
-            // Need to bring into range
-            numVal *= 10;
-            --numOffset;
-        }
-    }
+        normalizeNative (numVal, numOffset);
 
     if (den.native())
-    {
-        while (denVal < STAmount::cMinValue)
-        {
-            denVal *= 10;
-            --denOffset;
-        }
-    }
+        normalizeNative (denVal, denOffset);
 
     // We divide the two mantissas (each is between 10^15
     // and 10^16). To maintain precision, we multiply the
@@ -1095,22 +1147,10 @@ multiply (STAmount const& v1, STAmount const& v2, Issue const& issue)
     int offset2 = v2.exponent();
 
     if (v1.native())
-    {
-        while (value1 < STAmount::cMinValue)
-        {
-            value1 *= 10;
-            --offset1;
-        }
-    }
+        normalizeNative (value1, offset1);
 
     if (v2.native())
-    {
-        while (value2 < STAmount::cMinValue)
-        {
-            value2 *= 10;
-            --offset2;
-        }
-    }
+        normalizeNative (value2, offset2);
 
     // We multiply the two mantissas (each is between 10^15
     // and 10^16), so their product is in the 10^30 to 10^32
@@ -1130,13 +1170,13 @@ canonicalizeRound (bool native, std::uint64_t& value, int& offset)
     {
         if (offset < 0)
         {
-            int loops = 0;
+            // Drop all but the last digit at once
+            int const loops = -1 - offset;
 
-            while (offset < -1)
+            if (loops > 0)
             {
-                value /= 10;
-                ++offset;
-                ++loops;
+                value = (loops > 19) ? 0 : value / powersOfTen[loops];
+                offset = -1;
             }
 
             value += (loops >= 2) ? 9 : 10; // add before last divide
@@ -1146,12 +1186,18 @@ canonicalizeRound (bool native, std::uint64_t& value, int& offset)
     }
     else if (value > STAmount::cMaxValue)
     {
-        while (value > (10 * STAmount::cMaxValue))
+        // Drop all but the last excess digit at once
+        int shift = std::max (decimalDigits (value) - 17, 0);
+        value /= powersOfTen[shift];
+
+        if (value > (10 * STAmount::cMaxValue))
         {
             value /= 10;
-            ++offset;
+            ++shift;
         }
 
+        offset += shift;
+
         value += 9;     // add before last divide
         value /= 10;
         ++offset;
@@ -1187,22 +1233,10 @@ mulRound (STAmount const& v1, STAmount const& v2, Issue const& issue,
     int offset1 = v1.exponent(), offset2 = v2.exponent();
 
     if (v1.native())
-    {
-        while (value1 < STAmount::cMinValue)
-        {
-            value1 *= 10;
-            --offset1;
-        }
-    }
+        normalizeNative (value1, offset1);
 
     if (v2.native())
-    {
-        while (value2 < STAmount::cMinValue)
-        {
-            value2 *= 10;
-            --offset2;
-        }
-    }
+        normalizeNative (value2, offset2);
 
     bool const resultNegative = v1.negative() != v2.negative();
 
@@ -1257,22 +1291,10 @@ divRound (STAmount const& num, STAmount const& den,
     int numOffset = num.exponent(), denOffset = den.exponent();
 
     if (num.native())
-    {
-        while (numVal < STAmount::cMinValue)
-        {
-            numVal *= 10;
-            --numOffset;
-        }
-    }
+        normalizeNative (numVal, numOffset);
 
     if (den.native())
-    {
-        while (denVal < STAmount::cMinValue)
-        {
-            denVal *= 10;
-            --denOffset;
-        }
-    }
+        normalizeNative (denVal, denOffset);
 
     bool const resultNegative =
         (num.negative() != den.negative());
@@ -93,6 +93,13 @@ int Serializer::addRaw (Blob const& vector)
     return ret;
 }
 
+int Serializer::addRaw (Slice slice)
+{
+    int ret = mData.size ();
+    mData.insert (mData.end (), slice.data (), slice.data () + slice.size ());
+    return ret;
+}
+
 int Serializer::addRaw (const Serializer& s)
 {
     int ret = mData.size ();
@@ -18,11 +18,13 @@
 //==============================================================================
 
 #include <BeastConfig.h>
+#include <ripple/app/ledger/IssuerBalancesDB.h>
 #include <ripple/app/main/Application.h>
 #include <ripple/app/paths/RippleState.h>
 #include <ripple/ledger/ReadView.h>
 #include <ripple/protocol/AccountID.h>
 #include <ripple/protocol/ErrorCodes.h>
+#include <ripple/protocol/Indexes.h>
 #include <ripple/protocol/JsonFields.h>
 #include <ripple/protocol/PublicKey.h>
 #include <ripple/resource/Fees.h>
@@ -143,8 +145,77 @@ Json::Value doGatewayBalances (RPC::Context& context)
     std::map <AccountID, std::vector <STAmount>> assets;
     std::map <AccountID, std::vector <STAmount>> frozenBalances;
 
-    // Traverse the cold wallet's trust lines
+    auto const totals = context.app.getIssuerBalancesDB ().getTotals (
+        *ledger, accountID);
+
+    if (totals)
+    {
+        // The index doesn't know the hot wallets, so read their lines
+        // and take them out of the obligations.
+        auto obligations = totals->obligations ();
+
+        for (auto const& hot : hotWallets)
+        {
+            std::set <Currency> currencies;
+            for (auto const& o : obligations)
+                currencies.insert (o.first);
+            for (auto const balances :
+                { &totals->frozen (), &totals->assets () })
+            {
+                auto const it = balances->find (hot);
+                if (it != balances->end ())
+                    for (auto const& b : it->second)
+                        currencies.insert (b.first);
+            }
+
+            for (auto const& currency : currencies)
+            {
+                auto rs = RippleState::makeItem (accountID,
+                    ledger->read (keylet::line (accountID, hot, currency)));
+
+                if (!rs || rs->getBalance () == zero)
+                    continue;
+
+                hotBalances[hot].push_back (-rs->getBalance ());
+
+                if (rs->getBalance () > zero || rs->getFreeze ())
+                    continue;
+
+                auto const it = obligations.find (currency);
+                if (it == obligations.end ())
+                    continue;
+
+                if (--it->second.lines == 0)
+                    obligations.erase (it);
+                else
+                    it->second.amount += rs->getBalance ();
+            }
+        }
+
+        for (auto const& o : obligations)
+            sums[o.first] = o.second.amount;
+
+        auto collect = [&hotWallets](
+            IssuerBalances::Totals::Balances const& from,
+            std::map <AccountID, std::vector <STAmount>>& to)
+            {
+                for (auto const& account : from)
+                {
+                    if (hotWallets.count (account.first) > 0)
+                        continue;
+
+                    auto& balances = to[account.first];
+                    for (auto const& b : account.second)
+                        balances.push_back (b.second);
+                }
+            };
+
+        collect (totals->frozen (), frozenBalances);
+        collect (totals->assets (), assets);
+    }
+    else
     {
+        // Traverse the cold wallet's trust lines
         forEachItem(*ledger, accountID,
             [&](std::shared_ptr<SLE const> const& sle)
             {
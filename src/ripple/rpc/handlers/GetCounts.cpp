@@ -32,6 +32,8 @@
 #include <ripple/protocol/ErrorCodes.h>
 #include <ripple/protocol/JsonFields.h>
 #include <ripple/rpc/Context.h>
+#include <ripple/rpc/impl/ResponseCache.h>
+#include <ripple/shamap/SHAMapItem.h>
 
 namespace ripple {
 
@@ -91,6 +93,22 @@ Json::Value doGetCounts (RPC::Context& context)
     if (dbKB > 0)
         ret[jss::dbKBTransaction] = dbKB;
 
+    {
+        auto readStats = [](DatabaseCon const& db)
+        {
+            auto const stats = db.readStats ();
+            Json::Value v (Json::objectValue);
+            v[jss::checkouts] = static_cast<Json::UInt> (stats.checkouts);
+            v[jss::waits] = static_cast<Json::UInt> (stats.waits);
+            v[jss::wait_ms] = static_cast<Json::UInt> (
+                stats.waitMicroseconds / 1000);
+            return v;
+        };
+        Json::Value& pool = ret[jss::db_read_pool] = Json::objectValue;
+        pool[jss::ledger] = readStats (context.app.getLedgerDB ());
+        pool[jss::transaction] = readStats (context.app.getTxnDB ());
+    }
+
     {
         std::size_t c = context.app.getOPs().getLocalTxCount ();
         if (c > 0)
@@ -109,6 +127,14 @@ Json::Value doGetCounts (RPC::Context& context)
     ret[jss::fullbelow_size] = static_cast<int>(context.app.family().fullbelow().size());
     ret[jss::treenode_cache_size] = context.app.family().treecache().getCacheSize();
     ret[jss::treenode_track_size] = context.app.family().treecache().getTrackSize();
+    ret[jss::item_pool_kb] = static_cast<Json::UInt>(getSHAMapItemPoolSize() / 1024);
+
+    auto const& responses = context.app.getResponseCache ();
+    ret[jss::rpc_cache_hit_rate] = responses.getHitRate ();
+    ret[jss::rpc_cache_hits] = static_cast<Json::UInt> (responses.getHits ());
+    ret[jss::rpc_cache_misses] = static_cast<Json::UInt> (responses.getMisses ());
+    ret[jss::rpc_cache_size] = static_cast<Json::UInt> (responses.size ());
+    ret[jss::rpc_cache_kb] = static_cast<Json::UInt> (responses.bytes () / 1024);
 
     std::string uptime;
     int s = UptimeTimer::getInstance ().getElapsedSeconds ();
@@ -125,6 +151,11 @@ Json::Value doGetCounts (RPC::Context& context)
     ret[jss::node_written_bytes] = context.app.getNodeStore().getStoreSize();
     ret[jss::node_read_bytes] = context.app.getNodeStore().getFetchSize();
 
+    auto const logCounts = context.app.logs().asyncCounts();
+    ret[jss::log_written] = static_cast<Json::UInt>(logCounts.written);
+    ret[jss::log_dropped] = static_cast<Json::UInt>(logCounts.dropped);
+    ret[jss::log_blocked] = static_cast<Json::UInt>(logCounts.blocked);
+
     return ret;
 }
 
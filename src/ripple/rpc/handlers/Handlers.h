@@ -45,11 +45,13 @@ Json::Value doFee                   (RPC::Context&);
 Json::Value doFetchInfo             (RPC::Context&);
 Json::Value doGatewayBalances       (RPC::Context&);
 Json::Value doGetCounts             (RPC::Context&);
+Json::Value doJobTrace              (RPC::Context&);
 Json::Value doLedgerAccept          (RPC::Context&);
 Json::Value doLedgerCleaner         (RPC::Context&);
 Json::Value doLedgerClosed          (RPC::Context&);
 Json::Value doLedgerCurrent         (RPC::Context&);
 Json::Value doLedgerData            (RPC::Context&);
+Json::Value doLedgerDiff            (RPC::Context&);
 Json::Value doLedgerEntry           (RPC::Context&);
 Json::Value doLedgerHeader          (RPC::Context&);
 Json::Value doLedgerRequest         (RPC::Context&);
@@ -67,6 +69,7 @@ Json::Value doServerInfo            (RPC::Context&); // for humans
 Json::Value doServerState           (RPC::Context&); // for machines
 Json::Value doSessionClose          (RPC::Context&);
 Json::Value doSessionOpen           (RPC::Context&);
+Json::Value doShards                (RPC::Context&);
 Json::Value doSign                  (RPC::Context&);
 Json::Value doSignFor               (RPC::Context&);
 Json::Value doStop                  (RPC::Context&);
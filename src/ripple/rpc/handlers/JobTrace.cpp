@@ -0,0 +1,59 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/app/main/Application.h>
+#include <ripple/core/JobQueue.h>
+#include <ripple/json/json_value.h>
+#include <ripple/protocol/ErrorCodes.h>
+#include <ripple/protocol/JsonFields.h>
+#include <ripple/rpc/Context.h>
+
+namespace ripple {
+
+// {
+//   format: "chrome"  // optional, return Chrome trace-event JSON
+//   clear: true       // optional, reset after reporting
+// }
+Json::Value doJobTrace (RPC::Context& context)
+{
+    auto& trace = context.app.getJobQueue ().getTrace ();
+
+    bool chrome = false;
+    if (context.params.isMember (jss::format))
+    {
+        if (context.params[jss::format].asString () != "chrome")
+            return RPC::invalid_field_error (jss::format);
+        chrome = true;
+    }
+
+    Json::Value ret = chrome ? trace.getChromeTrace () : trace.getJson ();
+
+    if (context.params.isMember (jss::clear) &&
+        context.params[jss::clear].asBool ())
+    {
+        trace.clear ();
+        if (! chrome)
+            ret[jss::clear] = true;
+    }
+
+    return ret;
+}
+
+} // ripple
@@ -0,0 +1,149 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/app/ledger/Ledger.h>
+#include <ripple/app/ledger/LedgerMaster.h>
+#include <ripple/basics/strHex.h>
+#include <ripple/ledger/ReadView.h>
+#include <ripple/net/RPCErr.h>
+#include <ripple/protocol/ErrorCodes.h>
+#include <ripple/protocol/JsonFields.h>
+#include <ripple/rpc/impl/RPCHelpers.h>
+#include <ripple/rpc/impl/Tuning.h>
+#include <ripple/rpc/Context.h>
+#include <ripple/rpc/Role.h>
+#include <ripple/shamap/SHAMapMissingNode.h>
+
+namespace ripple {
+
+// Get the state entries that differ between two closed ledgers
+//   Inputs:
+//     ledger_hash/ledger_index: the ledger to compare
+//     base_ledger:  hash or index of the ledger to compare it with,
+//                   defaults to its parent
+//     limit:        integer, maximum number of entries
+//     marker:       opaque, resume point
+//   Outputs:
+//     ledger_hash, ledger_index: the chosen ledger
+//     base_ledger_hash, base_ledger_index: the base ledger
+//     diff:         array of changed entries, each with its index and the
+//                   serialized entry before and after, if it exists
+//     marker:       resume point, if any
+Json::Value doLedgerDiff (RPC::Context& context)
+{
+    auto const& params = context.params;
+    auto& ledgerMaster = context.ledgerMaster;
+
+    std::shared_ptr<ReadView const> view;
+    auto jvResult = RPC::lookupLedger (view, context);
+    if (!view)
+        return jvResult;
+
+    // The open ledger has no state map we can walk
+    auto const ledger = ledgerMaster.getLedgerByHash (view->info().hash);
+    if (!ledger)
+        return rpcError (rpcLGR_NOT_FOUND);
+
+    std::shared_ptr<Ledger const> base;
+    if (params.isMember (jss::base_ledger))
+    {
+        Json::Value const& jBase = params[jss::base_ledger];
+        uint256 hash;
+        if (jBase.isIntegral () && jBase.isConvertibleTo (Json::uintValue))
+            base = ledgerMaster.getLedgerBySeq (jBase.asUInt ());
+        else if (jBase.isString () && hash.SetHex (jBase.asString ()))
+            base = ledgerMaster.getLedgerByHash (hash);
+        else
+            return RPC::expected_field_error (
+                jss::base_ledger, "ledger hash or index");
+    }
+    else
+    {
+        base = ledgerMaster.getLedgerByHash (ledger->info().parentHash);
+    }
+
+    if (!base)
+        return rpcError (rpcLGR_NOT_FOUND);
+
+    boost::optional<uint256> marker;
+    if (params.isMember (jss::marker))
+    {
+        Json::Value const& jMarker = params[jss::marker];
+        marker.emplace ();
+        if (! (jMarker.isString () && marker->SetHex (jMarker.asString ())))
+            return RPC::expected_field_error (jss::marker, "valid");
+    }
+
+    int limit = -1;
+    if (params.isMember (jss::limit))
+    {
+        Json::Value const& jLimit = params[jss::limit];
+        if (!jLimit.isIntegral ())
+            return RPC::expected_field_error (jss::limit, "integer");
+
+        limit = jLimit.asInt ();
+    }
+
+    auto const maxLimit = RPC::Tuning::pageLength (true);
+    if ((limit <= 0) || ((limit > maxLimit) && (! isUnlimited (context.role))))
+        limit = maxLimit;
+
+    jvResult[jss::ledger_hash] = to_string (ledger->info().hash);
+    jvResult[jss::ledger_index] = ledger->info().seq;
+    jvResult[jss::base_ledger_hash] = to_string (base->info().hash);
+    jvResult[jss::base_ledger_index] = base->info().seq;
+
+    Json::Value& diff = (jvResult[jss::diff] = Json::arrayValue);
+
+    // Entries are produced in key order, so the last key sent is
+    // where the next request picks up.
+    uint256 last;
+    try
+    {
+        ledger->stateMap ().visitDelta (base->stateMap (),
+            [&](uint256 const& key,
+                boost::intrusive_ptr<SHAMapItem const> const& after,
+                boost::intrusive_ptr<SHAMapItem const> const& before)
+            {
+                if (limit-- <= 0)
+                {
+                    jvResult[jss::marker] = to_string (last);
+                    return false;
+                }
+
+                Json::Value& entry = diff.append (Json::objectValue);
+                entry[jss::index] = to_string (key);
+                if (before)
+                    entry[jss::before] = strHex (before->slice ());
+                if (after)
+                    entry[jss::after] = strHex (after->slice ());
+                last = key;
+                return true;
+            }, marker);
+    }
+    catch (SHAMapMissingNode const&)
+    {
+        return rpcError (rpcLGR_NOT_FOUND);
+    }
+
+    return jvResult;
+}
+
+} // ripple
@@ -70,6 +70,11 @@ public:
         return NO_CONDITION;
     }
 
+    static Purity purity()
+    {
+        return PURE_FOR_LEDGER;
+    }
+
 private:
     Context& context_;
     std::shared_ptr<ReadView const> ledger_;
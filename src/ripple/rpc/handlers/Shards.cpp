@@ -0,0 +1,91 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/app/ledger/LedgerMaster.h>
+#include <ripple/app/main/Application.h>
+#include <ripple/app/misc/SHAMapStore.h>
+#include <ripple/protocol/ErrorCodes.h>
+#include <ripple/protocol/JsonFields.h>
+#include <ripple/rpc/Context.h>
+
+namespace ripple {
+
+// List, import or export history shards
+//   Inputs:
+//     import_path:  directory holding a shard to add
+//     export_path:  directory to create with a copy of a shard
+//     shard_index:  the shard to export
+//   Outputs:
+//     ledgers_per_shard: the number of ledgers in each shard
+//     shards:       array of the indexes of the finalized shards
+Json::Value doShards (RPC::Context& context)
+{
+    auto const shards = context.app.getSHAMapStore().getShards();
+    if (! shards)
+        return RPC::make_error (rpcNOT_ENABLED);
+
+    auto const& params = context.params;
+    try
+    {
+        if (params.isMember (jss::import_path))
+        {
+            if (! params[jss::import_path].isString())
+                return RPC::expected_field_error (jss::import_path, "string");
+
+            auto& ledgerMaster = context.ledgerMaster;
+            shards->importShard (params[jss::import_path].asString(),
+                [&ledgerMaster](std::uint32_t seq)
+                {
+                    return ledgerMaster.walkHashBySeq (seq);
+                });
+        }
+        else if (params.isMember (jss::export_path))
+        {
+            if (! params[jss::export_path].isString())
+                return RPC::expected_field_error (jss::export_path, "string");
+
+            if (! params.isMember (jss::shard_index))
+                return RPC::missing_field_error (jss::shard_index);
+
+            auto const& index = params[jss::shard_index];
+            if (! index.isIntegral() || ! index.isConvertibleTo (Json::uintValue))
+                return RPC::expected_field_error (
+                    jss::shard_index, "unsigned integer");
+
+            shards->exportShard (index.asUInt(),
+                params[jss::export_path].asString());
+        }
+    }
+    catch (std::exception const& e)
+    {
+        return RPC::make_error (rpcINVALID_PARAMS, e.what());
+    }
+
+    Json::Value ret (Json::objectValue);
+    ret[jss::ledgers_per_shard] = shards->ledgersPerShard();
+
+    Json::Value& list = (ret[jss::shards] = Json::arrayValue);
+    for (auto const index : shards->getShards())
+        list.append (index);
+
+    return ret;
+}
+
+} // ripple
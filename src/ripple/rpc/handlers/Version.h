@@ -55,6 +55,11 @@ public:
     {
         return NO_CONDITION;
     }
+
+    static Purity purity()
+    {
+        return IMPURE;
+    }
 };
 
 } // RPC
@@ -0,0 +1,341 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/rpc/impl/Admission.h>
+#include <ripple/basics/Log.h>
+#include <ripple/protocol/JsonFields.h>
+#include <algorithm>
+#include <cstdint>
+
+namespace ripple {
+namespace RPC {
+
+int
+estimateCost (std::string const& command, Json::Value const& params)
+{
+    // The number of results asked for, within what the handler allows
+    auto const limit = [&params](unsigned int rdefault, unsigned int rmax)
+    {
+        auto const& jv = params[jss::limit];
+        if (! jv.isIntegral () || (jv.isInt () && jv.asInt () < 0))
+            return rdefault;
+        return std::min (jv.asUInt (), rmax);
+    };
+
+    auto const flag = [&params](Json::StaticString const& name)
+    {
+        return params.isMember (name) && params[name].asBool ();
+    };
+
+    // A ledger sequence, or -1 if the field does not hold one. This runs
+    // before the handler validates the request, so it must not throw.
+    auto const sequence = [](Json::Value const& jv) -> std::int64_t
+    {
+        if (jv.isUInt ())
+            return jv.asUInt ();
+        if (jv.isInt ())
+            return std::max (jv.asInt (), -1);
+        return -1;
+    };
+
+    if (command == "account_tx" || command == "account_tx_old")
+    {
+        if (params.isMember (jss::ledger_index) ||
+            params.isMember (jss::ledger_hash))
+            return 5;
+
+        auto const min = sequence (params[jss::ledger_index_min]);
+        auto const max = sequence (params[jss::ledger_index_max]);
+        if (min < 0 || max < 0)
+            return 100;
+
+        // Searching more ledgers costs more, up to the whole history
+        auto const range = std::max<std::int64_t> (max - min, 0);
+        return 5 + static_cast<int> (
+            std::min<std::int64_t> (range / 10000, 95));
+    }
+
+    if (command == "ledger_data")
+    {
+        auto const page = Tuning::pageLength (flag (jss::binary));
+        return 5 + limit (page, page) / 16;
+    }
+
+    if (command == "ledger")
+    {
+        if (flag (jss::full) || flag (jss::accounts))
+            return 200;
+        if (flag (jss::transactions) && flag (jss::expand))
+            return 10;
+        return 1;
+    }
+
+    if (command == "ripple_path_find")
+        return 100;
+
+    if (command == "path_find")
+    {
+        auto const& subcommand = params[jss::subcommand];
+        return subcommand.isString () &&
+            subcommand.asString () == "create" ? 100 : 1;
+    }
+
+    if (command == "gateway_balances")
+        return 50;
+
+    if (command == "book_offers")
+        return 5 + limit (Tuning::bookOffers.rdefault,
+            Tuning::bookOffers.rmax) / 50;
+
+    if (command == "account_lines" || command == "account_channels" ||
+        command == "account_objects" || command == "account_offers")
+        return 2 + limit (Tuning::accountLines.rdefault,
+            Tuning::accountLines.rmax) / 100;
+
+    if (command == "subscribe")
+        return params.isMember (jss::books) ? 20 : 1;
+
+    if (command == "tx_history" || command == "noripple_check" ||
+        command == "submit" || command == "submit_multisigned" ||
+        command == "sign" || command == "sign_for")
+        return 5;
+
+    return 1;
+}
+
+//------------------------------------------------------------------------------
+
+Admission::Ticket::~Ticket ()
+{
+    if (entry_)
+        admission_->release (*entry_);
+}
+
+Admission::Ticket&
+Admission::Ticket::operator= (Ticket&& other)
+{
+    if (this != &other)
+    {
+        if (entry_)
+            admission_->release (*entry_);
+        admission_ = other.admission_;
+        entry_ = std::move (other.entry_);
+    }
+    return *this;
+}
+
+bool
+Admission::Ticket::waiting () const
+{
+    if (! entry_)
+        return false;
+    std::lock_guard <std::mutex> lock (admission_->mutex_);
+    return entry_->state == State::waiting;
+}
+
+bool
+Admission::Ticket::admitted () const
+{
+    if (! entry_)
+        return false;
+    std::lock_guard <std::mutex> lock (admission_->mutex_);
+    return entry_->state == State::admitted;
+}
+
+//------------------------------------------------------------------------------
+
+Admission::Admission (Setup const& setup, beast::Journal journal)
+    : setup_ (setup)
+    , j_ (journal)
+{
+}
+
+Admission::Ticket
+Admission::enter (std::string const& client, int cost, bool loaded,
+    std::function <void()> resume)
+{
+    auto entry = std::make_shared <Entry> ();
+    entry->client = client;
+    entry->cost = std::max (cost, 1);
+    entry->arrived = clock_type::now ();
+    entry->resume = std::move (resume);
+    cost = entry->cost;
+
+    std::lock_guard <std::mutex> lock (mutex_);
+
+    if (stopped_)
+        return decide (std::move (entry), State::refused);
+
+    bool const heavy = cost >= setup_.heavyCost;
+    if (loaded && heavy)
+        return decide (std::move (entry), State::refused);
+
+    // Run at once if nothing is waiting and there is room
+    if (queue_.empty () &&
+        (running_ == 0 || running_ + cost <= setup_.capacity))
+    {
+        running_ += cost;
+        return decide (std::move (entry), State::admitted);
+    }
+
+    if (queued_ + cost > setup_.queueLimit)
+        return decide (std::move (entry), State::refused);
+
+    // Shed early before the queue fills
+    if ((loaded || queued_ * 4 >= setup_.queueLimit * 3) &&
+        (heavy || crowding (client, cost)))
+        return decide (std::move (entry), State::refused);
+
+    auto& c = clients_[client];
+    auto const start = std::max (virtualTime_, c.finish);
+    c.finish = start + cost;
+    c.queued += cost;
+    queued_ += cost;
+
+    entry->key = Key (start, arrivals_++);
+    queue_.emplace (entry->key, entry);
+    return decide (std::move (entry), State::waiting);
+}
+
+void
+Admission::stop ()
+{
+    std::vector <std::function <void()>> resumes;
+    {
+        std::lock_guard <std::mutex> lock (mutex_);
+        stopped_ = true;
+        dispatch (resumes);
+    }
+
+    for (auto const& resume : resumes)
+        resume ();
+}
+
+int
+Admission::running () const
+{
+    std::lock_guard <std::mutex> lock (mutex_);
+    return running_;
+}
+
+int
+Admission::queued () const
+{
+    std::lock_guard <std::mutex> lock (mutex_);
+    return queued_;
+}
+
+std::uint64_t
+Admission::refused () const
+{
+    std::lock_guard <std::mutex> lock (mutex_);
+    return refused_;
+}
+
+Admission::Ticket
+Admission::decide (std::shared_ptr <Entry> entry, State state)
+{
+    entry->state = state;
+    if (state == State::refused)
+    {
+        ++refused_;
+        JLOG (j_.debug()) << "Refused request from " << entry->client <<
+            " costing " << entry->cost << ", " << running_ << " running, " <<
+                queued_ << " queued";
+        return Ticket ();
+    }
+    return Ticket (*this, std::move (entry));
+}
+
+bool
+Admission::crowding (std::string const& client, int cost) const
+{
+    int waiting = 0;
+    for (auto const& c : clients_)
+        if (c.second.queued > 0)
+            ++waiting;
+    if (waiting == 0)
+        return false;
+
+    auto const iter = clients_.find (client);
+    auto const mine = (iter == clients_.end ()) ? 0 : iter->second.queued;
+    return mine + cost > queued_ / waiting;
+}
+
+void
+Admission::unqueue (Entry& entry)
+{
+    queue_.erase (entry.key);
+    queued_ -= entry.cost;
+    clients_[entry.client].queued -= entry.cost;
+}
+
+void
+Admission::dispatch (std::vector <std::function <void()>>& resumes)
+{
+    auto const now = clock_type::now ();
+    while (! queue_.empty ())
+    {
+        auto const entry = queue_.begin ()->second;
+
+        if (stopped_ || now - entry->arrived > setup_.maxWait)
+        {
+            unqueue (*entry);
+            entry->state = State::refused;
+            ++refused_;
+            resumes.push_back (std::move (entry->resume));
+            continue;
+        }
+
+        if (running_ > 0 && running_ + entry->cost > setup_.capacity)
+            break;
+
+        unqueue (*entry);
+        virtualTime_ = entry->key.first;
+        running_ += entry->cost;
+        entry->state = State::admitted;
+        resumes.push_back (std::move (entry->resume));
+    }
+
+    // Clients start afresh once the backlog clears
+    if (queue_.empty ())
+        clients_.clear ();
+}
+
+void
+Admission::release (Entry& entry)
+{
+    std::vector <std::function <void()>> resumes;
+    {
+        std::lock_guard <std::mutex> lock (mutex_);
+        if (entry.state == State::admitted)
+            running_ -= entry.cost;
+        else if (entry.state == State::waiting)
+            unqueue (entry);
+        entry.state = State::finished;
+        dispatch (resumes);
+    }
+
+    for (auto const& resume : resumes)
+        resume ();
+}
+
+} // RPC
+} // ripple
@@ -0,0 +1,204 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_RPC_ADMISSION_H_INCLUDED
+#define RIPPLE_RPC_ADMISSION_H_INCLUDED
+
+#include <ripple/json/json_value.h>
+#include <ripple/rpc/impl/Tuning.h>
+#include <ripple/beast/utility/Journal.h>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ripple {
+namespace RPC {
+
+/** Returns the estimated cost of running a command.
+
+    Costs are in units of a cheap command such as server_info, and grow
+    with the amount of work the parameters ask for, such as the range of
+    ledgers searched or the number of results requested.
+*/
+int
+estimateCost (std::string const& command, Json::Value const& params);
+
+/** Admits RPC requests by estimated cost, sharing capacity between clients.
+
+    Requests run at once while the cost of the requests already running
+    leaves room for them. Otherwise they wait in a start-time fair queue:
+    each client's requests advance that client's virtual clock by their
+    cost, so a client sending heavy requests waits longer for each one
+    than a client sending cheap ones, and no client can crowd out the
+    rest.
+
+    When the queue is nearly full or the server reports that it is
+    loaded, heavy requests and requests from clients already holding more
+    than their share of the queue are refused instead of queued. Requests
+    which waited too long are refused when they reach the front.
+*/
+class Admission
+{
+public:
+    using clock_type = std::chrono::steady_clock;
+
+    struct Setup
+    {
+        /** Total cost of the requests allowed to run at once. */
+        int capacity = Tuning::admissionCapacity;
+
+        /** Total cost of the requests allowed to wait. */
+        int queueLimit = Tuning::admissionQueueLimit;
+
+        /** Requests costing at least this are refused first under load. */
+        int heavyCost = Tuning::heavyRequestCost;
+
+        /** Longest time a request may wait before it is refused. */
+        std::chrono::milliseconds maxWait = Tuning::maxAdmissionWait;
+    };
+
+private:
+    struct Entry;
+
+public:
+    /** The decision for one request.
+        While admitted, the request's cost counts against the capacity.
+        It is returned when the ticket is destroyed.
+    */
+    class Ticket
+    {
+    public:
+        Ticket () = default;
+        Ticket (Ticket&&) = default;
+        Ticket& operator= (Ticket&& other);
+        ~Ticket ();
+
+        /** Returns `true` if the request is queued.
+            The resume function passed to enter is called once, from
+            another thread, when the request is admitted or refused.
+        */
+        bool
+        waiting () const;
+
+        /** Returns `true` if the request may run. */
+        bool
+        admitted () const;
+
+    private:
+        friend class Admission;
+
+        Ticket (Admission& admission, std::shared_ptr <Entry> entry)
+            : admission_ (&admission)
+            , entry_ (std::move (entry))
+        {
+        }
+
+        Admission* admission_ = nullptr;
+        std::shared_ptr <Entry> entry_;
+    };
+
+    Admission (Setup const& setup, beast::Journal journal);
+
+    Admission (Admission const&) = delete;
+    Admission& operator= (Admission const&) = delete;
+
+    /** Ask to run a request.
+        @param client Identifies the client, for fair sharing.
+        @param cost The estimated cost of the request.
+        @param loaded `true` if the server is loaded.
+        @param resume Called if the request is queued, once it is decided.
+    */
+    Ticket
+    enter (std::string const& client, int cost, bool loaded,
+        std::function <void()> resume);
+
+    /** Refuse all queued requests, and any made from now on. */
+    void
+    stop ();
+
+    /** Returns the total cost of the requests running. */
+    int
+    running () const;
+
+    /** Returns the total cost of the requests waiting. */
+    int
+    queued () const;
+
+    /** Returns the number of requests refused so far. */
+    std::uint64_t
+    refused () const;
+
+private:
+    enum class State
+    {
+        waiting,
+        admitted,
+        refused,
+        finished
+    };
+
+    // Virtual start time and arrival order
+    using Key = std::pair <std::uint64_t, std::uint64_t>;
+
+    struct Entry
+    {
+        std::string client;
+        int cost;
+        State state;
+        Key key;
+        clock_type::time_point arrived;
+        std::function <void()> resume;
+    };
+
+    struct Client
+    {
+        std::uint64_t finish = 0;   // virtual time of its last request
+        int queued = 0;             // cost of its waiting requests
+    };
+
+    Ticket decide (std::shared_ptr <Entry> entry, State state);
+    bool crowding (std::string const& client, int cost) const;
+    void unqueue (Entry& entry);
+    void dispatch (std::vector <std::function <void()>>& resumes);
+    void release (Entry& entry);
+
+    Setup const setup_;
+    beast::Journal j_;
+
+    mutable std::mutex mutex_;
+    std::map <Key, std::shared_ptr <Entry>> queue_;
+    std::map <std::string, Client> clients_;
+    std::uint64_t virtualTime_ = 0;
+    std::uint64_t arrivals_ = 0;
+    std::uint64_t refused_ = 0;
+    int running_ = 0;
+    int queued_ = 0;
+    bool stopped_ = false;
+};
+
+} // RPC
+} // ripple
+
+#endif
@@ -93,6 +93,7 @@ class HandlerTable {
         h.role_ = HandlerImpl::role();
         h.condition_ = HandlerImpl::condition();
         h.objectMethod_ = &handle<Json::Object, HandlerImpl>;
+        h.purity_ = HandlerImpl::purity();
 
         table_[HandlerImpl::name()] = h;
     };
@@ -101,32 +102,34 @@ class HandlerTable {
 Handler handlerArray[] {
     // Some handlers not specified here are added to the table via addHandler()
     // Request-response methods
-    {   "account_info",         byRef (&doAccountInfo),         Role::USER,  NO_CONDITION  },
-    {   "account_currencies",   byRef (&doAccountCurrencies),   Role::USER,  NO_CONDITION  },
-    {   "account_lines",        byRef (&doAccountLines),        Role::USER,  NO_CONDITION  },
-    {   "account_channels",     byRef (&doAccountChannels),     Role::USER,  NO_CONDITION  },
-    {   "account_objects",      byRef (&doAccountObjects),      Role::USER,  NO_CONDITION  },
-    {   "account_offers",       byRef (&doAccountOffers),       Role::USER,  NO_CONDITION  },
+    {   "account_info",         byRef (&doAccountInfo),         Role::USER,  NO_CONDITION, {}, PURE_FOR_LEDGER },
+    {   "account_currencies",   byRef (&doAccountCurrencies),   Role::USER,  NO_CONDITION, {}, PURE_FOR_LEDGER },
+    {   "account_lines",        byRef (&doAccountLines),        Role::USER,  NO_CONDITION, {}, PURE_FOR_LEDGER },
+    {   "account_channels",     byRef (&doAccountChannels),     Role::USER,  NO_CONDITION, {}, PURE_FOR_LEDGER },
+    {   "account_objects",      byRef (&doAccountObjects),      Role::USER,  NO_CONDITION, {}, PURE_FOR_LEDGER },
+    {   "account_offers",       byRef (&doAccountOffers),       Role::USER,  NO_CONDITION, {}, PURE_FOR_LEDGER },
     {   "account_tx",           byRef (&doAccountTxSwitch),     Role::USER,  NO_CONDITION  },
     {   "blacklist",            byRef (&doBlackList),           Role::ADMIN,   NO_CONDITION     },
-    {   "book_offers",          byRef (&doBookOffers),          Role::USER,  NO_CONDITION  },
+    {   "book_offers",          byRef (&doBookOffers),          Role::USER,  NO_CONDITION, {}, PURE_FOR_LEDGER },
     {   "can_delete",           byRef (&doCanDelete),           Role::ADMIN,   NO_CONDITION     },
     {   "channel_authorize",    byRef (&doChannelAuthorize),    Role::USER,  NO_CONDITION  },
     {   "channel_verify",       byRef (&doChannelVerify),       Role::USER,  NO_CONDITION  },
     {   "connect",              byRef (&doConnect),             Role::ADMIN,   NO_CONDITION     },
     {   "consensus_info",       byRef (&doConsensusInfo),       Role::ADMIN,   NO_CONDITION     },
-    {   "gateway_balances",     byRef (&doGatewayBalances),     Role::USER,  NO_CONDITION  },
+    {   "gateway_balances",     byRef (&doGatewayBalances),     Role::USER,  NO_CONDITION, {}, PURE_FOR_LEDGER },
     {   "get_counts",           byRef (&doGetCounts),           Role::ADMIN,   NO_CONDITION     },
     {   "feature",              byRef (&doFeature),             Role::ADMIN,   NO_CONDITION     },
     {   "fee",                  byRef (&doFee),                 Role::USER,    NO_CONDITION     },
     {   "fetch_info",           byRef (&doFetchInfo),           Role::ADMIN,   NO_CONDITION     },
+    {   "job_trace",            byRef (&doJobTrace),            Role::ADMIN,   NO_CONDITION     },
     {   "ledger_accept",        byRef (&doLedgerAccept),        Role::ADMIN,   NEEDS_CURRENT_LEDGER  },
     {   "ledger_cleaner",       byRef (&doLedgerCleaner),       Role::ADMIN,   NEEDS_NETWORK_CONNECTION  },
     {   "ledger_closed",        byRef (&doLedgerClosed),        Role::USER,  NO_CONDITION   },
     {   "ledger_current",       byRef (&doLedgerCurrent),       Role::USER,  NEEDS_CURRENT_LEDGER  },
-    {   "ledger_data",          byRef (&doLedgerData),          Role::USER,  NO_CONDITION  },
-    {   "ledger_entry",         byRef (&doLedgerEntry),         Role::USER,  NO_CONDITION  },
-    {   "ledger_header",        byRef (&doLedgerHeader),        Role::USER,  NO_CONDITION  },
+    {   "ledger_data",          byRef (&doLedgerData),          Role::USER,  NO_CONDITION, {}, PURE_FOR_LEDGER },
+    {   "ledger_diff",          byRef (&doLedgerDiff),          Role::ADMIN,   NO_CONDITION     },
+    {   "ledger_entry",         byRef (&doLedgerEntry),         Role::USER,  NO_CONDITION, {}, PURE_FOR_LEDGER },
+    {   "ledger_header",        byRef (&doLedgerHeader),        Role::USER,  NO_CONDITION, {}, PURE_FOR_LEDGER },
     {   "ledger_request",       byRef (&doLedgerRequest),       Role::ADMIN,   NO_CONDITION     },
     {   "log_level",            byRef (&doLogLevel),            Role::ADMIN,   NO_CONDITION     },
     {   "logrotate",            byRef (&doLogRotate),           Role::ADMIN,   NO_CONDITION     },
@@ -145,9 +148,10 @@ Handler handlerArray[] {
     {   "submit_multisigned",   byRef (&doSubmitMultiSigned),   Role::USER,  NEEDS_CURRENT_LEDGER  },
     {   "server_info",          byRef (&doServerInfo),          Role::USER,  NO_CONDITION     },
     {   "server_state",         byRef (&doServerState),         Role::USER,  NO_CONDITION     },
+    {   "shards",               byRef (&doShards),              Role::ADMIN,   NO_CONDITION     },
     {   "stop",                 byRef (&doStop),                Role::ADMIN,   NO_CONDITION     },
-    {   "transaction_entry",    byRef (&doTransactionEntry),    Role::USER,  NO_CONDITION  },
-    {   "tx",                   byRef (&doTx),                  Role::USER,  NEEDS_NETWORK_CONNECTION  },
+    {   "transaction_entry",    byRef (&doTransactionEntry),    Role::USER,  NO_CONDITION, {}, PURE_FOR_LEDGER },
+    {   "tx",                   byRef (&doTx),                  Role::USER,  NEEDS_NETWORK_CONNECTION, {}, PURE_IF_VALIDATED },
     {   "tx_history",           byRef (&doTxHistory),           Role::USER,  NO_CONDITION     },
     {   "unl_add",              byRef (&doUnlAdd),              Role::ADMIN,   NO_CONDITION     },
     {   "unl_delete",           byRef (&doUnlDelete),           Role::ADMIN,   NO_CONDITION     },
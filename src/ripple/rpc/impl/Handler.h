@@ -39,6 +39,17 @@ enum Condition {
     NEEDS_CLOSED_LEDGER   = 4 + NEEDS_NETWORK_CONNECTION,
 };
 
+// May the result of this RPC be served from the response cache?
+enum Purity {
+    IMPURE            = 0,
+
+    // The result depends only on the request and the ledger it names.
+    PURE_FOR_LEDGER   = 1,
+
+    // The result never changes once it reports itself validated.
+    PURE_IF_VALIDATED = 2,
+};
+
 struct Handler
 {
     template <class JsonValue>
@@ -49,6 +60,7 @@ struct Handler
     Role role_;
     RPC::Condition condition_;
     Method<Json::Object> objectMethod_;
+    RPC::Purity purity_ = IMPURE;
 };
 
 const Handler* getHandler (std::string const&);
@@ -0,0 +1,295 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/rpc/impl/ResponseCache.h>
+#include <ripple/app/ledger/LedgerMaster.h>
+#include <ripple/json/to_string.h>
+#include <ripple/protocol/JsonFields.h>
+#include <ripple/rpc/Context.h>
+#include <ripple/rpc/Role.h>
+#include <ripple/rpc/impl/Handler.h>
+#include <algorithm>
+#include <functional>
+#include <iterator>
+
+namespace ripple {
+namespace RPC {
+
+namespace {
+
+// Returns the hash of the closed ledger a request names, or zero if it
+// names the open ledger or an unknown one. Mirrors lookupLedger, but runs
+// before the request is validated so anything unexpected yields zero.
+uint256
+requestedLedger (Context& context)
+{
+    Json::Value const& params = context.params;
+    auto& ledgerMaster = context.ledgerMaster;
+
+    auto indexValue = params[jss::ledger_index];
+    auto hashValue = params[jss::ledger_hash];
+
+    auto const& legacyLedger = params[jss::ledger];
+    if (legacyLedger)
+    {
+        if (legacyLedger.isString () && legacyLedger.asString ().size () > 12)
+            hashValue = legacyLedger;
+        else
+            indexValue = legacyLedger;
+    }
+
+    uint256 hash;
+    if (hashValue)
+    {
+        if (! hashValue.isString () || ! hash.SetHex (hashValue.asString ()))
+            hash.zero ();
+        return hash;
+    }
+
+    if (indexValue.isInt () || indexValue.isUInt ())
+    {
+        auto const valid = ledgerMaster.getValidLedgerIndex ();
+        if ((indexValue.isUInt () && indexValue.asUInt () <= valid) ||
+            (indexValue.isInt () && indexValue.asInt () > 0 &&
+                static_cast<LedgerIndex> (indexValue.asInt ()) <= valid))
+            hash = ledgerMaster.getHashBySeq (indexValue.asUInt ());
+        return hash;
+    }
+
+    if (! indexValue.isString ())
+        return hash;
+
+    std::shared_ptr<Ledger const> ledger;
+    auto const index = indexValue.asString ();
+    if (index == "validated")
+        ledger = ledgerMaster.getValidatedLedger ();
+    else if (index == "closed")
+        ledger = ledgerMaster.getClosedLedger ();
+
+    if (ledger)
+        hash = ledger->info().hash;
+    return hash;
+}
+
+// Returns the key for a pure command's result on a ledger, or an empty
+// string if the command's handler is not pure.
+std::string
+makeScopedKey (Context& context, std::string const& command,
+    char const* format, std::function <uint256 ()> const& ledger)
+{
+    auto const handler = getHandler (command);
+    if (! handler || handler->purity_ == IMPURE)
+        return {};
+
+    uint256 hash;
+    if (handler->purity_ == PURE_FOR_LEDGER)
+    {
+        hash = ledger ();
+        if (hash.isZero ())
+            return {};
+    }
+
+    // Some commands return more to unlimited callers
+    std::string scope = format;
+    if (isUnlimited (context.role))
+        scope += "/unlimited";
+
+    return ResponseCache::makeKey (scope, command, context.params, hash);
+}
+
+} // namespace
+
+//------------------------------------------------------------------------------
+
+ResponseCache::ResponseCache (Setup const& setup, Stopwatch& clock)
+    : setup_ (setup)
+    , clock_ (clock)
+{
+}
+
+std::string
+ResponseCache::makeKey (std::string const& format, std::string const& command,
+    Json::Value const& params, uint256 const& ledger)
+{
+    // The ledger is named by its hash instead
+    Json::Value canonical (params);
+    for (auto const& field : {jss::id, jss::jsonrpc, jss::ripplerpc,
+            jss::command, jss::method, jss::ledger, jss::ledger_hash,
+                jss::ledger_index})
+        canonical.removeMember (field.c_str ());
+
+    std::string key = format;
+    key += '\n';
+    key += command;
+    key += '\n';
+    key += to_string (ledger);
+    key += '\n';
+    key += Json::to_string (canonical);
+    return key;
+}
+
+bool
+ResponseCache::cacheable (Json::Value const& result)
+{
+    if (! result.isObject () || result.isMember (jss::error))
+        return false;
+
+    auto const& validated = result[jss::validated];
+    return validated.isBool () && validated.asBool ();
+}
+
+ResponseCache::Bytes
+ResponseCache::fetch (std::string const& key)
+{
+    std::lock_guard <std::mutex> lock (mutex_);
+
+    auto const iter = index_.find (key);
+    if (iter == index_.end ())
+    {
+        ++misses_;
+        return nullptr;
+    }
+
+    ++hits_;
+    entries_.splice (entries_.begin (), entries_, iter->second);
+    return iter->second->bytes;
+}
+
+void
+ResponseCache::insert (std::string const& key, Bytes bytes)
+{
+    Entry entry {key, std::move (bytes), clock_.now ()};
+    auto const size = footprint (entry);
+    if (size > setup_.maxBytes)
+        return;
+
+    std::lock_guard <std::mutex> lock (mutex_);
+
+    auto const iter = index_.find (key);
+    if (iter != index_.end ())
+        erase (iter->second);
+
+    entries_.push_front (std::move (entry));
+    index_.emplace (entries_.front ().key, entries_.begin ());
+    bytes_ += size;
+
+    while (bytes_ > setup_.maxBytes)
+        erase (std::prev (entries_.end ()));
+}
+
+void
+ResponseCache::sweep ()
+{
+    std::lock_guard <std::mutex> lock (mutex_);
+
+    auto const cutoff = clock_.now () - setup_.maxAge;
+    for (auto iter = entries_.begin (); iter != entries_.end ();)
+    {
+        auto const next = std::next (iter);
+        if (iter->stored <= cutoff)
+            erase (iter);
+        iter = next;
+    }
+}
+
+std::uint64_t
+ResponseCache::getHits () const
+{
+    std::lock_guard <std::mutex> lock (mutex_);
+    return hits_;
+}
+
+std::uint64_t
+ResponseCache::getMisses () const
+{
+    std::lock_guard <std::mutex> lock (mutex_);
+    return misses_;
+}
+
+float
+ResponseCache::getHitRate () const
+{
+    std::lock_guard <std::mutex> lock (mutex_);
+    auto const total = static_cast<float> (hits_ + misses_);
+    return hits_ * (100.0f / std::max (1.0f, total));
+}
+
+std::size_t
+ResponseCache::size () const
+{
+    std::lock_guard <std::mutex> lock (mutex_);
+    return entries_.size ();
+}
+
+std::size_t
+ResponseCache::bytes () const
+{
+    std::lock_guard <std::mutex> lock (mutex_);
+    return bytes_;
+}
+
+std::size_t
+ResponseCache::footprint (Entry const& entry)
+{
+    // The key is held by both the list and the index
+    return sizeof (Entry) + 2 * entry.key.size () + entry.bytes->size ();
+}
+
+void
+ResponseCache::erase (List::iterator iter)
+{
+    bytes_ -= footprint (*iter);
+    index_.erase (iter->key);
+    entries_.erase (iter);
+}
+
+//------------------------------------------------------------------------------
+
+std::string
+responseCacheKey (Context& context, std::string const& command,
+    char const* format)
+{
+    return makeScopedKey (context, command, format,
+        [&context]
+        {
+            return requestedLedger (context);
+        });
+}
+
+std::string
+responseCacheKey (Context& context, std::string const& command,
+    char const* format, Json::Value const& result)
+{
+    // The handler resolves ledger aliases again when it runs, which may be
+    // a different ledger than the request named when it arrived. Key the
+    // result on the ledger it actually describes.
+    return makeScopedKey (context, command, format,
+        [&result]
+        {
+            uint256 hash;
+            auto const& hashValue = result[jss::ledger_hash];
+            if (! hashValue.isString () || ! hash.SetHex (hashValue.asString ()))
+                hash.zero ();
+            return hash;
+        });
+}
+
+} // RPC
+} // ripple
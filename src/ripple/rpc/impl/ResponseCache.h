@@ -0,0 +1,164 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_RPC_RESPONSECACHE_H_INCLUDED
+#define RIPPLE_RPC_RESPONSECACHE_H_INCLUDED
+
+#include <ripple/basics/base_uint.h>
+#include <ripple/basics/chrono.h>
+#include <ripple/json/json_value.h>
+#include <ripple/rpc/impl/Tuning.h>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace ripple {
+namespace RPC {
+
+struct Context;
+
+/** Holds the serialized results of read-only commands.
+
+    Only commands whose handlers declare themselves pure are cached, and
+    only for validated ledgers. An entry is keyed on the command, its
+    other parameters and the hash of the ledger it names, so it cannot
+    go stale. Entries are dropped least recently used first to stay
+    within a memory budget, and expire a while after they are stored as
+    the ledgers they describe age.
+*/
+class ResponseCache
+{
+public:
+    using Bytes = std::shared_ptr <std::string const>;
+
+    struct Setup
+    {
+        /** Memory the entries may use, in bytes. */
+        std::size_t maxBytes = Tuning::responseCacheBytes;
+
+        /** Time an entry is kept after it is stored. */
+        std::chrono::seconds maxAge = Tuning::responseCacheAge;
+    };
+
+    ResponseCache (Setup const& setup, Stopwatch& clock);
+
+    ResponseCache (ResponseCache const&) = delete;
+    ResponseCache& operator= (ResponseCache const&) = delete;
+
+    /** Returns the key for a request on a particular ledger.
+        Parameters which do not affect the result, such as the request
+        id and the ledger selectors, are left out.
+        @param format Distinguishes ways of serializing the same result.
+        @param ledger The ledger's hash, or zero for results which are
+                      not tied to a ledger.
+    */
+    static
+    std::string
+    makeKey (std::string const& format, std::string const& command,
+        Json::Value const& params, uint256 const& ledger);
+
+    /** Returns `true` if a result may be stored.
+        Only successful results which report a validated ledger qualify.
+    */
+    static
+    bool
+    cacheable (Json::Value const& result);
+
+    /** Returns a stored result, or nullptr if there is none. */
+    Bytes
+    fetch (std::string const& key);
+
+    /** Store a result. */
+    void
+    insert (std::string const& key, Bytes bytes);
+
+    /** Remove entries older than the maximum age. */
+    void
+    sweep ();
+
+    std::uint64_t
+    getHits () const;
+
+    std::uint64_t
+    getMisses () const;
+
+    float
+    getHitRate () const;
+
+    /** Returns the number of entries. */
+    std::size_t
+    size () const;
+
+    /** Returns the memory used by the entries, in bytes. */
+    std::size_t
+    bytes () const;
+
+private:
+    struct Entry
+    {
+        std::string key;
+        Bytes bytes;
+        Stopwatch::time_point stored;
+    };
+
+    using List = std::list <Entry>;
+
+    static
+    std::size_t
+    footprint (Entry const& entry);
+
+    void
+    erase (List::iterator iter);
+
+    Setup const setup_;
+    Stopwatch& clock_;
+
+    mutable std::mutex mutex_;
+    List entries_;                  // most recently used first
+    std::unordered_map <std::string, List::iterator> index_;
+    std::size_t bytes_ = 0;
+    std::uint64_t hits_ = 0;
+    std::uint64_t misses_ = 0;
+};
+
+/** Returns the key the result of a request is cached under.
+    Returns an empty string if the command's handler is not pure, or the
+    request does not name a closed ledger. Use it to look results up.
+    @param format Distinguishes ways of serializing the same result.
+*/
+std::string
+responseCacheKey (Context& context, std::string const& command,
+    char const* format);
+
+/** Returns the key a result is stored under.
+    The ledger is taken from the hash the result reports, which may be
+    later than the one the request named when it arrived.
+*/
+std::string
+responseCacheKey (Context& context, std::string const& command,
+    char const* format, Json::Value const& result);
+
+} // RPC
+} // ripple
+
+#endif
@@ -19,10 +19,12 @@
 
 #include <BeastConfig.h>
 #include <ripple/app/main/Application.h>
+#include <ripple/app/misc/LoadFeeTrack.h>
 #include <ripple/app/misc/NetworkOPs.h>
 #include <ripple/beast/rfc2616.h>
 #include <ripple/beast/net/IPAddressConversion.h>
 #include <ripple/json/json_reader.h>
+#include <ripple/json/json_writer.h>
 #include <ripple/rpc/json_body.h>
 #include <ripple/rpc/ServerHandler.h>
 #include <ripple/server/Server.h>
@@ -37,6 +39,7 @@
 #include <ripple/overlay/Overlay.h>
 #include <ripple/resource/ResourceManager.h>
 #include <ripple/resource/Fees.h>
+#include <ripple/rpc/impl/ResponseCache.h>
 #include <ripple/rpc/impl/Tuning.h>
 #include <ripple/rpc/RPCHandler.h>
 #include <ripple/server/SimpleWriter.h>
@@ -130,11 +133,13 @@ ServerHandlerImp::ServerHandlerImp (Application& app, Stoppable& parent,
     , m_server (make_Server(
         *this, io_service, app_.journal("Server")))
     , m_jobQueue (jobQueue)
+    , admission_ (RPC::Admission::Setup {}, app_.journal ("RPC"))
 {
     auto const& group (cm.group ("rpc"));
     rpc_requests_ = group->make_counter ("requests");
     rpc_size_ = group->make_event ("size");
     rpc_time_ = group->make_event ("time");
+    rpc_refused_ = group->make_counter ("refused");
 }
 
 ServerHandlerImp::~ServerHandlerImp()
@@ -154,6 +159,8 @@ ServerHandlerImp::setup (Setup const& setup, beast::Journal journal)
 void
 ServerHandlerImp::onStop()
 {
+    // Release coroutines waiting to run so the JobQueue can stop
+    admission_.stop();
     m_server->close();
 }
 
@@ -297,6 +304,33 @@ buffers_to_string(ConstBufferSequence const& bs)
     return s;
 }
 
+// Serialize `reply` as to_string would, with `result` already
+// serialized in place of the "result" member.
+static
+std::string
+writeReply (Json::Value const& reply, std::string const& result)
+{
+    auto names = reply.getMemberNames ();
+    if (! reply.isMember (jss::result))
+        names.insert (std::upper_bound (names.begin (), names.end (),
+            std::string (jss::result)), jss::result);
+
+    std::string s = "{";
+    for (auto const& name : names)
+    {
+        if (s.size () > 1)
+            s += ',';
+        s += Json::valueToQuotedString (name.c_str ());
+        s += ':';
+        if (name == jss::result)
+            s += result;
+        else
+            s += to_string (reply[name]);
+    }
+    s += '}';
+    return s;
+}
+
 void
 ServerHandlerImp::onRequest (Session& session)
 {
@@ -363,9 +397,11 @@ ServerHandlerImp::onWSMessage(
         [this, session = std::move(session),
             jv = std::move(jv)](auto const& c)
         {
+            RPC::ResponseCache::Bytes cached;
             auto const jr =
-                this->processSession(session, c, jv);
-            auto const s = to_string(jr);
+                this->processSession(session, c, jv, cached);
+            auto const s = cached ?
+                writeReply(jr, *cached) : to_string(jr);
             auto const n = s.length();
             beast::streambuf sb(n);
             sb.commit(boost::asio::buffer_copy(
@@ -392,11 +428,33 @@ ServerHandlerImp::onStopped (Server&)
 
 //------------------------------------------------------------------------------
 
+// Run as a coroutine. Waits for the request's turn to run,
+// and returns `false` if the server is too busy to run it.
+bool
+ServerHandlerImp::admit (RPC::Admission::Ticket& ticket,
+    Resource::Consumer& usage, std::string const& command,
+        Json::Value const& params,
+            std::shared_ptr<JobQueue::Coro> const& coro)
+{
+    ticket = admission_.enter (usage.to_string(),
+        RPC::estimateCost (command, params),
+            app_.getFeeTrack().isLoadedLocal(),
+                std::bind (&JobQueue::Coro::post, coro));
+    if (ticket.waiting())
+        coro->yield();
+    if (ticket.admitted())
+        return true;
+
+    ++rpc_refused_;
+    usage.charge (Resource::feeReferenceRPC);
+    return false;
+}
+
 Json::Value
 ServerHandlerImp::processSession(
     std::shared_ptr<WSSession> const& session,
         std::shared_ptr<JobQueue::Coro> const& coro,
-            Json::Value const& jv)
+            Json::Value const& jv, RPC::ResponseCache::Bytes& cached)
 {
     auto is = std::static_pointer_cast<WSInfoSub> (session->appDefined);
     if (is->getConsumer().disconnect())
@@ -429,36 +487,66 @@ ServerHandlerImp::processSession(
     }
 
     Resource::Charge loadType = Resource::feeReferenceRPC;
-    auto required = RPC::roleRequired(jv.isMember(jss::command) ?
-                                      jv[jss::command].asString() :
-                                      jv[jss::method].asString());
+    auto const command = jv.isMember(jss::command) ?
+        jv[jss::command].asString() : jv[jss::method].asString();
+    auto required = RPC::roleRequired(command);
     auto role = requestRole(
         required,
         session->port(),
         jv,
         beast::IP::from_asio(session->remote_endpoint().address()),
         is->user());
+    RPC::Context context{
+        app_.journal("RPCHandler"),
+        jv,
+        app_,
+        loadType,
+        app_.getOPs(),
+        app_.getLedgerMaster(),
+        is->getConsumer(),
+        role,
+        coro,
+        is,
+        {is->user(), is->forwarded_for()}
+        };
+    auto& responses = app_.getResponseCache();
+    std::string cacheKey;
+    if (Role::FORBID != role)
+    {
+        cacheKey = RPC::responseCacheKey(context, command, "ws");
+        if (! cacheKey.empty())
+            cached = responses.fetch(cacheKey);
+    }
+
+    RPC::Admission::Ticket ticket;
     if (Role::FORBID == role)
     {
         loadType = Resource::feeInvalidRPC;
         jr[jss::result] = rpcError (rpcFORBIDDEN);
     }
+    else if (cached)
+    {
+        // Served from the cache; the caller writes it in place.
+        jr[jss::result] = Json::objectValue;
+    }
+    else if (! isUnlimited (role) &&
+        ! admit (ticket, is->getConsumer(), command, jv, coro))
+    {
+        jr[jss::result] = rpcError (rpcTOO_BUSY);
+    }
     else
     {
-        RPC::Context context{
-            app_.journal("RPCHandler"),
-            jv,
-            app_,
-            loadType,
-            app_.getOPs(),
-            app_.getLedgerMaster(),
-            is->getConsumer(),
-            role,
-            coro,
-            is,
-            {is->user(), is->forwarded_for()}
-            };
         RPC::doCommand(context, jr[jss::result]);
+        if (! cacheKey.empty() &&
+            RPC::ResponseCache::cacheable(jr[jss::result]))
+        {
+            auto const key = RPC::responseCacheKey(
+                context, command, "ws", jr[jss::result]);
+            if (! key.empty())
+                responses.insert(key,
+                    std::make_shared<std::string const>(
+                        to_string(jr[jss::result])));
+        }
     }
 
     is->getConsumer().charge(loadType);
@@ -669,36 +757,75 @@ ServerHandlerImp::processRequest (Port const& port,
     RPC::Context context {m_journal, params, app_, loadType, m_networkOPs,
         app_.getLedgerMaster(), usage, role, coro, InfoSub::pointer(),
         {user, forwardedFor}};
-    Json::Value result;
-    RPC::doCommand (context, result);
 
-    // Always report "status".  On an error report the request as received.
-    if (result.isMember (jss::error))
+    // A result already computed for the same query is served
+    // without waiting for admission.
+    auto& responses = app_.getResponseCache ();
+    auto const cacheKey =
+        RPC::responseCacheKey (context, strMethod, "http");
+    auto cached = cacheKey.empty () ?
+        RPC::ResponseCache::Bytes {} : responses.fetch (cacheKey);
+
+    RPC::Admission::Ticket ticket;
+    if (! cached && ! isUnlimited (role) &&
+        ! admit (ticket, usage, strMethod, params, coro))
     {
-        result[jss::status] = jss::error;
-        result[jss::request] = params;
-        JLOG (m_journal.debug())  <<
-            "rpcError: " << result [jss::error] <<
-            ": " << result [jss::error_message];
+        HTTPReply (503, "Server is overloaded", output, rpcJ);
+        return;
     }
-    else
+
+    Json::Value result;
+    if (! cached)
     {
-        result[jss::status]  = jss::success;
+        RPC::doCommand (context, result);
+
+        // Always report "status".  On an error report the request as received.
+        if (result.isMember (jss::error))
+        {
+            result[jss::status] = jss::error;
+            result[jss::request] = params;
+            JLOG (m_journal.debug())  <<
+                "rpcError: " << result [jss::error] <<
+                ": " << result [jss::error_message];
+        }
+        else
+        {
+            result[jss::status]  = jss::success;
+            if (! cacheKey.empty () &&
+                RPC::ResponseCache::cacheable (result))
+            {
+                auto const key = RPC::responseCacheKey (
+                    context, strMethod, "http", result);
+                if (! key.empty ())
+                    responses.insert (key,
+                        std::make_shared<std::string const> (
+                            to_string (result)));
+            }
+        }
     }
 
     usage.charge (loadType);
     if (usage.warn())
+    {
+        if (cached)
+        {
+            Json::Reader{}.parse (*cached, result);
+            cached.reset ();
+        }
         result[jss::warning] = jss::load;
+    }
 
     Json::Value reply (Json::objectValue);
-    reply[jss::result] = std::move (result);
+    if (! cached)
+        reply[jss::result] = std::move (result);
     if (jsonRPC.isMember(jss::jsonrpc))
         reply[jss::jsonrpc] = jsonRPC[jss::jsonrpc];
     if (jsonRPC.isMember(jss::ripplerpc))
         reply[jss::ripplerpc] = jsonRPC[jss::ripplerpc];
     if (jsonRPC.isMember(jss::id))
         reply[jss::id] = jsonRPC[jss::id];
-    auto response = to_string (reply);
+    auto response = cached ?
+        writeReply (reply, *cached) : to_string (reply);
 
     rpc_time_.notify (static_cast <beast::insight::Event::value_type> (
         std::chrono::duration_cast <std::chrono::milliseconds> (
@@ -21,6 +21,8 @@
 #define RIPPLE_RPC_SERVERHANDLERIMP_H_INCLUDED
 
 #include <ripple/core/JobQueue.h>
+#include <ripple/rpc/impl/Admission.h>
+#include <ripple/rpc/impl/ResponseCache.h>
 #include <ripple/rpc/impl/WSInfoSub.h>
 #include <ripple/server/Server.h>
 #include <ripple/server/Session.h>
@@ -87,8 +89,10 @@ private:
     beast::insight::Counter rpc_requests_;
     beast::insight::Event rpc_size_;
     beast::insight::Event rpc_time_;
+    beast::insight::Counter rpc_refused_;
     std::mutex countlock_;
     std::map<std::reference_wrapper<Port const>, int> count_;
+    RPC::Admission admission_;
 
 public:
     ServerHandlerImp (Application& app, Stoppable& parent,
@@ -153,7 +157,7 @@ private:
     processSession(
         std::shared_ptr<WSSession> const& session,
             std::shared_ptr<JobQueue::Coro> const& coro,
-                Json::Value const& jv);
+                Json::Value const& jv, RPC::ResponseCache::Bytes& cached);
 
     void
     processSession (std::shared_ptr<Session> const&,
@@ -165,6 +169,11 @@ private:
         std::shared_ptr<JobQueue::Coro> coro,
         std::string forwardedFor, std::string user);
 
+    bool
+    admit (RPC::Admission::Ticket& ticket, Resource::Consumer& usage,
+        std::string const& command, Json::Value const& params,
+            std::shared_ptr<JobQueue::Coro> const& coro);
+
     Handoff
     statusResponse(http_request_type const& request) const;
 
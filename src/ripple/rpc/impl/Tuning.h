@@ -20,6 +20,9 @@
 #ifndef RIPPLE_RPC_TUNING_H_INCLUDED
 #define RIPPLE_RPC_TUNING_H_INCLUDED
 
+#include <chrono>
+#include <cstddef>
+
 namespace ripple {
 namespace RPC {
 
@@ -59,6 +62,24 @@ using namespace std::chrono_literals;
 auto constexpr maxValidatedLedgerAge = 2min;
 static int const maxRequestSize = 1000000;
 
+/** Total estimated cost of the RPC requests allowed to run at once. */
+static int const admissionCapacity = 200;
+
+/** Total estimated cost of the RPC requests allowed to wait to run. */
+static int const admissionQueueLimit = 2000;
+
+/** Requests costing at least this much are refused first under load. */
+static int const heavyRequestCost = 50;
+
+/** Longest time a request may wait to run before it is refused. */
+auto constexpr maxAdmissionWait = 10s;
+
+/** Memory the RPC response cache may use, in bytes. */
+static std::size_t const responseCacheBytes = 64 * 1024 * 1024;
+
+/** Time a cached RPC response is kept after it is stored. */
+auto constexpr responseCacheAge = 5min;
+
 /** Maximum number of pages in one response from a binary LedgerData request. */
 static int const binaryPageLength = 2048;
 
@@ -33,6 +33,7 @@
 #include <ripple/nodestore/Database.h>
 #include <ripple/nodestore/NodeObject.h>
 #include <ripple/beast/utility/Journal.h>
+#include <boost/optional.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/shared_lock_guard.hpp>
 #include <boost/thread/shared_mutex.hpp>
@@ -101,10 +102,19 @@ public:
             {return !(x == y);}
     };
 
-    using DeltaItem = std::pair<std::shared_ptr<SHAMapItem const>,
-                                std::shared_ptr<SHAMapItem const>>;
+    using DeltaItem = std::pair<boost::intrusive_ptr<SHAMapItem const>,
+                                boost::intrusive_ptr<SHAMapItem const>>;
     using Delta     = std::map<uint256, DeltaItem>;
 
+    /** Receives one difference found by visitDelta.
+        The arguments are the key, the item in this map and the item in
+        the other map. The item is null on the side that lacks the key.
+        Return false to stop the walk.
+    */
+    using DeltaVisitor = std::function<bool (uint256 const&,
+        boost::intrusive_ptr<SHAMapItem const> const&,
+        boost::intrusive_ptr<SHAMapItem const> const&)>;
+
     ~SHAMap ();
     SHAMap(SHAMap const&) = delete;
     SHAMap& operator=(SHAMap const&) = delete;
@@ -157,21 +167,45 @@ public:
     // normal hash access functions
     bool hasItem (uint256 const& id) const;
     bool delItem (uint256 const& id);
-    bool addItem (SHAMapItem&& i, bool isTransaction, bool hasMeta);
     SHAMapHash getHash () const;
 
     // save a copy if you have a temporary anyway
-    bool updateGiveItem (std::shared_ptr<SHAMapItem const> const&,
+    bool updateGiveItem (boost::intrusive_ptr<SHAMapItem const> const&,
                          bool isTransaction, bool hasMeta);
-    bool addGiveItem (std::shared_ptr<SHAMapItem const> const&,
+    bool addGiveItem (boost::intrusive_ptr<SHAMapItem const> const&,
                       bool isTransaction, bool hasMeta);
 
+    using SortedItems = std::vector<boost::intrusive_ptr<SHAMapItem const>>;
+
+    /** Fill an empty map with items sorted by key.
+
+        The tree is built bottom-up in a single pass instead of
+        walking from the root for each item, and the subtrees below
+        the root are built and hashed in parallel. Only version 1 maps
+        are supported.
+
+        @return `false` if the keys are not strictly ascending, in
+                which case the map is unchanged.
+    */
+    bool addSortedItems (SortedItems const& items,
+                         bool isTransaction, bool hasMeta);
+
+    /** Fill an empty map with items sorted by key, and store it.
+
+        As above, but each node is also written to the NodeStore as
+        soon as its subtree is built, in batches, and the map is left
+        clean as though flushDirty had been called.
+    */
+    bool addSortedItems (SortedItems const& items,
+                         bool isTransaction, bool hasMeta,
+                         NodeObjectType t);
+
     // Save a copy if you need to extend the life
     // of the SHAMapItem beyond this SHAMap
-    std::shared_ptr<SHAMapItem const> const& peekItem (uint256 const& id) const;
-    std::shared_ptr<SHAMapItem const> const&
+    boost::intrusive_ptr<SHAMapItem const> const& peekItem (uint256 const& id) const;
+    boost::intrusive_ptr<SHAMapItem const> const&
         peekItem (uint256 const& id, SHAMapHash& hash) const;
-    std::shared_ptr<SHAMapItem const> const&
+    boost::intrusive_ptr<SHAMapItem const> const&
         peekItem (uint256 const& id, SHAMapTreeNode::TNType & type) const;
 
     // traverse functions
@@ -180,7 +214,7 @@ public:
     void visitNodes (std::function<bool (SHAMapAbstractNode&)> const&) const;
     void
         visitLeaves(
-            std::function<void(std::shared_ptr<SHAMapItem const> const&)> const&) const;
+            std::function<void(boost::intrusive_ptr<SHAMapItem const> const&)> const&) const;
 
     // comparison/sync functions
     std::vector<std::pair<SHAMapNodeID, uint256>>
@@ -188,6 +222,18 @@ public:
         std::size_t max,
         SHAMapSyncFilter *filter);
 
+    /** Find nodes that are part of this map but not available locally.
+        Each missing node is passed to `onMissing` as soon as it is found,
+        while reads for other branches are still in flight. Returning
+        `false` from `onMissing` ends the search early. At most `max`
+        nodes are reported.
+    */
+    void
+    getMissingNodes (
+        std::size_t max,
+        SHAMapSyncFilter *filter,
+        std::function<bool (SHAMapNodeID const&, uint256 const&)> const& onMissing);
+
     bool getNodeFat (SHAMapNodeID node,
         std::vector<SHAMapNodeID>& nodeIDs,
             std::vector<Blob>& rawNode,
@@ -212,6 +258,24 @@ public:
     bool compare (SHAMap const& otherMap,
                   Delta& differences, int maxCount) const;
 
+    /** Visit the items that differ between this map and `otherMap`.
+        Differences are passed to `func` in key order as they are found,
+        without a limit on how many there may be. Branches with matching
+        hashes are never fetched. If `after` is set, only keys greater
+        than it are visited, which lets a caller resume a walk.
+        @return false if `func` stopped the walk.
+        CAUTION: otherMap must be immutable.
+    */
+    bool visitDelta (SHAMap const& otherMap, DeltaVisitor const& func,
+        boost::optional<uint256> const& after = boost::none) const;
+
+    /** Like visitDelta, but each branch of the root is walked on its
+        own thread. `func` may be called concurrently and the order of
+        the differences is not defined. Both maps must be immutable.
+    */
+    bool visitDeltaParallel (SHAMap const& otherMap,
+        DeltaVisitor const& func) const;
+
     int flushDirty (NodeObjectType t, std::uint32_t seq);
     void walkMap (std::vector<SHAMapMissingNode>& missingNodes, int maxMissing) const;
     bool deepCompare (SHAMap & other) const;  // Intended for debug/test only
@@ -234,8 +298,8 @@ public:
 private:
     using SharedPtrNodeStack =
         std::stack<std::pair<std::shared_ptr<SHAMapAbstractNode>, SHAMapNodeID>>;
-    using DeltaRef = std::pair<std::shared_ptr<SHAMapItem const> const&,
-                               std::shared_ptr<SHAMapItem const> const&>;
+    using DeltaRef = std::pair<boost::intrusive_ptr<SHAMapItem const> const&,
+                               boost::intrusive_ptr<SHAMapItem const> const&>;
 
     void visitDifferences(SHAMap const* have, std::function<bool(SHAMapAbstractNode&)>) const;
 
@@ -245,6 +309,8 @@ private:
 
     // database operations
     std::shared_ptr<SHAMapAbstractNode> fetchNodeFromDB (SHAMapHash const& hash) const;
+    std::shared_ptr<SHAMapAbstractNode> finishFetch (SHAMapHash const& hash,
+        std::shared_ptr<NodeObject> const& obj) const;
     std::shared_ptr<SHAMapAbstractNode> fetchNodeNT (SHAMapHash const& hash) const;
     std::shared_ptr<SHAMapAbstractNode> fetchNodeNT (
         SHAMapHash const& hash,
@@ -253,6 +319,24 @@ private:
     std::shared_ptr<SHAMapAbstractNode> checkFilter(SHAMapHash const& hash,
         SHAMapSyncFilter* filter) const;
 
+    bool buildSorted (SortedItems const& items,
+                      SHAMapTreeNode::TNType type,
+                      boost::optional<NodeObjectType> store);
+
+    /** Build the subtree holding a run of sorted items.
+        If `batch` is set, the nodes are stored through it.
+    */
+    std::shared_ptr<SHAMapAbstractNode>
+        buildSubtree (SortedItems::const_iterator first,
+                      SortedItems::const_iterator last,
+                      SHAMapNodeID const& nodeID,
+                      SHAMapTreeNode::TNType type,
+                      NodeStore::Batch* batch, NodeObjectType t) const;
+
+    /** Make a newly built node shareable and add it to a batch */
+    void storeBuilt (std::shared_ptr<SHAMapAbstractNode>& node,
+                     NodeStore::Batch& batch, NodeObjectType t) const;
+
     /** Update hashes up to the root */
     void dirtyUp (SharedPtrNodeStack& stack,
                   uint256 const& target, std::shared_ptr<SHAMapAbstractNode> terminal);
@@ -291,8 +375,10 @@ private:
     std::shared_ptr<SHAMapAbstractNode> descendThrow (std::shared_ptr<SHAMapInnerNode> const&, int branch) const;
 
     // Descend with filter
+    // If a read is posted, pending is set and callback is invoked when it completes
     SHAMapAbstractNode* descendAsync (SHAMapInnerNode* parent, int branch,
-        SHAMapSyncFilter* filter, bool& pending) const;
+        SHAMapSyncFilter* filter, bool& pending,
+        NodeStore::Database::ReadCallback&& callback) const;
 
     std::pair <SHAMapAbstractNode*, SHAMapNodeID>
         descend (SHAMapInnerNode* parent, SHAMapNodeID const& parentID,
@@ -304,7 +390,13 @@ private:
         descendNoStore (std::shared_ptr<SHAMapInnerNode> const&, int branch) const;
 
     /** If there is only one leaf below this node, get its contents */
-    std::shared_ptr<SHAMapItem const> const& onlyBelow (SHAMapAbstractNode*) const;
+    boost::intrusive_ptr<SHAMapItem const> const& onlyBelow (SHAMapAbstractNode*) const;
+
+    // getMissingNodes helpers
+    class MissingNodes;
+    void gmn_ProcessNodes (MissingNodes&, SHAMapInnerNode* node,
+        SHAMapNodeID nodeID);
+    void gmn_ProcessDeferredReads (MissingNodes&, bool wait);
 
     bool hasInnerNode (SHAMapNodeID const& nodeID, SHAMapHash const& hash) const;
     bool hasLeafNode (uint256 const& tag, SHAMapHash const& hash) const;
@@ -312,8 +404,16 @@ private:
     SHAMapTreeNode const* peekFirstItem(SharedPtrNodeStack& stack) const;
     SHAMapTreeNode const* peekNextItem(uint256 const& id, SharedPtrNodeStack& stack) const;
     bool walkBranch (SHAMapAbstractNode* node,
-                     std::shared_ptr<SHAMapItem const> const& otherMapItem,
+                     boost::intrusive_ptr<SHAMapItem const> const& otherMapItem,
                      bool isFirstMap, Delta & differences, int & maxCount) const;
+    bool walkDeltaBranch (SHAMapAbstractNode* node,
+                          boost::intrusive_ptr<SHAMapItem const> otherMapItem,
+                          bool isFirstMap, uint256 const* after,
+                          DeltaVisitor const& func) const;
+    bool walkDelta (SHAMap const& otherMap,
+                    SHAMapAbstractNode* ours, SHAMapAbstractNode* other,
+                    SHAMapNodeID const& nodeID, uint256 const* after,
+                    DeltaVisitor const& func) const;
     int walkSubTree (bool doWrite, NodeObjectType t, std::uint32_t seq);
     bool isInconsistentNode(std::shared_ptr<SHAMapAbstractNode> const& node) const;
 };
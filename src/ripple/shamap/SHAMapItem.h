@@ -21,58 +21,94 @@
 #define RIPPLE_SHAMAP_SHAMAPITEM_H_INCLUDED
 
 #include <ripple/basics/base_uint.h>
-#include <ripple/basics/Blob.h>
 #include <ripple/basics/Slice.h>
-#include <ripple/protocol/Serializer.h>
-#include <ripple/beast/utility/Journal.h>
-
+#include <boost/intrusive_ptr.hpp>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 
 namespace ripple {
 
 // an item stored in a SHAMap
+//
+// The key, the reference count and the payload share one block from a
+// pool of size classes. Items are immutable once made, and are handled
+// through boost::intrusive_ptr<SHAMapItem const>; see make_shamapitem.
 class SHAMapItem
 {
 private:
-    uint256    tag_;
-    Blob       data_;
+    uint256 const tag_;
+    std::uint32_t const size_;
+    mutable std::atomic<std::uint32_t> refcount_ {1};
+
+    // The payload is stored directly after the item
+    SHAMapItem (uint256 const& tag, Slice data);
+
+    void destroy () const;
+
+    friend
+    boost::intrusive_ptr<SHAMapItem const>
+    make_shamapitem (uint256 const& tag, Slice data);
+
+    friend void intrusive_ptr_add_ref (SHAMapItem const* item);
+    friend void intrusive_ptr_release (SHAMapItem const* item);
 
 public:
-    SHAMapItem (uint256 const& tag, Blob const & data);
-    SHAMapItem (uint256 const& tag, Serializer const& s);
-    SHAMapItem (uint256 const& tag, Serializer&& s);
+    SHAMapItem (SHAMapItem const&) = delete;
+    SHAMapItem& operator= (SHAMapItem const&) = delete;
 
     Slice slice() const;
 
     uint256 const& key() const;
 
-    Blob const& peekData() const;
-
     std::size_t size() const;
     void const* data() const;
 };
 
+/** Create an item holding a copy of `data`. */
+boost::intrusive_ptr<SHAMapItem const>
+make_shamapitem (uint256 const& tag, Slice data);
+
+/** The number of bytes reserved by the item pool. */
+std::size_t
+getSHAMapItemPoolSize ();
+
 //------------------------------------------------------------------------------
 
+inline
+void
+intrusive_ptr_add_ref (SHAMapItem const* item)
+{
+    item->refcount_.fetch_add (1, std::memory_order_relaxed);
+}
+
+inline
+void
+intrusive_ptr_release (SHAMapItem const* item)
+{
+    if (item->refcount_.fetch_sub (1, std::memory_order_acq_rel) == 1)
+        item->destroy ();
+}
+
 inline
 Slice
 SHAMapItem::slice() const
 {
-    return {data_.data(), data_.size()};
+    return {data(), size_};
 }
 
 inline
 std::size_t
 SHAMapItem::size() const
 {
-    return data_.size();
+    return size_;
 }
 
 inline
 void const*
 SHAMapItem::data() const
 {
-    return data_.data();
+    return this + 1;
 }
 
 inline
@@ -82,13 +118,6 @@ SHAMapItem::key() const
     return tag_;
 }
 
-inline
-Blob const&
-SHAMapItem::peekData() const
-{
-    return data_;
-}
-
 } // ripple
 
 #endif
@@ -22,6 +22,7 @@
 
 #include <ripple/shamap/SHAMapItem.h>
 #include <ripple/shamap/SHAMapNodeID.h>
+#include <ripple/protocol/Serializer.h>
 #include <ripple/basics/TaggedCache.h>
 #include <ripple/beast/utility/Journal.h>
 
@@ -228,15 +229,15 @@ class SHAMapTreeNode
     : public SHAMapAbstractNode
 {
 private:
-    std::shared_ptr<SHAMapItem const> mItem;
+    boost::intrusive_ptr<SHAMapItem const> mItem;
 
 public:
     SHAMapTreeNode (const SHAMapTreeNode&) = delete;
     SHAMapTreeNode& operator= (const SHAMapTreeNode&) = delete;
 
-    SHAMapTreeNode (std::shared_ptr<SHAMapItem const> const& item,
+    SHAMapTreeNode (boost::intrusive_ptr<SHAMapItem const> const& item,
                     TNType type, std::uint32_t seq);
-    SHAMapTreeNode(std::shared_ptr<SHAMapItem const> const& item, TNType type,
+    SHAMapTreeNode(boost::intrusive_ptr<SHAMapItem const> const& item, TNType type,
                    std::uint32_t seq, SHAMapHash const& hash);
     std::shared_ptr<SHAMapAbstractNode> clone(std::uint32_t seq) const override;
 
@@ -251,8 +252,8 @@ public:  // public only to SHAMap
 
     // item node function
     bool hasItem () const;
-    std::shared_ptr<SHAMapItem const> const& peekItem () const;
-    bool setItem (std::shared_ptr<SHAMapItem const> const& i, TNType type);
+    boost::intrusive_ptr<SHAMapItem const> const& peekItem () const;
+    bool setItem (boost::intrusive_ptr<SHAMapItem const> const& i, TNType type);
 
     std::string getString (SHAMapNodeID const&) const override;
     bool updateHash () override;
@@ -417,7 +418,7 @@ SHAMapTreeNode::hasItem () const
 }
 
 inline
-std::shared_ptr<SHAMapItem const> const&
+boost::intrusive_ptr<SHAMapItem const> const&
 SHAMapTreeNode::peekItem () const
 {
     return mItem;
@@ -20,6 +20,8 @@
 #include <BeastConfig.h>
 #include <ripple/basics/contract.h>
 #include <ripple/shamap/SHAMap.h>
+#include <array>
+#include <future>
 
 namespace ripple {
 
@@ -242,54 +244,61 @@ SHAMap::findKey(uint256 const& id) const
 
 std::shared_ptr<SHAMapAbstractNode>
 SHAMap::fetchNodeFromDB (SHAMapHash const& hash) const
+{
+    if (! backed_)
+        return {};
+
+    return finishFetch (hash, f_.db().fetch (hash.as_uint256()));
+}
+
+// Decode a node read from the database, or note that it was missing
+std::shared_ptr<SHAMapAbstractNode>
+SHAMap::finishFetch (SHAMapHash const& hash,
+    std::shared_ptr<NodeObject> const& obj) const
 {
     std::shared_ptr<SHAMapAbstractNode> node;
 
-    if (backed_)
+    if (obj)
     {
-        std::shared_ptr<NodeObject> obj = f_.db().fetch (hash.as_uint256());
-        if (obj)
+        try
         {
-            try
+            node = SHAMapAbstractNode::make(makeSlice(obj->getData()),
+                0, snfPREFIX, hash, true, f_.journal());
+            if (node && node->isInner())
             {
-                node = SHAMapAbstractNode::make(makeSlice(obj->getData()),
-                    0, snfPREFIX, hash, true, f_.journal());
-                if (node && node->isInner())
+                bool isv2 = std::dynamic_pointer_cast<SHAMapInnerNodeV2>(node) != nullptr;
+                if (isv2 != is_v2())
                 {
-                    bool isv2 = std::dynamic_pointer_cast<SHAMapInnerNodeV2>(node) != nullptr;
-                    if (isv2 != is_v2())
+                    auto root =  std::dynamic_pointer_cast<SHAMapInnerNode>(root_);
+                    assert(root);
+                    assert(root->isEmpty());
+                    if (isv2)
                     {
-                        auto root =  std::dynamic_pointer_cast<SHAMapInnerNode>(root_);
-                        assert(root);
-                        assert(root->isEmpty());
-                        if (isv2)
-                        {
-                            auto temp = make_v2();
-                            swap(temp->root_, const_cast<std::shared_ptr<SHAMapAbstractNode>&>(root_));
-                        }
-                        else
-                        {
-                            auto temp = make_v1();
-                            swap(temp->root_, const_cast<std::shared_ptr<SHAMapAbstractNode>&>(root_));
-                        }
+                        auto temp = make_v2();
+                        swap(temp->root_, const_cast<std::shared_ptr<SHAMapAbstractNode>&>(root_));
+                    }
+                    else
+                    {
+                        auto temp = make_v1();
+                        swap(temp->root_, const_cast<std::shared_ptr<SHAMapAbstractNode>&>(root_));
                     }
                 }
-                if (node)
-                    canonicalize (hash, node);
-            }
-            catch (std::exception const&)
-            {
-                JLOG(journal_.warn()) <<
-                    "Invalid DB node " << hash;
-                return std::shared_ptr<SHAMapTreeNode> ();
             }
+            if (node)
+                canonicalize (hash, node);
         }
-        else if (ledgerSeq_ != 0)
+        catch (std::exception const&)
         {
-            f_.missing_node(ledgerSeq_);
-            const_cast<std::uint32_t&>(ledgerSeq_) = 0;
+            JLOG(journal_.warn()) <<
+                "Invalid DB node " << hash;
+            return std::shared_ptr<SHAMapTreeNode> ();
         }
     }
+    else if (ledgerSeq_ != 0)
+    {
+        f_.missing_node(ledgerSeq_);
+        const_cast<std::uint32_t&>(ledgerSeq_) = 0;
+    }
 
     return node;
 }
@@ -463,7 +472,8 @@ SHAMap::descend (SHAMapInnerNode * parent, SHAMapNodeID const& parentID,
 
 SHAMapAbstractNode*
 SHAMap::descendAsync (SHAMapInnerNode* parent, int branch,
-    SHAMapSyncFilter * filter, bool & pending) const
+    SHAMapSyncFilter * filter, bool & pending,
+    NodeStore::Database::ReadCallback&& callback) const
 {
     pending = false;
 
@@ -482,7 +492,8 @@ SHAMap::descendAsync (SHAMapInnerNode* parent, int branch,
         if (!ptr && backed_)
         {
             std::shared_ptr<NodeObject> obj;
-            if (! f_.db().asyncFetch (hash.as_uint256(), obj))
+            if (! f_.db().asyncFetch (hash.as_uint256(), obj,
+                std::move (callback)))
             {
                 pending = true;
                 return nullptr;
@@ -490,10 +501,7 @@ SHAMap::descendAsync (SHAMapInnerNode* parent, int branch,
             if (!obj)
                 return nullptr;
 
-            ptr = SHAMapAbstractNode::make(makeSlice(obj->getData()), 0, snfPREFIX,
-                                           hash, true, f_.journal());
-            if (ptr && backed_)
-                canonicalize (hash, ptr);
+            ptr = finishFetch (hash, obj);
         }
     }
 
@@ -581,9 +589,9 @@ SHAMap::firstBelow(std::shared_ptr<SHAMapAbstractNode> node,
     return nullptr;
 }
 
-static const std::shared_ptr<SHAMapItem const> no_item;
+static const boost::intrusive_ptr<SHAMapItem const> no_item;
 
-std::shared_ptr<SHAMapItem const> const&
+boost::intrusive_ptr<SHAMapItem const> const&
 SHAMap::onlyBelow (SHAMapAbstractNode* node) const
 {
     // If there is only one item below this node, return it
@@ -620,7 +628,7 @@ SHAMap::onlyBelow (SHAMapAbstractNode* node) const
     return leaf->peekItem ();
 }
 
-static std::shared_ptr<
+static boost::intrusive_ptr<
     SHAMapItem const> const nullConstSHAMapItem;
 
 SHAMapTreeNode const*
@@ -667,7 +675,7 @@ SHAMap::peekNextItem(uint256 const& id, SharedPtrNodeStack& stack) const
     return nullptr;
 }
 
-std::shared_ptr<SHAMapItem const> const&
+boost::intrusive_ptr<SHAMapItem const> const&
 SHAMap::peekItem (uint256 const& id) const
 {
     SHAMapTreeNode* leaf = findKey(id);
@@ -678,7 +686,7 @@ SHAMap::peekItem (uint256 const& id) const
     return leaf->peekItem ();
 }
 
-std::shared_ptr<SHAMapItem const> const&
+boost::intrusive_ptr<SHAMapItem const> const&
 SHAMap::peekItem (uint256 const& id, SHAMapTreeNode::TNType& type) const
 {
     SHAMapTreeNode* leaf = findKey(id);
@@ -690,7 +698,7 @@ SHAMap::peekItem (uint256 const& id, SHAMapTreeNode::TNType& type) const
     return leaf->peekItem ();
 }
 
-std::shared_ptr<SHAMapItem const> const&
+boost::intrusive_ptr<SHAMapItem const> const&
 SHAMap::peekItem (uint256 const& id, SHAMapHash& hash) const
 {
     SHAMapTreeNode* leaf = findKey(id);
@@ -877,7 +885,7 @@ prefix(unsigned depth, uint256 const& key)
 }
 
 bool
-SHAMap::addGiveItem (std::shared_ptr<SHAMapItem const> const& item,
+SHAMap::addGiveItem (boost::intrusive_ptr<SHAMapItem const> const& item,
                      bool isTransaction, bool hasMeta)
 {
     // add the specified item, does not update
@@ -965,7 +973,7 @@ SHAMap::addGiveItem (std::shared_ptr<SHAMapItem const> const& item,
         {
             // this is a leaf node that has to be made an inner node holding two items
             auto leaf = std::static_pointer_cast<SHAMapTreeNode>(node);
-            std::shared_ptr<SHAMapItem const> otherItem = leaf->peekItem ();
+            boost::intrusive_ptr<SHAMapItem const> otherItem = leaf->peekItem ();
             assert (otherItem && (tag != otherItem->key()));
 
             node = std::make_shared<SHAMapInnerNode>(node->getSeq());
@@ -1001,11 +1009,170 @@ SHAMap::addGiveItem (std::shared_ptr<SHAMapItem const> const& item,
     return true;
 }
 
+void
+SHAMap::storeBuilt (std::shared_ptr<SHAMapAbstractNode>& node,
+    NodeStore::Batch& batch, NodeObjectType t) const
+{
+    node->setSeq (0);
+    canonicalize (node->getNodeHash (), node);
+
+    Serializer s;
+    node->addRaw (s, snfPREFIX);
+    batch.push_back (NodeObject::createObject (t,
+        std::move (s.modData ()), node->getNodeHash ().as_uint256 ()));
+
+    if (batch.size () >= NodeStore::batchWritePreallocationSize)
+    {
+        f_.db ().storeBatch (batch);
+        batch.clear ();
+    }
+}
+
+std::shared_ptr<SHAMapAbstractNode>
+SHAMap::buildSubtree (SortedItems::const_iterator first,
+    SortedItems::const_iterator last, SHAMapNodeID const& nodeID,
+        SHAMapTreeNode::TNType type, NodeStore::Batch* batch,
+            NodeObjectType t) const
+{
+    assert (first != last);
+
+    std::shared_ptr<SHAMapAbstractNode> node;
+
+    if (std::next (first) == last)
+    {
+        node = std::make_shared<SHAMapTreeNode> (*first, type, seq_);
+    }
+    else
+    {
+        auto inner = std::make_shared<SHAMapInnerNode> (seq_);
+
+        // Items in the same branch are adjacent, since the keys are sorted
+        while (first != last)
+        {
+            int const branch = nodeID.selectBranch ((*first)->key ());
+            auto end = std::next (first);
+            while (end != last && nodeID.selectBranch ((*end)->key ()) == branch)
+                ++end;
+
+            inner->setChild (branch, buildSubtree (
+                first, end, nodeID.getChildNodeID (branch), type, batch, t));
+            first = end;
+        }
+
+        inner->updateHashDeep ();
+        node = std::move (inner);
+    }
+
+    if (batch)
+        storeBuilt (node, *batch, t);
+
+    return node;
+}
+
+bool
+SHAMap::addSortedItems (SortedItems const& items,
+    bool isTransaction, bool hasMeta)
+{
+    SHAMapTreeNode::TNType type = !isTransaction ? SHAMapTreeNode::tnACCOUNT_STATE :
+        (hasMeta ? SHAMapTreeNode::tnTRANSACTION_MD : SHAMapTreeNode::tnTRANSACTION_NM);
+
+    return buildSorted (items, type, boost::none);
+}
+
 bool
-SHAMap::addItem(SHAMapItem&& i, bool isTransaction, bool hasMetaData)
+SHAMap::addSortedItems (SortedItems const& items,
+    bool isTransaction, bool hasMeta, NodeObjectType t)
 {
-    return addGiveItem(std::make_shared<SHAMapItem const>(std::move(i)),
-                                                          isTransaction, hasMetaData);
+    SHAMapTreeNode::TNType type = !isTransaction ? SHAMapTreeNode::tnACCOUNT_STATE :
+        (hasMeta ? SHAMapTreeNode::tnTRANSACTION_MD : SHAMapTreeNode::tnTRANSACTION_NM);
+
+    return buildSorted (items, type,
+        backed_ ? boost::optional<NodeObjectType>(t) : boost::none);
+}
+
+bool
+SHAMap::buildSorted (SortedItems const& items,
+    SHAMapTreeNode::TNType type, boost::optional<NodeObjectType> store)
+{
+    assert (state_ != SHAMapState::Immutable);
+
+    if (is_v2 ())
+        LogicError ("SHAMap::addSortedItems: v2 maps are not supported");
+
+    if (!std::static_pointer_cast<SHAMapInnerNode>(root_)->isEmpty ())
+        LogicError ("SHAMap::addSortedItems: map is not empty");
+
+    for (std::size_t i = 1; i < items.size (); ++i)
+        if (! (items[i - 1]->key () < items[i]->key ()))
+            return false;
+
+    if (items.empty ())
+        return true;
+
+    auto const t = store ? *store : hotUNKNOWN;
+    auto root = std::make_shared<SHAMapInnerNode> (seq_);
+    SHAMapNodeID const rootID;
+
+    // Split the items by their branch below the root
+    std::array<std::pair<SortedItems::const_iterator,
+        SortedItems::const_iterator>, 16> ranges;
+    for (auto& r : ranges)
+        r = {items.end (), items.end ()};
+    for (auto first = items.begin (); first != items.end ();)
+    {
+        int const branch = rootID.selectBranch ((*first)->key ());
+        auto end = std::next (first);
+        while (end != items.end () &&
+                rootID.selectBranch ((*end)->key ()) == branch)
+            ++end;
+        ranges[branch] = {first, end};
+        first = end;
+    }
+
+    // Small maps aren't worth the threads
+    bool const parallel = items.size () >= 4096;
+
+    // Each subtree stores through a batch of its own
+    std::array<NodeStore::Batch, 16> batches;
+    std::array<std::future<std::shared_ptr<SHAMapAbstractNode>>, 16> subtrees;
+    for (int i = 0; i < 16; ++i)
+    {
+        if (ranges[i].first == ranges[i].second)
+            continue;
+
+        auto const batch = store ? &batches[i] : nullptr;
+        if (batch)
+            batch->reserve (NodeStore::batchWritePreallocationSize);
+
+        subtrees[i] = std::async (
+            parallel ? std::launch::async : std::launch::deferred,
+            [this, &ranges, &rootID, i, type, batch, t]()
+            {
+                auto node = buildSubtree (ranges[i].first, ranges[i].second,
+                    rootID.getChildNodeID (i), type, batch, t);
+                if (batch && ! batch->empty ())
+                    f_.db ().storeBatch (*batch);
+                return node;
+            });
+    }
+
+    for (int i = 0; i < 16; ++i)
+        if (subtrees[i].valid ())
+            root->setChild (i, subtrees[i].get ());
+
+    root->updateHashDeep ();
+
+    std::shared_ptr<SHAMapAbstractNode> node = std::move (root);
+    if (store)
+    {
+        NodeStore::Batch batch;
+        storeBuilt (node, batch, t);
+        if (! batch.empty ())
+            f_.db ().storeBatch (batch);
+    }
+
+    root_ = std::move (node);
+    return true;
 }
 
 SHAMapHash
@@ -1021,7 +1188,7 @@ SHAMap::getHash () const
 }
 
 bool
-SHAMap::updateGiveItem (std::shared_ptr<SHAMapItem const> const& item,
+SHAMap::updateGiveItem (boost::intrusive_ptr<SHAMapItem const> const& item,
                         bool isTransaction, bool hasMeta)
 {
     // can't change the tag but can change the hash
@@ -20,6 +20,9 @@
 #include <BeastConfig.h>
 #include <ripple/basics/contract.h>
 #include <ripple/shamap/SHAMap.h>
+#include <array>
+#include <atomic>
+#include <future>
 
 namespace ripple {
 
@@ -32,7 +35,7 @@ namespace ripple {
 // synchronizing matching branches too.)
 
 bool SHAMap::walkBranch (SHAMapAbstractNode* node,
-                         std::shared_ptr<SHAMapItem const> const& otherMapItem,
+                         boost::intrusive_ptr<SHAMapItem const> const& otherMapItem,
                          bool isFirstMap,Delta& differences, int& maxCount) const
 {
     // Walk a branch of a SHAMap that's matched by an empty branch or single item in the other map
@@ -64,15 +67,15 @@ bool SHAMap::walkBranch (SHAMapAbstractNode* node,
                 // unmatched
                 if (isFirstMap)
                     differences.insert (std::make_pair (item->key(),
-                        DeltaRef (item, std::shared_ptr<SHAMapItem const> ())));
+                        DeltaRef (item, boost::intrusive_ptr<SHAMapItem const> ())));
                 else
                     differences.insert (std::make_pair (item->key(),
-                        DeltaRef (std::shared_ptr<SHAMapItem const> (), item)));
+                        DeltaRef (boost::intrusive_ptr<SHAMapItem const> (), item)));
 
                 if (--maxCount <= 0)
                     return false;
             }
-            else if (item->peekData () != otherMapItem->peekData ())
+            else if (item->slice () != otherMapItem->slice ())
             {
                 // non-matching items with same tag
                 if (isFirstMap)
@@ -100,11 +103,11 @@ bool SHAMap::walkBranch (SHAMapAbstractNode* node,
         // otherMapItem was unmatched, must add
         if (isFirstMap) // this is first map, so other item is from second
             differences.insert(std::make_pair(otherMapItem->key(),
-                                              DeltaRef(std::shared_ptr<SHAMapItem const>(),
+                                              DeltaRef(boost::intrusive_ptr<SHAMapItem const>(),
                                                        otherMapItem)));
         else
             differences.insert(std::make_pair(otherMapItem->key(),
-                DeltaRef(otherMapItem, std::shared_ptr<SHAMapItem const>())));
+                DeltaRef(otherMapItem, boost::intrusive_ptr<SHAMapItem const>())));
 
         if (--maxCount <= 0)
             return false;
@@ -150,7 +153,7 @@ SHAMap::compare (SHAMap const& otherMap,
             auto other = static_cast<SHAMapTreeNode*>(otherNode);
             if (ours->peekItem()->key() == other->peekItem()->key())
             {
-                if (ours->peekItem()->peekData () != other->peekItem()->peekData ())
+                if (ours->peekItem()->slice () != other->peekItem()->slice ())
                 {
                     differences.insert (std::make_pair (ours->peekItem()->key(),
                                                  DeltaRef (ours->peekItem (),
@@ -163,12 +166,12 @@ SHAMap::compare (SHAMap const& otherMap,
             {
                 differences.insert (std::make_pair(ours->peekItem()->key(),
                                                    DeltaRef(ours->peekItem(),
-                                                   std::shared_ptr<SHAMapItem const>())));
+                                                   boost::intrusive_ptr<SHAMapItem const>())));
                 if (--maxCount <= 0)
                     return false;
 
                 differences.insert(std::make_pair(other->peekItem()->key(),
-                    DeltaRef(std::shared_ptr<SHAMapItem const>(), other->peekItem ())));
+                    DeltaRef(boost::intrusive_ptr<SHAMapItem const>(), other->peekItem ())));
                 if (--maxCount <= 0)
                     return false;
             }
@@ -201,7 +204,7 @@ SHAMap::compare (SHAMap const& otherMap,
                         // We have a branch, the other tree does not
                         SHAMapAbstractNode* iNode = descendThrow (ours, i);
                         if (!walkBranch (iNode,
-                                         std::shared_ptr<SHAMapItem const> (), true,
+                                         boost::intrusive_ptr<SHAMapItem const> (), true,
                                          differences, maxCount))
                             return false;
                     }
@@ -211,7 +214,7 @@ SHAMap::compare (SHAMap const& otherMap,
                         SHAMapAbstractNode* iNode =
                             otherMap.descendThrow(other, i);
                         if (!otherMap.walkBranch (iNode,
-                                                   std::shared_ptr<SHAMapItem const>(),
+                                                   boost::intrusive_ptr<SHAMapItem const>(),
                                                    false, differences, maxCount))
                             return false;
                     }
@@ -227,6 +230,230 @@ SHAMap::compare (SHAMap const& otherMap,
     return true;
 }
 
+// The delta walk below visits the same differences as compare, but
+// hands them to a callback in key order instead of collecting them, so
+// there is no need for a cap. The walk descends both trees together,
+// and a branch is only fetched when its hash differs from the matching
+// branch of the other tree. An empty branch is treated as an inner node
+// with no children, so a one-sided subtree is still walked in order.
+
+bool
+SHAMap::walkDeltaBranch (SHAMapAbstractNode* node,
+    boost::intrusive_ptr<SHAMapItem const> otherMapItem, bool isFirstMap,
+    uint256 const* after, DeltaVisitor const& func) const
+{
+    // Walk a branch that's matched by an empty branch or a single item
+    // in the other map, merging that item into the walk by key.
+    static boost::intrusive_ptr<SHAMapItem const> const none;
+
+    auto emit = [&](boost::intrusive_ptr<SHAMapItem const> const& mine,
+        boost::intrusive_ptr<SHAMapItem const> const& theirs)
+    {
+        auto const& key = mine ? mine->key () : theirs->key ();
+        return isFirstMap ? func (key, mine, theirs) : func (key, theirs, mine);
+    };
+
+    if (otherMapItem && after && (otherMapItem->key () <= *after))
+        otherMapItem.reset ();
+
+    std::stack <SHAMapAbstractNode*, std::vector<SHAMapAbstractNode*>> nodeStack;
+    nodeStack.push (node);
+
+    while (!nodeStack.empty ())
+    {
+        node = nodeStack.top ();
+        nodeStack.pop ();
+
+        if (node->isInner ())
+        {
+            // Push in reverse so that branches come off the stack in order
+            auto inner = static_cast<SHAMapInnerNode*>(node);
+            for (int i = 15; i >= 0; --i)
+                if (!inner->isEmptyBranch (i))
+                    nodeStack.push (descendThrow (inner, i));
+            continue;
+        }
+
+        auto const& item = static_cast<SHAMapTreeNode*>(node)->peekItem ();
+        if (after && (item->key () <= *after))
+            continue;
+
+        if (otherMapItem && (otherMapItem->key () < item->key ()))
+        {
+            if (!emit (none, otherMapItem))
+                return false;
+            otherMapItem.reset ();
+        }
+
+        if (otherMapItem && (otherMapItem->key () == item->key ()))
+        {
+            auto const other = std::move (otherMapItem);
+            otherMapItem.reset ();
+            if ((item->slice () != other->slice ()) && !emit (item, other))
+                return false;
+        }
+        else if (!emit (item, none))
+        {
+            return false;
+        }
+    }
+
+    if (otherMapItem)
+        return emit (none, otherMapItem);
+
+    return true;
+}
+
+bool
+SHAMap::walkDelta (SHAMap const& otherMap,
+    SHAMapAbstractNode* ours, SHAMapAbstractNode* other,
+    SHAMapNodeID const& nodeID, uint256 const* after,
+    DeltaVisitor const& func) const
+{
+    if (ours && other && (ours->getNodeHash () == other->getNodeHash ()))
+        return true;
+
+    bool const ourLeaf = ours && ours->isLeaf ();
+    bool const otherLeaf = other && other->isLeaf ();
+
+    if (ourLeaf)
+    {
+        auto const& item = static_cast<SHAMapTreeNode*>(ours)->peekItem ();
+        if (other)
+            return otherMap.walkDeltaBranch (other, item, false, after, func);
+        return walkDeltaBranch (ours, nullptr, true, after, func);
+    }
+
+    if (otherLeaf)
+    {
+        auto const& item = static_cast<SHAMapTreeNode*>(other)->peekItem ();
+        if (ours)
+            return walkDeltaBranch (ours, item, true, after, func);
+        return otherMap.walkDeltaBranch (other, nullptr, false, after, func);
+    }
+
+    // Two inner nodes, either of which may be empty
+    auto ourInner = static_cast<SHAMapInnerNode*>(ours);
+    auto otherInner = static_cast<SHAMapInnerNode*>(other);
+
+    // Branches that lie wholly before the resume point are skipped
+    int const first = after ? nodeID.selectBranch (*after) : 0;
+
+    for (int i = first; i < 16; ++i)
+    {
+        bool const ourEmpty = !ourInner || ourInner->isEmptyBranch (i);
+        bool const otherEmpty = !otherInner || otherInner->isEmptyBranch (i);
+
+        if (ourEmpty && otherEmpty)
+            continue;
+
+        if (!ourEmpty && !otherEmpty &&
+                (ourInner->getChildHash (i) == otherInner->getChildHash (i)))
+            continue;
+
+        if (!walkDelta (otherMap,
+                ourEmpty ? nullptr : descendThrow (ourInner, i),
+                otherEmpty ? nullptr : otherMap.descendThrow (otherInner, i),
+                nodeID.getChildNodeID (i),
+                (i == first) ? after : nullptr,
+                func))
+            return false;
+    }
+
+    return true;
+}
+
+bool
+SHAMap::visitDelta (SHAMap const& otherMap, DeltaVisitor const& func,
+    boost::optional<uint256> const& after) const
+{
+    // CAUTION: otherMap is not locked and must be immutable
+    assert (isValid () && otherMap.isValid ());
+
+    if (getHash () == otherMap.getHash ())
+        return true;
+
+    return walkDelta (otherMap, root_.get (), otherMap.root_.get (),
+        SHAMapNodeID (), after ? after.get_ptr () : nullptr, func);
+}
+
+bool
+SHAMap::visitDeltaParallel (SHAMap const& otherMap,
+    DeltaVisitor const& func) const
+{
+    // CAUTION: both maps must be immutable, since they're read
+    // from several threads at once
+    assert (isValid () && otherMap.isValid ());
+
+    if (getHash () == otherMap.getHash ())
+        return true;
+
+    auto const ours = root_.get ();
+    auto const other = otherMap.root_.get ();
+    if (!ours->isInner () || !other->isInner ())
+        return walkDelta (otherMap, ours, other, SHAMapNodeID (), nullptr, func);
+
+    auto ourInner = static_cast<SHAMapInnerNode*>(ours);
+    auto otherInner = static_cast<SHAMapInnerNode*>(other);
+
+    // Once any branch is stopped, the others stop at their next item
+    std::atomic<bool> stopped {false};
+    DeltaVisitor const visit = [&](uint256 const& key,
+        boost::intrusive_ptr<SHAMapItem const> const& mine,
+        boost::intrusive_ptr<SHAMapItem const> const& theirs)
+    {
+        if (stopped.load (std::memory_order_relaxed))
+            return false;
+        if (func (key, mine, theirs))
+            return true;
+        stopped = true;
+        return false;
+    };
+
+    SHAMapNodeID const rootID;
+    std::array<std::future<bool>, 16> branches;
+    for (int i = 0; i < 16; ++i)
+    {
+        bool const ourEmpty = ourInner->isEmptyBranch (i);
+        bool const otherEmpty = otherInner->isEmptyBranch (i);
+
+        if ((ourEmpty && otherEmpty) || (!ourEmpty && !otherEmpty &&
+                (ourInner->getChildHash (i) == otherInner->getChildHash (i))))
+            continue;
+
+        branches[i] = std::async (std::launch::async,
+            [&, i, ourEmpty, otherEmpty]()
+            {
+                return walkDelta (otherMap,
+                    ourEmpty ? nullptr : descendThrow (ourInner, i),
+                    otherEmpty ? nullptr : otherMap.descendThrow (otherInner, i),
+                    rootID.getChildNodeID (i), nullptr, visit);
+            });
+    }
+
+    // Wait for every branch before rethrowing, since they share our stack
+    std::exception_ptr error;
+    for (auto& branch : branches)
+    {
+        if (!branch.valid ())
+            continue;
+        try
+        {
+            branch.get ();
+        }
+        catch (std::exception const&)
+        {
+            if (!error)
+                error = std::current_exception ();
+        }
+    }
+
+    if (error)
+        std::rethrow_exception (error);
+
+    return !stopped;
+}
+
 void SHAMap::walkMap (std::vector<SHAMapMissingNode>& missingNodes, int maxMissing) const
 {
     if (!root_->isInner ())  // root_ is only node, and we have it
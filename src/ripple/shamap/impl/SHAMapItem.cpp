@@ -18,29 +18,68 @@
 //==============================================================================
 
 #include <BeastConfig.h>
-#include <ripple/protocol/Serializer.h>
+#include <ripple/basics/SlabAllocator.h>
 #include <ripple/shamap/SHAMapItem.h>
+#include <cstring>
+#include <new>
 
 namespace ripple {
 
-class SHAMap;
+static_assert (alignof (SHAMapItem) <= alignof (std::max_align_t), "");
 
-SHAMapItem::SHAMapItem (uint256 const& tag, Blob const& data)
-    : tag_(tag)
-    , data_(data)
+// Most ledger entries and transactions fit in one of these. Larger
+// items, mostly transactions with long metadata, come from the heap.
+// The pool is never destroyed, since items may outlive static objects.
+static
+SlabAllocatorSet&
+itemPool ()
 {
+    static auto const pool = new SlabAllocatorSet ({
+        sizeof (SHAMapItem) + 64,
+        sizeof (SHAMapItem) + 128,
+        sizeof (SHAMapItem) + 192,
+        sizeof (SHAMapItem) + 256,
+        sizeof (SHAMapItem) + 384,
+        sizeof (SHAMapItem) + 512,
+        sizeof (SHAMapItem) + 768,
+        sizeof (SHAMapItem) + 1024 },
+        1024 * 1024);
+    return *pool;
 }
 
-SHAMapItem::SHAMapItem (uint256 const& tag, const Serializer& data)
+SHAMapItem::SHAMapItem (uint256 const& tag, Slice data)
     : tag_ (tag)
-    , data_(data.peekData())
+    , size_ (static_cast<std::uint32_t> (data.size ()))
 {
+    if (size_ != 0)
+        std::memcpy (reinterpret_cast<std::uint8_t*> (this + 1),
+            data.data (), size_);
 }
 
-SHAMapItem::SHAMapItem (uint256 const& tag, Serializer&& data)
-    : tag_ (tag)
-    , data_(std::move(data.modData()))
+void
+SHAMapItem::destroy () const
+{
+    auto const bytes = sizeof (SHAMapItem) + size_;
+    this->~SHAMapItem ();
+    itemPool ().deallocate (const_cast<SHAMapItem*> (this), bytes);
+}
+
+boost::intrusive_ptr<SHAMapItem const>
+make_shamapitem (uint256 const& tag, Slice data)
+{
+    auto const bytes = sizeof (SHAMapItem) + data.size ();
+    auto const p = itemPool ().allocate (bytes);
+
+    // The new item starts with a reference count of one,
+    // which the pointer adopts.
+    return boost::intrusive_ptr<SHAMapItem const> (
+        ::new (p) SHAMapItem (tag, data), false);
+}
+
+std::size_t
+getSHAMapItemPoolSize ()
 {
+    return itemPool ().reserved ();
 }
 
 } // ripple
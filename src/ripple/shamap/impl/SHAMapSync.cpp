@@ -21,12 +21,16 @@
 #include <ripple/basics/random.h>
 #include <ripple/shamap/SHAMap.h>
 #include <ripple/nodestore/Database.h>
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <set>
 
 namespace ripple {
 
 void
 SHAMap::visitLeaves(
-    std::function<void(std::shared_ptr<SHAMapItem const> const& item)> const& leafFunction) const
+    std::function<void(boost::intrusive_ptr<SHAMapItem const> const& item)> const& leafFunction) const
 {
     visitNodes(
         [&leafFunction](SHAMapAbstractNode& node)
@@ -100,205 +104,357 @@ void SHAMap::visitNodes(std::function<bool (SHAMapAbstractNode&)> const& functio
     }
 }
 
-/** Get a list of node IDs and hashes for nodes that are part of this SHAMap
-    but not available locally.  The filter can hold alternate sources of
-    nodes that are not permanently stored locally
+/** State for a single getMissingNodes traversal.
+
+    Reads that cannot complete immediately are handed to the node store
+    along with a callback that queues the result here. The walk picks up
+    completed reads between inner nodes, so it keeps descending other
+    branches while reads are in flight and only waits when it has run
+    out of other work.
 */
-std::vector<std::pair<SHAMapNodeID, uint256>>
-SHAMap::getMissingNodes(std::size_t max, SHAMapSyncFilter* filter)
+class SHAMap::MissingNodes
 {
-    assert (root_->isValid ());
-    assert (root_->getNodeHash().isNonZero ());
+public:
+    using OnMissing =
+        std::function<bool (SHAMapNodeID const&, uint256 const&)>;
 
-    std::vector<std::pair<SHAMapNodeID, uint256>> ret;
+    // A completed read, to be attached to its parent
+    struct Read
+    {
+        SHAMapInnerNode* parent;
+        int branch;
+        SHAMapNodeID nodeID;
+        std::shared_ptr<NodeObject> object;
+    };
 
-    std::uint32_t generation = f_.fullbelow().getGeneration();
+    // Shared with the read threads, which can outlive the traversal
+    struct Completions
+    {
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::vector<Read> reads;
+    };
 
-    if (!root_->isInner ())
+    std::size_t const max_;
+    SHAMapSyncFilter* const filter_;
+    int const maxDefer_;
+    std::uint32_t const generation_;
+    OnMissing const& onMissing_;
+
+    std::size_t found_ = 0;
+    bool stopped_ = false;
+
+    // Track the missing hashes we have found so far
+    std::set <SHAMapHash> missingHashes_;
+
+    // Inner nodes whose reads completed but which have not been walked
+    std::vector <std::pair <SHAMapInnerNode*, SHAMapNodeID>> resumes_;
+
+    std::shared_ptr <Completions> completions_;
+    int outstanding_ = 0;   // reads posted and not yet processed
+    int deferred_ = 0;      // reads posted during the current pass
+    int hits_ = 0;          // deferred reads that found their node
+
+    MissingNodes (std::size_t max, SHAMapSyncFilter* filter,
+            int maxDefer, std::uint32_t generation,
+                OnMissing const& onMissing)
+        : max_ (max)
+        , filter_ (filter)
+        , maxDefer_ (std::max (maxDefer, 1))
+        , generation_ (generation)
+        , onMissing_ (onMissing)
+        , completions_ (std::make_shared <Completions> ())
     {
-        if (generation == 0)
-            clearSynching();
-        else
-            JLOG(journal_.warn()) << "synching empty tree";
-        return ret;
     }
 
-    if (std::static_pointer_cast<SHAMapInnerNode>(root_)->isFullBelow (generation))
+    void
+    addMissing (SHAMapNodeID const& nodeID, SHAMapHash const& hash)
     {
-        clearSynching ();
-        return ret;
+        if (stopped_ || ! missingHashes_.insert (hash).second)
+            return;
+
+        ++found_;
+        if (! onMissing_ (nodeID, hash.as_uint256()) || (found_ >= max_))
+            stopped_ = true;
     }
 
-    int const maxDefer = f_.db().getDesiredAsyncReadCount ();
+    NodeStore::Database::ReadCallback
+    makeCallback (SHAMapInnerNode* parent, int branch,
+        SHAMapNodeID const& nodeID) const
+    {
+        return [completions = completions_, parent, branch, nodeID] (
+            std::shared_ptr<NodeObject> const& object)
+        {
+            std::lock_guard <std::mutex> lock (completions->mutex);
+            completions->reads.push_back ({parent, branch, nodeID, object});
+            completions->cond.notify_one ();
+        };
+    }
+};
 
-    // Track the missing hashes we have found so far
-    std::set <SHAMapHash> missingHashes;
+static
+SHAMapNodeID
+innerNodeID (SHAMapInnerNode* node, SHAMapNodeID const& nodeID)
+{
+    if (auto v2Node = dynamic_cast<SHAMapInnerNodeV2*>(node))
+        return SHAMapNodeID{v2Node->depth(), v2Node->key()};
+    return nodeID;
+}
 
-    // preallocate memory
-    ret.reserve (max);
+// Walk the subtree below node without blocking on reads
+void
+SHAMap::gmn_ProcessNodes (MissingNodes& mn,
+    SHAMapInnerNode* node, SHAMapNodeID nodeID)
+{
+    using StackEntry = std::tuple<SHAMapInnerNode*, SHAMapNodeID, int, int, bool>;
+    std::stack <StackEntry, std::vector<StackEntry>> stack;
 
-    while (1)
+    // The firstChild value is selected randomly so if multiple threads
+    // are traversing the map, each thread will start at a different
+    // (randomly selected) inner node.  This increases the likelihood
+    // that the two threads will produce different request sets (which is
+    // more efficient than sending identical requests).
+    int firstChild = rand_int(255);
+    int currentChild = 0;
+    bool fullBelow = true;
+
+    do
     {
-        std::vector <std::tuple <SHAMapInnerNode*, int, SHAMapNodeID>> deferredReads;
-        deferredReads.reserve (maxDefer + 16);
+        while (currentChild < 16)
+        {
+            if (mn.stopped_)
+                return;
 
-        using StackEntry = std::tuple<SHAMapInnerNode*, SHAMapNodeID, int, int, bool>;
-        std::stack <StackEntry, std::vector<StackEntry>> stack;
+            int branch = (firstChild + currentChild++) % 16;
+            if (node->isEmptyBranch (branch))
+                continue;
 
-        // Traverse the map without blocking
+            auto const& childHash = node->getChildHash (branch);
 
-        auto node = static_cast<SHAMapInnerNode*>(root_.get());
-        SHAMapNodeID nodeID;
+            if (mn.missingHashes_.count (childHash) != 0)
+            {
+                fullBelow = false;
+                continue;
+            }
 
-        // The firstChild value is selected randomly so if multiple threads
-        // are traversing the map, each thread will start at a different
-        // (randomly selected) inner node.  This increases the likelihood
-        // that the two threads will produce different request sets (which is
-        // more efficient than sending identical requests).
-        int firstChild = rand_int(255);
-        int currentChild = 0;
-        bool fullBelow = true;
+            if (backed_ && f_.fullbelow().touch_if_exists (childHash.as_uint256()))
+                continue;
 
-        do
-        {
-            while (currentChild < 16)
+            SHAMapNodeID childID = nodeID.getChildNodeID (branch);
+
+            // Only build a read callback if the child isn't in memory
+            bool pending = false;
+            auto d = node->getChildPointer (branch);
+            if (!d)
+                d = descendAsync (node, branch, mn.filter_, pending,
+                    mn.makeCallback (node, branch, childID));
+
+            if (!d)
             {
-                int branch = (firstChild + currentChild++) % 16;
-                if (!node->isEmptyBranch (branch))
+                if (!pending)
+                { // node is not in the database
+                    mn.addMissing (childID, childHash);
+                }
+                else
                 {
-                    auto const& childHash = node->getChildHash (branch);
+                    // read is deferred, keep walking
+                    ++mn.outstanding_;
+                    ++mn.deferred_;
 
-                    if (missingHashes.count (childHash) != 0)
-                    {
-                        fullBelow = false;
-                    }
-                    else if (! backed_ || ! f_.fullbelow().touch_if_exists (childHash.as_uint256()))
-                    {
-                        SHAMapNodeID childID = nodeID.getChildNodeID (branch);
-                        bool pending = false;
-                        auto d = descendAsync (node, branch, filter, pending);
-
-                        if (!d)
-                        {
-                            if (!pending)
-                            { // node is not in the database
-                                missingHashes.insert (childHash);
-                                ret.emplace_back (
-                                    childID,
-                                    childHash.as_uint256());
-
-                                if (--max <= 0)
-                                    return ret;
-                            }
-                            else
-                            {
-                                // read is deferred
-                                deferredReads.emplace_back (node, branch, childID);
-                            }
-
-                            fullBelow = false; // This node is not known full below
-                        }
-                        else if (d->isInner() &&
-                                 !static_cast<SHAMapInnerNode*>(d)->isFullBelow(generation))
-                        {
-                            stack.push (std::make_tuple (node, nodeID,
-                                  firstChild, currentChild, fullBelow));
-
-                            // Switch to processing the child node
-                            node = static_cast<SHAMapInnerNode*>(d);
-                            if (auto v2Node = dynamic_cast<SHAMapInnerNodeV2*>(node))
-                                nodeID = SHAMapNodeID{v2Node->depth(), v2Node->key()};
-                            else
-                                nodeID = childID;
-                            firstChild = rand_int(255);
-                            currentChild = 0;
-                            fullBelow = true;
-                        }
-                    }
+                    // Don't let reads pile up in the node store
+                    if (mn.outstanding_ >= mn.maxDefer_)
+                        gmn_ProcessDeferredReads (mn, true);
                 }
+
+                fullBelow = false; // This node is not known full below
+            }
+            else if (d->isInner() &&
+                     !static_cast<SHAMapInnerNode*>(d)->isFullBelow(mn.generation_))
+            {
+                stack.push (std::make_tuple (node, nodeID,
+                      firstChild, currentChild, fullBelow));
+
+                // Switch to processing the child node
+                node = static_cast<SHAMapInnerNode*>(d);
+                nodeID = innerNodeID (node, childID);
+                firstChild = rand_int(255);
+                currentChild = 0;
+                fullBelow = true;
             }
+        }
 
-            // We are done with this inner node (and thus all of its children)
+        // We are done with this inner node (and thus all of its children)
 
-            if (fullBelow)
-            { // No partial node encountered below this node
-                node->setFullBelowGen (generation);
-                if (backed_)
-                    f_.fullbelow().insert (node->getNodeHash ().as_uint256());
-            }
+        if (fullBelow)
+        { // No partial node encountered below this node
+            node->setFullBelowGen (mn.generation_);
+            if (backed_)
+                f_.fullbelow().insert (node->getNodeHash ().as_uint256());
+        }
 
-            if (stack.empty ())
-                node = nullptr; // Finished processing the last node, we are done
-            else
-            { // Pick up where we left off (above this node)
-                bool was;
-                std::tie(node, nodeID, firstChild, currentChild, was) = stack.top ();
-                fullBelow = was && fullBelow; // was and still is
-                stack.pop ();
-            }
+        if (stack.empty ())
+            node = nullptr; // Finished processing the last node, we are done
+        else
+        { // Pick up where we left off (above this node)
+            bool was;
+            std::tie(node, nodeID, firstChild, currentChild, was) = stack.top ();
+            fullBelow = was && fullBelow; // was and still is
+            stack.pop ();
+        }
 
+        // Pick up any reads that finished while we were walking
+        if (mn.outstanding_ != 0)
+            gmn_ProcessDeferredReads (mn, false);
+    }
+    while (node != nullptr);
+}
+
+// Attach the nodes from completed reads, queueing inner nodes to be walked
+void
+SHAMap::gmn_ProcessDeferredReads (MissingNodes& mn, bool wait)
+{
+    std::vector<MissingNodes::Read> reads;
+
+    {
+        auto& completions = *mn.completions_;
+        std::unique_lock <std::mutex> lock (completions.mutex);
+        while (wait && completions.reads.empty ())
+            completions.cond.wait (lock);
+        reads.swap (completions.reads);
+    }
+
+    for (auto& read : reads)
+    {
+        --mn.outstanding_;
+
+        auto const& nodeHash = read.parent->getChildHash (read.branch);
+
+        // A corrupt node is treated as missing
+        auto nodePtr = finishFetch (nodeHash, read.object);
+        if (!nodePtr)
+        {
+            // The node may have arrived some other way in the meantime
+            nodePtr = getCache (nodeHash);
+            if (!nodePtr && mn.filter_)
+                nodePtr = checkFilter (nodeHash, mn.filter_);
         }
-        while ((node != nullptr) && (deferredReads.size () <= maxDefer));
 
-        // If we didn't defer any reads, we're done
-        if (deferredReads.empty ())
-            break;
+        if (nodePtr && isInconsistentNode (nodePtr))
+            nodePtr = nullptr;
+
+        if (!nodePtr)
+        {
+            mn.addMissing (read.nodeID, nodeHash);
+            continue;
+        }
+
+        ++mn.hits_;
+        nodePtr = read.parent->canonicalizeChild (read.branch, std::move(nodePtr));
+
+        if (nodePtr->isInner () &&
+            !static_cast<SHAMapInnerNode*>(nodePtr.get())->isFullBelow(mn.generation_))
+        {
+            auto inner = static_cast<SHAMapInnerNode*>(nodePtr.get());
+            mn.resumes_.emplace_back (inner, innerNodeID (inner, read.nodeID));
+        }
+    }
+}
 
-        auto const before = std::chrono::steady_clock::now();
-        f_.db().waitReads();
-        auto const after = std::chrono::steady_clock::now();
+/** Get a list of node IDs and hashes for nodes that are part of this SHAMap
+    but not available locally.  The filter can hold alternate sources of
+    nodes that are not permanently stored locally
+*/
+std::vector<std::pair<SHAMapNodeID, uint256>>
+SHAMap::getMissingNodes(std::size_t max, SHAMapSyncFilter* filter)
+{
+    std::vector<std::pair<SHAMapNodeID, uint256>> ret;
 
-        auto const elapsed = std::chrono::duration_cast
-            <std::chrono::milliseconds> (after - before);
-        auto const count = deferredReads.size ();
+    // preallocate memory
+    ret.reserve (max);
 
-        // Process all deferred reads
-        int hits = 0;
-        for (auto const& deferredNode : deferredReads)
+    getMissingNodes (max, filter,
+        [&ret](SHAMapNodeID const& nodeID, uint256 const& hash)
         {
-            auto parent = std::get<0>(deferredNode);
-            auto branch = std::get<1>(deferredNode);
-            auto const& deferredNodeID = std::get<2>(deferredNode);
-            auto const& nodeHash = parent->getChildHash (branch);
+            ret.emplace_back (nodeID, hash);
+            return true;
+        });
+
+    return ret;
+}
+
+void
+SHAMap::getMissingNodes (std::size_t max, SHAMapSyncFilter* filter,
+    std::function<bool (SHAMapNodeID const&, uint256 const&)> const& onMissing)
+{
+    assert (root_->isValid ());
+    assert (root_->getNodeHash().isNonZero ());
+
+    std::uint32_t generation = f_.fullbelow().getGeneration();
+
+    if (!root_->isInner ())
+    {
+        if (generation == 0)
+            clearSynching();
+        else
+            JLOG(journal_.warn()) << "synching empty tree";
+        return;
+    }
+
+    if (std::static_pointer_cast<SHAMapInnerNode>(root_)->isFullBelow (generation))
+    {
+        clearSynching ();
+        return;
+    }
+
+    MissingNodes mn (max, filter, f_.db().getDesiredAsyncReadCount (),
+        generation, onMissing);
 
-            auto nodePtr = fetchNodeNT(nodeHash, filter);
-            if (nodePtr)
+    auto const before = std::chrono::steady_clock::now();
+    int reads = 0;
+
+    // Each pass walks the map from the root. Subtrees whose reads complete
+    // are walked as they arrive; a pass that defers nothing has marked
+    // everything it could as full below.
+    while (1)
+    {
+        mn.deferred_ = 0;
+
+        gmn_ProcessNodes (mn,
+            static_cast<SHAMapInnerNode*>(root_.get()), SHAMapNodeID{});
+
+        while (!mn.stopped_ && (mn.outstanding_ != 0 || !mn.resumes_.empty ()))
+        {
+            if (mn.resumes_.empty ())
             {
-                ++hits;
-                if (backed_)
-                    canonicalize (nodeHash, nodePtr);
-                nodePtr = parent->canonicalizeChild (branch, std::move(nodePtr));
+                // Nothing left to walk until a read completes
+                gmn_ProcessDeferredReads (mn, true);
             }
-            else if ((max > 0) && (missingHashes.insert (nodeHash).second))
+            else
             {
-                ret.push_back (
-                    std::make_pair (
-                        deferredNodeID,
-                        nodeHash.as_uint256()));
-
-                --max;
+                auto const resume = mn.resumes_.back ();
+                mn.resumes_.pop_back ();
+                gmn_ProcessNodes (mn, resume.first, resume.second);
             }
         }
 
-        auto const process_time = std::chrono::duration_cast
-            <std::chrono::milliseconds> (std::chrono::steady_clock::now() - after);
+        reads += mn.deferred_;
 
-        if ((count > 50) || (elapsed.count() > 50))
-        {
-            JLOG(journal_.debug()) << "getMissingNodes reads " <<
-                count << " nodes (" << hits << " hits) in "
-                << elapsed.count() << " + " << process_time.count()  << " ms";
-        }
+        if (mn.stopped_ || (mn.deferred_ == 0))
+            break;
+    }
 
-        if (max <= 0)
-            return ret;
+    auto const elapsed = std::chrono::duration_cast
+        <std::chrono::milliseconds> (std::chrono::steady_clock::now() - before);
 
+    if ((reads > 50) || (elapsed.count() > 50))
+    {
+        JLOG(journal_.debug()) << "getMissingNodes reads " <<
+            reads << " nodes (" << mn.hits_ << " hits) in "
+            << elapsed.count() << " ms";
     }
 
-    if (ret.empty ())
+    if (mn.found_ == 0)
         clearSynching ();
-
-    return ret;
 }
 
 std::vector<uint256> SHAMap::getNeededHashes (int max, SHAMapSyncFilter* filter)
@@ -583,7 +739,7 @@ bool SHAMap::deepCompare (SHAMap& other) const
             auto& otherNodePeek = static_cast<SHAMapTreeNode*>(otherNode)->peekItem();
             if (nodePeek->key() != otherNodePeek->key())
                 return false;
-            if (nodePeek->peekData() != otherNodePeek->peekData())
+            if (nodePeek->slice() != otherNodePeek->slice())
                 return false;
         }
         else if (node->isInner ())
@@ -80,21 +80,21 @@ SHAMapTreeNode::clone(std::uint32_t seq) const
     return std::make_shared<SHAMapTreeNode>(mItem, mType, seq, mHash);
 }
 
-SHAMapTreeNode::SHAMapTreeNode (std::shared_ptr<SHAMapItem const> const& item,
+SHAMapTreeNode::SHAMapTreeNode (boost::intrusive_ptr<SHAMapItem const> const& item,
                                 TNType type, std::uint32_t seq)
     : SHAMapAbstractNode(type, seq)
     , mItem (item)
 {
-    assert (item->peekData ().size () >= 12);
+    assert (item->size () >= 12);
     updateHash();
 }
 
-SHAMapTreeNode::SHAMapTreeNode (std::shared_ptr<SHAMapItem const> const& item,
+SHAMapTreeNode::SHAMapTreeNode (boost::intrusive_ptr<SHAMapItem const> const& item,
                                 TNType type, std::uint32_t seq, SHAMapHash const& hash)
     : SHAMapAbstractNode(type, seq, hash)
     , mItem (item)
 {
-    assert (item->peekData ().size () >= 12);
+    assert (item->size () >= 12);
 }
 
 std::shared_ptr<SHAMapAbstractNode>
@@ -116,10 +116,10 @@ SHAMapAbstractNode::make(Slice const& rawNode, std::uint32_t seq, SHANodeFormat
         if (type == 0)
         {
             // transaction
-            auto item = std::make_shared<SHAMapItem const>(
+            auto item = make_shamapitem(
                 sha512Half(HashPrefix::transactionID,
                     Slice(s.data(), s.size())),
-                        s.peekData());
+                        s.slice());
             if (hashValid)
                 return std::make_shared<SHAMapTreeNode>(item, tnTRANSACTION_NM, seq, hash);
             return std::make_shared<SHAMapTreeNode>(item, tnTRANSACTION_NM, seq);
@@ -136,7 +136,7 @@ SHAMapAbstractNode::make(Slice const& rawNode, std::uint32_t seq, SHANodeFormat
 
             if (u.isZero ()) Throw<std::runtime_error> ("invalid AS node");
 
-            auto item = std::make_shared<SHAMapItem const> (u, s.peekData ());
+            auto item = make_shamapitem (u, s.slice ());
             if (hashValid)
                 return std::make_shared<SHAMapTreeNode>(item, tnACCOUNT_STATE, seq, hash);
             return std::make_shared<SHAMapTreeNode>(item, tnACCOUNT_STATE, seq);
@@ -195,7 +195,7 @@ SHAMapAbstractNode::make(Slice const& rawNode, std::uint32_t seq, SHANodeFormat
             if (u.isZero ())
                 Throw<std::runtime_error> ("invalid TM node");
 
-            auto item = std::make_shared<SHAMapItem const> (u, s.peekData ());
+            auto item = make_shamapitem (u, s.slice ());
             if (hashValid)
                 return std::make_shared<SHAMapTreeNode>(item, tnTRANSACTION_MD, seq, hash);
             return std::make_shared<SHAMapTreeNode>(item, tnTRANSACTION_MD, seq);
@@ -264,9 +264,9 @@ SHAMapAbstractNode::make(Slice const& rawNode, std::uint32_t seq, SHANodeFormat
 
         if (prefix == HashPrefix::transactionID)
         {
-            auto item = std::make_shared<SHAMapItem const>(
+            auto item = make_shamapitem(
                 sha512Half(rawNode),
-                    s.peekData ());
+                    s.slice ());
             if (hashValid)
                 return std::make_shared<SHAMapTreeNode>(item, tnTRANSACTION_NM, seq, hash);
             return std::make_shared<SHAMapTreeNode>(item, tnTRANSACTION_NM, seq);
@@ -286,7 +286,7 @@ SHAMapAbstractNode::make(Slice const& rawNode, std::uint32_t seq, SHANodeFormat
                 Throw<std::runtime_error> ("invalid PLN node");
             }
 
-            auto item = std::make_shared<SHAMapItem const> (u, s.peekData ());
+            auto item = make_shamapitem (u, s.slice ());
             if (hashValid)
                 return std::make_shared<SHAMapTreeNode>(item, tnACCOUNT_STATE, seq, hash);
             return std::make_shared<SHAMapTreeNode>(item, tnACCOUNT_STATE, seq);
@@ -343,7 +343,7 @@ SHAMapAbstractNode::make(Slice const& rawNode, std::uint32_t seq, SHANodeFormat
             uint256 txID;
             s.get256 (txID, s.getLength () - 32);
             s.chop (32);
-            auto item = std::make_shared<SHAMapItem const> (txID, s.peekData ());
+            auto item = make_shamapitem (txID, s.slice ());
             if (hashValid)
                 return std::make_shared<SHAMapTreeNode>(item, tnTRANSACTION_MD, seq, hash);
             return std::make_shared<SHAMapTreeNode>(item, tnTRANSACTION_MD, seq);
@@ -397,18 +397,18 @@ SHAMapTreeNode::updateHash()
     if (mType == tnTRANSACTION_NM)
     {
         nh = sha512Half(HashPrefix::transactionID,
-            makeSlice(mItem->peekData()));
+            mItem->slice());
     }
     else if (mType == tnACCOUNT_STATE)
     {
         nh = sha512Half(HashPrefix::leafNode,
-            makeSlice(mItem->peekData()),
+            mItem->slice(),
                 mItem->key());
     }
     else if (mType == tnTRANSACTION_MD)
     {
         nh = sha512Half(HashPrefix::txNode,
-            makeSlice(mItem->peekData()),
+            mItem->slice(),
                 mItem->key());
     }
     else
@@ -533,12 +533,12 @@ SHAMapTreeNode::addRaw(Serializer& s, SHANodeFormat format) const
         if (format == snfPREFIX)
         {
             s.add32 (HashPrefix::leafNode);
-            s.addRaw (mItem->peekData ());
+            s.addRaw (mItem->slice ());
             s.add256 (mItem->key());
         }
         else
         {
-            s.addRaw (mItem->peekData ());
+            s.addRaw (mItem->slice ());
             s.add256 (mItem->key());
             s.add8 (1);
         }
@@ -548,11 +548,11 @@ SHAMapTreeNode::addRaw(Serializer& s, SHANodeFormat format) const
         if (format == snfPREFIX)
         {
             s.add32 (HashPrefix::transactionID);
-            s.addRaw (mItem->peekData ());
+            s.addRaw (mItem->slice ());
         }
         else
         {
-            s.addRaw (mItem->peekData ());
+            s.addRaw (mItem->slice ());
             s.add8 (0);
         }
     }
@@ -561,12 +561,12 @@ SHAMapTreeNode::addRaw(Serializer& s, SHANodeFormat format) const
         if (format == snfPREFIX)
         {
             s.add32 (HashPrefix::txNode);
-            s.addRaw (mItem->peekData ());
+            s.addRaw (mItem->slice ());
             s.add256 (mItem->key());
         }
         else
         {
-            s.addRaw (mItem->peekData ());
+            s.addRaw (mItem->slice ());
             s.add256 (mItem->key());
             s.add8 (4);
         }
@@ -575,7 +575,7 @@ SHAMapTreeNode::addRaw(Serializer& s, SHANodeFormat format) const
         assert (false);
 }
 
-bool SHAMapTreeNode::setItem (std::shared_ptr<SHAMapItem const> const& i, TNType type)
+bool SHAMapTreeNode::setItem (boost::intrusive_ptr<SHAMapItem const> const& i, TNType type)
 {
     mType = type;
     mItem = i;
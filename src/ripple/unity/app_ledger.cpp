@@ -22,11 +22,16 @@
 #include <ripple/app/ledger/AcceptedLedger.cpp>
 #include <ripple/app/ledger/AcceptedLedgerTx.cpp>
 #include <ripple/app/ledger/AccountStateSF.cpp>
+#include <ripple/app/ledger/BookIndex.cpp>
 #include <ripple/app/ledger/BookListeners.cpp>
 #include <ripple/app/ledger/ConsensusTransSetSF.cpp>
+#include <ripple/app/ledger/IncrementalIndex.cpp>
+#include <ripple/app/ledger/IssuerBalances.cpp>
+#include <ripple/app/ledger/IssuerBalancesDB.cpp>
 #include <ripple/app/ledger/Ledger.cpp>
 #include <ripple/app/ledger/LedgerHistory.cpp>
 #include <ripple/app/ledger/LedgerProposal.cpp>
+#include <ripple/app/ledger/LedgerSnapshot.cpp>
 #include <ripple/app/ledger/OrderBookDB.cpp>
 #include <ripple/app/ledger/TransactionStateSF.cpp>
 
@@ -20,12 +20,15 @@
 #include <BeastConfig.h>
 
 #include <ripple/core/impl/Config.cpp>
+#include <ripple/core/impl/CoroStackPool.cpp>
 #include <ripple/core/impl/DatabaseCon.cpp>
 #include <ripple/core/impl/DeadlineTimer.cpp>
 #include <ripple/core/impl/LoadEvent.cpp>
 #include <ripple/core/impl/LoadMonitor.cpp>
 #include <ripple/core/impl/Job.cpp>
 #include <ripple/core/impl/JobQueue.cpp>
+#include <ripple/core/impl/JobSet.cpp>
+#include <ripple/core/impl/JobTrace.cpp>
 #include <ripple/core/impl/SNTPClock.cpp>
 #include <ripple/core/impl/Stoppable.cpp>
 #include <ripple/core/impl/TimeKeeper.cpp>
@@ -31,6 +31,11 @@
 #include <ripple/nodestore/impl/DummyScheduler.cpp>
 #include <ripple/nodestore/impl/DecodedBlob.cpp>
 #include <ripple/nodestore/impl/EncodedBlob.cpp>
+#include <ripple/nodestore/impl/Importer.cpp>
+#include <ripple/nodestore/impl/KeyFilter.cpp>
 #include <ripple/nodestore/impl/ManagerImp.cpp>
 #include <ripple/nodestore/impl/NodeObject.cpp>
+#include <ripple/nodestore/impl/ReadScheduler.cpp>
+#include <ripple/nodestore/impl/ShardStoreImp.cpp>
+#include <ripple/nodestore/impl/WorkerPool.cpp>
 
@@ -49,12 +49,14 @@
 #include <ripple/rpc/handlers/FetchInfo.cpp>
 #include <ripple/rpc/handlers/GatewayBalances.cpp>
 #include <ripple/rpc/handlers/GetCounts.cpp>
+#include <ripple/rpc/handlers/JobTrace.cpp>
 #include <ripple/rpc/handlers/LedgerHandler.cpp>
 #include <ripple/rpc/handlers/LedgerAccept.cpp>
 #include <ripple/rpc/handlers/LedgerCleanerHandler.cpp>
 #include <ripple/rpc/handlers/LedgerClosed.cpp>
 #include <ripple/rpc/handlers/LedgerCurrent.cpp>
 #include <ripple/rpc/handlers/LedgerData.cpp>
+#include <ripple/rpc/handlers/LedgerDiff.cpp>
 #include <ripple/rpc/handlers/LedgerEntry.cpp>
 #include <ripple/rpc/handlers/LedgerHeader.cpp>
 #include <ripple/rpc/handlers/LedgerRequest.cpp>
@@ -71,6 +73,7 @@
 #include <ripple/rpc/handlers/RipplePathFind.cpp>
 #include <ripple/rpc/handlers/ServerInfo.cpp>
 #include <ripple/rpc/handlers/ServerState.cpp>
+#include <ripple/rpc/handlers/Shards.cpp>
 #include <ripple/rpc/handlers/SignFor.cpp>
 #include <ripple/rpc/handlers/SignHandler.cpp>
 #include <ripple/rpc/handlers/Stop.cpp>
@@ -89,8 +92,10 @@
 #include <ripple/rpc/handlers/WalletPropose.cpp>
 #include <ripple/rpc/handlers/WalletSeed.cpp>
 
+#include <ripple/rpc/impl/Admission.cpp>
 #include <ripple/rpc/impl/Handler.cpp>
 #include <ripple/rpc/impl/LegacyPathFind.cpp>
+#include <ripple/rpc/impl/ResponseCache.cpp>
 #include <ripple/rpc/impl/Role.cpp>
 #include <ripple/rpc/impl/RPCHelpers.cpp>
 #include <ripple/rpc/impl/ServerHandlerImp.cpp>
@@ -0,0 +1,261 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/app/ledger/BookIndex.h>
+#include <ripple/app/ledger/IncrementalIndex.h>
+#include <ripple/protocol/JsonFields.h>
+#include <test/jtx.h>
+
+namespace ripple {
+namespace test {
+
+class BookIndex_test : public beast::unit_test::suite
+{
+    // The index must match a fresh read of the book from the ledger
+    void
+    expectIndexed (BookIndex const& index, ReadView const& ledger,
+        Book const& book)
+    {
+        auto const indexed = index.find (book);
+        if (! BEAST_EXPECT(indexed))
+            return;
+
+        auto const fresh = BookIndex::build (ledger, book, beast::Journal());
+        BEAST_EXPECT(indexed->size () == fresh->size ());
+
+        auto const& a = indexed->directories ();
+        auto const& b = fresh->directories ();
+        if (! BEAST_EXPECT(a.size () == b.size ()))
+            return;
+
+        for (auto ia = a.begin (), ib = b.begin (); ia != a.end (); ++ia, ++ib)
+        {
+            BEAST_EXPECT(ia->first == ib->first);
+            if (! BEAST_EXPECT(ia->second.size () == ib->second.size ()))
+                continue;
+
+            for (std::size_t i = 0; i < ia->second.size (); ++i)
+            {
+                auto const& x = *ia->second[i];
+                auto const& y = *ib->second[i];
+                BEAST_EXPECT(x.key () == y.key ());
+                BEAST_EXPECT(x == y);
+
+                auto const owner = y.getAccountID (sfAccount);
+                auto const fx = indexed->funds (owner);
+                auto const fy = fresh->funds (owner);
+                BEAST_EXPECT((fx == nullptr) == (fy == nullptr));
+                if (fx && fy)
+                    BEAST_EXPECT(*fx == *fy);
+            }
+        }
+    }
+
+    static
+    Json::Value
+    cancel (jtx::Account const& account, std::uint32_t seq)
+    {
+        Json::Value jv;
+        jv[jss::Account] = account.human ();
+        jv[jss::OfferSequence] = seq;
+        jv[jss::TransactionType] = "OfferCancel";
+        return jv;
+    }
+
+    void
+    testIncremental ()
+    {
+        testcase ("incremental");
+
+        using namespace jtx;
+        Env env (*this);
+
+        auto const gw = Account ("gw");
+        auto const alice = Account ("alice");
+        auto const bob = Account ("bob");
+        auto const carol = Account ("carol");
+        auto const USD = gw["USD"];
+        auto const EUR = gw["EUR"];
+
+        env.fund (XRP(10000), gw, alice, bob, carol);
+        env.close ();
+        env.trust (USD(1000), alice, bob, carol);
+        env.trust (EUR(1000), alice, bob);
+        env.close ();
+        env (pay (gw, alice, USD(500)));
+        env (pay (gw, bob, USD(500)));
+        env (pay (gw, alice, EUR(500)));
+        env.close ();
+
+        // Offers to sell USD for XRP
+        Book const book {xrpIssue (), USD.issue ()};
+        Book const other {xrpIssue (), EUR.issue ()};
+
+        env (offer (alice, XRP(100), USD(10)));
+        env (offer (bob, XRP(200), USD(10)));
+        auto const aliceSeq = env.seq (alice);
+        env (offer (alice, XRP(100), USD(10)));
+        env (offer (gw, XRP(50), USD(10)));
+        env (offer (alice, XRP(100), EUR(10)));
+        env.close ();
+
+        auto index = std::make_shared<BookIndex const> (env.closed ()->info ());
+        index = index->insert (book,
+            BookIndex::build (*env.closed (), book, env.journal));
+        BEAST_EXPECT(index->size () == 1);
+        BEAST_EXPECT(index->find (book)->size () == 4);
+        BEAST_EXPECT(index->find (book)->directories ().size () == 3);
+        BEAST_EXPECT(! index->find (other));
+
+        // The issuer's own offers are funded without a cached balance
+        BEAST_EXPECT(! index->find (book)->funds (gw));
+        BEAST_EXPECT(*index->find (book)->funds (alice) == USD(500));
+
+        auto next = [&]()
+        {
+            env.close ();
+            index = index->advance (*env.closed (), env.journal);
+            BEAST_EXPECT(index->seq () == env.closed ()->info ().seq);
+            expectIndexed (*index, *env.closed (), book);
+        };
+
+        // Crossing consumes the issuer's offer and part of alice's
+        env (offer (carol, USD(15), XRP(125)));
+        next ();
+        BEAST_EXPECT(index->find (book)->size () == 3);
+
+        // Cancel one offer, and add one at the end of a directory
+        env (cancel (alice, aliceSeq));
+        env (offer (bob, XRP(100), USD(10)));
+        next ();
+        BEAST_EXPECT(index->find (book)->size () == 3);
+
+        // Balances change without touching any offer
+        env (pay (alice, carol, USD(400)));
+        next ();
+        BEAST_EXPECT(*index->find (book)->funds (alice) == USD(95));
+
+        // Offers created and consumed in the same ledger
+        env (offer (carol, XRP(50), USD(10)));
+        env (offer (bob, USD(10), XRP(50)));
+        next ();
+        BEAST_EXPECT(index->find (book)->size () == 3);
+
+        // Changes to other books are ignored
+        env (offer (bob, XRP(100), EUR(10)));
+        next ();
+        BEAST_EXPECT(! index->find (other));
+
+        // A gap in the ledger sequence empties the index
+        env.close ();
+        env.close ();
+        index = index->advance (*env.closed (), env.journal);
+        BEAST_EXPECT(index->size () == 0);
+    }
+
+    void
+    testEviction ()
+    {
+        testcase ("eviction");
+
+        using namespace jtx;
+        Env env (*this);
+
+        auto const gw = Account ("gw");
+        auto const USD = gw["USD"];
+        auto const EUR = gw["EUR"];
+        auto const BTC = gw["BTC"];
+
+        env.fund (XRP(10000), gw);
+        env.close ();
+
+        Book const usd {xrpIssue (), USD.issue ()};
+        Book const eur {xrpIssue (), EUR.issue ()};
+        Book const btc {xrpIssue (), BTC.issue ()};
+
+        // At most two books, dropped after two idle ledgers
+        PublishedIndex <Book, BookIndex> published (2, 2);
+
+        auto advance = [&]()
+        {
+            env.close ();
+            auto const ledger = env.closed ();
+            published.update (
+                [&](std::shared_ptr<BookIndex const> const& current)
+                {
+                    if (current)
+                        return current->advance (*ledger, env.journal);
+                    return std::make_shared<BookIndex const> (
+                        ledger->info ());
+                });
+        };
+
+        auto find = [&](Book const& book)
+        {
+            auto const ledger = env.closed ();
+            return published.find (*ledger, book,
+                [&]()
+                {
+                    return BookIndex::build (*ledger, book, env.journal);
+                });
+        };
+
+        auto indexed = [&](Book const& book)
+        {
+            return published.current ()->find (book) != nullptr;
+        };
+
+        advance ();
+        BEAST_EXPECT(find (eur));
+        advance ();
+        BEAST_EXPECT(find (usd));
+
+        // The least recently asked for book makes room
+        BEAST_EXPECT(find (btc));
+        BEAST_EXPECT(published.current ()->size () == 2);
+        BEAST_EXPECT(indexed (usd));
+        BEAST_EXPECT(! indexed (eur));
+        BEAST_EXPECT(indexed (btc));
+
+        // Books nobody asks for are dropped
+        advance ();
+        BEAST_EXPECT(find (btc));
+        advance ();
+        BEAST_EXPECT(indexed (usd));
+        advance ();
+        BEAST_EXPECT(! indexed (usd));
+        BEAST_EXPECT(indexed (btc));
+        advance ();
+        BEAST_EXPECT(published.current ()->size () == 0);
+    }
+
+public:
+    void
+    run ()
+    {
+        testIncremental ();
+        testEviction ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(BookIndex,app,ripple);
+
+} // test
+} // ripple
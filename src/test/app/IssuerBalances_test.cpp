@@ -0,0 +1,168 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/app/ledger/IssuerBalances.h>
+#include <ripple/protocol/TxFlags.h>
+#include <test/jtx.h>
+
+namespace ripple {
+namespace test {
+
+class IssuerBalances_test : public beast::unit_test::suite
+{
+    static
+    bool
+    equal (IssuerBalances::Totals const& a, IssuerBalances::Totals const& b)
+    {
+        if (a.obligations ().size () != b.obligations ().size ())
+            return false;
+
+        for (auto ia = a.obligations ().begin (),
+            ib = b.obligations ().begin ();
+                ia != a.obligations ().end (); ++ia, ++ib)
+        {
+            if (ia->first != ib->first ||
+                ia->second.amount != ib->second.amount ||
+                ia->second.lines != ib->second.lines)
+            {
+                return false;
+            }
+        }
+
+        return a.frozen () == b.frozen () && a.assets () == b.assets ();
+    }
+
+    // The index must match a fresh read of the issuer's lines
+    void
+    expectIndexed (IssuerBalances const& index, ReadView const& ledger,
+        AccountID const& issuer)
+    {
+        auto const indexed = index.find (issuer);
+        if (! BEAST_EXPECT(indexed))
+            return;
+
+        auto const fresh = IssuerBalances::build (ledger, issuer);
+        BEAST_EXPECT(equal (*indexed, *fresh));
+    }
+
+    void
+    testIncremental ()
+    {
+        testcase ("incremental");
+
+        using namespace jtx;
+        Env env (*this);
+
+        auto const gw = Account ("gw");
+        auto const hot = Account ("hot");
+        auto const alice = Account ("alice");
+        auto const bob = Account ("bob");
+        auto const USD = gw["USD"];
+        auto const EUR = gw["EUR"];
+
+        env.fund (XRP(10000), gw, hot, alice, bob);
+        env.close ();
+        env.trust (USD(1000), hot, alice, bob);
+        env.trust (EUR(1000), alice);
+        env.close ();
+        env (pay (gw, hot, USD(500)));
+        env (pay (gw, alice, USD(100)));
+        env (pay (gw, alice, EUR(50)));
+        env.close ();
+
+        auto index = std::make_shared<IssuerBalances const> (
+            env.closed ()->info ());
+        index = index->insert (gw, IssuerBalances::build (*env.closed (), gw));
+        BEAST_EXPECT(index->size () == 1);
+
+        {
+            auto const& o = index->find (gw)->obligations ();
+            BEAST_EXPECT(o.size () == 2);
+            BEAST_EXPECT(o.at (USD.currency).amount == USD(600));
+            BEAST_EXPECT(o.at (USD.currency).lines == 2);
+            BEAST_EXPECT(o.at (EUR.currency).amount == EUR(50));
+        }
+
+        auto next = [&]()
+        {
+            env.close ();
+            index = index->advance (*env.closed (), env.journal);
+            BEAST_EXPECT(index->seq () == env.closed ()->info ().seq);
+            expectIndexed (*index, *env.closed (), gw);
+        };
+
+        // The same line changed twice in one ledger
+        env (pay (hot, bob, USD(200)));
+        env (pay (bob, alice, USD(50)));
+        next ();
+        BEAST_EXPECT(index->find (gw)->obligations ().at (
+            USD.currency).lines == 3);
+
+        // Freezing moves a line out of the obligations
+        env (trust (gw, alice["USD"](0), tfSetFreeze));
+        next ();
+        BEAST_EXPECT(index->find (gw)->frozen ().at (alice).at (
+            USD.currency) == USD(150));
+        env (trust (gw, alice["USD"](0), tfClearFreeze));
+        next ();
+        BEAST_EXPECT(index->find (gw)->frozen ().empty ());
+
+        // A positive balance is an asset of the issuer
+        env.trust (alice["BTC"](100), gw);
+        env (pay (alice, gw, alice["BTC"](20)));
+        next ();
+        BEAST_EXPECT(index->find (gw)->assets ().at (alice).size () == 1);
+
+        // Paying back everything and removing the line deletes it
+        env (pay (alice, gw, EUR(50)));
+        env (trust (alice, EUR(0)));
+        next ();
+        BEAST_EXPECT(index->find (gw)->obligations ().count (
+            EUR.currency) == 0);
+
+        // The saved form reads back the same
+        {
+            Serializer s;
+            index->find (gw)->serialize (s);
+            auto const copy = IssuerBalances::Totals::deserialize (
+                s.slice ());
+            if (BEAST_EXPECT(copy))
+                BEAST_EXPECT(equal (*copy, *index->find (gw)));
+        }
+
+        // A gap in the ledger sequence empties the index
+        env.close ();
+        env.close ();
+        index = index->advance (*env.closed (), env.journal);
+        BEAST_EXPECT(index->size () == 0);
+    }
+
+public:
+    void
+    run ()
+    {
+        testIncremental ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(IssuerBalances,app,ripple);
+
+} // test
+} // ripple
@@ -20,6 +20,8 @@
 #include <BeastConfig.h>
 #include <test/jtx.h>
 #include <test/jtx/Env.h>
+#include <ripple/app/ledger/LedgerMaster.h>
+#include <ripple/app/ledger/LedgerSnapshot.h>
 #include <ripple/beast/unit_test.h>
 #include <ripple/protocol/JsonFields.h>
 #include <ripple/protocol/SField.h>
@@ -35,6 +37,8 @@ class LedgerLoad_test : public beast::unit_test::suite
     Json::Value jvLedger_;
     Json::Value jvHashes_;
     boost::filesystem::path ledgerFile_;
+    boost::filesystem::path snapshotFile_;
+    uint256 snapshotHash_;
     boost::filesystem::path dbPath_;
 
     auto ledgerConfig(std::string const& ledger, Config::StartUpType type)
@@ -67,6 +71,7 @@ class LedgerLoad_test : public beast::unit_test::suite
             return;
 
         ledgerFile_ = dbPath_ / "ledgerdata.json";
+        snapshotFile_ = dbPath_ / "ledgerdata.snapshot";
 
         Env env {*this};
         Account prev;
@@ -102,6 +107,13 @@ class LedgerLoad_test : public beast::unit_test::suite
         std::ofstream o (ledgerFile_.string(), std::ios::out | std::ios::trunc);
         o << to_string(jvLedger_);
         o.close();
+
+        auto const closed = env.app().getLedgerMaster().getClosedLedger();
+        snapshotHash_ = closed->info().hash;
+        BEAST_EXPECT(writeLedgerSnapshot(
+            *closed, snapshotFile_.string(), env.journal));
+        BEAST_EXPECT(! boost::filesystem::exists(
+            snapshotFile_.string() + ".tmp"));
     }
 
     void
@@ -160,6 +172,82 @@ class LedgerLoad_test : public beast::unit_test::suite
         });
     }
 
+    void
+    testLoadSnapshot ()
+    {
+        testcase ("Load a ledger snapshot");
+        using namespace test::jtx;
+        using namespace boost::filesystem;
+
+        BEAST_EXPECT(isLedgerSnapshot(snapshotFile_.string()));
+        BEAST_EXPECT(! isLedgerSnapshot(ledgerFile_.string()));
+
+        auto const info = readLedgerSnapshotInfo(snapshotFile_.string());
+        if (BEAST_EXPECT(info))
+            BEAST_EXPECT(info->hash == snapshotHash_);
+
+        {
+            // a snapshot is accepted wherever a ledger file is
+            Env env(*this, ledgerConfig(
+                snapshotFile_.string(), Config::LOAD_FILE));
+            auto const closed =
+                env.app().getLedgerMaster().getClosedLedger();
+            BEAST_EXPECT(closed->info().hash == snapshotHash_);
+            auto jrb = env.rpc ( "ledger", "current", "full") [jss::result];
+            BEAST_EXPECT(
+                jvLedger_[jss::ledger][jss::accountState].size() ==
+                jrb[jss::ledger][jss::accountState].size());
+        }
+
+        Env env {*this};
+        auto load = [&](boost::filesystem::path const& p)
+        {
+            return loadLedgerSnapshot(p.string(), env.app().config(),
+                env.app().family(), env.journal);
+        };
+
+        auto ledger = load(snapshotFile_);
+        if (BEAST_EXPECT(ledger))
+            BEAST_EXPECT(ledger->info().hash == snapshotHash_);
+
+        boost::system::error_code ec;
+        auto const size = file_size(snapshotFile_, ec);
+        if(! BEAST_EXPECTS(!ec, ec.message()))
+            return;
+
+        // truncated
+        auto const truncated = dbPath_ / "truncated.snapshot";
+        copy_file(snapshotFile_, truncated,
+            copy_option::overwrite_if_exists, ec);
+        if(! BEAST_EXPECTS(!ec, ec.message()))
+            return;
+        resize_file(truncated, size - 10, ec);
+        if(! BEAST_EXPECTS(!ec, ec.message()))
+            return;
+        BEAST_EXPECT(! load(truncated));
+
+        // one byte changed in the middle of the state items
+        auto const damaged = dbPath_ / "damaged.snapshot";
+        copy_file(snapshotFile_, damaged,
+            copy_option::overwrite_if_exists, ec);
+        if(! BEAST_EXPECTS(!ec, ec.message()))
+            return;
+        {
+            std::fstream f (damaged.string(),
+                std::ios::in | std::ios::out | std::ios::binary);
+            f.seekg(size / 2);
+            char c = f.get();
+            f.seekp(size / 2);
+            f.put(c ^ 0x20);
+        }
+        BEAST_EXPECT(! load(damaged));
+
+        except ([this, &truncated]
+        {
+            Env env(*this, ledgerConfig(truncated.string(), Config::LOAD_FILE));
+        });
+    }
+
     void
     testLoadByHash ()
     {
@@ -218,6 +306,7 @@ public:
         // test cases
         testLoad ();
         testBadFiles ();
+        testLoadSnapshot ();
         testLoadByHash ();
         testLoadLatest ();
         testLoadIndex ();
@@ -24,6 +24,7 @@
 #include <ripple/app/tx/apply.h>
 #include <ripple/basics/Log.h>
 #include <ripple/basics/mulDiv.h>
+#include <ripple/beast/core/LexicalCast.h>
 #include <test/jtx/TestSuite.h>
 #include <ripple/protocol/ErrorCodes.h>
 #include <ripple/protocol/Feature.h>
@@ -2665,5 +2666,126 @@ public:
 
 BEAST_DEFINE_TESTSUITE(TxQ,app,ripple);
 
+//------------------------------------------------------------------------------
+
+/*  Times TxQ::accept when the queue is full of transactions
+    from many different accounts. Run manually, eg:
+
+        rippled --unittest=TxQBench --unittest-arg=2000
+
+    where the argument is the number of accounts to fund.
+*/
+class TxQBench_test : public beast::unit_test::suite
+{
+    using clock_type = std::chrono::steady_clock;
+
+    static
+    std::unique_ptr<Config>
+    makeConfig(std::size_t perLedger)
+    {
+        auto p = std::make_unique<Config>();
+        setupConfigForUnitTests(*p);
+        auto& section = p->section("transaction_queue");
+        auto const expected = std::to_string(perLedger);
+        section.set("minimum_txn_in_ledger_standalone", expected);
+        section.set("target_txn_in_ledger", expected);
+        section.set("maximum_txn_in_ledger", expected);
+        section.set("ledgers_in_queue", "20");
+        return p;
+    }
+
+public:
+    void
+    run() override
+    {
+        using namespace jtx;
+        using namespace std::chrono;
+
+        std::size_t numAccounts = 2000;
+        if (! arg().empty())
+            numAccounts = beast::lexicalCastThrow<std::size_t>(arg());
+        std::size_t const perLedger = 100;
+
+        Env env(*this, makeConfig(perLedger),
+            features(featureFeeEscalation));
+        auto& txq = env.app().getTxQ();
+
+        std::vector<Account> accounts;
+        accounts.reserve(numAccounts);
+        for (std::size_t i = 0; i < numAccounts; ++i)
+        {
+            accounts.emplace_back("bench" + std::to_string(i));
+            env.fund(XRP(1000), noripple(accounts.back()));
+            // Stay below the escalation threshold while funding
+            if ((i + 1) % (perLedger - 1) == 0)
+                env.close();
+        }
+        env.close();
+        env.close();
+
+        auto metrics = txq.getMetrics(env.app().config(), *env.current());
+        if (! BEAST_EXPECT(metrics && metrics->txQMaxSize))
+            return;
+        log << "accounts: " << numAccounts <<
+            ", queue max size: " << *metrics->txQMaxSize << std::endl;
+
+        // Fill the open ledger and then the queue with a spread
+        // of fee levels, a few transactions per account. Queued
+        // transactions don't advance the account's sequence in the
+        // open ledger, so track it here.
+        std::vector<std::uint32_t> seqs;
+        seqs.reserve(numAccounts);
+        for (auto const& account : accounts)
+            seqs.push_back(env.seq(account));
+
+        std::size_t submitted = 0;
+        for (std::size_t round = 0; round < 5; ++round)
+        {
+            for (std::size_t i = 0; i < numAccounts; ++i)
+            {
+                env(noop(accounts[i]), seq(seqs[i]),
+                    fee(11 + (i * 7 + round) % 200), ter(std::ignore));
+                if (env.ter() == tesSUCCESS || env.ter() == terQUEUED)
+                    ++seqs[i];
+                ++submitted;
+            }
+        }
+
+        std::size_t queuedAccounts = 0;
+        std::size_t chained = 0;
+        for (auto const& account : accounts)
+        {
+            auto const txs = txq.getAccountTxs(account.id(),
+                env.app().config(), *env.current());
+            if (! txs)
+                continue;
+            ++queuedAccounts;
+            if (txs->size() > 1)
+                ++chained;
+        }
+
+        metrics = txq.getMetrics(env.app().config(), *env.current());
+        log << "submitted: " << submitted <<
+            ", queued: " << metrics->txCount <<
+            " from " << queuedAccounts << " accounts" <<
+            ", " << chained << " with more than one" << std::endl;
+        // The queue must hold chains of transactions per account
+        BEAST_EXPECT(chained > 0);
+        BEAST_EXPECT(metrics->txCount > queuedAccounts);
+
+        auto const start = clock_type::now();
+        env.close();
+        auto const elapsed = duration_cast<milliseconds>(
+            clock_type::now() - start);
+
+        metrics = txq.getMetrics(env.app().config(), *env.current());
+        log << "close and accept: " << elapsed.count() << "ms" <<
+            ", applied: " << metrics->txInLedger <<
+            ", still queued: " << metrics->txCount << std::endl;
+    }
+};
+
+BEAST_DEFINE_TESTSUITE_MANUAL(TxQBench,app,ripple);
+
 }
 }
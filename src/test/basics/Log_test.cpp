@@ -0,0 +1,222 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/basics/BasicConfig.h>
+#include <ripple/basics/Log.h>
+#include <ripple/beast/unit_test.h>
+#include <boost/filesystem.hpp>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ripple {
+
+class Log_test : public beast::unit_test::suite
+{
+    boost::filesystem::path
+    tempFile ()
+    {
+        return boost::filesystem::temp_directory_path () /
+            boost::filesystem::unique_path ("%%%%-%%%%-%%%%-%%%%.log");
+    }
+
+    static
+    std::vector<std::string>
+    readLines (boost::filesystem::path const& path)
+    {
+        std::vector<std::string> lines;
+        std::ifstream in (path.string ());
+        std::string line;
+        while (std::getline (in, line))
+            lines.push_back (line);
+        return lines;
+    }
+
+    // Returns the thread and index in a line written by logLines
+    static
+    std::pair<int, int>
+    parse (std::string const& line)
+    {
+        auto const pos = line.rfind ("line ");
+        if (pos == std::string::npos)
+            return {-1, -1};
+        int thread = -1;
+        int n = -1;
+        std::sscanf (line.c_str () + pos, "line %d %d", &thread, &n);
+        return {thread, n};
+    }
+
+    static
+    void
+    logLines (Logs& logs, int threads, int count)
+    {
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t)
+        {
+            workers.emplace_back ([&logs, t, count]
+            {
+                for (int i = 0; i < count; ++i)
+                    logs.write (beast::severities::kWarning, "Test",
+                        "line " + std::to_string (t) + " " +
+                            std::to_string (i), false);
+            });
+        }
+        for (auto& w : workers)
+            w.join ();
+    }
+
+    void
+    testBlock ()
+    {
+        testcase ("block when full");
+
+        auto const path = tempFile ();
+        {
+            Logs logs (beast::severities::kTrace);
+            logs.silent (true);
+            BEAST_EXPECT(logs.open (path));
+
+            Logs::AsyncSetup setup;
+            setup.size = 16;
+            setup.block = true;
+            logs.startAsync (setup);
+
+            logLines (logs, 4, 2000);
+            logs.flush ();
+
+            auto const counts = logs.asyncCounts ();
+            BEAST_EXPECT(counts.written == 8000);
+            BEAST_EXPECT(counts.dropped == 0);
+
+            // Each thread's lines are in the order they were logged
+            auto const lines = readLines (path);
+            BEAST_EXPECT(lines.size () == 8000);
+            std::vector<int> next (4, 0);
+            bool ordered = true;
+            for (auto const& line : lines)
+            {
+                auto const p = parse (line);
+                if (p.first < 0 || p.first >= 4 || p.second != next[p.first]++)
+                    ordered = false;
+            }
+            BEAST_EXPECT(ordered);
+        }
+        boost::system::error_code ec;
+        boost::filesystem::remove (path, ec);
+    }
+
+    void
+    testDrop ()
+    {
+        testcase ("drop when full");
+
+        auto const path = tempFile ();
+        {
+            Logs logs (beast::severities::kTrace);
+            logs.silent (true);
+            BEAST_EXPECT(logs.open (path));
+
+            Logs::AsyncSetup setup;
+            setup.size = 4;
+            logs.startAsync (setup);
+
+            logLines (logs, 2, 5000);
+            logs.flush ();
+
+            auto const counts = logs.asyncCounts ();
+            BEAST_EXPECT(counts.written + counts.dropped == 10000);
+            BEAST_EXPECT(counts.blocked == 0);
+            BEAST_EXPECT(readLines (path).size () == counts.written);
+        }
+        boost::system::error_code ec;
+        boost::filesystem::remove (path, ec);
+    }
+
+    void
+    testFatal ()
+    {
+        testcase ("flush on fatal");
+
+        auto const path = tempFile ();
+        {
+            Logs logs (beast::severities::kTrace);
+            logs.silent (true);
+            BEAST_EXPECT(logs.open (path));
+
+            Logs::AsyncSetup setup;
+            setup.size = 1024;
+            logs.startAsync (setup);
+
+            logs.write (beast::severities::kInfo, "Test", "before", false);
+            logs.write (beast::severities::kFatal, "Test", "fatal", false);
+
+            // Both lines are in the file without waiting for the writer
+            auto const lines = readLines (path);
+            if (BEAST_EXPECT(lines.size () == 2))
+            {
+                BEAST_EXPECT(lines[0].find ("before") != std::string::npos);
+                BEAST_EXPECT(lines[1].find ("FTL fatal") != std::string::npos);
+            }
+        }
+        boost::system::error_code ec;
+        boost::filesystem::remove (path, ec);
+    }
+
+    void
+    testSetup ()
+    {
+        testcase ("setup");
+
+        {
+            Section s ("log_queue");
+            auto const setup = setup_LogsAsync (s);
+            BEAST_EXPECT(setup.size == 0);
+            BEAST_EXPECT(! setup.block);
+        }
+        {
+            Section s ("log_queue");
+            s.set ("size", "4096");
+            s.set ("overflow", "block");
+            auto const setup = setup_LogsAsync (s);
+            BEAST_EXPECT(setup.size == 4096);
+            BEAST_EXPECT(setup.block);
+        }
+        {
+            Section s ("log_queue");
+            s.set ("overflow", "sometimes");
+            except ([&s] { setup_LogsAsync (s); });
+        }
+    }
+
+public:
+    void run ()
+    {
+        testBlock ();
+        testDrop ();
+        testFatal ();
+        testSetup ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(Log,basics,ripple);
+
+} // ripple
@@ -0,0 +1,131 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/basics/SlabAllocator.h>
+#include <ripple/beast/unit_test.h>
+#include <algorithm>
+#include <cstring>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace ripple {
+
+class SlabAllocator_test : public beast::unit_test::suite
+{
+public:
+    void testAllocator ()
+    {
+        testcase ("allocator");
+
+        // Sizes are rounded up so every block is aligned
+        SlabAllocator a (20, 1000);
+        BEAST_EXPECT(a.size () >= 20);
+        BEAST_EXPECT(a.size () % alignof (std::max_align_t) == 0);
+        BEAST_EXPECT(a.reserved () == 0);
+
+        std::set<void*> blocks;
+        for (int i = 0; i < 200; ++i)
+        {
+            auto const p = a.allocate ();
+            BEAST_EXPECT(reinterpret_cast<std::uintptr_t> (p) %
+                alignof (std::max_align_t) == 0);
+            std::memset (p, i, a.size ());
+            BEAST_EXPECT(blocks.insert (p).second);
+        }
+        auto const reserved = a.reserved ();
+        BEAST_EXPECT(reserved >= 200 * a.size ());
+
+        // Released blocks are reused before any new slab is made
+        for (auto const p : blocks)
+            a.deallocate (p);
+        for (int i = 0; i < 200; ++i)
+            BEAST_EXPECT(blocks.count (a.allocate ()) == 1);
+        BEAST_EXPECT(a.reserved () == reserved);
+    }
+
+    void testSet ()
+    {
+        testcase ("set");
+
+        SlabAllocatorSet set ({ 256, 64, 128 }, 4096);
+
+        // Small requests come from a slab, large ones from the heap
+        auto const small = set.allocate (50);
+        BEAST_EXPECT(set.reserved () == 4096 / 64 * 64);
+        auto const medium = set.allocate (200);
+        BEAST_EXPECT(set.reserved () == 2 * 4096 / 64 * 64);
+        auto const large = set.allocate (1000);
+        BEAST_EXPECT(set.reserved () == 2 * 4096 / 64 * 64);
+
+        std::memset (large, 0, 1000);
+        set.deallocate (large, 1000);
+        set.deallocate (medium, 200);
+        set.deallocate (small, 50);
+
+        // The same size class hands back the same block
+        BEAST_EXPECT(set.allocate (60) == small);
+        BEAST_EXPECT(set.allocate (129) == medium);
+    }
+
+    void testThreads ()
+    {
+        testcase ("threads");
+
+        SlabAllocatorSet set ({ 64, 128 }, 64 * 1024);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t)
+        {
+            threads.emplace_back ([&set, t]()
+            {
+                std::vector<std::uint8_t*> blocks;
+                for (int round = 0; round < 50; ++round)
+                {
+                    for (int i = 0; i < 100; ++i)
+                    {
+                        auto const p = static_cast<std::uint8_t*> (
+                            set.allocate (100));
+                        std::fill_n (p, 100, static_cast<std::uint8_t> (t));
+                        blocks.push_back (p);
+                    }
+                    for (auto const p : blocks)
+                        set.deallocate (p, 100);
+                    blocks.clear ();
+                }
+            });
+        }
+        for (auto& thread : threads)
+            thread.join ();
+
+        // Each thread holds at most 100 blocks at a time
+        BEAST_EXPECT(set.reserved () <= 64 * 1024 * 4);
+    }
+
+    void run ()
+    {
+        testAllocator ();
+        testSet ();
+        testThreads ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(SlabAllocator,basics,ripple);
+
+} // ripple
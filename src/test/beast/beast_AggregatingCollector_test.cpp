@@ -0,0 +1,235 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of Beast: https://github.com/vinniefalco/Beast
+    Copyright 2013, Vinnie Falco <vinnie.falco@gmail.com>
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <ripple/beast/insight/AggregatingCollector.h>
+#include <ripple/beast/unit_test.h>
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/ip/udp.hpp>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace beast {
+namespace insight {
+
+class AggregatingCollector_test : public unit_test::suite
+{
+public:
+    class TestSink : public AggregatingCollector::Sink
+    {
+    private:
+        std::mutex m_mutex;
+        std::string m_data;
+
+    public:
+        void
+        write (std::string const& lines) override
+        {
+            std::lock_guard <std::mutex> lock (m_mutex);
+            m_data += lines;
+        }
+
+        std::string
+        take ()
+        {
+            std::lock_guard <std::mutex> lock (m_mutex);
+            std::string result;
+            std::swap (result, m_data);
+            return result;
+        }
+    };
+
+    // Forwards to a sink which outlives the collector
+    class ForwardSink : public AggregatingCollector::Sink
+    {
+    private:
+        TestSink& m_sink;
+
+    public:
+        explicit
+        ForwardSink (TestSink& sink)
+            : m_sink (sink)
+        {
+        }
+
+        void
+        write (std::string const& lines) override
+        {
+            m_sink.write (lines);
+        }
+    };
+
+    static
+    bool
+    contains (std::string const& data, std::string const& line)
+    {
+        return data.find (line + "\n") != std::string::npos;
+    }
+
+    void
+    testAggregation ()
+    {
+        testcase ("aggregation");
+
+        auto sink = std::make_unique <TestSink> ();
+        auto& out = *sink;
+        // Use a long interval so that only explicit flushes report
+        auto const collector = AggregatingCollector::New (std::move (sink),
+            "test", std::chrono::hours (1), Journal ());
+
+        {
+            auto counter = collector->make_counter ("counter");
+            auto meter = collector->make_meter ("meter");
+            auto gauge = collector->make_gauge ("gauge");
+            auto event = collector->make_event ("event");
+
+            std::vector <std::thread> threads;
+            for (int t = 0; t < 4; ++t)
+            {
+                threads.emplace_back ([&]
+                {
+                    for (int i = 1; i <= 1000; ++i)
+                    {
+                        counter.increment (1);
+                        meter.increment (2);
+                        event.notify (std::chrono::milliseconds (i));
+                    }
+                });
+            }
+            for (auto& thread : threads)
+                thread.join ();
+            gauge.set (42);
+
+            collector->flush ();
+            auto const data = out.take ();
+            BEAST_EXPECT(contains (data, "test.counter:4000|c"));
+            BEAST_EXPECT(contains (data, "test.meter:8000|m"));
+            BEAST_EXPECT(contains (data, "test.gauge:42|g"));
+            BEAST_EXPECT(contains (data, "test.event.count:4000|c"));
+            BEAST_EXPECT(contains (data, "test.event.max:1000|g"));
+            // Buckets are at most 12.5% wide
+            BEAST_EXPECT(contains (data, "test.event.p50:511|g"));
+            // Capped at the maximum seen
+            BEAST_EXPECT(contains (data, "test.event.p99:1000|g"));
+
+            // Nothing changed, so nothing is reported
+            collector->flush ();
+            BEAST_EXPECT(out.take ().empty ());
+
+            gauge.increment (-50);
+            collector->flush ();
+            BEAST_EXPECT(out.take () == "test.gauge:0|g\n");
+        }
+    }
+
+    void
+    testHook ()
+    {
+        testcase ("hook");
+
+        auto sink = std::make_unique <TestSink> ();
+        auto& out = *sink;
+        auto const collector = AggregatingCollector::New (std::move (sink),
+            "test", std::chrono::hours (1), Journal ());
+
+        int calls = 0;
+        auto gauge = collector->make_gauge ("polled");
+        auto hook = collector->make_hook ([&]
+            {
+                ++calls;
+                gauge.set (calls);
+            });
+        collector->flush ();
+        collector->flush ();
+        BEAST_EXPECT(calls == 2);
+        // The hook runs before the gauge is reported
+        BEAST_EXPECT(contains (out.take (), "test.polled:2|g"));
+    }
+
+    void
+    testDestroy ()
+    {
+        testcase ("destroy");
+
+        TestSink out;
+        {
+            // Not positive, so the default interval is used instead of
+            // flushing continuously
+            auto const collector = AggregatingCollector::New (
+                std::make_unique <ForwardSink> (out), "test",
+                    std::chrono::milliseconds (0), Journal ());
+            auto counter = collector->make_counter ("counter");
+            auto gauge = collector->make_gauge ("gauge");
+            counter.increment (3);
+            gauge.set (7);
+        }
+        // The final values are written when the collector goes away
+        auto const data = out.take ();
+        BEAST_EXPECT(contains (data, "test.counter:3|c"));
+        BEAST_EXPECT(contains (data, "test.gauge:7|g"));
+    }
+
+    void
+    testUDPSink ()
+    {
+        testcase ("udp sink");
+
+        boost::asio::io_service io_service;
+        boost::asio::ip::udp::socket socket (io_service,
+            boost::asio::ip::udp::endpoint (
+                boost::asio::ip::address_v4::loopback (), 0));
+        auto const port = socket.local_endpoint ().port ();
+
+        auto sink = make_UDPSink (IP::Endpoint (
+            IP::AddressV4 (127, 0, 0, 1), port), Journal ());
+
+        // More than one packet's worth of lines
+        std::string lines;
+        for (int i = 0; i < 100; ++i)
+            lines += "test.counter" + std::to_string (i) + ":1|c\n";
+        sink->write (lines);
+
+        std::string received;
+        std::vector <char> buffer (2048);
+        int packets = 0;
+        while (received.size () < lines.size ())
+        {
+            auto const n = socket.receive (boost::asio::buffer (buffer));
+            BEAST_EXPECT(n <= 1472);
+            received.append (buffer.data (), n);
+            ++packets;
+        }
+        BEAST_EXPECT(received == lines);
+        BEAST_EXPECT(packets > 1);
+    }
+
+    void
+    run () override
+    {
+        testAggregation ();
+        testHook ();
+        testDestroy ();
+        testUDPSink ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(AggregatingCollector,insight,beast);
+
+} // insight
+} // beast
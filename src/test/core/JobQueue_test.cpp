@@ -0,0 +1,430 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/core/JobQueue.h>
+#include <ripple/core/impl/JobSet.h>
+#include <ripple/basics/Log.h>
+#include <ripple/beast/core/LexicalCast.h>
+#include <ripple/beast/insight/NullCollector.h>
+#include <ripple/beast/unit_test.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ripple {
+
+namespace test {
+
+// A JobQueue with its own root and logs
+class JobQueueFixture
+{
+    Logs logs_;
+    RootStoppable root_;
+
+public:
+    JobQueue jq;
+
+    JobQueueFixture (JobQueue::Setup const& setup, int threads)
+        : logs_ (beast::severities::kError)
+        , root_ ("JobQueueFixture")
+        , jq (beast::insight::NullCollector::New (), root_,
+            beast::Journal (), logs_, setup)
+    {
+        jq.setThreadCount (threads, false);
+        root_.start ();
+    }
+
+    ~JobQueueFixture ()
+    {
+        root_.stop (beast::Journal ());
+    }
+};
+
+static
+JobQueue::Setup
+makeSetup (JobQueue::Scheduler scheduler)
+{
+    JobQueue::Setup setup;
+    setup.scheduler = scheduler;
+    return setup;
+}
+
+static
+char const*
+to_string (JobQueue::Scheduler scheduler)
+{
+    return scheduler == JobQueue::Scheduler::locked
+        ? "locked" : "stealing";
+}
+
+}
+
+//------------------------------------------------------------------------------
+
+class JobQueue_test : public beast::unit_test::suite
+{
+public:
+    void
+    testLimits (JobQueue::Scheduler scheduler)
+    {
+        testcase (std::string ("limits ") + test::to_string (scheduler));
+
+        test::JobQueueFixture f (test::makeSetup (scheduler), 4);
+
+        JobType const types[] = { jtPACK, jtLEDGER_REQ, jtCLIENT, jtACCEPT };
+        std::map <JobType, std::atomic <int>> running;
+        std::map <JobType, std::atomic <int>> peak;
+        for (auto t : types)
+        {
+            running[t] = 0;
+            peak[t] = 0;
+        }
+        std::atomic <int> done (0);
+
+        int const producers = 4;
+        int const perProducer = 5000;
+
+        std::vector <std::thread> threads;
+        for (int p = 0; p < producers; ++p)
+        {
+            threads.emplace_back ([&, p]
+            {
+                for (int i = 0; i < perProducer; ++i)
+                {
+                    auto const t = types[(i + p) % 4];
+                    f.jq.addJob (t, "test", [&, t](Job&)
+                    {
+                        auto const n = ++running[t];
+                        auto prev = peak[t].load ();
+                        while (prev < n &&
+                                ! peak[t].compare_exchange_weak (prev, n))
+                            ;
+                        std::this_thread::yield ();
+                        --running[t];
+                        ++done;
+                    });
+                }
+            });
+        }
+        for (auto& t : threads)
+            t.join ();
+
+        f.jq.rendezvous ();
+        BEAST_EXPECT (done == producers * perProducer);
+        BEAST_EXPECT (peak[jtPACK] == 1);
+        BEAST_EXPECT (peak[jtLEDGER_REQ] >= 1 && peak[jtLEDGER_REQ] <= 2);
+        BEAST_EXPECT (f.jq.getJobCountTotal (jtPACK) == 0);
+    }
+
+    void
+    testPriority (JobQueue::Scheduler scheduler)
+    {
+        testcase (std::string ("priority ") + test::to_string (scheduler));
+
+        test::JobQueueFixture f (test::makeSetup (scheduler), 1);
+
+        std::mutex m;
+        std::condition_variable cv;
+        bool started = false;
+        bool release = false;
+        std::vector <int> order;
+
+        // Occupy the only thread while the other jobs are queued
+        f.jq.addJob (jtCLIENT, "block", [&](Job&)
+        {
+            std::unique_lock <std::mutex> lock (m);
+            started = true;
+            cv.notify_all ();
+            cv.wait (lock, [&]{ return release; });
+        });
+        {
+            std::unique_lock <std::mutex> lock (m);
+            cv.wait (lock, [&]{ return started; });
+        }
+
+        for (int i = 0; i < 3; ++i)
+            f.jq.addJob (jtCLIENT, "low",
+                [&, i](Job&){ order.push_back (i); });
+        for (int i = 0; i < 3; ++i)
+            f.jq.addJob (jtACCEPT, "high",
+                [&, i](Job&){ order.push_back (10 + i); });
+
+        BEAST_EXPECT (f.jq.getJobCount (jtCLIENT) == 3);
+        BEAST_EXPECT (f.jq.getJobCountGE (jtCLIENT) == 6);
+
+        {
+            std::lock_guard <std::mutex> lock (m);
+            release = true;
+        }
+        cv.notify_all ();
+        f.jq.rendezvous ();
+
+        BEAST_EXPECT (order == std::vector <int> ({10, 11, 12, 0, 1, 2}));
+    }
+
+    void
+    testJobSet (std::unique_ptr <JobSet> set, char const* name)
+    {
+        testcase (std::string ("job set ") + name);
+
+        using namespace std::chrono_literals;
+
+        // jtRPC has no latency target
+        LoadMonitor lm {beast::Journal ()};
+        std::uint64_t index = 0;
+        auto push = [&](std::string const& name)
+        {
+            set->push (Job (jtRPC, name, ++index, lm, [](Job&) {}, nullptr));
+        };
+
+        // A pop reserved ahead of its push waits for it
+        {
+            std::thread t ([&]
+                {
+                    std::this_thread::sleep_for (20ms);
+                    push ("late");
+                });
+            BEAST_EXPECT (set->pop (jtRPC).getName () == "late");
+            t.join ();
+        }
+
+        // A job queued by another thread, which has waited longer than
+        // the bound for its type, goes ahead of a newer one
+        {
+            std::thread t ([&] { push ("old"); });
+            t.join ();
+            std::this_thread::sleep_for (50ms);
+            push ("new");
+            BEAST_EXPECT (set->pop (jtRPC).getName () == "old");
+            BEAST_EXPECT (set->pop (jtRPC).getName () == "new");
+        }
+    }
+
+    void
+    testSetup ()
+    {
+        testcase ("setup");
+
+        Section s ("job_queue");
+        {
+            auto const setup = setup_JobQueue (s);
+            BEAST_EXPECT (setup.scheduler == JobQueue::Scheduler::locked);
+            BEAST_EXPECT (setup.coroStackSize == 1024 * 1024);
+        }
+        s.set ("scheduler", "stealing");
+        s.set ("coro_stack_size", "128");
+        s.set ("coro_stack_cache", "16");
+        {
+            auto const setup = setup_JobQueue (s);
+            BEAST_EXPECT (setup.scheduler == JobQueue::Scheduler::stealing);
+            BEAST_EXPECT (setup.coroStackSize == 128 * 1024);
+            BEAST_EXPECT (setup.coroStackCache == 16);
+        }
+
+        auto invalid = [&](char const* key, char const* value)
+        {
+            Section bad ("job_queue");
+            bad.set (key, value);
+            try
+            {
+                setup_JobQueue (bad);
+                fail ();
+            }
+            catch (std::runtime_error const&)
+            {
+                pass ();
+            }
+        };
+        invalid ("scheduler", "fifo");
+        invalid ("coro_stack_size", "16");
+    }
+
+    void
+    testCoroStacks ()
+    {
+        testcase ("coroutine stacks");
+
+        JobQueue::Setup setup;
+        setup.coroStackSize = 128 * 1024;
+        setup.coroStackCache = 4;
+        test::JobQueueFixture f (setup, 2);
+        auto const& stacks = f.jq.getCoroStacks ();
+
+        // Each round runs more coroutines than the cache holds, each
+        // yielding once, and the later rounds reuse cached stacks.
+        int const rounds = 3;
+        int const perRound = 8;
+        std::atomic <int> done (0);
+        for (int r = 0; r < rounds; ++r)
+        {
+            for (int i = 0; i < perRound; ++i)
+            {
+                f.jq.postCoro (jtCLIENT, "test",
+                    [&](std::shared_ptr <JobQueue::Coro> const& c)
+                    {
+                        c->post ();
+                        c->yield ();
+                        ++done;
+                    });
+            }
+            f.jq.rendezvous ();
+        }
+
+        BEAST_EXPECT (done == rounds * perRound);
+        BEAST_EXPECT (stacks.cached () == 4);
+        BEAST_EXPECT (stacks.reused () > 0);
+        BEAST_EXPECT (stacks.allocated () + stacks.reused () ==
+            rounds * perRound);
+
+        // Every cached stack was used during the last round, so the first
+        // sweep keeps them, and the next one finds them idle.
+        f.jq.sweep ();
+        BEAST_EXPECT (stacks.cached () == 4);
+        f.jq.sweep ();
+        BEAST_EXPECT (stacks.cached () == 0);
+    }
+
+    void
+    run () override
+    {
+        for (auto s : { JobQueue::Scheduler::locked,
+                JobQueue::Scheduler::stealing })
+        {
+            testLimits (s);
+            testPriority (s);
+        }
+        testJobSet (make_LockedJobSet (), "locked");
+        testJobSet (make_StealingJobSet (JobTypes (), 4), "stealing");
+        testSetup ();
+        testCoroStacks ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(JobQueue,core,ripple);
+
+//------------------------------------------------------------------------------
+
+/*  Measures JobQueue throughput with many tiny jobs, and the cost of
+    creating, suspending and resuming many short lived coroutines.
+
+    The argument is the number of worker threads, which defaults to the
+    number of hardware threads. As many producer threads queue the jobs.
+*/
+class JobQueueBench_test : public beast::unit_test::suite
+{
+public:
+    void
+    bench (JobQueue::Scheduler scheduler, int threads, int jobs)
+    {
+        using namespace std::chrono;
+
+        test::JobQueueFixture f (test::makeSetup (scheduler), threads);
+        std::atomic <int> done (0);
+
+        int const perProducer = jobs / threads;
+        auto const start = steady_clock::now ();
+
+        std::vector <std::thread> producers;
+        for (int p = 0; p < threads; ++p)
+        {
+            producers.emplace_back ([&]
+            {
+                for (int i = 0; i < perProducer; ++i)
+                    f.jq.addJob (jtTRANSACTION, "bench",
+                        [&](Job&){ ++done; });
+            });
+        }
+        for (auto& t : producers)
+            t.join ();
+        f.jq.rendezvous ();
+
+        auto const elapsed = duration_cast <milliseconds> (
+            steady_clock::now () - start);
+        BEAST_EXPECT (done == perProducer * threads);
+
+        log << test::to_string (scheduler) << ": " << done << " jobs on " <<
+            threads << " threads in " << elapsed.count () << "ms (" <<
+            (done * 1000.0 / std::max <std::int64_t> (elapsed.count (), 1)) <<
+            " jobs/s)" << std::endl;
+    }
+
+    void
+    benchCoro (std::size_t cache, int threads, int coros)
+    {
+        using namespace std::chrono;
+
+        JobQueue::Setup setup;
+        setup.coroStackCache = cache;
+        test::JobQueueFixture f (setup, threads);
+        std::atomic <int> done (0);
+
+        auto const start = steady_clock::now ();
+
+        // Keep a bounded number in flight, like a busy RPC server
+        int const batch = 1000;
+        for (int n = 0; n < coros; n += batch)
+        {
+            for (int i = 0; i < batch; ++i)
+            {
+                f.jq.postCoro (jtCLIENT, "bench",
+                    [&](std::shared_ptr <JobQueue::Coro> const& c)
+                    {
+                        c->post ();
+                        c->yield ();
+                        ++done;
+                    });
+            }
+            f.jq.rendezvous ();
+        }
+
+        auto const elapsed = duration_cast <milliseconds> (
+            steady_clock::now () - start);
+        BEAST_EXPECT (done == coros);
+
+        auto const& stacks = f.jq.getCoroStacks ();
+        log << "coroutines, stack cache " << cache << ": " << done <<
+            " in " << elapsed.count () << "ms, " << stacks.allocated () <<
+            " stacks mapped, " << stacks.reused () << " reused" << std::endl;
+    }
+
+    void
+    run () override
+    {
+        int threads = std::max (1u, std::thread::hardware_concurrency ());
+        if (! arg ().empty ())
+            threads = beast::lexicalCastThrow <int> (arg ());
+        int const jobs = 2000000;
+        int const coros = 200000;
+
+        bench (JobQueue::Scheduler::locked, threads, jobs);
+        bench (JobQueue::Scheduler::stealing, threads, jobs);
+        benchCoro (0, threads, coros);
+        benchCoro (JobQueue::Setup{}.coroStackCache, threads, coros);
+        pass ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE_MANUAL(JobQueueBench,core,ripple);
+
+}
@@ -0,0 +1,150 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/core/JobTrace.h>
+#include <ripple/beast/unit_test.h>
+#include <limits>
+
+namespace ripple {
+
+class JobTrace_test : public beast::unit_test::suite
+{
+public:
+    using clock_type = JobTrace::clock_type;
+    using ms = std::chrono::milliseconds;
+    using us = std::chrono::microseconds;
+
+    void
+    testHistogram ()
+    {
+        testcase ("histogram");
+
+        using H = JobTrace::Histogram;
+
+        // Buckets are monotonic and each value falls within its bucket
+        std::size_t prev = 0;
+        for (std::uint64_t v = 0; v < 100000; v += 7)
+        {
+            auto const b = H::bucket (v);
+            BEAST_EXPECT (b >= prev);
+            BEAST_EXPECT (v <= H::highest (b));
+            if (b > 0)
+                BEAST_EXPECT (v > H::highest (b - 1));
+            prev = b;
+        }
+        BEAST_EXPECT (H::bucket (
+            std::numeric_limits <std::uint64_t>::max ()) ==
+                H::bucketCount - 1);
+
+        H h;
+        BEAST_EXPECT (h.count () == 0);
+        for (std::uint64_t v = 1; v <= 100; ++v)
+            h.record (v * 10);
+        BEAST_EXPECT (h.count () == 100);
+
+        // A snapshot leaves the samples in place
+        H::Counts counts;
+        auto const max = h.snapshot (counts);
+        BEAST_EXPECT (max == 1000);
+        BEAST_EXPECT (h.count () == 100);
+
+        // Reported percentiles are within one sub-bucket of the truth
+        auto const p50 = H::percentile (counts, 100, max, 50);
+        BEAST_EXPECT (p50 >= 500 && p50 < 500 * 9 / 8);
+        auto const p99 = H::percentile (counts, 100, max, 99);
+        BEAST_EXPECT (p99 >= 990 && p99 <= 1000);
+        BEAST_EXPECT (H::percentile (counts, 100, max, 100) == 1000);
+
+        h.clear ();
+        BEAST_EXPECT (h.count () == 0);
+        BEAST_EXPECT (h.snapshot (counts) == 0);
+    }
+
+    void
+    testSlowJobs ()
+    {
+        testcase ("slow jobs");
+
+        JobTypes types;
+        JobTrace trace (types, ms (100), 4);
+
+        auto const start = clock_type::now ();
+
+        // Fast jobs are only counted
+        trace.onJob (jtCLIENT, "fast", ms (1), start, start + ms (2));
+        BEAST_EXPECT (trace.getSlowJobs ().empty ());
+        BEAST_EXPECT (trace.waitHistogram (jtCLIENT).count () == 1);
+        BEAST_EXPECT (trace.runHistogram (jtCLIENT).count () == 1);
+        BEAST_EXPECT (trace.runHistogram (jtACCEPT).count () == 0);
+
+        // A long wait or a long run is slow
+        trace.onJob (jtWRITE, "starved", ms (150), start, start + ms (1));
+        trace.onJob (jtACCEPT, "accept", ms (1), start, start + ms (200));
+        {
+            auto const slow = trace.getSlowJobs ();
+            BEAST_EXPECT (slow.size () == 2);
+            BEAST_EXPECT (slow[0].name == "starved");
+            BEAST_EXPECT (slow[0].wait == us (150000));
+            BEAST_EXPECT (slow[1].type == jtACCEPT);
+            BEAST_EXPECT (slow[1].duration == us (200000));
+        }
+
+        // The ring keeps the most recent jobs, oldest first
+        for (int i = 0; i < 6; ++i)
+            trace.onJob (jtACCEPT, std::to_string (i), ms (0),
+                start, start + ms (100 + i));
+        {
+            auto const slow = trace.getSlowJobs ();
+            BEAST_EXPECT (slow.size () == 4);
+            BEAST_EXPECT (slow.front ().name == "2");
+            BEAST_EXPECT (slow.back ().name == "5");
+        }
+
+        auto const jv = trace.getJson ();
+        BEAST_EXPECT (jv["job_types"].size () == 3);
+        BEAST_EXPECT (jv["slow_jobs"].size () == 4);
+        BEAST_EXPECT (jv["slow_threshold_ms"].asUInt () == 100);
+        BEAST_EXPECT (jv["slow_jobs"][0u]["job_type"] == "acceptLedger");
+
+        auto const chrome = trace.getChromeTrace ();
+        BEAST_EXPECT (chrome["traceEvents"].size () == 4);
+        auto const& ev = chrome["traceEvents"][3u];
+        BEAST_EXPECT (ev["ph"] == "X");
+        BEAST_EXPECT (ev["name"] == "5");
+        BEAST_EXPECT (ev["cat"] == "acceptLedger");
+        BEAST_EXPECT (ev["dur"].asDouble () == 105000);
+
+        trace.clear ();
+        BEAST_EXPECT (trace.getSlowJobs ().empty ());
+        BEAST_EXPECT (trace.runHistogram (jtACCEPT).count () == 0);
+        BEAST_EXPECT (trace.getJson ()["job_types"].size () == 0);
+    }
+
+    void
+    run ()
+    {
+        testHistogram ();
+        testSlowJobs ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(JobTrace,core,ripple);
+
+}
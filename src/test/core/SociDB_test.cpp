@@ -20,6 +20,7 @@
 #include <BeastConfig.h>
 
 #include <ripple/core/ConfigSections.h>
+#include <ripple/core/DatabaseCon.h>
 #include <ripple/core/SociDB.h>
 #include <ripple/basics/contract.h>
 #include <test/jtx/TestSuite.h>
@@ -361,12 +362,85 @@ public:
         if (bfs::is_regular_file (dbPath))
             bfs::remove (dbPath);
     }
+    void testDatabaseConReaders ()
+    {
+        testcase ("readers");
+        DatabaseCon::Setup setup;
+        setup.dataDir = getDatabasePath ();
+        setup.readConnections = 2;
+        const char* dbInit[] = {
+            "PRAGMA journal_mode=WAL;",
+            "CREATE TABLE IF NOT EXISTS Ledgers (LedgerSeq INTEGER);"};
+        int dbInitCount = std::extent<decltype(dbInit)>::value;
+        {
+            DatabaseCon con (setup, "SociReadTest.db", dbInit, dbInitCount);
+            {
+                auto db = con.checkoutDb ();
+                *db << "INSERT INTO Ledgers (LedgerSeq) VALUES (7);";
+            }
+            {
+                // Readers are separate from each other and the writer
+                auto r1 = con.checkoutReadDb ();
+                auto r2 = con.checkoutReadDb ();
+                BEAST_EXPECT(r1.get () != r2.get ());
+                BEAST_EXPECT(r1.get () != &con.getSession ());
+
+                // Readers see the writer's committed data
+                int seq = 0;
+                *r1 << "SELECT LedgerSeq FROM Ledgers;", soci::into (seq);
+                BEAST_EXPECT(seq == 7);
+
+                // and cannot modify the database
+                bool threw = false;
+                try
+                {
+                    *r2 << "DELETE FROM Ledgers;";
+                }
+                catch (soci::soci_error const&)
+                {
+                    threw = true;
+                }
+                BEAST_EXPECT(threw);
+
+                // The writer is not blocked by the readers
+                auto db = con.checkoutDb ();
+                *db << "INSERT INTO Ledgers (LedgerSeq) VALUES (8);";
+            }
+            {
+                // Sessions are returned to the pool
+                auto r1 = con.checkoutReadDb ();
+                auto r2 = con.checkoutReadDb ();
+                int count = 0;
+                *r2 << "SELECT COUNT(*) FROM Ledgers;", soci::into (count);
+                BEAST_EXPECT(count == 2);
+            }
+            auto const stats = con.readStats ();
+            BEAST_EXPECT(stats.checkouts == 4);
+            BEAST_EXPECT(stats.waits == 0);
+        }
+        {
+            // Without a pool, readers use the writer's session
+            setup.readConnections = 0;
+            DatabaseCon con (setup, "SociReadTest.db", dbInit, dbInitCount);
+            auto r = con.checkoutReadDb ();
+            BEAST_EXPECT(r.get () == &con.getSession ());
+        }
+        namespace bfs = boost::filesystem;
+        for (auto const suffix : {"", "-wal", "-shm"})
+        {
+            bfs::path dbPath (getDatabasePath () /
+                (std::string ("SociReadTest.db") + suffix));
+            if (bfs::is_regular_file (dbPath))
+                bfs::remove (dbPath);
+        }
+    }
     void testSQLite ()
     {
         testSQLiteFileNames ();
         testSQLiteSession ();
         testSQLiteSelect ();
         testSQLiteDeleteWithSubselect();
+        testDatabaseConReaders ();
     }
     void run ()
     {
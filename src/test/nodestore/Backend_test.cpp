@@ -80,6 +80,23 @@ public:
                 fetchCopyOfBatch (*backend, &copy, batch);
                 BEAST_EXPECT(areBatchesEqual (batch, copy));
             }
+
+            if (backend->canFetchBatch ())
+            {
+                // Read it back in one call, with a missing key at the end
+                auto const missing = createPredictableBatch (1, rng());
+                std::vector <void const*> keys;
+                for (auto const& object : batch)
+                    keys.push_back (object->getHash ().begin ());
+                keys.push_back (missing.front ()->getHash ().begin ());
+
+                auto const fetched =
+                    backend->fetchBatch (keys.size (), keys.data ());
+                BEAST_EXPECT (fetched.size () == keys.size ());
+                BEAST_EXPECT (fetched.back () == nullptr);
+                Batch copy (fetched.begin (), fetched.end () - 1);
+                BEAST_EXPECT(areBatchesEqual (batch, copy));
+            }
         }
 
         {
@@ -0,0 +1,180 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <test/nodestore/TestBase.h>
+#include <ripple/nodestore/DummyScheduler.h>
+#include <ripple/nodestore/impl/BatchWriter.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ripple {
+namespace NodeStore {
+
+class BatchWriter_test : public TestBase
+{
+    // Runs each task on a thread of its own
+    class ThreadScheduler : public DummyScheduler
+    {
+    public:
+        ~ThreadScheduler ()
+        {
+            join ();
+        }
+
+        void
+        scheduleTask (Task& task) override
+        {
+            std::lock_guard<std::mutex> lock (mutex_);
+            threads_.emplace_back ([&task] { task.performScheduledTask (); });
+        }
+
+        void
+        join ()
+        {
+            for (;;)
+            {
+                std::vector<std::thread> threads;
+                {
+                    std::lock_guard<std::mutex> lock (mutex_);
+                    threads.swap (threads_);
+                }
+                if (threads.empty ())
+                    return;
+                for (auto& thread : threads)
+                    thread.join ();
+            }
+        }
+
+    private:
+        std::mutex mutex_;
+        std::vector<std::thread> threads_;
+    };
+
+    // Records what is written, taking time for each commit
+    class Recorder : public BatchWriter::Callback
+    {
+    public:
+        explicit Recorder (std::chrono::milliseconds delay)
+            : delay_ (delay)
+        {
+        }
+
+        void
+        writeBatch (Batch const& batch) override
+        {
+            ++committing_;
+            std::this_thread::sleep_for (delay_);
+            {
+                std::lock_guard<std::mutex> lock (mutex_);
+                written_.insert (written_.end (), batch.begin (), batch.end ());
+                ++commits_;
+            }
+            --committing_;
+        }
+
+        std::unique_ptr <BatchWriter::Prepared>
+        prepareBatch (Batch const& batch) override
+        {
+            if (committing_ != 0)
+                ++overlapped_;
+            return BatchWriter::Callback::prepareBatch (batch);
+        }
+
+        Batch
+        written ()
+        {
+            std::lock_guard<std::mutex> lock (mutex_);
+            return written_;
+        }
+
+        int commits () const { return commits_; }
+        int overlapped () const { return overlapped_; }
+
+    private:
+        std::chrono::milliseconds const delay_;
+        std::mutex mutex_;
+        Batch written_;
+        std::atomic<int> commits_ {0};
+        std::atomic<int> committing_ {0};
+        std::atomic<int> overlapped_ {0};
+    };
+
+public:
+    void
+    testSynchronous ()
+    {
+        testcase ("synchronous");
+
+        DummyScheduler scheduler;
+        Recorder recorder (std::chrono::milliseconds (0));
+        auto const batch = createPredictableBatch (100, 1);
+        {
+            BatchWriter writer (recorder, scheduler);
+            for (auto const& object : batch)
+                writer.store (object);
+            BEAST_EXPECT(writer.getWriteLoad () == 0);
+        }
+        BEAST_EXPECT(areBatchesEqual (batch, recorder.written ()));
+        BEAST_EXPECT(recorder.commits () == static_cast<int> (batch.size ()));
+    }
+
+    void
+    testPipelined ()
+    {
+        testcase ("pipelined");
+
+        ThreadScheduler scheduler;
+        Recorder recorder (std::chrono::milliseconds (20));
+        auto const batch = createPredictableBatch (2000, 2);
+        {
+            BatchWriter writer (recorder, scheduler);
+            for (auto const& object : batch)
+            {
+                writer.store (object);
+                BEAST_EXPECT(writer.getWriteLoad () > 0);
+                std::this_thread::sleep_for (std::chrono::microseconds (50));
+            }
+        }
+        scheduler.join ();
+
+        // Objects are written once, in the order they were stored
+        BEAST_EXPECT(areBatchesEqual (batch, recorder.written ()));
+
+        // Objects stored during a commit are grouped, and encoded
+        // while that commit is in progress
+        BEAST_EXPECT(recorder.commits () < static_cast<int> (batch.size ()) / 4);
+        BEAST_EXPECT(recorder.overlapped () > 0);
+    }
+
+    void
+    run () override
+    {
+        testSynchronous ();
+        testPipelined ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(BatchWriter,NodeStore,ripple);
+
+}
+}
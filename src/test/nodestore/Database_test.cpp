@@ -23,6 +23,7 @@
 #include <ripple/nodestore/Manager.h>
 #include <ripple/beast/utility/temp_dir.h>
 #include <algorithm>
+#include <chrono>
 
 namespace ripple {
 namespace NodeStore {
@@ -73,7 +74,7 @@ public:
                 "' from '" + srcBackendType + "'");
 
             // Do the import
-            dest->import (*src);
+            dest->import (*src, Importer::Setup {});
 
             // Get the results of the import
             fetchCopyOfBatch (*dest, &copy, batch);
@@ -136,6 +137,18 @@ public:
                 fetchCopyOfBatch (*db, &copy, batch);
                 BEAST_EXPECT(areBatchesEqual (batch, copy));
             }
+
+            {
+                // Read it back at a low priority with a deadline
+                auto const deadline = std::chrono::steady_clock::now () +
+                    std::chrono::seconds (10);
+                std::size_t found = 0;
+                for (auto const& object : batch)
+                    if (db->fetch (object->getHash (),
+                            FetchPriority::client, deadline))
+                        ++found;
+                BEAST_EXPECT(found == batch.size ());
+            }
         }
 
         if (testPersistence)
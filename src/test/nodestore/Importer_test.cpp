@@ -0,0 +1,351 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <test/nodestore/TestBase.h>
+#include <ripple/nodestore/DummyScheduler.h>
+#include <ripple/nodestore/Importer.h>
+#include <ripple/nodestore/Manager.h>
+#include <ripple/basics/Slice.h>
+#include <ripple/beast/utility/temp_dir.h>
+#include <ripple/protocol/digest.h>
+#include <nudb/nudb.hpp>
+#include <boost/filesystem.hpp>
+#include <chrono>
+#include <fstream>
+
+namespace ripple {
+namespace NodeStore {
+
+class Importer_test : public TestBase
+{
+public:
+    static
+    Section
+    makeParams (std::string const& type, std::string const& path)
+    {
+        Section params;
+        params.set ("type", type);
+        params.set ("path", path);
+        return params;
+    }
+
+    // The objects of a database, in the order they are visited
+    static
+    Batch
+    visit (Database& db)
+    {
+        Batch batch;
+        db.for_each ([&](std::shared_ptr<NodeObject> object)
+        {
+            batch.push_back (std::move (object));
+        });
+        return batch;
+    }
+
+    // The number of objects in a batch that a backend holds
+    static
+    std::size_t
+    countFound (Backend& backend, Batch const& batch)
+    {
+        std::size_t found = 0;
+        for (auto const& object : batch)
+        {
+            std::shared_ptr<NodeObject> copy;
+            if (backend.fetch (object->getHash ().cbegin (), &copy) == ok &&
+                    copy && isSame (copy, object))
+                ++found;
+        }
+        return found;
+    }
+
+    void
+    testImport ()
+    {
+        testcase ("import");
+
+        DummyScheduler scheduler;
+        beast::Journal j;
+        beast::temp_dir source_db;
+        beast::temp_dir dest_db;
+        auto const batch = createHashedBatch (2000, 1);
+
+        auto source = Manager::instance ().make_Database ("test",
+            scheduler, j, 2, makeParams ("nudb", source_db.path ()));
+        storeBatch (*source, batch);
+
+        auto dest = Manager::instance ().make_Backend (
+            makeParams ("nudb", dest_db.path ()), scheduler, j);
+
+        Importer::Setup setup;
+        setup.batchSize = 100;
+        setup.queueDepth = 2;
+        setup.verify = true;
+        auto const stats = Importer (setup, j).run (*source, *dest);
+
+        BEAST_EXPECT(stats.read == batch.size ());
+        BEAST_EXPECT(stats.written == batch.size ());
+        BEAST_EXPECT(stats.skipped == 0);
+        BEAST_EXPECT(stats.corrupt == 0);
+
+        Batch copy;
+        fetchCopyOfBatch (*dest, &copy, batch);
+        BEAST_EXPECT(areBatchesEqual (batch, copy));
+    }
+
+    void
+    testVerify ()
+    {
+        testcase ("verify");
+
+        DummyScheduler scheduler;
+        beast::Journal j;
+        auto const good = createHashedBatch (500, 2);
+
+        // Keys that are not the hash of the data
+        auto const bad = createPredictableBatch (5, 3);
+
+        auto source = Manager::instance ().make_Database ("test",
+            scheduler, j, 2, makeParams ("memory", "importer_verify_source"));
+        storeBatch (*source, good);
+        storeBatch (*source, bad);
+
+        auto dest = Manager::instance ().make_Backend (
+            makeParams ("memory", "importer_verify_dest"), scheduler, j);
+
+        Importer::Setup setup;
+        setup.batchSize = 64;
+        setup.verify = true;
+        auto const stats = Importer (setup, j).run (*source, *dest);
+
+        BEAST_EXPECT(stats.read == good.size () + bad.size ());
+        BEAST_EXPECT(stats.written == good.size ());
+        BEAST_EXPECT(stats.corrupt == bad.size ());
+
+        BEAST_EXPECT(countFound (*dest, good) == good.size ());
+        BEAST_EXPECT(countFound (*dest, bad) == 0);
+    }
+
+    void
+    testResume ()
+    {
+        testcase ("resume");
+
+        DummyScheduler scheduler;
+        beast::Journal j;
+        beast::temp_dir dir;
+        auto const batch = createHashedBatch (1000, 4);
+
+        auto source = Manager::instance ().make_Database ("test",
+            scheduler, j, 2, makeParams ("memory", "importer_resume_source"));
+        storeBatch (*source, batch);
+        auto const order = visit (*source);
+
+        Importer::Setup setup;
+        setup.batchSize = 50;
+        setup.checkpoint = dir.file ("checkpoint");
+
+        // An earlier import of this source handled 300 objects
+        {
+            std::ofstream out (setup.checkpoint);
+            out << source->getName () << '\n' << 300 << '\n';
+        }
+
+        {
+            auto dest = Manager::instance ().make_Backend (makeParams (
+                "memory", "importer_resume_dest1"), scheduler, j);
+            auto const stats = Importer (setup, j).run (*source, *dest);
+
+            BEAST_EXPECT(stats.skipped == 300);
+            BEAST_EXPECT(stats.written == batch.size () - 300);
+            BEAST_EXPECT(! boost::filesystem::exists (setup.checkpoint));
+
+            BEAST_EXPECT(countFound (*dest,
+                Batch (order.begin (), order.begin () + 300)) == 0);
+            BEAST_EXPECT(countFound (*dest,
+                Batch (order.begin () + 300, order.end ())) ==
+                    batch.size () - 300);
+        }
+
+        // A checkpoint for another source is ignored
+        {
+            std::ofstream out (setup.checkpoint);
+            out << "elsewhere" << '\n' << 300 << '\n';
+        }
+
+        {
+            auto dest = Manager::instance ().make_Backend (makeParams (
+                "memory", "importer_resume_dest2"), scheduler, j);
+            auto const stats = Importer (setup, j).run (*source, *dest);
+
+            BEAST_EXPECT(stats.skipped == 0);
+            BEAST_EXPECT(stats.written == batch.size ());
+        }
+    }
+
+    void
+    testCorrupt ()
+    {
+        testcase ("corrupt");
+
+        DummyScheduler scheduler;
+        beast::Journal j;
+        beast::temp_dir source_db;
+        beast::temp_dir dest_db;
+        auto const batch = createHashedBatch (1000, 5);
+
+        {
+            auto source = Manager::instance ().make_Backend (
+                makeParams ("nudb", source_db.path ()), scheduler, j);
+            source->storeBatch (batch);
+        }
+
+        // Add a record whose data cannot be decoded
+        {
+            auto const folder = boost::filesystem::path (source_db.path ());
+            nudb::store db;
+            nudb::error_code ec;
+            db.open ((folder / "nudb.dat").string (),
+                (folder / "nudb.key").string (),
+                    (folder / "nudb.log").string (), ec);
+            BEAST_EXPECT(! ec);
+            uint256 const key (1);
+            std::uint8_t const data[] = {99, 1, 2, 3};
+            db.insert (key.data (), data, sizeof (data), ec);
+            BEAST_EXPECT(! ec);
+            db.close (ec);
+            BEAST_EXPECT(! ec);
+        }
+
+        auto source = Manager::instance ().make_Database ("test",
+            scheduler, j, 2, makeParams ("nudb", source_db.path ()));
+        auto dest = Manager::instance ().make_Backend (
+            makeParams ("nudb", dest_db.path ()), scheduler, j);
+
+        Importer::Setup setup;
+        setup.batchSize = 100;
+        try
+        {
+            Importer (setup, j).run (*source, *dest);
+            fail ("corrupt record imported");
+        }
+        catch (std::exception const&)
+        {
+            pass ();
+        }
+
+        // The source is still readable afterwards
+        Batch copy;
+        fetchCopyOfBatch (*source, &copy, batch);
+        BEAST_EXPECT(areBatchesEqual (batch, copy));
+    }
+
+    void
+    testSetup ()
+    {
+        testcase ("setup");
+
+        Section section;
+        section.set ("type", "nudb");
+        section.set ("import_batch", "256");
+        section.set ("import_threads", "8");
+        section.set ("import_verify", "1");
+        section.set ("import_checkpoint", "import.checkpoint");
+
+        auto const setup = setup_Importer (section);
+        BEAST_EXPECT(setup.batchSize == 256);
+        BEAST_EXPECT(setup.threads == 8);
+        BEAST_EXPECT(setup.verify);
+        BEAST_EXPECT(setup.checkpoint == "import.checkpoint");
+
+        auto const defaults = setup_Importer (Section {});
+        BEAST_EXPECT(! defaults.verify);
+        BEAST_EXPECT(defaults.checkpoint.empty ());
+    }
+
+    void
+    run () override
+    {
+        testImport ();
+        testVerify ();
+        testResume ();
+        testCorrupt ();
+        testSetup ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(Importer,NodeStore,ripple);
+
+//------------------------------------------------------------------------------
+
+// Measures a NuDB to NuDB import.
+// Arguments: objects=<count>,threads=<threads>,verify=<0|1>
+class Importer_timing_test : public Importer_test
+{
+public:
+    void
+    run () override
+    {
+        testcase ("NuDB to NuDB");
+
+        std::vector<std::string> lines;
+        boost::split (lines, arg (), boost::algorithm::is_any_of (","));
+        Section args;
+        args.append (lines);
+        auto const objects = get<std::size_t> (args, "objects", 200000);
+
+        DummyScheduler scheduler;
+        beast::Journal j;
+        beast::temp_dir source_db;
+        beast::temp_dir dest_db;
+
+        {
+            auto source = Manager::instance ().make_Backend (
+                makeParams ("nudb", source_db.path ()), scheduler, j);
+            for (std::size_t n = 0; n < objects; n += 10000)
+                source->storeBatch (createHashedBatch (
+                    std::min<std::size_t> (10000, objects - n), n + 1));
+        }
+
+        auto source = Manager::instance ().make_Database ("test",
+            scheduler, j, 2, makeParams ("nudb", source_db.path ()));
+        auto dest = Manager::instance ().make_Backend (
+            makeParams ("nudb", dest_db.path ()), scheduler, j);
+
+        Importer::Setup setup;
+        setup.threads = get<std::size_t> (args, "threads", setup.threads);
+        setup.verify = get<int> (args, "verify", 1) != 0;
+
+        using namespace std::chrono;
+        auto const start = steady_clock::now ();
+        auto const stats = Importer (setup, j).run (*source, *dest);
+        auto const elapsed = duration_cast<milliseconds> (
+            steady_clock::now () - start).count ();
+
+        log << stats.written << " objects in " << elapsed << "ms, " <<
+            (stats.written * 1000 / std::max<std::int64_t> (elapsed, 1)) <<
+            " objects/s" << std::endl;
+        BEAST_EXPECT(stats.written == objects);
+    }
+};
+
+BEAST_DEFINE_TESTSUITE_MANUAL(Importer_timing,NodeStore,ripple);
+
+}
+}
@@ -0,0 +1,288 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/nodestore/impl/ReadScheduler.h>
+#include <ripple/core/LoadMonitor.h>
+#include <ripple/beast/unit_test.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+namespace ripple {
+namespace NodeStore {
+
+class ReadScheduler_test : public beast::unit_test::suite
+{
+    using clock_type = ReadScheduler::clock_type;
+
+    // Long enough that no client read is promoted during a test
+    static
+    std::chrono::milliseconds
+    never ()
+    {
+        return std::chrono::hours (1);
+    }
+
+    static
+    clock_type::time_point
+    soon ()
+    {
+        return clock_type::now () + std::chrono::milliseconds (20);
+    }
+
+    // Spin until the condition holds, or give up after a while
+    template <class Condition>
+    static
+    bool
+    eventually (Condition const& condition)
+    {
+        auto const deadline = clock_type::now () + std::chrono::seconds (10);
+        while (! condition ())
+        {
+            if (clock_type::now () > deadline)
+                return false;
+            std::this_thread::sleep_for (std::chrono::milliseconds (1));
+        }
+        return true;
+    }
+
+public:
+    void
+    testLimits ()
+    {
+        testcase ("limits");
+
+        ReadScheduler reads (2, 1, never ());
+
+        {
+            // Consensus reads are never held back
+            auto const c1 = reads.acquire (FetchPriority::consensus, soon ());
+            auto const c2 = reads.acquire (FetchPriority::consensus, soon ());
+            auto const c3 = reads.acquire (FetchPriority::consensus, soon ());
+            BEAST_EXPECT(c1 && c2 && c3);
+            BEAST_EXPECT(reads.active (FetchPriority::consensus) == 3);
+        }
+        BEAST_EXPECT(reads.active (FetchPriority::consensus) == 0);
+
+        auto c1 = reads.acquire (FetchPriority::client);
+        BEAST_EXPECT(c1);
+
+        // Client reads are limited on their own
+        BEAST_EXPECT(! reads.acquire (FetchPriority::client, soon ()));
+        BEAST_EXPECT(reads.waiting (FetchPriority::client) == 0);
+
+        // Sync reads share the remaining slots
+        auto s1 = reads.acquire (FetchPriority::sync, soon ());
+        BEAST_EXPECT(s1);
+        BEAST_EXPECT(! reads.acquire (FetchPriority::sync, soon ()));
+        BEAST_EXPECT(reads.acquire (FetchPriority::consensus, soon ()));
+
+        // Returning a permit frees its slot
+        {
+            auto const released = std::move (c1);
+        }
+        BEAST_EXPECT(! c1);
+        BEAST_EXPECT(reads.active (FetchPriority::client) == 0);
+        BEAST_EXPECT(reads.acquire (FetchPriority::sync, soon ()));
+    }
+
+    void
+    testPreference ()
+    {
+        testcase ("sync preferred");
+
+        ReadScheduler reads (1, 1, never ());
+
+        auto held = std::make_unique <ReadScheduler::Permit> (
+            reads.acquire (FetchPriority::sync));
+        BEAST_EXPECT(*held);
+
+        std::atomic <bool> syncAdmitted (false);
+        std::atomic <bool> clientAdmitted (false);
+        std::atomic <bool> finishSync (false);
+
+        std::thread client ([&]
+        {
+            auto const permit = reads.acquire (FetchPriority::client);
+            clientAdmitted = static_cast <bool> (permit);
+        });
+        BEAST_EXPECT(eventually ([&]
+            { return reads.waiting (FetchPriority::client) == 1; }));
+
+        std::thread sync ([&]
+        {
+            auto const permit = reads.acquire (FetchPriority::sync);
+            syncAdmitted = static_cast <bool> (permit);
+            while (! finishSync)
+                std::this_thread::yield ();
+        });
+        BEAST_EXPECT(eventually ([&]
+            { return reads.waiting (FetchPriority::sync) == 1; }));
+
+        // The sync read goes first, though the client read came earlier
+        held.reset ();
+        BEAST_EXPECT(eventually ([&] { return syncAdmitted.load (); }));
+        BEAST_EXPECT(! clientAdmitted);
+        BEAST_EXPECT(reads.waiting (FetchPriority::client) == 1);
+
+        finishSync = true;
+        sync.join ();
+        client.join ();
+        BEAST_EXPECT(clientAdmitted);
+        BEAST_EXPECT(reads.active (FetchPriority::sync) == 0);
+        BEAST_EXPECT(reads.active (FetchPriority::client) == 0);
+    }
+
+    void
+    testPromotion ()
+    {
+        testcase ("client promoted");
+
+        using namespace std::chrono;
+        ReadScheduler reads (1, 1, milliseconds (20));
+
+        auto held = std::make_unique <ReadScheduler::Permit> (
+            reads.acquire (FetchPriority::sync));
+        BEAST_EXPECT(*held);
+
+        std::atomic <bool> syncAdmitted (false);
+        std::atomic <bool> clientAdmitted (false);
+        std::atomic <bool> finishClient (false);
+
+        auto const start = clock_type::now ();
+        std::thread client ([&]
+        {
+            auto const permit = reads.acquire (FetchPriority::client);
+            clientAdmitted = static_cast <bool> (permit);
+            while (! finishClient)
+                std::this_thread::yield ();
+        });
+        BEAST_EXPECT(eventually ([&]
+            { return reads.waiting (FetchPriority::client) == 1; }));
+
+        std::thread sync ([&]
+        {
+            auto const permit = reads.acquire (FetchPriority::sync);
+            syncAdmitted = static_cast <bool> (permit);
+        });
+        BEAST_EXPECT(eventually ([&]
+            { return reads.waiting (FetchPriority::sync) == 1; }));
+
+        // Once the client read has waited long enough, it goes ahead
+        // of the sync read which would otherwise have kept it waiting.
+        std::this_thread::sleep_until (start + milliseconds (100));
+        held.reset ();
+        BEAST_EXPECT(eventually ([&] { return clientAdmitted.load (); }));
+        BEAST_EXPECT(! syncAdmitted);
+
+        finishClient = true;
+        client.join ();
+        sync.join ();
+        BEAST_EXPECT(syncAdmitted);
+        BEAST_EXPECT(reads.waiting (FetchPriority::client) == 0);
+        BEAST_EXPECT(reads.active (FetchPriority::sync) == 0);
+        BEAST_EXPECT(reads.active (FetchPriority::client) == 0);
+    }
+
+    void
+    testDeadline ()
+    {
+        testcase ("deadline");
+
+        ReadScheduler reads (1, 1, never ());
+
+        auto const held = reads.acquire (FetchPriority::client);
+        BEAST_EXPECT(held);
+
+        auto const start = clock_type::now ();
+        auto const permit = reads.acquire (FetchPriority::sync,
+            start + std::chrono::milliseconds (50));
+        BEAST_EXPECT(! permit);
+        BEAST_EXPECT(clock_type::now () - start >=
+            std::chrono::milliseconds (50));
+        BEAST_EXPECT(reads.waiting (FetchPriority::sync) == 0);
+        BEAST_EXPECT(reads.active (FetchPriority::sync) == 0);
+
+        // A deadline already passed fails at once when busy
+        BEAST_EXPECT(! reads.acquire (FetchPriority::client, start));
+    }
+
+    void
+    testScopedPriority ()
+    {
+        testcase ("scoped priority");
+
+        BEAST_EXPECT(ScopedFetchPriority::current () ==
+            FetchPriority::client);
+        {
+            ScopedFetchPriority const outer (FetchPriority::consensus);
+            BEAST_EXPECT(ScopedFetchPriority::current () ==
+                FetchPriority::consensus);
+            {
+                ScopedFetchPriority const inner (FetchPriority::sync);
+                BEAST_EXPECT(ScopedFetchPriority::current () ==
+                    FetchPriority::sync);
+
+                // Each thread has its own priority, and a thread which
+                // never set one is throttled like a client
+                FetchPriority other = FetchPriority::consensus;
+                std::thread ([&]
+                    { other = ScopedFetchPriority::current (); }).join ();
+                BEAST_EXPECT(other == FetchPriority::client);
+            }
+            BEAST_EXPECT(ScopedFetchPriority::current () ==
+                FetchPriority::consensus);
+        }
+        BEAST_EXPECT(ScopedFetchPriority::current () ==
+            FetchPriority::client);
+
+        BEAST_EXPECT(fetchPriority (jtRPC) == FetchPriority::client);
+        BEAST_EXPECT(fetchPriority (jtLEDGER_DATA) == FetchPriority::sync);
+        BEAST_EXPECT(fetchPriority (jtADVANCE) == FetchPriority::sync);
+        BEAST_EXPECT(fetchPriority (jtACCEPT) == FetchPriority::consensus);
+        BEAST_EXPECT(fetchPriority (jtGENERIC) == FetchPriority::client);
+
+        // A running job sets the priority of its thread by its type
+        LoadMonitor monitor {beast::Journal ()};
+        FetchPriority inJob = FetchPriority::client;
+        Job job (jtACCEPT, "test", 0, monitor,
+            [&](Job&) { inJob = ScopedFetchPriority::current (); }, nullptr);
+        job.doJob ();
+        BEAST_EXPECT(inJob == FetchPriority::consensus);
+        BEAST_EXPECT(ScopedFetchPriority::current () ==
+            FetchPriority::client);
+    }
+
+    void
+    run () override
+    {
+        testLimits ();
+        testPreference ();
+        testPromotion ();
+        testDeadline ();
+        testScopedPriority ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(ReadScheduler,NodeStore,ripple);
+
+}
+}
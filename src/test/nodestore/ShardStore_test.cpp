@@ -0,0 +1,381 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <test/nodestore/TestBase.h>
+#include <ripple/nodestore/DummyScheduler.h>
+#include <ripple/nodestore/Manager.h>
+#include <ripple/nodestore/ShardStore.h>
+#include <ripple/nodestore/impl/KeyFilter.h>
+#include <ripple/basics/Slice.h>
+#include <ripple/beast/utility/temp_dir.h>
+#include <ripple/protocol/digest.h>
+#include <ripple/protocol/HashPrefix.h>
+#include <ripple/protocol/Serializer.h>
+#include <boost/filesystem.hpp>
+#include <functional>
+
+namespace ripple {
+namespace NodeStore {
+
+class ShardStore_test : public TestBase
+{
+    static std::uint32_t const ledgersPerShard = 4;
+
+    // A ledger header as it is stored, linked to the one before it
+    static
+    std::shared_ptr<NodeObject>
+    makeHeader (std::uint32_t seq, uint256 const& salt = uint256 ())
+    {
+        uint256 parent;
+        if (seq > 1)
+            parent = makeHeader (seq - 1, salt)->getHash ();
+
+        Serializer s;
+        s.add32 (HashPrefix::ledgerMaster);
+        s.add32 (seq);
+        s.add64 (seq * 1000);
+        s.add256 (parent);
+        s.add256 (salt);
+        s.add256 (uint256 ());
+        s.add32 (seq * 10);
+        s.add32 (seq * 10 + 10);
+        s.add8 (10);
+        s.add8 (0);
+        auto const hash = sha512Half (s.slice ());
+        return NodeObject::createObject (hotLEDGER, s.getData (), hash);
+    }
+
+    // The validated chain, as far as this test is concerned
+    static
+    boost::optional<uint256>
+    validated (std::uint32_t seq)
+    {
+        return makeHeader (seq)->getHash ();
+    }
+
+    static
+    Section
+    makeConfig (std::string const& path)
+    {
+        Section config;
+        config.set ("path", path);
+        config.set ("ledgers_per_shard", std::to_string (ledgersPerShard));
+        return config;
+    }
+
+    // Write a complete shard with the given nodes
+    static
+    bool
+    buildShard (ShardStore& store, std::uint32_t index, Batch const& nodes)
+    {
+        auto writer = store.makeWriter (index);
+        writer->store (nodes);
+        for (auto seq = store.firstSeq (index);
+                seq <= store.lastSeq (index); ++seq)
+        {
+            auto const header = makeHeader (seq);
+            writer->store (Batch {header});
+            writer->addLedger (seq, header->getHash ());
+        }
+        return writer->finalize ();
+    }
+
+    bool
+    hasAll (ShardStore& store, Batch const& batch)
+    {
+        for (auto const& object : batch)
+        {
+            auto const found = store.fetch (object->getHash ());
+            if (! found || ! isSame (found, object))
+                return false;
+        }
+        return true;
+    }
+
+public:
+    void
+    testBuild ()
+    {
+        testcase ("build");
+
+        DummyScheduler scheduler;
+        beast::Journal j;
+        beast::temp_dir shard_db;
+        auto const batch = createPredictableBatch (100, 1);
+
+        auto store = make_ShardStore (
+            makeConfig (shard_db.path ()), scheduler, j);
+        BEAST_EXPECT(store->ledgersPerShard () == ledgersPerShard);
+        BEAST_EXPECT(store->shardIndex (1) == 0);
+        BEAST_EXPECT(store->shardIndex (4) == 0);
+        BEAST_EXPECT(store->shardIndex (5) == 1);
+        BEAST_EXPECT(store->firstSeq (2) == 9);
+        BEAST_EXPECT(store->lastSeq (2) == 12);
+
+        // Incomplete shards are not kept
+        {
+            auto writer = store->makeWriter (1);
+            writer->store (batch);
+            writer->addLedger (5, makeHeader (5)->getHash ());
+            BEAST_EXPECT(! writer->finalize ());
+        }
+        BEAST_EXPECT(! store->hasShard (1));
+        BEAST_EXPECT(! store->fetch (batch.front ()->getHash ()));
+
+        BEAST_EXPECT(buildShard (*store, 1, batch));
+        BEAST_EXPECT(! buildShard (*store, 1, batch));
+        BEAST_EXPECT(store->hasShard (1));
+        BEAST_EXPECT(store->getShards () == std::vector<std::uint32_t> {1});
+        BEAST_EXPECT(hasAll (*store, batch));
+        BEAST_EXPECT(store->fetch (makeHeader (6)->getHash ()));
+
+        auto const missing = createPredictableBatch (1, 2);
+        BEAST_EXPECT(! store->fetch (missing.front ()->getHash ()));
+        BEAST_EXPECT(store->getFetchHitCount () < store->getFetchCount ());
+    }
+
+    void
+    testReopen ()
+    {
+        testcase ("reopen");
+
+        DummyScheduler scheduler;
+        beast::Journal j;
+        beast::temp_dir shard_db;
+        auto const batch = createPredictableBatch (100, 3);
+
+        {
+            auto store = make_ShardStore (
+                makeConfig (shard_db.path ()), scheduler, j);
+            BEAST_EXPECT(buildShard (*store, 3, batch));
+            BEAST_EXPECT(buildShard (*store, 0, Batch {}));
+        }
+
+        // Left behind by an interrupted build
+        auto const stale = boost::filesystem::path (
+            shard_db.path ()) / "2.tmp";
+        boost::filesystem::create_directories (stale);
+
+        auto store = make_ShardStore (
+            makeConfig (shard_db.path ()), scheduler, j);
+        BEAST_EXPECT(store->getShards () ==
+            (std::vector<std::uint32_t> {0, 3}));
+        BEAST_EXPECT(hasAll (*store, batch));
+        BEAST_EXPECT(! boost::filesystem::exists (stale));
+    }
+
+    void
+    testImportExport ()
+    {
+        testcase ("import and export");
+
+        DummyScheduler scheduler;
+        beast::Journal j;
+        beast::temp_dir source_db;
+        beast::temp_dir dest_db;
+        beast::temp_dir exports;
+        auto const batch = createHashedBatch (100, 4);
+
+        auto source = make_ShardStore (
+            makeConfig (source_db.path ()), scheduler, j);
+        BEAST_EXPECT(buildShard (*source, 5, batch));
+
+        auto const path = exports.file ("5");
+        except ([&] { source->exportShard (4, path); });
+        source->exportShard (5, path);
+        except ([&] { source->exportShard (5, path); });
+
+        auto dest = make_ShardStore (
+            makeConfig (dest_db.path ()), scheduler, j);
+        BEAST_EXPECT(dest->importShard (path, validated) == 5);
+        BEAST_EXPECT(dest->getShards () == std::vector<std::uint32_t> {5});
+        BEAST_EXPECT(hasAll (*dest, batch));
+        except ([&] { dest->importShard (path, validated); });
+
+        // Export a shard built by `build` and try to import it
+        auto const rejected = [&](std::uint32_t index, std::string const& name,
+            std::function<void(ShardStore::Writer&)> const& build)
+        {
+            beast::temp_dir other_db;
+            auto other = make_ShardStore (
+                makeConfig (other_db.path ()), scheduler, j);
+            {
+                auto writer = other->makeWriter (index);
+                build (*writer);
+                BEAST_EXPECT(writer->finalize ());
+            }
+            auto const bad = exports.file (name);
+            other->exportShard (index, bad);
+            except ([&] { dest->importShard (bad, validated); });
+            BEAST_EXPECT(! dest->hasShard (index));
+        };
+
+        // A shard missing a ledger header
+        rejected (2, "missing", [&](ShardStore::Writer& writer)
+        {
+            for (auto seq = dest->firstSeq (2); seq <= dest->lastSeq (2); ++seq)
+                writer.addLedger (seq, makeHeader (seq)->getHash ());
+        });
+
+        // A shard holding an object that is not keyed by its hash
+        rejected (2, "corrupt", [&](ShardStore::Writer& writer)
+        {
+            writer.store (createPredictableBatch (1, 7));
+            for (auto seq = dest->firstSeq (2); seq <= dest->lastSeq (2); ++seq)
+            {
+                auto const header = makeHeader (seq);
+                writer.store (Batch {header});
+                writer.addLedger (seq, header->getHash ());
+            }
+        });
+
+        // A self-consistent shard of ledgers that were never validated
+        rejected (2, "forged", [&](ShardStore::Writer& writer)
+        {
+            for (auto seq = dest->firstSeq (2); seq <= dest->lastSeq (2); ++seq)
+            {
+                auto const header = makeHeader (seq, uint256 (1));
+                writer.store (Batch {header});
+                writer.addLedger (seq, header->getHash ());
+            }
+        });
+
+        // A validated last ledger whose parents are not linked
+        rejected (2, "unlinked", [&](ShardStore::Writer& writer)
+        {
+            for (auto seq = dest->firstSeq (2); seq <= dest->lastSeq (2); ++seq)
+            {
+                auto const header = seq == dest->lastSeq (2) ?
+                    makeHeader (seq) : makeHeader (seq, uint256 (1));
+                writer.store (Batch {header});
+                writer.addLedger (seq, header->getHash ());
+            }
+        });
+
+        except ([&] { dest->importShard (exports.file ("none"), validated); });
+    }
+
+    void
+    testFilter ()
+    {
+        testcase ("filter");
+
+        beast::temp_dir dir;
+        auto const present = createPredictableBatch (1000, 8);
+        auto const absent = createPredictableBatch (10000, 9);
+
+        KeyFilter filter (present.size ());
+        for (auto const& object : present)
+            filter.insert (object->getHash ());
+
+        auto const count = [](KeyFilter const& f, Batch const& batch)
+        {
+            std::size_t n = 0;
+            for (auto const& object : batch)
+                if (f.mayContain (object->getHash ()))
+                    ++n;
+            return n;
+        };
+
+        BEAST_EXPECT(count (filter, present) == present.size ());
+        BEAST_EXPECT(count (filter, absent) < absent.size () / 50);
+        BEAST_EXPECT(count (KeyFilter (), absent) == absent.size ());
+
+        auto const path = dir.file ("filter");
+        filter.save (path);
+        auto const loaded = KeyFilter::load (path);
+        BEAST_EXPECT(loaded);
+        if (loaded)
+        {
+            BEAST_EXPECT(count (*loaded, present) == present.size ());
+            BEAST_EXPECT(count (*loaded, absent) == count (filter, absent));
+        }
+
+        // A truncated file is not trusted
+        boost::filesystem::resize_file (path,
+            boost::filesystem::file_size (path) - 1);
+        BEAST_EXPECT(! KeyFilter::load (path));
+        BEAST_EXPECT(! KeyFilter::load (dir.file ("none")));
+
+        // A shard rebuilds its filter when the file is lost
+        DummyScheduler scheduler;
+        beast::Journal j;
+        beast::temp_dir shard_db;
+        auto const batch = createPredictableBatch (100, 10);
+        auto const filterPath =
+            boost::filesystem::path (shard_db.path ()) / "1" / "filter";
+        {
+            auto store = make_ShardStore (
+                makeConfig (shard_db.path ()), scheduler, j);
+            BEAST_EXPECT(buildShard (*store, 1, batch));
+            BEAST_EXPECT(boost::filesystem::exists (filterPath));
+        }
+        boost::filesystem::remove (filterPath);
+        auto store = make_ShardStore (
+            makeConfig (shard_db.path ()), scheduler, j);
+        BEAST_EXPECT(boost::filesystem::exists (filterPath));
+        BEAST_EXPECT(hasAll (*store, batch));
+    }
+
+    void
+    testDatabase ()
+    {
+        testcase ("database");
+
+        DummyScheduler scheduler;
+        beast::Journal j;
+        beast::temp_dir shard_db;
+        auto const archived = createPredictableBatch (100, 5);
+        auto const recent = createPredictableBatch (100, 6);
+
+        std::shared_ptr<ShardStore> shards = make_ShardStore (
+            makeConfig (shard_db.path ()), scheduler, j);
+        BEAST_EXPECT(buildShard (*shards, 0, archived));
+
+        Section params;
+        params.set ("type", "memory");
+        params.set ("path", "shards_test");
+        auto db = Manager::instance ().make_Database (
+            "test", scheduler, j, 2, params);
+        db->setShards (shards);
+        storeBatch (*db, recent);
+
+        Batch copy;
+        fetchCopyOfBatch (*db, &copy, recent);
+        BEAST_EXPECT(areBatchesEqual (recent, copy));
+        fetchCopyOfBatch (*db, &copy, archived);
+        BEAST_EXPECT(areBatchesEqual (archived, copy));
+    }
+
+    void
+    run () override
+    {
+        testBuild ();
+        testReopen ();
+        testImportExport ();
+        testFilter ();
+        testDatabase ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(ShardStore,NodeStore,ripple);
+
+}
+}
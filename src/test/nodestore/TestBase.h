@@ -22,10 +22,12 @@
 
 #include <ripple/nodestore/Database.h>
 #include <ripple/basics/random.h>
+#include <ripple/basics/Slice.h>
 #include <ripple/basics/StringUtilities.h>
 #include <ripple/beast/unit_test.h>
 #include <ripple/beast/utility/rngfill.h>
 #include <ripple/beast/xor_shift_engine.h>
+#include <ripple/protocol/digest.h>
 #include <boost/algorithm/string.hpp>
 #include <iomanip>
 
@@ -111,6 +113,28 @@ public:
         return batch;
     }
 
+    // Create objects keyed by the hash of their data, as the ledger
+    // stores them
+    static
+    Batch
+    createHashedBatch (int numObjects, std::uint64_t seed)
+    {
+        beast::xor_shift_engine rng (seed);
+
+        Batch batch;
+        batch.reserve (numObjects);
+        for (int i = 0; i < numObjects; ++i)
+        {
+            Blob data (32 + rng () % 480);
+            for (auto& b : data)
+                b = static_cast<std::uint8_t> (rng ());
+            auto const hash = sha512Half (makeSlice (data));
+            batch.push_back (NodeObject::createObject (
+                hotACCOUNT_NODE, std::move (data), hash));
+        }
+        return batch;
+    }
+
     // Compare two batches for equality
     static bool areBatchesEqual (Batch const& lhs, Batch const& rhs)
     {
@@ -0,0 +1,116 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/nodestore/impl/WorkerPool.h>
+#include <ripple/basics/contract.h>
+#include <ripple/beast/unit_test.h>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+namespace ripple {
+namespace NodeStore {
+
+class WorkerPool_test : public beast::unit_test::suite
+{
+    void
+    testForEach ()
+    {
+        testcase ("for_each");
+
+        for (std::size_t threads : {0, 1, 4})
+        {
+            WorkerPool pool (threads, "test");
+            std::vector <std::atomic <int>> calls (1000);
+            for (auto& c : calls)
+                c = 0;
+
+            pool.for_each (calls.size (),
+                [&](std::size_t i) { ++calls[i]; });
+
+            bool once = true;
+            for (auto const& c : calls)
+                once = once && c == 1;
+            BEAST_EXPECT(once);
+        }
+    }
+
+    void
+    testException ()
+    {
+        testcase ("exception");
+
+        WorkerPool pool (4, "test");
+        for (std::size_t bad : {0, 1, 500, 999})
+        {
+            std::atomic <std::size_t> calls {0};
+            try
+            {
+                pool.for_each (1000,
+                    [&](std::size_t i)
+                    {
+                        ++calls;
+                        if (i == bad)
+                            Throw<std::runtime_error> ("bad index");
+                    });
+                fail ("no exception");
+            }
+            catch (std::runtime_error const& e)
+            {
+                BEAST_EXPECT(std::string (e.what ()) == "bad index");
+            }
+            BEAST_EXPECT(calls <= 1000);
+        }
+
+        // Every call throwing at once
+        try
+        {
+            pool.for_each (100,
+                [](std::size_t)
+                {
+                    Throw<std::runtime_error> ("all");
+                });
+            fail ("no exception");
+        }
+        catch (std::runtime_error const&)
+        {
+            pass ();
+        }
+
+        // The pool is still usable afterwards
+        std::atomic <std::size_t> calls {0};
+        pool.for_each (100, [&](std::size_t) { ++calls; });
+        BEAST_EXPECT(calls == 100);
+    }
+
+    void
+    run () override
+    {
+        testForEach ();
+        testException ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(WorkerPool,NodeStore,ripple);
+
+}
+}
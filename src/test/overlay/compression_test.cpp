@@ -0,0 +1,269 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/overlay/Message.h>
+#include <ripple/overlay/impl/ProtocolMessage.h>
+#include <ripple/beast/unit_test.h>
+#include <boost/asio/buffer.hpp>
+#include <array>
+#include <string>
+
+namespace ripple {
+
+class compression_test : public beast::unit_test::suite
+{
+private:
+    // Records the messages delivered by invokeProtocolMessage
+    struct Handler
+    {
+        int type = 0;
+        std::size_t size = 0;
+        std::string payload;
+
+        boost::system::error_code
+        onMessageUnknown (std::uint16_t)
+        {
+            return boost::system::errc::make_error_code(
+                boost::system::errc::not_supported);
+        }
+
+        boost::system::error_code
+        onMessageBegin (std::uint16_t t,
+            std::shared_ptr<::google::protobuf::Message> const& m,
+                std::size_t n)
+        {
+            type = t;
+            size = n;
+            payload = m->SerializeAsString();
+            return {};
+        }
+
+        template <class T>
+        void
+        onMessage (std::shared_ptr<T> const&)
+        {
+        }
+
+        void
+        onMessageEnd (std::uint16_t,
+            std::shared_ptr<::google::protobuf::Message> const&)
+        {
+        }
+    };
+
+    static
+    protocol::TMGetObjectByHash
+    makeObjects (int count)
+    {
+        protocol::TMGetObjectByHash tm;
+        tm.set_type (protocol::TMGetObjectByHash::otSTATE_NODE);
+        tm.set_query (false);
+        for (int i = 0; i < count; ++i)
+        {
+            auto& o = *tm.add_objects();
+            o.set_hash (std::string (32, static_cast<char>(i % 7)));
+            o.set_data (std::string (200, 'x'));
+        }
+        return tm;
+    }
+
+    static
+    std::pair<std::size_t, boost::system::error_code>
+    invoke (std::vector<std::uint8_t> const& buf, Handler& h)
+    {
+        return invokeProtocolMessage (
+            boost::asio::const_buffers_1 (buf.data(), buf.size()), h);
+    }
+
+public:
+    void
+    testSmall()
+    {
+        testcase ("small message");
+
+        protocol::TMPing ping;
+        ping.set_type (protocol::TMPing::ptPING);
+        ping.set_seq (42);
+        Message m (ping, protocol::mtPING);
+
+        // Too small to compress, so the plain buffer is used
+        BEAST_EXPECT(&m.getBuffer(true) == &m.getBuffer());
+        BEAST_EXPECT(! Message::compressed(
+            boost::asio::buffer(m.getBuffer())));
+    }
+
+    void
+    testRoundTrip()
+    {
+        testcase ("round trip");
+
+        auto const tm = makeObjects (100);
+        Message m (tm, protocol::mtGET_OBJECTS);
+
+        auto const& plain = m.getBuffer();
+        auto const& packed = m.getBuffer(true);
+        BEAST_EXPECT(&packed != &plain);
+        BEAST_EXPECT(packed.size() < plain.size());
+        BEAST_EXPECT(&m.getBuffer(true) == &packed);
+        BEAST_EXPECT(Message::compressed(boost::asio::buffer(packed)));
+        BEAST_EXPECT(Message::type(boost::asio::buffer(packed)) ==
+            protocol::mtGET_OBJECTS);
+        BEAST_EXPECT(Message::kHeaderBytes +
+            Message::size(boost::asio::buffer(packed)) == packed.size());
+
+        Handler h;
+        auto const result = invoke (packed, h);
+        BEAST_EXPECT(! result.second);
+        BEAST_EXPECT(result.first == packed.size());
+        BEAST_EXPECT(h.type == protocol::mtGET_OBJECTS);
+        BEAST_EXPECT(h.size == packed.size());
+        BEAST_EXPECT(h.payload == tm.SerializeAsString());
+
+        // The message is split across buffers
+        for (std::size_t split : {std::size_t{3},
+            Message::kHeaderBytes + 2, packed.size() / 2})
+        {
+            std::array<boost::asio::const_buffer, 2> const buffers {{
+                boost::asio::const_buffer (packed.data(), split),
+                boost::asio::const_buffer (packed.data() + split,
+                    packed.size() - split)}};
+            Handler hs;
+            auto const rs = invokeProtocolMessage (buffers, hs);
+            BEAST_EXPECT(! rs.second);
+            BEAST_EXPECT(rs.first == packed.size());
+            BEAST_EXPECT(hs.payload == tm.SerializeAsString());
+        }
+
+        // Only part of the message has arrived
+        std::vector<std::uint8_t> partial (
+            packed.begin(), packed.end() - 1);
+        Handler h2;
+        auto const r2 = invoke (partial, h2);
+        BEAST_EXPECT(! r2.second);
+        BEAST_EXPECT(r2.first == 0);
+        BEAST_EXPECT(h2.type == 0);
+    }
+
+    void
+    testMalformed()
+    {
+        testcase ("malformed");
+
+        Message m (makeObjects (100), protocol::mtGET_OBJECTS);
+        auto const& packed = m.getBuffer(true);
+
+        {
+            // Uncompressed size beyond the limit
+            auto buf = packed;
+            buf[Message::kHeaderBytes] = 0xFF;
+            Handler h;
+            auto const result = invoke (buf, h);
+            BEAST_EXPECT(result.second);
+            BEAST_EXPECT(h.type == 0);
+        }
+
+        {
+            // Uncompressed size too large for the block to expand to
+            auto buf = packed;
+            auto const n = (buf.size() - Message::kHeaderBytes - 4) * 256;
+            buf[Message::kHeaderBytes] = (n >> 24) & 0xFF;
+            buf[Message::kHeaderBytes + 1] = (n >> 16) & 0xFF;
+            buf[Message::kHeaderBytes + 2] = (n >> 8) & 0xFF;
+            buf[Message::kHeaderBytes + 3] = n & 0xFF;
+            Handler h;
+            auto const result = invoke (buf, h);
+            BEAST_EXPECT(result.second);
+            BEAST_EXPECT(h.type == 0);
+        }
+
+        {
+            // Uncompressed size does not match the block
+            auto buf = packed;
+            buf[Message::kHeaderBytes + 3] ^= 0x01;
+            Handler h;
+            auto const result = invoke (buf, h);
+            BEAST_EXPECT(result.second);
+            BEAST_EXPECT(h.type == 0);
+        }
+
+        {
+            // Truncated block
+            auto buf = packed;
+            buf.resize (Message::kHeaderBytes + 2);
+            buf[3] = 2;
+            buf[2] = 0;
+            buf[1] = 0;
+            buf[0] = 0x80;
+            Handler h;
+            auto const result = invoke (buf, h);
+            BEAST_EXPECT(result.second);
+        }
+    }
+
+    void
+    testTail()
+    {
+        testcase ("serialized tail");
+
+        // The objects are serialized once and appended to a reply
+        auto const objects = makeObjects (50);
+        std::string tail;
+        objects.SerializePartialToString (&tail);
+
+        protocol::TMGetObjectByHash head;
+        head.set_type (protocol::TMGetObjectByHash::otFETCH_PACK);
+        head.set_query (false);
+        head.set_seq (9);
+
+        Message m (head, protocol::mtGET_OBJECTS,
+            { makeSlice (tail), makeSlice (tail) });
+
+        auto expected = head;
+        expected.MergeFrom (objects);
+        expected.MergeFrom (objects);
+
+        for (auto const compressed : {false, true})
+        {
+            Handler h;
+            auto const& buf = m.getBuffer (compressed);
+            auto const result = invoke (buf, h);
+            BEAST_EXPECT(! result.second);
+            BEAST_EXPECT(result.first == buf.size());
+            protocol::TMGetObjectByHash got;
+            BEAST_EXPECT(got.ParseFromString (h.payload));
+            BEAST_EXPECT(got.objects_size () == 100);
+            BEAST_EXPECT(got.seq () == 9);
+            BEAST_EXPECT(h.payload == expected.SerializeAsString());
+        }
+    }
+
+    void
+    run()
+    {
+        testSmall();
+        testRoundTrip();
+        testMalformed();
+        testTail();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(compression,overlay,ripple);
+
+}
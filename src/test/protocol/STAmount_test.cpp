@@ -18,13 +18,336 @@
 //==============================================================================
 
 #include <BeastConfig.h>
+#include <ripple/basics/contract.h>
 #include <ripple/basics/Log.h>
 #include <ripple/basics/random.h>
 #include <ripple/protocol/STAmount.h>
 #include <ripple/beast/unit_test.h>
+#include <ripple/beast/xor_shift_engine.h>
+#include <boost/multiprecision/cpp_int.hpp>
+#include <boost/optional.hpp>
+#include <chrono>
+#include <iterator>
 
 namespace ripple {
 
+// The arithmetic as it was written before the native 128-bit products
+// and power-of-ten rescaling, kept to check that both agree bit for bit.
+namespace reference {
+
+static std::uint64_t const tenTo14 = 100000000000000ull;
+static std::uint64_t const tenTo17 = tenTo14 * 1000;
+
+static
+std::uint64_t
+muldiv_round (std::uint64_t multiplier, std::uint64_t multiplicand,
+    std::uint64_t divisor, std::uint64_t rounding)
+{
+    boost::multiprecision::uint128_t ret;
+
+    boost::multiprecision::multiply (ret, multiplier, multiplicand);
+    ret += rounding;
+    ret /= divisor;
+
+    if (ret > std::numeric_limits<std::uint64_t>::max())
+        Throw<std::overflow_error> ("overflow");
+
+    return static_cast<std::uint64_t>(ret);
+}
+
+static
+STAmount
+canonicalize (Issue const& issue,
+    std::uint64_t value, int offset, bool negative)
+{
+    if (isXRP (issue))
+    {
+        if (value == 0)
+            return { issue, 0, 0, true, false, STAmount::unchecked{} };
+
+        while (offset < 0)
+        {
+            value /= 10;
+            ++offset;
+        }
+
+        while (offset > 0)
+        {
+            value *= 10;
+            --offset;
+        }
+
+        if (value > STAmount::cMaxNativeN)
+            Throw<std::runtime_error> ("Native currency amount out of range");
+
+        return { issue, value, 0, true, negative, STAmount::unchecked{} };
+    }
+
+    if (value == 0)
+        return { issue, 0, -100, false, false, STAmount::unchecked{} };
+
+    while ((value < STAmount::cMinValue) && (offset > STAmount::cMinOffset))
+    {
+        value *= 10;
+        --offset;
+    }
+
+    while (value > STAmount::cMaxValue)
+    {
+        if (offset >= STAmount::cMaxOffset)
+            Throw<std::runtime_error> ("value overflow");
+
+        value /= 10;
+        ++offset;
+    }
+
+    if ((offset < STAmount::cMinOffset) || (value < STAmount::cMinValue))
+        return { issue, 0, -100, false, false, STAmount::unchecked{} };
+
+    if (offset > STAmount::cMaxOffset)
+        Throw<std::runtime_error> ("value overflow");
+
+    return { issue, value, offset, false, negative, STAmount::unchecked{} };
+}
+
+static
+void
+normalize (STAmount const& amount, std::uint64_t& value, int& offset)
+{
+    value = amount.mantissa();
+    offset = amount.exponent();
+
+    if (amount.native())
+    {
+        while (value < STAmount::cMinValue)
+        {
+            value *= 10;
+            --offset;
+        }
+    }
+}
+
+static
+void
+canonicalizeRound (bool native, std::uint64_t& value, int& offset)
+{
+    if (native)
+    {
+        if (offset < 0)
+        {
+            int loops = 0;
+
+            while (offset < -1)
+            {
+                value /= 10;
+                ++offset;
+                ++loops;
+            }
+
+            value += (loops >= 2) ? 9 : 10;
+            value /= 10;
+            ++offset;
+        }
+    }
+    else if (value > STAmount::cMaxValue)
+    {
+        while (value > (10 * STAmount::cMaxValue))
+        {
+            value /= 10;
+            ++offset;
+        }
+
+        value += 9;
+        value /= 10;
+        ++offset;
+    }
+}
+
+// Shared tail of mulRound and divRound
+static
+STAmount
+roundResult (Issue const& issue, std::uint64_t amount, int offset,
+    bool resultNegative, bool roundUp)
+{
+    if (resultNegative != roundUp)
+        canonicalizeRound (isXRP (issue), amount, offset);
+
+    STAmount result = canonicalize (issue, amount, offset, resultNegative);
+
+    if (roundUp && !resultNegative && !result && *stAmountCalcSwitchover)
+    {
+        if (isXRP (issue) && *stAmountCalcSwitchover2)
+            return canonicalize (issue, 1, 0, resultNegative);
+
+        return canonicalize (issue,
+            STAmount::cMinValue, STAmount::cMinOffset, resultNegative);
+    }
+    return result;
+}
+
+// Not valid for two native operands with a native result,
+// which never reached the code being compared.
+static
+STAmount
+multiply (STAmount const& v1, STAmount const& v2, Issue const& issue)
+{
+    if (v1 == zero || v2 == zero)
+        return STAmount (issue);
+
+    std::uint64_t value1, value2;
+    int offset1, offset2;
+    normalize (v1, value1, offset1);
+    normalize (v2, value2, offset2);
+
+    return canonicalize (issue,
+        muldiv_round (value1, value2, tenTo14, 0) + 7,
+        offset1 + offset2 + 14,
+        v1.negative() != v2.negative());
+}
+
+static
+STAmount
+divide (STAmount const& num, STAmount const& den, Issue const& issue)
+{
+    if (num == zero)
+        return {issue};
+
+    std::uint64_t numVal, denVal;
+    int numOffset, denOffset;
+    normalize (num, numVal, numOffset);
+    normalize (den, denVal, denOffset);
+
+    return canonicalize (issue,
+        muldiv_round (numVal, tenTo17, denVal, 0) + 5,
+        numOffset - denOffset - 17,
+        num.negative() != den.negative());
+}
+
+static
+STAmount
+mulRound (STAmount const& v1, STAmount const& v2, Issue const& issue,
+    bool roundUp)
+{
+    if (v1 == zero || v2 == zero)
+        return {issue};
+
+    std::uint64_t value1, value2;
+    int offset1, offset2;
+    normalize (v1, value1, offset1);
+    normalize (v2, value2, offset2);
+
+    bool const resultNegative = v1.negative() != v2.negative();
+
+    return roundResult (issue,
+        muldiv_round (value1, value2, tenTo14,
+            (resultNegative != roundUp) ? tenTo14 - 1 : 0),
+        offset1 + offset2 + 14, resultNegative, roundUp);
+}
+
+static
+STAmount
+divRound (STAmount const& num, STAmount const& den, Issue const& issue,
+    bool roundUp)
+{
+    if (num == zero)
+        return {issue};
+
+    std::uint64_t numVal, denVal;
+    int numOffset, denOffset;
+    normalize (num, numVal, numOffset);
+    normalize (den, denVal, denOffset);
+
+    bool const resultNegative = num.negative() != den.negative();
+
+    return roundResult (issue,
+        muldiv_round (numVal, tenTo17, denVal,
+            (resultNegative != roundUp) ? denVal - 1 : 0),
+        numOffset - denOffset - 17, resultNegative, roundUp);
+}
+
+} // reference
+
+//------------------------------------------------------------------------------
+
+// Random operands spread over the whole representable range,
+// with extra weight on the boundaries.
+class STAmountGenerator
+{
+    beast::xor_shift_engine engine_;
+
+public:
+    explicit
+    STAmountGenerator (std::uint64_t seed)
+        : engine_ (seed)
+    {
+    }
+
+    std::uint64_t
+    next ()
+    {
+        return engine_ ();
+    }
+
+    // A value with a random number of decimal digits
+    std::uint64_t
+    mantissa ()
+    {
+        static std::uint64_t const edges[] =
+        {
+            1, 9, 10, STAmount::cMinValue - 1, STAmount::cMinValue,
+            STAmount::cMaxValue, STAmount::cMaxValue + 1,
+            10 * STAmount::cMaxValue, 10 * STAmount::cMaxValue + 1,
+            STAmount::cMaxNativeN, STAmount::cMaxNativeN + 1,
+            std::numeric_limits<std::uint64_t>::max()
+        };
+
+        if (rand_int (engine_, 7) == 0)
+            return edges[rand_int (engine_,
+                std::distance (std::begin (edges), std::end (edges)) - 1)];
+
+        auto const v = engine_ () >> rand_int (engine_, 63);
+        return (v == 0) ? 1 : v;
+    }
+
+    STAmount
+    amount (bool native)
+    {
+        bool const negative = rand_bool (engine_);
+
+        if (native)
+        {
+            return STAmount (
+                rand_int (engine_, STAmount::cMaxNativeN) >>
+                    rand_int (engine_, 56), negative);
+        }
+
+        return STAmount (noIssue(),
+            rand_int (engine_, STAmount::cMinValue, STAmount::cMaxValue),
+            rand_int (engine_, STAmount::cMinOffset, STAmount::cMaxOffset),
+            negative);
+    }
+
+    Issue
+    issue ()
+    {
+        return rand_bool (engine_) ? xrpIssue () : noIssue ();
+    }
+
+    bool
+    flip ()
+    {
+        return rand_bool (engine_);
+    }
+
+    int
+    offset (int lo, int hi)
+    {
+        return rand_int (engine_, lo, hi);
+    }
+};
+
+//------------------------------------------------------------------------------
+
 class STAmount_test : public beast::unit_test::suite
 {
 public:
@@ -607,6 +930,102 @@ public:
 
     //--------------------------------------------------------------------------
 
+    bool
+    same (STAmount const& a, STAmount const& b)
+    {
+        return a.mantissa() == b.mantissa() &&
+            a.exponent() == b.exponent() &&
+            a.native() == b.native() &&
+            a.negative() == b.negative();
+    }
+
+    // Runs both versions of an operation, expecting identical
+    // results or an exception from both.
+    template <class F, class G>
+    void
+    expectSame (F const& f, G const& g, std::string const& what)
+    {
+        boost::optional<STAmount> actual;
+        boost::optional<STAmount> expected;
+
+        try { actual = f (); } catch (std::exception const&) { }
+        try { expected = g (); } catch (std::exception const&) { }
+
+        if (bool (actual) != bool (expected))
+        {
+            fail (what + ": only one side threw");
+            return;
+        }
+
+        if (actual && ! same (*actual, *expected))
+        {
+            fail (what + ": " + actual->getFullText () + " != " +
+                expected->getFullText ());
+            return;
+        }
+
+        pass ();
+    }
+
+    void testDifferential ()
+    {
+        testcase ("differential");
+
+        STAmountGenerator gen (20170413);
+
+        for (int i = 0; i < 100000; ++i)
+        {
+            auto const issue = gen.issue ();
+            auto const mantissa = gen.mantissa ();
+            auto const offset = gen.offset (-130, 110);
+            bool const negative = gen.flip ();
+
+            expectSame (
+                [&]{ return STAmount (issue, mantissa, offset, negative); },
+                [&]{ return reference::canonicalize (
+                    issue, mantissa, offset, negative); },
+                "canonicalize");
+        }
+
+        for (int i = 0; i < 100000; ++i)
+        {
+            auto const a = gen.amount (gen.flip ());
+            auto const b = gen.amount (gen.flip ());
+            auto issue = gen.issue ();
+            bool const roundUp = gen.flip ();
+
+            // Two native operands with a native result take a
+            // separate path that does not share this arithmetic.
+            if (a.native () && b.native ())
+                issue = noIssue ();
+
+            expectSame (
+                [&]{ return multiply (a, b, issue); },
+                [&]{ return reference::multiply (a, b, issue); },
+                "multiply");
+
+            expectSame (
+                [&]{ return mulRound (a, b, issue, roundUp); },
+                [&]{ return reference::mulRound (a, b, issue, roundUp); },
+                "mulRound");
+
+            if (b == zero)
+                continue;
+
+            expectSame (
+                [&]{ return divide (a, b, issue); },
+                [&]{ return reference::divide (a, b, issue); },
+                "divide");
+
+            expectSame (
+                [&]{ return divRound (a, b, issue, roundUp); },
+                [&]{ return reference::divRound (a, b, issue, roundUp); },
+                "divRound");
+        }
+    }
+
+    //--------------------------------------------------------------------------
+
     void run ()
     {
         testSetValue ();
@@ -617,9 +1036,104 @@ public:
         testRounding ();
         testConvertXRP ();
         testConvertIOU ();
+        testDifferential ();
+    }
+};
+
+//------------------------------------------------------------------------------
+
+class STAmount_timing_test : public beast::unit_test::suite
+{
+    // Returns the number of operations per second
+    template <class Operation>
+    double
+    rate (std::vector<STAmount> const& operands, Operation const& op)
+    {
+        using namespace std::chrono;
+
+        int const rounds = 20;
+        std::uint64_t sink = 0;
+
+        auto const start = steady_clock::now ();
+        for (int r = 0; r < rounds; ++r)
+        {
+            for (std::size_t i = 1; i < operands.size (); ++i)
+                sink += op (operands[i - 1], operands[i]).mantissa ();
+        }
+        auto const elapsed = duration_cast<duration<double>> (
+            steady_clock::now () - start);
+
+        // Keep the results observable so the work is not discarded
+        if (sink == 1)
+            log << "";
+
+        return rounds * (operands.size () - 1) / elapsed.count ();
+    }
+
+    template <class Operation, class Reference>
+    void
+    compare (std::string const& name,
+        std::vector<STAmount> const& operands,
+        Operation const& op, Reference const& ref)
+    {
+        log <<
+            name << ": " <<
+            static_cast<std::uint64_t> (rate (operands, ref)) <<
+                "/s before, " <<
+            static_cast<std::uint64_t> (rate (operands, op)) <<
+                "/s after" << std::endl;
+    }
+
+public:
+    void
+    run ()
+    {
+        testcase ("throughput");
+
+        STAmountGenerator gen (20170413);
+
+        // Operands from a mix of native and issued amounts of similar
+        // magnitude, so that few results overflow or round to zero.
+        std::vector<STAmount> operands;
+        for (int i = 0; i < 100000; ++i)
+        {
+            operands.push_back (gen.flip ()
+                ? STAmount (gen.offset (1, 100000000), false)
+                : STAmount (noIssue (), gen.offset (1, 100000000),
+                    gen.offset (-8, 8)));
+        }
+
+        auto const issue = noIssue ();
+
+        compare ("multiply", operands,
+            [&](STAmount const& a, STAmount const& b)
+                { return multiply (a, b, issue); },
+            [&](STAmount const& a, STAmount const& b)
+                { return reference::multiply (a, b, issue); });
+
+        compare ("divide", operands,
+            [&](STAmount const& a, STAmount const& b)
+                { return divide (a, b, issue); },
+            [&](STAmount const& a, STAmount const& b)
+                { return reference::divide (a, b, issue); });
+
+        compare ("mulRound", operands,
+            [&](STAmount const& a, STAmount const& b)
+                { return mulRound (a, b, issue, true); },
+            [&](STAmount const& a, STAmount const& b)
+                { return reference::mulRound (a, b, issue, true); });
+
+        compare ("divRound", operands,
+            [&](STAmount const& a, STAmount const& b)
+                { return divRound (a, b, issue, true); },
+            [&](STAmount const& a, STAmount const& b)
+                { return reference::divRound (a, b, issue, true); });
+
+        pass ();
     }
 };
 
 BEAST_DEFINE_TESTSUITE(STAmount,ripple_data,ripple);
+BEAST_DEFINE_TESTSUITE_MANUAL(STAmount_timing,ripple_data,ripple);
 
 } // ripple
@@ -0,0 +1,207 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/crypto/csprng.h>
+#include <ripple/crypto/impl/chacha20.h>
+#include <ripple/basics/strHex.h>
+#include <ripple/beast/unit_test.h>
+#include <openssl/rand.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace ripple {
+
+class csprng_test : public beast::unit_test::suite
+{
+public:
+    void
+    testChaCha20 ()
+    {
+        testcase ("ChaCha20 block");
+
+        // RFC 7539 section 2.3.2
+        std::array<std::uint8_t, 32> key;
+        for (std::size_t i = 0; i < key.size (); ++i)
+            key[i] = static_cast<std::uint8_t> (i);
+        std::array<std::uint8_t, 12> const nonce {{
+            0x00, 0x00, 0x00, 0x09, 0x00, 0x00,
+            0x00, 0x4a, 0x00, 0x00, 0x00, 0x00 }};
+
+        std::array<std::uint8_t, 64> out;
+        detail::chacha20_block (key.data (), 1, nonce.data (), out.data ());
+
+        BEAST_EXPECT(strHex (out.data (), out.size ()) ==
+            "10F1E7E4D13B5915500FDD1FA32071C4"
+            "C7D1F4C733C068030422AA9AC3D46C4E"
+            "D2826446079FAA0914C2D705D98B02A2"
+            "B5129CD1DE164EB9CBD083E8A2503C4E");
+    }
+
+    void
+    testOutput ()
+    {
+        testcase ("output");
+
+        auto& g = crypto_prng ();
+
+        std::set<csprng_engine::result_type> seen;
+        for (int i = 0; i < 10000; ++i)
+            seen.insert (g ());
+        BEAST_EXPECT(seen.size () == 10000);
+
+        // Fills larger than the per-thread buffer, and
+        // that span a reseed, are not repeated.
+        std::vector<std::uint8_t> a (3 * 1024 * 1024);
+        std::vector<std::uint8_t> b (a.size ());
+        g (a.data (), a.size ());
+        g (b.data (), b.size ());
+        BEAST_EXPECT(a != b);
+
+        std::array<std::size_t, 256> counts {};
+        for (auto const c : a)
+            ++counts[c];
+        auto const expected = a.size () / counts.size ();
+        BEAST_EXPECT(std::all_of (counts.begin (), counts.end (),
+            [expected](std::size_t n)
+            {
+                return n > expected * 9 / 10 && n < expected * 11 / 10;
+            }));
+
+        // Zero length fills are allowed
+        g (a.data (), 0);
+
+        // Mixing in entropy reseeds the generators
+        g.mix_entropy (a.data (), 64);
+        BEAST_EXPECT(seen.count (g ()) == 0);
+    }
+
+    void
+    testThreads ()
+    {
+        testcase ("threads");
+
+        int const threads = 8;
+        int const draws = 10000;
+
+        std::vector<std::vector<csprng_engine::result_type>> results (threads);
+        std::vector<std::thread> workers;
+        for (auto& r : results)
+        {
+            workers.emplace_back ([&r, draws]
+                {
+                    auto& g = crypto_prng ();
+                    r.reserve (draws);
+                    for (int i = 0; i < draws; ++i)
+                        r.push_back (g ());
+                });
+        }
+        for (auto& t : workers)
+            t.join ();
+
+        std::set<csprng_engine::result_type> seen;
+        for (auto const& r : results)
+            seen.insert (r.begin (), r.end ());
+        BEAST_EXPECT(seen.size () == threads * draws);
+    }
+
+    void
+    run ()
+    {
+        testChaCha20 ();
+        testOutput ();
+        testThreads ();
+    }
+};
+
+//------------------------------------------------------------------------------
+
+class csprng_timing_test : public beast::unit_test::suite
+{
+    // Generates 32 byte values, the size of a nonce or secret
+    // key, on the given number of threads and returns the rate.
+    template <class Generate>
+    double
+    rate (int threads, Generate const& generate)
+    {
+        using namespace std::chrono;
+
+        int const draws = 200000;
+        std::vector<std::thread> workers;
+
+        auto const start = steady_clock::now ();
+        for (int t = 0; t < threads; ++t)
+        {
+            workers.emplace_back ([&generate, draws]
+                {
+                    std::array<std::uint8_t, 32> buf;
+                    for (int i = 0; i < draws; ++i)
+                        generate (buf.data (), buf.size ());
+                });
+        }
+        for (auto& t : workers)
+            t.join ();
+        auto const elapsed = duration_cast<duration<double>> (
+            steady_clock::now () - start);
+
+        return threads * draws / elapsed.count ();
+    }
+
+public:
+    void
+    run ()
+    {
+        testcase ("throughput");
+
+        // The previous implementation: every call
+        // goes to OpenSSL under a single lock.
+        std::mutex m;
+        auto locked = [&m](std::uint8_t* p, std::size_t n)
+        {
+            std::lock_guard<std::mutex> lock (m);
+            RAND_bytes (p, static_cast<int> (n));
+        };
+
+        auto local = [](std::uint8_t* p, std::size_t n)
+        {
+            crypto_prng () (p, n);
+        };
+
+        for (int threads : {1, 2, 4, 8})
+        {
+            log <<
+                threads << " threads: " <<
+                static_cast<std::uint64_t> (rate (threads, locked)) <<
+                    "/s locked, " <<
+                static_cast<std::uint64_t> (rate (threads, local)) <<
+                    "/s per-thread" << std::endl;
+        }
+        pass ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(csprng,crypto,ripple);
+BEAST_DEFINE_TESTSUITE_MANUAL(csprng_timing,crypto,ripple);
+
+}
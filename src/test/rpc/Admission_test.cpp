@@ -0,0 +1,281 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/rpc/impl/Admission.h>
+#include <ripple/json/json_reader.h>
+#include <ripple/protocol/JsonFields.h>
+#include <ripple/beast/unit_test.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ripple {
+namespace RPC {
+
+class Admission_test : public beast::unit_test::suite
+{
+    static
+    Admission::Setup
+    makeSetup ()
+    {
+        Admission::Setup setup;
+        setup.capacity = 10;
+        setup.queueLimit = 40;
+        setup.heavyCost = 20;
+        return setup;
+    }
+
+    // Records the order in which queued requests are decided
+    struct Recorder
+    {
+        std::vector<std::string> order;
+
+        std::function<void()>
+        resume (std::string const& name)
+        {
+            return [this, name] { order.push_back (name); };
+        }
+    };
+
+public:
+    void
+    testCost ()
+    {
+        testcase ("cost");
+
+        Json::Value params (Json::objectValue);
+        BEAST_EXPECT(estimateCost ("server_info", params) == 1);
+        BEAST_EXPECT(estimateCost ("ripple_path_find", params) >=
+            Tuning::heavyRequestCost);
+        BEAST_EXPECT(estimateCost ("gateway_balances", params) >=
+            Tuning::heavyRequestCost);
+
+        // An unbounded search is the most expensive
+        auto const unbounded = estimateCost ("account_tx", params);
+        params[jss::ledger_index_min] = 1000000;
+        params[jss::ledger_index_max] = 1000100;
+        auto const narrow = estimateCost ("account_tx", params);
+        params[jss::ledger_index_min] = 1;
+        auto const wide = estimateCost ("account_tx", params);
+        BEAST_EXPECT(narrow < wide);
+        BEAST_EXPECT(wide <= unbounded);
+
+        // Asking for more results costs more
+        Json::Value book (Json::objectValue);
+        auto const defaultBook = estimateCost ("book_offers", book);
+        book[jss::limit] = 10;
+        BEAST_EXPECT(estimateCost ("book_offers", book) < defaultBook);
+        book[jss::limit] = 100000;
+        BEAST_EXPECT(estimateCost ("book_offers", book) ==
+            estimateCost ("book_offers", Json::Value (Json::objectValue)) +
+                (Tuning::bookOffers.rmax - Tuning::bookOffers.rdefault) / 50);
+
+        Json::Value data (Json::objectValue);
+        auto const json = estimateCost ("ledger_data", data);
+        data[jss::binary] = true;
+        BEAST_EXPECT(estimateCost ("ledger_data", data) > json);
+    }
+
+    void
+    testMalformed ()
+    {
+        testcase ("malformed");
+
+        // The estimate runs before the request is validated, so it must
+        // price anything a client sends without throwing.
+        auto const cost = [this](std::string const& command,
+            std::string const& request)
+        {
+            Json::Value params;
+            BEAST_EXPECT(Json::Reader ().parse (request, params));
+            try
+            {
+                return estimateCost (command, params);
+            }
+            catch (std::exception const&)
+            {
+                fail ("estimateCost threw");
+            }
+            return 0;
+        };
+
+        BEAST_EXPECT(cost ("account_tx",
+            R"({"ledger_index_min":3000000000,"ledger_index_max":3000000100})")
+                < cost ("account_tx", "{}"));
+        BEAST_EXPECT(cost ("account_tx",
+            R"({"ledger_index_min":1,"ledger_index_max":4000000000})")
+                == cost ("account_tx", "{}"));
+        BEAST_EXPECT(cost ("account_tx",
+            R"({"ledger_index_min":-1,"ledger_index_max":10})")
+                == cost ("account_tx", "{}"));
+        BEAST_EXPECT(cost ("account_tx",
+            R"({"ledger_index_min":1.5e300,"ledger_index_max":[1]})")
+                == cost ("account_tx", "{}"));
+        BEAST_EXPECT(cost ("path_find", R"({"subcommand":{}})") == 1);
+        BEAST_EXPECT(cost ("path_find", R"({"subcommand":["create"]})") == 1);
+        BEAST_EXPECT(cost ("book_offers", R"({"limit":{}})") ==
+            cost ("book_offers", "{}"));
+        BEAST_EXPECT(cost ("ledger", R"({"full":{},"accounts":[]})") >= 1);
+    }
+
+    void
+    testCapacity ()
+    {
+        testcase ("capacity");
+
+        Admission admission (makeSetup (), beast::Journal ());
+        Recorder recorder;
+
+        auto t1 = admission.enter ("a", 6, false, recorder.resume ("t1"));
+        auto t2 = admission.enter ("b", 4, false, recorder.resume ("t2"));
+        BEAST_EXPECT(t1.admitted () && t2.admitted ());
+        BEAST_EXPECT(admission.running () == 10);
+
+        auto t3 = admission.enter ("c", 1, false, recorder.resume ("t3"));
+        BEAST_EXPECT(t3.waiting ());
+        BEAST_EXPECT(admission.queued () == 1);
+
+        // Finishing a request lets the next one in
+        t1 = Admission::Ticket ();
+        BEAST_EXPECT(t3.admitted ());
+        BEAST_EXPECT(recorder.order == std::vector<std::string> {"t3"});
+        BEAST_EXPECT(admission.running () == 5);
+        BEAST_EXPECT(admission.queued () == 0);
+
+        {
+            // A request larger than the capacity runs alone
+            Admission big (makeSetup (), beast::Journal ());
+            auto const t = big.enter ("a", 15, false, recorder.resume ("big"));
+            BEAST_EXPECT(t.admitted ());
+        }
+    }
+
+    void
+    testFairness ()
+    {
+        testcase ("fairness");
+
+        Admission admission (makeSetup (), beast::Journal ());
+        Recorder recorder;
+
+        auto busy = admission.enter ("x", 10, false, recorder.resume ("x"));
+        BEAST_EXPECT(busy.admitted ());
+
+        // A heavy client queues first, a light one later
+        std::vector<Admission::Ticket> tickets;
+        tickets.push_back (admission.enter ("a", 5, false, recorder.resume ("a1")));
+        tickets.push_back (admission.enter ("a", 5, false, recorder.resume ("a2")));
+        tickets.push_back (admission.enter ("a", 5, false, recorder.resume ("a3")));
+        tickets.push_back (admission.enter ("b", 5, false, recorder.resume ("b1")));
+        for (auto const& t : tickets)
+            BEAST_EXPECT(t.waiting ());
+
+        // The light client does not wait behind the heavy client's backlog
+        busy = Admission::Ticket ();
+        BEAST_EXPECT(recorder.order ==
+            (std::vector<std::string> {"a1", "b1"}));
+
+        tickets[0] = Admission::Ticket ();
+        tickets[3] = Admission::Ticket ();
+        BEAST_EXPECT(recorder.order ==
+            (std::vector<std::string> {"a1", "b1", "a2", "a3"}));
+    }
+
+    void
+    testShedding ()
+    {
+        testcase ("shedding");
+
+        Admission admission (makeSetup (), beast::Journal ());
+        Recorder recorder;
+
+        // Heavy requests are refused at once when the server is loaded
+        BEAST_EXPECT(! admission.enter ("a", 20, true, {}).admitted ());
+        BEAST_EXPECT(admission.enter ("a", 1, true, {}).admitted ());
+        BEAST_EXPECT(admission.refused () == 1);
+
+        auto busy = admission.enter ("x", 10, false, recorder.resume ("x"));
+
+        // One client fills most of the queue
+        std::vector<Admission::Ticket> tickets;
+        for (int i = 0; i < 6; ++i)
+            tickets.push_back (admission.enter ("a", 5, false, {}));
+        for (auto const& t : tickets)
+            BEAST_EXPECT(t.waiting ());
+        BEAST_EXPECT(admission.queued () == 30);
+
+        // Near the limit, the crowding client and heavy requests are refused
+        BEAST_EXPECT(! admission.enter ("a", 5, false, {}).waiting ());
+        BEAST_EXPECT(! admission.enter ("b", 20, false, {}).waiting ());
+        auto b = admission.enter ("b", 5, false, recorder.resume ("b"));
+        BEAST_EXPECT(b.waiting ());
+
+        // The queue never grows past its limit
+        BEAST_EXPECT(! admission.enter ("c", 6, false, {}).waiting ());
+        BEAST_EXPECT(admission.queued () == 35);
+        BEAST_EXPECT(admission.refused () == 4);
+
+        // Stopping refuses everything that waits
+        tickets.clear ();
+        admission.stop ();
+        BEAST_EXPECT(recorder.order == std::vector<std::string> {"b"});
+        BEAST_EXPECT(! b.waiting () && ! b.admitted ());
+        BEAST_EXPECT(! admission.enter ("c", 1, false, {}).admitted ());
+        BEAST_EXPECT(admission.queued () == 0);
+        BEAST_EXPECT(admission.running () == 10);
+    }
+
+    void
+    testExpiry ()
+    {
+        testcase ("expiry");
+
+        auto setup = makeSetup ();
+        setup.maxWait = std::chrono::milliseconds (10);
+        Admission admission (setup, beast::Journal ());
+        Recorder recorder;
+
+        auto busy = admission.enter ("x", 10, false, recorder.resume ("x"));
+        auto late = admission.enter ("a", 1, false, recorder.resume ("a"));
+        BEAST_EXPECT(late.waiting ());
+
+        std::this_thread::sleep_for (std::chrono::milliseconds (20));
+        busy = Admission::Ticket ();
+        BEAST_EXPECT(recorder.order == std::vector<std::string> {"a"});
+        BEAST_EXPECT(! late.admitted ());
+        BEAST_EXPECT(admission.refused () == 1);
+    }
+
+    void
+    run () override
+    {
+        testCost ();
+        testMalformed ();
+        testCapacity ();
+        testFairness ();
+        testShedding ();
+        testExpiry ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(Admission,rpc,ripple);
+
+} // RPC
+} // ripple
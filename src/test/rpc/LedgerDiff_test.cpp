@@ -0,0 +1,172 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <ripple/protocol/JsonFields.h>
+#include <test/jtx.h>
+
+namespace ripple {
+
+class LedgerDiff_test : public beast::unit_test::suite
+{
+    static
+    Json::Value
+    ledgerDiff (test::jtx::Env& env, Json::Value const& params)
+    {
+        return env.rpc ("json", "ledger_diff",
+            boost::lexical_cast<std::string>(params))[jss::result];
+    }
+
+    void testDiff()
+    {
+        testcase ("diff");
+
+        using namespace test::jtx;
+        Env env {*this};
+        Account const alice {"alice"};
+        Account const bob {"bob"};
+        env.fund (XRP(10000), alice);
+        env.close ();
+        auto const funded = env.closed ()->info ().seq;
+
+        env.fund (XRP(10000), bob);
+        env (pay (alice, bob, XRP(100)));
+        env.close ();
+        auto const paid = env.closed ()->info ().seq;
+
+        // Against the parent, alice changed and bob is new
+        Json::Value params;
+        params[jss::ledger_index] = paid;
+        auto jrr = ledgerDiff (env, params);
+        BEAST_EXPECT(jrr[jss::ledger_index] == paid);
+        BEAST_EXPECT(jrr[jss::base_ledger_index] == paid - 1);
+        BEAST_EXPECT(jrr[jss::diff].isArray ());
+        BEAST_EXPECT(! jrr.isMember (jss::marker));
+
+        auto find = [](Json::Value const& diff, uint256 const& key)
+        {
+            for (auto const& entry : diff)
+                if (entry[jss::index] == to_string (key))
+                    return entry;
+            return Json::Value {};
+        };
+
+        auto const aliceKey = keylet::account (alice).key;
+        auto const bobKey = keylet::account (bob).key;
+
+        auto entry = find (jrr[jss::diff], aliceKey);
+        BEAST_EXPECT(entry.isMember (jss::before));
+        BEAST_EXPECT(entry.isMember (jss::after));
+        BEAST_EXPECT(entry[jss::before] != entry[jss::after]);
+
+        entry = find (jrr[jss::diff], bobKey);
+        BEAST_EXPECT(! entry.isMember (jss::before));
+        BEAST_EXPECT(entry.isMember (jss::after));
+
+        // Entries come back in key order
+        auto const& diff = jrr[jss::diff];
+        for (Json::UInt i = 1; i < diff.size (); ++i)
+            BEAST_EXPECT(diff[i - 1][jss::index].asString () <
+                diff[i][jss::index].asString ());
+
+        // Reversing the ledgers swaps before and after
+        params[jss::ledger_index] = paid - 1;
+        params[jss::base_ledger] = paid;
+        jrr = ledgerDiff (env, params);
+        entry = find (jrr[jss::diff], bobKey);
+        BEAST_EXPECT(entry.isMember (jss::before));
+        BEAST_EXPECT(! entry.isMember (jss::after));
+
+        // A ledger has no differences with itself
+        params[jss::ledger_index] = funded;
+        params[jss::base_ledger] = funded;
+        jrr = ledgerDiff (env, params);
+        BEAST_EXPECT(jrr[jss::diff].size () == 0);
+    }
+
+    void testMarker()
+    {
+        testcase ("marker");
+
+        using namespace test::jtx;
+        Env env {*this};
+        env.close ();
+        auto const base = env.closed ()->info ().seq;
+
+        for (int i = 0; i < 20; ++i)
+            env.fund (XRP(1000), Account {"bob" + std::to_string (i)});
+        env.close ();
+
+        Json::Value params;
+        params[jss::ledger_index] = "validated";
+        params[jss::base_ledger] = base;
+        auto const all = ledgerDiff (env, params)[jss::diff];
+        BEAST_EXPECT(all.size () > 20);
+
+        // Following the marker a few entries at a time returns the same list
+        params[jss::limit] = 3;
+        Json::Value paged {Json::arrayValue};
+        for (;;)
+        {
+            auto const jrr = ledgerDiff (env, params);
+            BEAST_EXPECT(jrr[jss::diff].size () <= 3);
+            for (auto const& entry : jrr[jss::diff])
+                paged.append (entry);
+            if (! jrr.isMember (jss::marker))
+                break;
+            params[jss::marker] = jrr[jss::marker];
+        }
+        BEAST_EXPECT(paged == all);
+    }
+
+    void testBadInput()
+    {
+        testcase ("bad input");
+
+        using namespace test::jtx;
+        Env env {*this};
+        env.close ();
+
+        Json::Value params;
+        params[jss::ledger_index] = "validated";
+        params[jss::base_ledger] = "bad";
+        auto jrr = ledgerDiff (env, params);
+        BEAST_EXPECT(jrr[jss::error] == "invalidParams");
+
+        params[jss::base_ledger] = 1000;
+        jrr = ledgerDiff (env, params);
+        BEAST_EXPECT(jrr[jss::error] == "lgrNotFound");
+
+        params.removeMember (jss::base_ledger);
+        params[jss::marker] = "bad";
+        jrr = ledgerDiff (env, params);
+        BEAST_EXPECT(jrr[jss::error] == "invalidParams");
+    }
+
+public:
+    void run()
+    {
+        testDiff();
+        testMarker();
+        testBadInput();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(LedgerDiff,app,ripple);
+
+}
@@ -0,0 +1,239 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+//==============================================================================
+
+#include <BeastConfig.h>
+#include <ripple/rpc/impl/ResponseCache.h>
+#include <ripple/app/ledger/LedgerMaster.h>
+#include <ripple/json/json_reader.h>
+#include <ripple/protocol/JsonFields.h>
+#include <ripple/resource/Fees.h>
+#include <ripple/rpc/Context.h>
+#include <test/jtx.h>
+#include <ripple/beast/unit_test.h>
+#include <string>
+
+namespace ripple {
+namespace RPC {
+
+class ResponseCache_test : public beast::unit_test::suite
+{
+    static
+    ResponseCache::Bytes
+    makeBytes (std::size_t size)
+    {
+        return std::make_shared <std::string const> (size, 'x');
+    }
+
+    void
+    testKey ()
+    {
+        testcase ("key");
+
+        uint256 const one (1);
+        uint256 const two (2);
+
+        Json::Value params (Json::objectValue);
+        params[jss::account] = "rHb9CJAWyB4rj91VRWn96DkukG4bwdtyTh";
+        auto const key = ResponseCache::makeKey (
+            "http", "account_info", params, one);
+
+        // The request id and the ledger selectors do not matter
+        Json::Value other (params);
+        other[jss::id] = 7;
+        other[jss::command] = "account_info";
+        other[jss::ledger_index] = "validated";
+        BEAST_EXPECT(key == ResponseCache::makeKey (
+            "http", "account_info", other, one));
+
+        // The ledger, format, command and parameters all do
+        BEAST_EXPECT(key != ResponseCache::makeKey (
+            "http", "account_info", params, two));
+        BEAST_EXPECT(key != ResponseCache::makeKey (
+            "ws", "account_info", params, one));
+        BEAST_EXPECT(key != ResponseCache::makeKey (
+            "http", "account_lines", params, one));
+        other[jss::strict] = true;
+        BEAST_EXPECT(key != ResponseCache::makeKey (
+            "http", "account_info", other, one));
+    }
+
+    void
+    testCacheable ()
+    {
+        testcase ("cacheable");
+
+        Json::Value result (Json::objectValue);
+        BEAST_EXPECT(! ResponseCache::cacheable (result));
+        result[jss::validated] = false;
+        BEAST_EXPECT(! ResponseCache::cacheable (result));
+        result[jss::validated] = true;
+        BEAST_EXPECT(ResponseCache::cacheable (result));
+        result[jss::error] = "lgrNotFound";
+        BEAST_EXPECT(! ResponseCache::cacheable (result));
+        BEAST_EXPECT(! ResponseCache::cacheable (Json::Value ("x")));
+    }
+
+    void
+    testEviction ()
+    {
+        testcase ("eviction");
+
+        TestStopwatch clock;
+        ResponseCache::Setup setup;
+        setup.maxBytes = 3 * 1024;
+        ResponseCache cache (setup, clock);
+
+        cache.insert ("a", makeBytes (900));
+        cache.insert ("b", makeBytes (900));
+        cache.insert ("c", makeBytes (900));
+        BEAST_EXPECT(cache.size () == 3);
+
+        // Touching "a" makes "b" the least recently used
+        BEAST_EXPECT(cache.fetch ("a"));
+        cache.insert ("d", makeBytes (900));
+        BEAST_EXPECT(cache.size () == 3);
+        BEAST_EXPECT(cache.bytes () <= setup.maxBytes);
+        BEAST_EXPECT(! cache.fetch ("b"));
+        BEAST_EXPECT(cache.fetch ("a"));
+        BEAST_EXPECT(cache.fetch ("c"));
+        BEAST_EXPECT(cache.fetch ("d"));
+
+        // Replacing an entry does not count it twice
+        auto const before = cache.bytes ();
+        cache.insert ("d", makeBytes (900));
+        BEAST_EXPECT(cache.bytes () == before);
+
+        // An entry larger than the budget is not stored
+        cache.insert ("e", makeBytes (4 * 1024));
+        BEAST_EXPECT(! cache.fetch ("e"));
+        BEAST_EXPECT(cache.size () == 3);
+
+        BEAST_EXPECT(cache.getHits () == 4);
+        BEAST_EXPECT(cache.getMisses () == 2);
+    }
+
+    void
+    testExpiry ()
+    {
+        testcase ("expiry");
+
+        TestStopwatch clock;
+        ResponseCache::Setup setup;
+        setup.maxAge = std::chrono::seconds (60);
+        ResponseCache cache (setup, clock);
+
+        cache.insert ("a", makeBytes (10));
+        clock.advance (std::chrono::seconds (30));
+        cache.insert ("b", makeBytes (10));
+        cache.sweep ();
+        BEAST_EXPECT(cache.size () == 2);
+
+        clock.advance (std::chrono::seconds (30));
+        cache.sweep ();
+        BEAST_EXPECT(cache.size () == 1);
+        BEAST_EXPECT(! cache.fetch ("a"));
+        BEAST_EXPECT(cache.fetch ("b"));
+
+        clock.advance (std::chrono::seconds (30));
+        cache.sweep ();
+        BEAST_EXPECT(cache.size () == 0);
+        BEAST_EXPECT(cache.bytes () == 0);
+    }
+
+    void
+    testRequest ()
+    {
+        testcase ("request");
+
+        using namespace test::jtx;
+        Env env (*this);
+        env.close ();
+
+        auto& app = env.app ();
+        Resource::Charge loadType = Resource::feeReferenceRPC;
+        Resource::Consumer c;
+        RPC::Context context {beast::Journal(), {}, app, loadType,
+            app.getOPs(), app.getLedgerMaster(), c, Role::USER, {}};
+
+        auto const key = [&](std::string const& request)
+        {
+            BEAST_EXPECT(Json::Reader ().parse (request, context.params));
+            try
+            {
+                return responseCacheKey (context, "account_info", "http");
+            }
+            catch (std::exception const&)
+            {
+                fail ("responseCacheKey threw");
+            }
+            return std::string ();
+        };
+
+        // Anything a client may send is looked up without throwing
+        BEAST_EXPECT(key (R"({"ledger":{}})").empty ());
+        BEAST_EXPECT(key (R"({"ledger":3000000000})").empty ());
+        BEAST_EXPECT(key (R"({"ledger_index":[1]})").empty ());
+        BEAST_EXPECT(key (R"({"ledger_index":3000000000})").empty ());
+        BEAST_EXPECT(key (R"({"ledger_index":1e300})").empty ());
+        BEAST_EXPECT(key (R"({"ledger_index":-1})").empty ());
+        BEAST_EXPECT(key (R"({"ledger_hash":7})").empty ());
+        BEAST_EXPECT(key (R"({"ledger_index":"current"})").empty ());
+
+        // Only closed ledgers are cached, and aliases resolve to the hash
+        auto const validated =
+            app.getLedgerMaster ().getValidatedLedger ()->info ().hash;
+        auto const byAlias = key (R"({"ledger_index":"validated"})");
+        BEAST_EXPECT(! byAlias.empty ());
+        BEAST_EXPECT(byAlias == key (
+            R"({"ledger_hash":")" + to_string (validated) + R"("})"));
+
+        // A result is stored under the ledger it reports, even if the
+        // alias has moved on since the request arrived.
+        Json::Value result (Json::objectValue);
+        result[jss::ledger_hash] = to_string (uint256 (7));
+        result[jss::validated] = true;
+        auto const stored = responseCacheKey (
+            context, "account_info", "http", result);
+        BEAST_EXPECT(! stored.empty ());
+        BEAST_EXPECT(stored != byAlias);
+        BEAST_EXPECT(stored == key (
+            R"({"ledger_hash":")" + to_string (uint256 (7)) + R"("})"));
+
+        result.removeMember (jss::ledger_hash);
+        BEAST_EXPECT(responseCacheKey (
+            context, "account_info", "http", result).empty ());
+    }
+
+    void
+    run () override
+    {
+        testKey ();
+        testCacheable ();
+        testEviction ();
+        testExpiry ();
+        testRequest ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(ResponseCache,rpc,ripple);
+
+} // RPC
+} // ripple
@@ -82,14 +82,13 @@ public:
         beast::Journal mJournal;
     };
 
-    std::shared_ptr <Item>
+    boost::intrusive_ptr <Item const>
     make_random_item (beast::xor_shift_engine& r)
     {
         Serializer s;
         for (int d = 0; d < 3; ++d)
             s.add32 (ripple::rand_int<std::uint32_t>(r));
-        return std::make_shared <Item> (
-            s.getSHA512Half(), s.peekData ());
+        return make_shamapitem (s.getSHA512Half(), s.slice ());
     }
 
     void
@@ -100,9 +99,8 @@ public:
     {
         while (n--)
         {
-            std::shared_ptr <SHAMapItem> item (
-                make_random_item (r));
-            auto const result (t.addItem (std::move(*item), false, false));
+            auto const result (t.addGiveItem (
+                make_random_item (r), false, false));
             assert (result);
             (void) result;
         }
@@ -31,15 +31,14 @@ namespace tests {
 class sync_test : public beast::unit_test::suite
 {
 public:
-    static std::shared_ptr<SHAMapItem> makeRandomAS ()
+    static boost::intrusive_ptr<SHAMapItem const> makeRandomAS ()
     {
         Serializer s;
 
         for (int d = 0; d < 3; ++d)
             s.add32 (rand_int<std::uint32_t>());
 
-        return std::make_shared<SHAMapItem>(
-            s.getSHA512Half(), s.peekData ());
+        return make_shamapitem (s.getSHA512Half(), s.slice ());
     }
 
     bool confuseMap (SHAMap& map, int count)
@@ -52,10 +51,10 @@ public:
 
         for (int i = 0; i < count; ++i)
         {
-            std::shared_ptr<SHAMapItem> item = makeRandomAS ();
+            auto const item = makeRandomAS ();
             items.push_back (item->key());
 
-            if (!map.addItem (std::move(*item), false, false))
+            if (!map.addGiveItem (item, false, false))
             {
                 log << "Unable to add item to map\n";
                 return false;
@@ -82,6 +81,132 @@ public:
         return true;
     }
 
+    // Nodes that are in the database but not in memory are found through
+    // deferred reads, while nodes that are nowhere are reported missing.
+    void testDeferredReads(SHAMap::version v)
+    {
+        testcase (std::string ("deferred reads, version ") +
+            (v == SHAMap::version{1} ? "1" : "2"));
+
+        beast::Journal const j;
+
+        // Both families use the same memory backend, but the destination
+        // starts with empty caches so every node must be read back.
+        TestFamily f(j), f2(j);
+        SHAMap source (SHAMapType::FREE, f, v);
+
+        for (int i = 0; i < 2000; ++i)
+            source.addGiveItem (makeRandomAS (), false, false);
+        source.flushDirty (hotACCOUNT_NODE, 1);
+
+        // These only exist in memory
+        for (int i = 0; i < 50; ++i)
+            source.addGiveItem (makeRandomAS (), false, false);
+        source.setImmutable ();
+        auto const rootHash = source.getHash ();
+
+        SHAMap destination (SHAMapType::FREE, f2, v);
+        destination.setSynching ();
+        {
+            std::vector<SHAMapNodeID> nodeIDs;
+            std::vector<Blob> nodes;
+            BEAST_EXPECT(source.getNodeFat (
+                SHAMapNodeID (), nodeIDs, nodes, false, 0));
+            BEAST_EXPECT(destination.addRootNode (rootHash,
+                makeSlice (nodes.front ()), snfWIRE, nullptr).isGood ());
+        }
+
+        // Stopping early reports exactly what was asked for
+        {
+            int calls = 0;
+            destination.getMissingNodes (2048, nullptr,
+                [&calls](SHAMapNodeID const&, uint256 const&)
+                {
+                    return ++calls < 3;
+                });
+            BEAST_EXPECT(calls == 3);
+            BEAST_EXPECT(destination.isSynching ());
+        }
+
+        int rounds = 0;
+        while (true)
+        {
+            auto const missing = destination.getMissingNodes (2048, nullptr);
+            if (missing.empty ())
+                break;
+
+            for (auto const& m : missing)
+            {
+                std::vector<SHAMapNodeID> nodeIDs;
+                std::vector<Blob> nodes;
+                BEAST_EXPECT(source.getNodeFat (
+                    m.first, nodeIDs, nodes, false, 0));
+                BEAST_EXPECT(! nodes.empty ());
+                for (std::size_t i = 0; i < nodes.size (); ++i)
+                    destination.addKnownNode (
+                        nodeIDs[i], makeSlice (nodes[i]), nullptr);
+            }
+
+            if (! BEAST_EXPECT(++rounds < 100))
+                break;
+        }
+
+        BEAST_EXPECT(! destination.isSynching ());
+        BEAST_EXPECT(source.deepCompare (destination));
+    }
+
+    // A node which is in the database but fails to decode is reported
+    // missing, so that it is acquired again, instead of ending the walk.
+    void testCorruptNode(SHAMap::version v)
+    {
+        testcase (std::string ("corrupt node, version ") +
+            (v == SHAMap::version{1} ? "1" : "2"));
+
+        beast::Journal const j;
+
+        // The families share a backend but each has its own caches
+        TestFamily f(j), f2(j), f3(j);
+        SHAMap source (SHAMapType::FREE, f, v);
+        for (int i = 0; i < 100; ++i)
+            source.addGiveItem (makeRandomAS (), false, false);
+        source.setImmutable ();
+        auto const rootHash = source.getHash ();
+
+        std::vector<SHAMapNodeID> nodeIDs;
+        std::vector<Blob> nodes;
+        BEAST_EXPECT(source.getNodeFat (
+            SHAMapNodeID (), nodeIDs, nodes, false, 0));
+
+        auto const addRoot = [&](SHAMap& map)
+        {
+            map.setSynching ();
+            BEAST_EXPECT(map.addRootNode (rootHash,
+                makeSlice (nodes.front ()), snfWIRE, nullptr).isGood ());
+        };
+
+        // Nothing below the root was stored
+        SHAMap probe (SHAMapType::FREE, f2, v);
+        addRoot (probe);
+        auto const missing = probe.getMissingNodes (2048, nullptr);
+        BEAST_EXPECT(! missing.empty ());
+
+        for (auto const& m : missing)
+            f.db().store (hotACCOUNT_NODE, Blob (3, 0xff), m.second);
+
+        SHAMap destination (SHAMapType::FREE, f3, v);
+        addRoot (destination);
+        std::vector<std::pair<SHAMapNodeID, uint256>> corrupt;
+        try
+        {
+            corrupt = destination.getMissingNodes (2048, nullptr);
+        }
+        catch (std::exception const&)
+        {
+            fail ("getMissingNodes threw");
+        }
+        BEAST_EXPECT(corrupt.size () == missing.size ());
+    }
+
     void run()
     {
         log << "Run, version 1\n" << std::endl;
@@ -89,6 +214,12 @@ public:
 
         log << "Run, version 2\n" << std::endl;
         run(SHAMap::version{2});
+
+        testDeferredReads(SHAMap::version{1});
+        testDeferredReads(SHAMap::version{2});
+
+        testCorruptNode(SHAMap::version{1});
+        testCorruptNode(SHAMap::version{2});
     }
 
     void run(SHAMap::version v)
@@ -101,7 +232,7 @@ public:
         int items = 10000;
         for (int i = 0; i < items; ++i)
         {
-            source.addItem (std::move(*makeRandomAS ()), false, false);
+            source.addGiveItem (makeRandomAS (), false, false);
             if (i % 100 == 0)
                 source.invariants();
         }
@@ -24,6 +24,9 @@
 #include <ripple/basics/StringUtilities.h>
 #include <ripple/beast/unit_test.h>
 #include <ripple/beast/utility/Journal.h>
+#include <ripple/beast/xor_shift_engine.h>
+#include <mutex>
+#include <tuple>
 
 namespace ripple {
 namespace tests {
@@ -52,10 +55,10 @@ static_assert( std::is_move_assignable      <SHAMap::const_iterator>{}, "");
 
 static_assert( std::is_nothrow_destructible <SHAMapItem>{}, "");
 static_assert(!std::is_default_constructible<SHAMapItem>{}, "");
-static_assert( std::is_copy_constructible   <SHAMapItem>{}, "");
-static_assert( std::is_copy_assignable      <SHAMapItem>{}, "");
-static_assert( std::is_move_constructible   <SHAMapItem>{}, "");
-static_assert( std::is_move_assignable      <SHAMapItem>{}, "");
+static_assert(!std::is_copy_constructible   <SHAMapItem>{}, "");
+static_assert(!std::is_copy_assignable      <SHAMapItem>{}, "");
+static_assert(!std::is_move_constructible   <SHAMapItem>{}, "");
+static_assert(!std::is_move_assignable      <SHAMapItem>{}, "");
 
 static_assert( std::is_nothrow_destructible <SHAMapNodeID>{}, "");
 static_assert( std::is_default_constructible<SHAMapNodeID>{}, "");
@@ -118,8 +121,36 @@ public:
         return vuc;
     }
 
+    void testItems ()
+    {
+        testcase ("items");
+
+        uint256 key;
+        key.SetHex ("b92891fe4ef6cee585fdc6fda0e09eb4d386363158ec3321b8123e5a772c6ca8");
+
+        // Sizes on both sides of the pool's size classes, and past them
+        for (std::size_t const size : { 0, 1, 64, 65, 1024, 1025, 70000 })
+        {
+            Blob data (size);
+            for (std::size_t i = 0; i < size; ++i)
+                data[i] = static_cast<std::uint8_t> (i * 7);
+
+            auto const item = make_shamapitem (key, makeSlice (data));
+            BEAST_EXPECT(item->key () == key);
+            BEAST_EXPECT(item->size () == size);
+            BEAST_EXPECT(item->slice () == makeSlice (data));
+
+            // Copies share the item
+            auto copy = item;
+            BEAST_EXPECT(copy.get () == item.get ());
+            copy.reset ();
+            BEAST_EXPECT(item->slice () == makeSlice (data));
+        }
+    }
+
     void run ()
     {
+        testItems ();
         run (true,  SHAMap::version{1});
         run (false, SHAMap::version{1});
         run (true,  SHAMap::version{2});
@@ -149,32 +180,35 @@ public:
         if (! backed)
             sMap.setUnbacked ();
 
-        SHAMapItem i1 (h1, IntToVUC (1)), i2 (h2, IntToVUC (2)), i3 (h3, IntToVUC (3)), i4 (h4, IntToVUC (4)), i5 (h5, IntToVUC (5));
-        unexpected (!sMap.addItem (SHAMapItem{i2}, true, false), "no add");
+        auto const i1 = make_shamapitem (h1, makeSlice (IntToVUC (1)));
+        auto const i2 = make_shamapitem (h2, makeSlice (IntToVUC (2)));
+        auto const i3 = make_shamapitem (h3, makeSlice (IntToVUC (3)));
+        auto const i4 = make_shamapitem (h4, makeSlice (IntToVUC (4)));
+        unexpected (!sMap.addGiveItem (i2, true, false), "no add");
         sMap.invariants();
-        unexpected (!sMap.addItem (SHAMapItem{i1}, true, false), "no add");
+        unexpected (!sMap.addGiveItem (i1, true, false), "no add");
         sMap.invariants();
 
         auto i = sMap.begin();
         auto e = sMap.end();
-        unexpected (i == e || (*i != i1), "bad traverse");
+        unexpected (i == e || (*i != *i1), "bad traverse");
         ++i;
-        unexpected (i == e || (*i != i2), "bad traverse");
+        unexpected (i == e || (*i != *i2), "bad traverse");
         ++i;
         unexpected (i != e, "bad traverse");
-        sMap.addItem (SHAMapItem{i4}, true, false);
+        sMap.addGiveItem (i4, true, false);
         sMap.invariants();
-        sMap.delItem (i2.key());
+        sMap.delItem (i2->key());
         sMap.invariants();
-        sMap.addItem (SHAMapItem{i3}, true, false);
+        sMap.addGiveItem (i3, true, false);
         sMap.invariants();
         i = sMap.begin();
         e = sMap.end();
-        unexpected (i == e || (*i != i1), "bad traverse");
+        unexpected (i == e || (*i != *i1), "bad traverse");
         ++i;
-        unexpected (i == e || (*i != i3), "bad traverse");
+        unexpected (i == e || (*i != *i3), "bad traverse");
         ++i;
-        unexpected (i == e || (*i != i4), "bad traverse");
+        unexpected (i == e || (*i != *i4), "bad traverse");
         ++i;
         unexpected (i != e, "bad traverse");
 
@@ -254,8 +288,8 @@ public:
             BEAST_EXPECT(map.getHash() == zero);
             for (int k = 0; k < keys.size(); ++k)
             {
-                SHAMapItem item (keys[k], IntToVUC (k));
-                BEAST_EXPECT(map.addItem (std::move(item), true, false));
+                BEAST_EXPECT(map.addGiveItem (make_shamapitem (
+                    keys[k], makeSlice (IntToVUC (k))), true, false));
                 BEAST_EXPECT(map.getHash().as_uint256() == hashes[k]);
                 map.invariants();
             }
@@ -308,7 +342,8 @@ public:
                 map.setUnbacked ();
             for (auto const& k : keys)
             {
-                map.addItem(SHAMapItem{k, IntToVUC(0)}, true, false);
+                map.addGiveItem(
+                    make_shamapitem(k, makeSlice(IntToVUC(0))), true, false);
                 map.invariants();
             }
 
@@ -319,10 +354,297 @@ public:
                 --h;
             }
         }
+
+        if (v != SHAMap::version{1})
+            return;
+
+        if (backed)
+            testcase ("sorted build backed");
+        else
+            testcase ("sorted build unbacked");
+
+        {
+            beast::xor_shift_engine eng (42);
+
+            // Enough items to build the subtrees in parallel
+            for (std::size_t const count : { 1, 2, 17, 5000 })
+            {
+                SHAMap::SortedItems items;
+                for (std::size_t k = 0; k < count; ++k)
+                {
+                    uint256 key;
+                    for (auto& b : key)
+                        b = static_cast<std::uint8_t> (eng ());
+                    items.push_back (make_shamapitem (
+                        key, makeSlice (IntToVUC (k))));
+                }
+
+                tests::TestFamily tf{beast::Journal{}};
+                SHAMap added{SHAMapType::FREE, tf, v};
+                SHAMap built{SHAMapType::FREE, tf, v};
+                if (! backed)
+                {
+                    added.setUnbacked ();
+                    built.setUnbacked ();
+                }
+
+                for (auto const& item : items)
+                    BEAST_EXPECT(added.addGiveItem (item, false, false));
+
+                std::sort (items.begin (), items.end (),
+                    [](auto const& a, auto const& b)
+                    {
+                        return a->key () < b->key ();
+                    });
+
+                // Unsorted input is refused
+                if (count > 1)
+                {
+                    std::swap (items.front (), items.back ());
+                    BEAST_EXPECT(! built.addSortedItems (items, false, false));
+                    BEAST_EXPECT(built.getHash () == zero);
+                    std::swap (items.front (), items.back ());
+                }
+
+                BEAST_EXPECT(built.addSortedItems (items, false, false));
+                built.invariants ();
+                BEAST_EXPECT(built.getHash () == added.getHash ());
+                BEAST_EXPECT(built.deepCompare (added));
+
+                // Built and stored in one pass
+                SHAMap stored{SHAMapType::FREE, tf, v};
+                if (! backed)
+                    stored.setUnbacked ();
+                BEAST_EXPECT(stored.addSortedItems (
+                    items, false, false, hotUNKNOWN));
+                stored.invariants ();
+                BEAST_EXPECT(stored.getHash () == added.getHash ());
+                BEAST_EXPECT(stored.deepCompare (added));
+                if (backed)
+                {
+                    BEAST_EXPECT(stored.flushDirty (hotUNKNOWN, 1) == 0);
+                    BEAST_EXPECT(tf.db ().fetch (
+                        stored.getHash ().as_uint256 ()));
+                }
+            }
+        }
+
+        if (backed)
+            testcase ("delta backed");
+        else
+            testcase ("delta unbacked");
+
+        {
+            beast::xor_shift_engine eng (7);
+            auto randomKey = [&eng]()
+            {
+                uint256 key;
+                for (auto& b : key)
+                    b = static_cast<std::uint8_t> (eng ());
+                return key;
+            };
+
+            tests::TestFamily tf{beast::Journal{}};
+            SHAMap map{SHAMapType::FREE, tf, v};
+            if (! backed)
+                map.setUnbacked ();
+
+            std::vector<uint256> keys;
+            for (int k = 0; k < 3000; ++k)
+            {
+                keys.push_back (randomKey ());
+                map.addGiveItem (make_shamapitem (
+                    keys.back (), makeSlice (IntToVUC (k))), false, false);
+            }
+
+            auto const before = map.snapShot (false);
+
+            // Remove, change and add items, including one that shares
+            // a long prefix with an existing key so a leaf on one side
+            // is matched by an inner node on the other.
+            for (int k = 0; k < 3000; k += 7)
+                BEAST_EXPECT(map.delItem (keys[k]));
+            for (int k = 1; k < 3000; k += 14)
+                BEAST_EXPECT(map.updateGiveItem (make_shamapitem (
+                    keys[k], makeSlice (IntToVUC (k + 1))), false, false));
+            for (int k = 0; k < 500; ++k)
+                map.addGiveItem (make_shamapitem (
+                    randomKey (), makeSlice (IntToVUC (k))), false, false);
+            {
+                uint256 near = keys[2];
+                near.begin ()[31] ^= 1;
+                map.addGiveItem (make_shamapitem (
+                    near, makeSlice (IntToVUC (2))), false, false);
+            }
+            map.setImmutable ();
+
+            SHAMap::Delta expected;
+            BEAST_EXPECT(map.compare (*before, expected, 1000000));
+
+            using Entry = std::tuple<uint256,
+                boost::intrusive_ptr<SHAMapItem const>,
+                boost::intrusive_ptr<SHAMapItem const>>;
+            auto check = [&](std::vector<Entry> const& got,
+                SHAMap::Delta::const_iterator first)
+            {
+                if (! BEAST_EXPECT(got.size () == static_cast<std::size_t> (
+                        std::distance (first, expected.cend ()))))
+                    return;
+                for (auto const& e : got)
+                {
+                    BEAST_EXPECT(std::get<0> (e) == first->first);
+                    BEAST_EXPECT(std::get<1> (e) == first->second.first);
+                    BEAST_EXPECT(std::get<2> (e) == first->second.second);
+                    ++first;
+                }
+            };
+
+            std::vector<Entry> got;
+            auto collect = [&got](uint256 const& key,
+                boost::intrusive_ptr<SHAMapItem const> const& ours,
+                boost::intrusive_ptr<SHAMapItem const> const& theirs)
+            {
+                got.emplace_back (key, ours, theirs);
+                return true;
+            };
+
+            BEAST_EXPECT(map.visitDelta (*before, collect));
+            check (got, expected.cbegin ());
+
+            // Resuming after a key visits only the keys that follow it
+            auto const middle = std::next (expected.cbegin (),
+                expected.size () / 2);
+            got.clear ();
+            BEAST_EXPECT(map.visitDelta (*before, collect, middle->first));
+            check (got, std::next (middle));
+
+            // Stopping early
+            int count = 0;
+            BEAST_EXPECT(! map.visitDelta (*before,
+                [&count](uint256 const&,
+                    boost::intrusive_ptr<SHAMapItem const> const&,
+                    boost::intrusive_ptr<SHAMapItem const> const&)
+                {
+                    return ++count < 3;
+                }));
+            BEAST_EXPECT(count == 3);
+
+            // Identical maps have no differences
+            got.clear ();
+            BEAST_EXPECT(before->visitDelta (*before, collect));
+            BEAST_EXPECT(got.empty ());
+
+            // The parallel walk finds the same differences in any order
+            std::mutex mutex;
+            got.clear ();
+            BEAST_EXPECT(map.visitDeltaParallel (*before,
+                [&](uint256 const& key,
+                    boost::intrusive_ptr<SHAMapItem const> const& ours,
+                    boost::intrusive_ptr<SHAMapItem const> const& theirs)
+                {
+                    std::lock_guard<std::mutex> lock (mutex);
+                    got.emplace_back (key, ours, theirs);
+                    return true;
+                }));
+            std::sort (got.begin (), got.end (),
+                [](Entry const& a, Entry const& b)
+                {
+                    return std::get<0> (a) < std::get<0> (b);
+                });
+            check (got, expected.cbegin ());
+        }
     }
 };
 
 BEAST_DEFINE_TESTSUITE(SHAMap,ripple_app,ripple);
 
+// Compares building a large map one item at a time with a sorted
+// build, first only building and hashing the tree, then also storing
+// the nodes. The nodes are stored to the null backend, so the times
+// leave out the backend's own cost.
+class SHAMapBuild_test : public beast::unit_test::suite
+{
+    using clock_type = std::chrono::steady_clock;
+
+    static
+    std::chrono::milliseconds::rep
+    elapsed (clock_type::time_point start)
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds> (
+            clock_type::now () - start).count ();
+    }
+
+    SHAMapHash
+    addEach (SHAMap::SortedItems const& items, bool store)
+    {
+        tests::TestFamily tf{beast::Journal{}, "none"};
+        SHAMap map{SHAMapType::FREE, tf, SHAMap::version{1}};
+        auto const start = clock_type::now ();
+        for (auto const& item : items)
+            map.addGiveItem (item, false, false);
+        if (store)
+            map.flushDirty (hotUNKNOWN, 1);
+        auto const hash = map.getHash ();
+        log << "  addGiveItem: " << elapsed (start) << "ms" << std::endl;
+        return hash;
+    }
+
+    SHAMapHash
+    addSorted (SHAMap::SortedItems const& items, bool store)
+    {
+        tests::TestFamily tf{beast::Journal{}, "none"};
+        SHAMap map{SHAMapType::FREE, tf, SHAMap::version{1}};
+        auto const start = clock_type::now ();
+        if (store)
+            map.addSortedItems (items, false, false, hotUNKNOWN);
+        else
+            map.addSortedItems (items, false, false);
+        auto const hash = map.getHash ();
+        log << "  addSortedItems: " << elapsed (start) << "ms" << std::endl;
+        return hash;
+    }
+
+public:
+    void run ()
+    {
+        std::size_t const count = 500000;
+
+        beast::xor_shift_engine eng (42);
+        SHAMap::SortedItems items;
+        items.reserve (count);
+        for (std::size_t k = 0; k < count; ++k)
+        {
+            uint256 key;
+            for (auto& b : key)
+                b = static_cast<std::uint8_t> (eng ());
+            Blob data (100);
+            for (auto& b : data)
+                b = static_cast<std::uint8_t> (eng ());
+            items.push_back (make_shamapitem (key, makeSlice (data)));
+        }
+
+        {
+            auto const start = clock_type::now ();
+            std::sort (items.begin (), items.end (),
+                [](auto const& a, auto const& b)
+                {
+                    return a->key () < b->key ();
+                });
+            log << count << " items, sorted in " <<
+                elapsed (start) << "ms" << std::endl;
+        }
+
+        for (bool const store : { false, true })
+        {
+            log << (store ? "build, hash and store:" : "build and hash:") <<
+                std::endl;
+            auto const expected = addEach (items, store);
+            BEAST_EXPECT(addSorted (items, store) == expected);
+        }
+    }
+};
+
+BEAST_DEFINE_TESTSUITE_MANUAL(SHAMapBuild,ripple_app,ripple);
+
 } // tests
 } // ripple
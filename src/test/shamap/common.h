@@ -47,13 +47,14 @@ private:
     beast::Journal j_;
 
 public:
-    TestFamily (beast::Journal j)
+    explicit
+    TestFamily (beast::Journal j, std::string const& type = "memory")
         : treecache_ ("TreeNodeCache", 65536, 60, clock_, j)
         , fullbelow_ ("full_below", clock_)
         , j_ (j)
     {
         Section testSection;
-        testSection.set("type", "memory");
+        testSection.set("type", type);
         testSection.set("Path", "SHAMap_test");
         db_ = NodeStore::Manager::instance ().make_Database (
             "test", scheduler_, j, 1, testSection);
@@ -19,6 +19,7 @@
 //==============================================================================
 
 #include <test/beast/aged_associative_container_test.cpp>
+#include <test/beast/beast_AggregatingCollector_test.cpp>
 #include <test/beast/beast_abstract_clock_test.cpp>
 #include <test/beast/beast_asio_error_test.cpp>
 #include <test/beast/beast_basic_seconds_clock_test.cpp>
@@ -21,6 +21,8 @@
 #include <test/core/Config_test.cpp>
 #include <test/core/Coroutine_test.cpp>
 #include <test/core/DeadlineTimer_test.cpp>
+#include <test/core/JobQueue_test.cpp>
+#include <test/core/JobTrace_test.cpp>
 #include <test/core/SociDB_test.cpp>
 #include <test/core/Stoppable_test.cpp>
 #include <test/core/Workers_test.cpp>
\ No newline at end of file
@@ -23,15 +23,18 @@
 #include <test/rpc/AccountObjects_test.cpp>
 #include <test/rpc/AccountOffers_test.cpp>
 #include <test/rpc/AccountSet_test.cpp>
+#include <test/rpc/Admission_test.cpp>
 #include <test/rpc/Book_test.cpp>
 #include <test/rpc/GatewayBalances_test.cpp>
 #include <test/rpc/JSONRPC_test.cpp>
 #include <test/rpc/KeyGeneration_test.cpp>
 #include <test/rpc/LedgerClosed_test.cpp>
 #include <test/rpc/LedgerData_test.cpp>
+#include <test/rpc/LedgerDiff_test.cpp>
 #include <test/rpc/LedgerRPC_test.cpp>
 #include <test/rpc/LedgerRequestRPC_test.cpp>
 #include <test/rpc/NoRipple_test.cpp>
+#include <test/rpc/ResponseCache_test.cpp>
 #include <test/rpc/RobustTransaction_test.cpp>
 #include <test/rpc/RPCOverload_test.cpp>
 #include <test/rpc/ServerInfo_test.cpp>